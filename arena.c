@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "engine.h"
+#include "net.h"
+#include "rules.h"
+
+#define ARENA_DEFAULT_GAMES 100
+
+// Structure for one of the two engines of the arena and its results
+typedef struct {
+    const char *command;
+    EngineProcess process;
+    int wins;
+    int time_losses;
+    int invalid_losses;
+    uint64_t shots;
+    uint64_t bytes;
+    float *move_times;
+    size_t num_move_times;
+    size_t move_time_capacity;
+} ArenaEngine;
+
+// Structure for the settings of the arena and its two engines
+typedef struct {
+    ArenaEngine engines[2];
+    int movetime;
+    bool binary;
+} Arena;
+
+/// \brief Parses the options, starts both engines and plays the games, swapping the seats every game.
+///
+/// Usage: battleship_arena [--games <n>] [--movetime <ms>] [--binary] <engine 1> <engine 2>. Each engine is a
+/// command line run by the shell, speaking the protocol of engine.h.
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 if every game was played, 1 otherwise.
+int main(int argc, char *argv[]);
+
+/// \brief Plays one game between the engines, resolving the fleets and shots with the rules of the game.
+///
+/// An engine that answers late or with an invalid fleet or shot loses the game and is restarted.
+///
+/// \param arena A pointer to the Arena.
+/// \param game_index The index of the game, the first engine plays seat 1 in the even games.
+/// \return bool Returns true if both engines are still running, false otherwise.
+bool play_arena_game(Arena *arena, int game_index);
+
+/// \brief Restarts an engine after it lost a game by failing to answer.
+///
+/// \param arena A pointer to the Arena.
+/// \param engine A pointer to the ArenaEngine.
+/// \return bool Returns true if the engine was restarted, false otherwise.
+bool restart_arena_engine(Arena *arena, ArenaEngine *engine);
+
+/// \brief Stops an engine, keeping the number of bytes of its session.
+///
+/// \param engine A pointer to the ArenaEngine.
+/// \return void
+void stop_arena_engine(ArenaEngine *engine);
+
+/// \brief Records the time an engine took for a move.
+///
+/// \param engine A pointer to the ArenaEngine.
+/// \return void
+void record_move_time(ArenaEngine *engine);
+
+/// \brief Prints the results of an engine.
+///
+/// \param engine A pointer to the ArenaEngine.
+/// \param games The number of games played.
+/// \return void
+void print_engine_results(ArenaEngine *engine, int games);
+
+/// \brief Compares two floats for qsort.
+///
+/// \param a A pointer to the first float.
+/// \param b A pointer to the second float.
+/// \return int The order of the floats.
+int compare_move_times(const void *a, const void *b);
+
+/// \brief Returns the value of the monotonic clock in seconds.
+///
+/// \return double The time in seconds.
+double get_time_s(void);
+
+int main(int argc, char *argv[]) {
+    Arena arena;
+    memset(&arena, 0, sizeof(arena));
+    arena.movetime = ENGINE_DEFAULT_MOVETIME;
+    int games = ARENA_DEFAULT_GAMES;
+
+    // Parse the command-line options, the two engines come last
+    bool valid = true;
+    int num_engines = 0;
+    for (int i = 1; i < argc && valid; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) {
+            arena.movetime = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            arena.binary = true;
+        } else if (argv[i][0] != '-' && num_engines < 2) {
+            arena.engines[num_engines++].command = argv[i];
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || num_engines != 2 || games <= 0 || arena.movetime <= 0) {
+        printf("Usage: %s [--games <n>] [--movetime <ms>] [--binary] <engine 1> <engine 2>\n", argv[0]);
+        return 1;
+    }
+
+    // Start both engines
+    for (int i = 0; i < 2; i++) {
+        ArenaEngine *engine = &arena.engines[i];
+        if (!start_engine(&engine->process, engine->command, arena.movetime, arena.binary)) {
+            printf("Could not start the engine \"%s\".\n", engine->command);
+            if (i == 1) {
+                stop_arena_engine(&arena.engines[0]);
+            }
+            return 1;
+        }
+    }
+    printf("%s against %s, %d games, %d ms per move, %s mode.\n", arena.engines[0].process.name,
+           arena.engines[1].process.name, games, arena.movetime,
+           arena.engines[0].process.binary && arena.engines[1].process.binary ? "binary" : "text");
+
+    // Play the games
+    double start_time = get_time_s();
+    int played = 0;
+    while (played < games && play_arena_game(&arena, played)) {
+        played++;
+    }
+    double elapsed = get_time_s() - start_time;
+
+    for (int i = 0; i < 2; i++) {
+        stop_arena_engine(&arena.engines[i]);
+    }
+
+    // Report the results of each engine and the throughput of the games
+    print_engine_results(&arena.engines[0], played);
+    print_engine_results(&arena.engines[1], played);
+    uint64_t moves = arena.engines[0].num_move_times + arena.engines[1].num_move_times;
+    uint64_t bytes = arena.engines[0].bytes + arena.engines[1].bytes;
+    printf("%d games in %.2f s: %.0f games/s, %.0f moves/s, %.0f bytes per game\n", played, elapsed,
+           (double) played / elapsed, (double) moves / elapsed, played > 0 ? (double) bytes / played : 0.0);
+
+    free(arena.engines[0].move_times);
+    free(arena.engines[1].move_times);
+    return played == games ? 0 : 1;
+}
+
+bool play_arena_game(Arena *arena, int game_index) {
+    // The engines swap seats every game
+    ArenaEngine *seats[2];
+    seats[0] = &arena->engines[game_index % 2];
+    seats[1] = &arena->engines[1 - game_index % 2];
+    CompactBoard boards[2];
+    int loser = -1;
+
+    // Ask both engines for their fleets, the rules of the game check them
+    for (int seat = 0; seat < 2 && loser < 0; seat++) {
+        EngineProcess *process = &seats[seat]->process;
+        NetShip fleet[RULES_NUM_SHIPS];
+        process->error = ENGINE_OK;
+        if (!start_engine_game(process, seat + 1) || !get_engine_fleet(process, fleet)) {
+            loser = seat;
+        } else if (!place_compact_fleet(&boards[seat], fleet)) {
+            process->error = ENGINE_INVALID;
+            loser = seat;
+        } else {
+            record_move_time(seats[seat]);
+        }
+    }
+
+    // Play the shots, seat 1 shoots first and a hit lets the same seat shoot again
+    int turn = 0;
+    int winner = -1;
+    while (loser < 0 && winner < 0) {
+        ArenaEngine *shooter = seats[turn];
+        uint8_t x, y;
+        NetShip sunk_ship = {0};
+        int result = -1;
+        if (get_engine_shot(&shooter->process, &x, &y)) {
+            record_move_time(shooter);
+            result = apply_compact_shot(&boards[1 - turn], x, y, &sunk_ship);
+            if (result < 0) {
+                shooter->process.error = ENGINE_INVALID;
+            }
+        }
+        if (result < 0) {
+            loser = turn;
+            break;
+        }
+        shooter->shots++;
+        send_engine_result(&shooter->process, x, y, (NetShotResult) result, &sunk_ship);
+        send_engine_incoming(&seats[1 - turn]->process, x, y);
+
+        if (boards[1 - turn].remaining_ships == 0) {
+            winner = turn;
+        } else if (result == NET_RESULT_MISS) {
+            turn = 1 - turn;
+        }
+    }
+
+    // Count the win and the reason of a forfeit
+    if (loser >= 0) {
+        winner = 1 - loser;
+        if (seats[loser]->process.error == ENGINE_TIMEOUT) {
+            seats[loser]->time_losses++;
+        } else {
+            seats[loser]->invalid_losses++;
+        }
+    }
+    seats[winner]->wins++;
+    end_engine_game(&seats[0]->process, winner + 1);
+    end_engine_game(&seats[1]->process, winner + 1);
+
+    // An engine that failed to answer may be out of step with the protocol
+    if (loser >= 0) {
+        printf("%s lost game %d: %s.\n", seats[loser]->process.name, game_index + 1,
+               seats[loser]->process.error == ENGINE_TIMEOUT ? "out of time"
+               : seats[loser]->process.error == ENGINE_CLOSED ? "the engine exited" : "invalid fleet or shot");
+        return restart_arena_engine(arena, seats[loser]);
+    }
+    return true;
+}
+
+bool restart_arena_engine(Arena *arena, ArenaEngine *engine) {
+    stop_arena_engine(engine);
+    if (!start_engine(&engine->process, engine->command, arena->movetime, arena->binary)) {
+        printf("Could not restart the engine \"%s\".\n", engine->command);
+        return false;
+    }
+    return true;
+}
+
+void stop_arena_engine(ArenaEngine *engine) {
+    engine->bytes += engine->process.bytes_sent + engine->process.bytes_received;
+    engine->process.bytes_sent = 0;
+    engine->process.bytes_received = 0;
+    stop_engine(&engine->process);
+}
+
+void record_move_time(ArenaEngine *engine) {
+    if (engine->num_move_times == engine->move_time_capacity) {
+        size_t capacity = engine->move_time_capacity > 0 ? 2 * engine->move_time_capacity : 4096;
+        float *move_times = realloc(engine->move_times, capacity * sizeof(float));
+        if (move_times == NULL) {
+            return;
+        }
+        engine->move_times = move_times;
+        engine->move_time_capacity = capacity;
+    }
+    engine->move_times[engine->num_move_times++] = engine->process.last_move_time;
+}
+
+void print_engine_results(ArenaEngine *engine, int games) {
+    float p50 = 0.0f, p99 = 0.0f;
+    if (engine->num_move_times > 0) {
+        qsort(engine->move_times, engine->num_move_times, sizeof(float), compare_move_times);
+        p50 = engine->move_times[(engine->num_move_times - 1) * 50 / 100];
+        p99 = engine->move_times[(engine->num_move_times - 1) * 99 / 100];
+    }
+    printf("%s: %d wins (%.1f%%), %d lost on time, %d lost on invalid moves, %.1f shots per game, "
+           "move time p50 %.3f ms, p99 %.3f ms\n", engine->process.name, engine->wins,
+           games > 0 ? 100.0 * engine->wins / games : 0.0, engine->time_losses, engine->invalid_losses,
+           games > 0 ? (double) engine->shots / games : 0.0, p50, p99);
+}
+
+int compare_move_times(const void *a, const void *b) {
+    float difference = *(const float *) a - *(const float *) b;
+    return (difference > 0) - (difference < 0);
+}
+
+double get_time_s(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
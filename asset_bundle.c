@@ -0,0 +1,171 @@
+#include "asset_bundle.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// \brief Maps a whole file into memory, read only.
+///
+/// \param bundle A pointer to the AssetBundle receiving the mapping.
+/// \param filename The path to the file.
+/// \return bool Returns true if the file was mapped, false otherwise.
+static bool map_file(AssetBundle *bundle, const char *filename);
+
+/// \brief Checks that the header and the entry table of a mapped bundle are valid.
+///
+/// \param bundle A pointer to the mapped AssetBundle.
+/// \return bool Returns true if every entry lies inside the file and the names are sorted, false otherwise.
+static bool validate_bundle(AssetBundle *bundle);
+
+bool open_asset_bundle(AssetBundle *bundle, const char *filename) {
+    memset(bundle, 0, sizeof(AssetBundle));
+    if (!map_file(bundle, filename)) {
+        return false;
+    }
+
+    if (!validate_bundle(bundle)) {
+        printf("Asset bundle %s is invalid.\n", filename);
+        close_asset_bundle(bundle);
+        return false;
+    }
+
+    return true;
+}
+
+void close_asset_bundle(AssetBundle *bundle) {
+#ifdef _WIN32
+    if (bundle->data != NULL) {
+        UnmapViewOfFile(bundle->data);
+    }
+    if (bundle->mapping_handle != NULL) {
+        CloseHandle(bundle->mapping_handle);
+    }
+    if (bundle->file_handle != NULL) {
+        CloseHandle(bundle->file_handle);
+    }
+#else
+    if (bundle->data != NULL) {
+        munmap((void *) bundle->data, bundle->size);
+    }
+#endif
+    memset(bundle, 0, sizeof(AssetBundle));
+}
+
+const void *find_asset(const AssetBundle *bundle, const char *name, size_t *size) {
+    // Binary search in the sorted entry table
+    uint32_t low = 0;
+    uint32_t high = bundle->num_entries;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        const AssetBundleEntry *entry = &bundle->entries[middle];
+        int order = strcmp(name, entry->name);
+        if (order == 0) {
+            *size = (size_t) entry->size;
+            return bundle->data + entry->offset;
+        } else if (order < 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return NULL;
+}
+
+static bool map_file(AssetBundle *bundle, const char *filename) {
+#ifdef _WIN32
+    // Open the file and map a read-only view of all of it
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bundle->file_handle = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        close_asset_bundle(bundle);
+        return false;
+    }
+    bundle->size = (size_t) file_size.QuadPart;
+
+    bundle->mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (bundle->mapping_handle == NULL) {
+        close_asset_bundle(bundle);
+        return false;
+    }
+
+    bundle->data = MapViewOfFile(bundle->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (bundle->data == NULL) {
+        close_asset_bundle(bundle);
+        return false;
+    }
+#else
+    // Open the file and map all of it, the mapping stays valid after the descriptor is closed
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    bundle->size = (size_t) file_stat.st_size;
+
+    void *data = mmap(NULL, bundle->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        bundle->size = 0;
+        return false;
+    }
+    bundle->data = data;
+#endif
+
+    return true;
+}
+
+static bool validate_bundle(AssetBundle *bundle) {
+    // Check the header
+    if (bundle->size < sizeof(AssetBundleHeader)) {
+        return false;
+    }
+    const AssetBundleHeader *header = (const AssetBundleHeader *) bundle->data;
+    if (memcmp(header->magic, ASSET_BUNDLE_MAGIC, 4) != 0 || header->version != ASSET_BUNDLE_VERSION) {
+        return false;
+    }
+
+    // Check that the entry table fits in the file
+    size_t table_size = (size_t) header->num_entries * sizeof(AssetBundleEntry);
+    if (header->num_entries > (bundle->size - sizeof(AssetBundleHeader)) / sizeof(AssetBundleEntry)) {
+        return false;
+    }
+    bundle->entries = (const AssetBundleEntry *) (bundle->data + sizeof(AssetBundleHeader));
+    bundle->num_entries = header->num_entries;
+
+    // Check every entry
+    size_t data_start = sizeof(AssetBundleHeader) + table_size;
+    for (uint32_t i = 0; i < bundle->num_entries; i++) {
+        const AssetBundleEntry *entry = &bundle->entries[i];
+        if (memchr(entry->name, '\0', ASSET_NAME_LENGTH) == NULL) {
+            return false;
+        }
+        if (entry->offset < data_start || entry->offset > bundle->size || entry->size > bundle->size - entry->offset) {
+            return false;
+        }
+        if (i > 0 && strcmp(bundle->entries[i - 1].name, entry->name) >= 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef ASSET_BUNDLE_H
+#define ASSET_BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_BUNDLE_FILE_NAME "Assets.pak"
+#define ASSET_BUNDLE_MAGIC "BSPK"
+#define ASSET_BUNDLE_VERSION 1
+#define ASSET_NAME_LENGTH 64
+#define ASSET_DATA_ALIGNMENT 16
+
+// Header at the start of a bundle file, followed by the entry table and the data of the entries
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t num_entries;
+    uint32_t reserved;
+} AssetBundleHeader;
+
+// Structure for one entry of the table, sorted by name so entries can be found with a binary search
+typedef struct {
+    char name[ASSET_NAME_LENGTH];
+    uint64_t offset;
+    uint64_t size;
+} AssetBundleEntry;
+
+// Structure for a bundle file mapped into memory
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    const AssetBundleEntry *entries;
+    uint32_t num_entries;
+#ifdef _WIN32
+    void *file_handle;
+    void *mapping_handle;
+#endif
+} AssetBundle;
+
+/// \brief Maps a bundle file into memory and validates its entry table.
+///
+/// \param bundle A pointer to the AssetBundle to open.
+/// \param filename The path to the bundle file.
+/// \return bool Returns true if the bundle was mapped and is valid, false otherwise.
+bool open_asset_bundle(AssetBundle *bundle, const char *filename);
+
+/// \brief Unmaps a bundle file.
+///
+/// The data returned by find_asset must not be used after the bundle is closed.
+///
+/// \param bundle A pointer to the AssetBundle to close.
+/// \return void
+void close_asset_bundle(AssetBundle *bundle);
+
+/// \brief Finds an asset in a bundle.
+///
+/// \param bundle A pointer to an open AssetBundle.
+/// \param name The name of the asset, which is its path relative to the game directory.
+/// \param size A pointer to a size_t to store the size of the asset.
+/// \return const void* A pointer to the data of the asset, or NULL if the bundle does not contain it.
+const void *find_asset(const AssetBundle *bundle, const char *name, size_t *size);
+
+#endif // ASSET_BUNDLE_H
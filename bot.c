@@ -0,0 +1,246 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "engine.h"
+#include "net.h"
+#include "rules.h"
+
+// Structure for the state of the bot in a game
+typedef struct {
+    CompactBoard board;
+    uint8_t view[RULES_NUM_CELLS];
+    int seat;
+    int sunk_ships;
+    pcg32_random_t rng;
+} BotGame;
+
+/// \brief Plays engine sessions on stdin and stdout with the AI of the match server.
+///
+/// Usage: battleship_bot [--seed <n>]. The protocol is described in engine.h, the bot supports both modes and
+/// answers at once, whatever the time allowed per move.
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 once the session is over, 1 on invalid options.
+int main(int argc, char *argv[]);
+
+/// \brief Starts a new game: a new random fleet and an unknown opponent's board.
+///
+/// \param game A pointer to the BotGame.
+/// \param seat The seat of the bot.
+/// \param fleet The buffer receiving the positions of the ships.
+/// \return void
+void start_bot_game(BotGame *game, int seat, NetShip fleet[RULES_NUM_SHIPS]);
+
+/// \brief Records the result of a shot of the bot, the cells of a sunk ship are no longer targets.
+///
+/// \param game A pointer to the BotGame.
+/// \param x The x-coordinate of the shot.
+/// \param y The y-coordinate of the shot.
+/// \param result The NetShotResult of the shot.
+/// \param ship A pointer to the sunk ship, used if the result is NET_RESULT_SUNK.
+/// \return void
+void apply_bot_result(BotGame *game, int x, int y, NetShotResult result, const NetShip *ship);
+
+/// \brief Runs the text mode until the session ends or switches to the binary mode.
+///
+/// \param game A pointer to the BotGame.
+/// \return bool Returns true if the session switched to the binary mode, false if it ended.
+bool run_text_session(BotGame *game);
+
+/// \brief Runs the binary mode until stdin is closed.
+///
+/// \param game A pointer to the BotGame.
+/// \return void
+void run_binary_session(BotGame *game);
+
+/// \brief Writes a message of the binary mode to stdout.
+///
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the message was written, false otherwise.
+bool write_bot_message(const NetMessage *message);
+
+/// \brief Writes the next shot of the bot in the binary mode.
+///
+/// \param game A pointer to the BotGame.
+/// \return bool Returns true if the message was written, false otherwise.
+bool write_bot_shot(BotGame *game);
+
+int main(int argc, char *argv[]) {
+    uint64_t seed = (uint64_t) time(NULL);
+    if (argc == 3 && strcmp(argv[1], "--seed") == 0) {
+        seed = strtoull(argv[2], NULL, 10);
+    } else if (argc != 1) {
+        printf("Usage: %s [--seed <n>]\n", argv[0]);
+        return 1;
+    }
+
+    BotGame game;
+    memset(&game, 0, sizeof(game));
+    pcg32_srandom_r(&game.rng, seed, (intptr_t) &game);
+    if (run_text_session(&game)) {
+        run_binary_session(&game);
+    }
+    return 0;
+}
+
+void start_bot_game(BotGame *game, int seat, NetShip fleet[RULES_NUM_SHIPS]) {
+    game->seat = seat;
+    game->sunk_ships = 0;
+    memset(game->view, NET_CELL_UNKNOWN, sizeof(game->view));
+    place_random_compact_fleet(&game->board, &game->rng, fleet);
+}
+
+void apply_bot_result(BotGame *game, int x, int y, NetShotResult result, const NetShip *ship) {
+    if (result == NET_RESULT_MISS) {
+        game->view[x * RULES_BOARD_SIZE + y] = NET_CELL_MISS;
+        return;
+    }
+    game->view[x * RULES_BOARD_SIZE + y] = NET_CELL_HIT;
+    if (result != NET_RESULT_SUNK || ship->index >= RULES_NUM_SHIPS) {
+        return;
+    }
+
+    // Mark the whole ship as sunk
+    game->sunk_ships++;
+    for (int k = 0; k < get_rules_ship_size(ship->index); k++) {
+        int cell_x = ship->x + (ship->orientation == 0 ? k : 0);
+        int cell_y = ship->y + (ship->orientation == 1 ? k : 0);
+        if (cell_x < RULES_BOARD_SIZE && cell_y < RULES_BOARD_SIZE) {
+            game->view[cell_x * RULES_BOARD_SIZE + cell_y] = NET_CELL_SUNK;
+        }
+    }
+}
+
+bool run_text_session(BotGame *game) {
+    char line[ENGINE_LINE_LENGTH];
+    NetShip fleet[RULES_NUM_SHIPS];
+    start_bot_game(game, 1, fleet);
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char command[16] = "";
+        int seat, movetime;
+        uint8_t x, y;
+        sscanf(line, "%15s", command);
+
+        if (strcmp(command, "bsp") == 0) {
+            printf("id name battleship_bot\noption binary\nbspok\n");
+        } else if (strcmp(command, "newgame") == 0 && sscanf(line, "newgame %d %d", &seat, &movetime) == 2) {
+            start_bot_game(game, seat, fleet);
+        } else if (strcmp(command, "fleet") == 0) {
+            // The fleet was placed when the game started
+            printf("fleet");
+            for (int i = 0; i < RULES_NUM_SHIPS; i++) {
+                char cell[4];
+                format_engine_cell(fleet[i].x, fleet[i].y, cell);
+                printf(" %s%c", cell, fleet[i].orientation == 0 ? 'h' : 'v');
+            }
+            printf("\n");
+        } else if (strcmp(command, "shoot") == 0) {
+            char cell[4];
+            choose_compact_shot(game->view, &game->rng, &x, &y);
+            format_engine_cell(x, y, cell);
+            printf("shot %s\n", cell);
+        } else if (strcmp(command, "result") == 0 && parse_engine_cell(line + 7, &x, &y) > 0) {
+            // The cell is followed by miss, hit, or sunk with the ship and its index
+            const char *outcome = strchr(line + 7, ' ');
+            NetShip ship;
+            int length = 0;
+            int index;
+            if (outcome != NULL && strncmp(outcome, " sunk ", 6) == 0 &&
+                (length = parse_engine_ship(outcome + 6, &ship)) > 0 &&
+                sscanf(outcome + 6 + length, "%d", &index) == 1 && index >= 0 && index < RULES_NUM_SHIPS) {
+                ship.index = (uint8_t) index;
+                apply_bot_result(game, x, y, NET_RESULT_SUNK, &ship);
+            } else {
+                bool hit = outcome != NULL && strncmp(outcome, " hit", 4) == 0;
+                apply_bot_result(game, x, y, hit ? NET_RESULT_HIT : NET_RESULT_MISS, NULL);
+            }
+        } else if (strcmp(command, "incoming") == 0 && parse_engine_cell(line + 9, &x, &y) > 0) {
+            apply_compact_shot(&game->board, x, y, NULL);
+        } else if (strcmp(command, "binary") == 0) {
+            printf("binaryok\n");
+            fflush(stdout);
+            return true;
+        } else if (strcmp(command, "quit") == 0) {
+            return false;
+        }
+        fflush(stdout);
+    }
+    return false;
+}
+
+void run_binary_session(BotGame *game) {
+    // Ask for the first game like a client of the match server
+    NetMessage place = {.type = NET_MSG_PLACE, .mode = NET_MODE_PVP};
+    start_bot_game(game, 1, place.fleet);
+    if (!write_bot_message(&place)) {
+        return;
+    }
+
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = 0;
+    int byte;
+    while ((byte = getchar()) != EOF) {
+        buffer[size++] = (uint8_t) byte;
+        NetMessage message;
+        int message_size = decode_net_message(buffer, size, &message);
+        if (message_size < 0) {
+            return;
+        }
+        if (message_size == 0) {
+            continue;
+        }
+        size = 0;
+
+        bool written = true;
+        switch (message.type) {
+            case NET_MSG_START:
+                // Seat 1 shoots first
+                game->seat = message.seat;
+                written = game->seat != 1 || write_bot_shot(game);
+                break;
+
+            case NET_MSG_RESULT:
+                // A hit lets the bot shoot again, unless it sunk the last ship
+                apply_bot_result(game, message.x, message.y, message.result, &message.ship);
+                if (message.result != NET_RESULT_MISS && game->sunk_ships < RULES_NUM_SHIPS) {
+                    written = write_bot_shot(game);
+                }
+                break;
+
+            case NET_MSG_SHOT:
+                // The turn comes back once the opponent misses
+                if (apply_compact_shot(&game->board, message.x, message.y, NULL) == NET_RESULT_MISS) {
+                    written = write_bot_shot(game);
+                }
+                break;
+
+            case NET_MSG_GAME_OVER:
+                start_bot_game(game, 1, place.fleet);
+                written = write_bot_message(&place);
+                break;
+
+            default:
+                break;
+        }
+        if (!written) {
+            return;
+        }
+    }
+}
+
+bool write_bot_message(const NetMessage *message) {
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = encode_net_message(message, buffer);
+    return fwrite(buffer, 1, size, stdout) == size && fflush(stdout) == 0;
+}
+
+bool write_bot_shot(BotGame *game) {
+    NetMessage message = {.type = NET_MSG_SHOT};
+    choose_compact_shot(game->view, &game->rng, &message.x, &message.y);
+    return write_bot_message(&message);
+}
@@ -0,0 +1,503 @@
+#include "engine.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+#define ENGINE_EXIT_TIME 500
+
+/// \brief Returns the value of the monotonic clock in milliseconds.
+///
+/// \return double The time in milliseconds.
+static double get_engine_time(void);
+
+/// \brief Writes bytes to the stdin of the engine.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param data The bytes.
+/// \param size The number of bytes.
+/// \return bool Returns true if the bytes were written, false if the engine is gone.
+static bool write_engine_bytes(EngineProcess *engine, const void *data, size_t size);
+
+/// \brief Reads the bytes the engine wrote to its stdout into the receive buffer, waiting until a deadline.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param deadline The time to give up at, see get_engine_time.
+/// \return bool Returns true if bytes were read, false on timeout or if the engine is gone, see its error.
+static bool fill_engine_buffer(EngineProcess *engine, double deadline);
+
+/// \brief Sends a line of the text mode.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param format The printf format of the line, without the newline.
+/// \return bool Returns true if the line was written, false if the engine is gone.
+static bool send_engine_line(EngineProcess *engine, const char *format, ...);
+
+/// \brief Reads lines of the text mode until one starts with a keyword, the other lines are ignored.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param keyword The first word of the expected line.
+/// \param line The buffer receiving the line without its newline, ENGINE_LINE_LENGTH bytes long.
+/// \param timeout The longest time to wait, in milliseconds.
+/// \return bool Returns true if the line was read, false otherwise, see the error of the engine.
+static bool read_engine_line(EngineProcess *engine, const char *keyword, char *line, int timeout);
+
+/// \brief Sends a message of the binary mode.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the message was written, false if the engine is gone.
+static bool send_engine_message(EngineProcess *engine, const NetMessage *message);
+
+/// \brief Reads the next message of the binary mode, which must be of a given type.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param type The expected NetMessageType.
+/// \param message A pointer to the NetMessage receiving the message.
+/// \param timeout The longest time to wait, in milliseconds.
+/// \return bool Returns true if the message was read, false otherwise, see the error of the engine.
+static bool read_engine_message(EngineProcess *engine, NetMessageType type, NetMessage *message, int timeout);
+
+#ifdef _WIN32
+bool start_engine(EngineProcess *engine, const char *command, int movetime, bool binary) {
+    (void) command;
+    (void) movetime;
+    (void) binary;
+    memset(engine, 0, sizeof(EngineProcess));
+    engine->pid = -1;
+    engine->error = ENGINE_CLOSED;
+    printf("External engines are not supported on Windows.\n");
+    return false;
+}
+
+void stop_engine(EngineProcess *engine) {
+    engine->pid = -1;
+}
+#else
+bool start_engine(EngineProcess *engine, const char *command, int movetime, bool binary) {
+    memset(engine, 0, sizeof(EngineProcess));
+    engine->pid = -1;
+    engine->input = -1;
+    engine->output = -1;
+    engine->movetime = movetime;
+    snprintf(engine->name, sizeof(engine->name), "%s", command);
+
+    // A write to an engine that exited must fail instead of killing the game
+    signal(SIGPIPE, SIG_IGN);
+
+    // Connect the stdin and stdout of the engine, the pipes are not inherited by the other engines
+    int to_engine[2], from_engine[2];
+    if (pipe(to_engine) != 0) {
+        printf("Could not create the pipes of the engine: %s\n", strerror(errno));
+        return false;
+    }
+    if (pipe(from_engine) != 0) {
+        printf("Could not create the pipes of the engine: %s\n", strerror(errno));
+        close(to_engine[0]);
+        close(to_engine[1]);
+        return false;
+    }
+    fcntl(to_engine[1], F_SETFD, FD_CLOEXEC);
+    fcntl(from_engine[0], F_SETFD, FD_CLOEXEC);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(to_engine[0], STDIN_FILENO);
+        dup2(from_engine[1], STDOUT_FILENO);
+        close(to_engine[0]);
+        close(from_engine[1]);
+        execl("/bin/sh", "sh", "-c", command, (char *) NULL);
+        _exit(127);
+    }
+    close(to_engine[0]);
+    close(from_engine[1]);
+    if (pid < 0) {
+        printf("Could not start the engine: %s\n", strerror(errno));
+        close(to_engine[1]);
+        close(from_engine[0]);
+        return false;
+    }
+    engine->pid = (int) pid;
+    engine->input = to_engine[1];
+    engine->output = from_engine[0];
+
+    // Run the handshake, the engine tells its name and whether it supports the binary mode
+    char line[ENGINE_LINE_LENGTH];
+    double deadline = get_engine_time() + ENGINE_HANDSHAKE_TIME;
+    bool started = send_engine_line(engine, "bsp");
+    while (started) {
+        int timeout = (int) (deadline - get_engine_time());
+        if (!read_engine_line(engine, "", line, timeout > 0 ? timeout : 0)) {
+            started = false;
+            break;
+        }
+        if (strncmp(line, "id name ", 8) == 0) {
+            snprintf(engine->name, sizeof(engine->name), "%.*s", ENGINE_NAME_LENGTH - 1, line + 8);
+        } else if (strcmp(line, "option binary") == 0) {
+            engine->supports_binary = true;
+        } else if (strcmp(line, "bspok") == 0) {
+            break;
+        }
+    }
+    if (!started) {
+        printf("The engine \"%s\" did not complete the handshake.\n", command);
+        stop_engine(engine);
+        return false;
+    }
+
+    // Switch to the binary mode for the rest of the session
+    if (binary && !engine->supports_binary) {
+        printf("The engine %s does not support the binary mode, using the text mode.\n", engine->name);
+    } else if (binary) {
+        if (!send_engine_line(engine, "binary %d", movetime) ||
+            !read_engine_line(engine, "binaryok", line, ENGINE_HANDSHAKE_TIME)) {
+            printf("The engine %s did not switch to the binary mode.\n", engine->name);
+            stop_engine(engine);
+            return false;
+        }
+        engine->binary = true;
+    }
+    return true;
+}
+
+void stop_engine(EngineProcess *engine) {
+    if (engine->pid <= 0) {
+        return;
+    }
+
+    // Closing the stdin of the engine ends the session in both modes
+    if (!engine->binary) {
+        send_engine_line(engine, "quit");
+    }
+    close(engine->input);
+    close(engine->output);
+
+    // Give the engine some time to exit before killing it
+    double deadline = get_engine_time() + ENGINE_EXIT_TIME;
+    while (waitpid(engine->pid, NULL, WNOHANG) == 0) {
+        if (get_engine_time() >= deadline) {
+            kill(engine->pid, SIGKILL);
+            waitpid(engine->pid, NULL, 0);
+            break;
+        }
+        struct timespec delay = {0, 5 * 1000000};
+        nanosleep(&delay, NULL);
+    }
+    engine->pid = -1;
+}
+#endif
+
+bool start_engine_game(EngineProcess *engine, int seat) {
+    // In the binary mode the engine places its fleet unprompted, then learns its seat
+    engine->seat = seat;
+    return engine->binary || send_engine_line(engine, "newgame %d %d", seat, engine->movetime);
+}
+
+bool get_engine_fleet(EngineProcess *engine, NetShip fleet[NET_FLEET_SIZE]) {
+    double start_time = get_engine_time();
+    int timeout = engine->movetime + ENGINE_GRACE_TIME;
+
+    if (engine->binary) {
+        NetMessage message;
+        if (!read_engine_message(engine, NET_MSG_PLACE, &message, timeout)) {
+            return false;
+        }
+        engine->last_move_time = (float) (get_engine_time() - start_time);
+        memcpy(fleet, message.fleet, sizeof(message.fleet));
+        NetMessage start = {.type = NET_MSG_START, .seat = (uint8_t) engine->seat};
+        return send_engine_message(engine, &start);
+    }
+
+    char line[ENGINE_LINE_LENGTH];
+    if (!send_engine_line(engine, "fleet") || !read_engine_line(engine, "fleet", line, timeout)) {
+        return false;
+    }
+    engine->last_move_time = (float) (get_engine_time() - start_time);
+
+    // Parse the five ships
+    const char *text = line + 5;
+    for (int i = 0; i < NET_FLEET_SIZE; i++) {
+        while (*text == ' ') {
+            text++;
+        }
+        int length = parse_engine_ship(text, &fleet[i]);
+        if (length == 0) {
+            engine->error = ENGINE_INVALID;
+            return false;
+        }
+        fleet[i].index = (uint8_t) i;
+        text += length;
+    }
+    return true;
+}
+
+bool get_engine_shot(EngineProcess *engine, uint8_t *x, uint8_t *y) {
+    double start_time = get_engine_time();
+    int timeout = engine->movetime + ENGINE_GRACE_TIME;
+
+    if (engine->binary) {
+        NetMessage message;
+        if (!read_engine_message(engine, NET_MSG_SHOT, &message, timeout)) {
+            return false;
+        }
+        engine->last_move_time = (float) (get_engine_time() - start_time);
+        *x = message.x;
+        *y = message.y;
+        return true;
+    }
+
+    char line[ENGINE_LINE_LENGTH];
+    if (!send_engine_line(engine, "shoot") || !read_engine_line(engine, "shot", line, timeout)) {
+        return false;
+    }
+    engine->last_move_time = (float) (get_engine_time() - start_time);
+
+    // The cell follows the keyword after spaces, a bare "shot" is invalid
+    const char *text = line + 4;
+    if (*text != ' ') {
+        engine->error = ENGINE_INVALID;
+        return false;
+    }
+    while (*text == ' ') {
+        text++;
+    }
+    if (parse_engine_cell(text, x, y) == 0) {
+        engine->error = ENGINE_INVALID;
+        return false;
+    }
+    return true;
+}
+
+bool send_engine_result(EngineProcess *engine, int x, int y, NetShotResult result, const NetShip *ship) {
+    if (engine->binary) {
+        NetMessage message = {.type = NET_MSG_RESULT, .x = (uint8_t) x, .y = (uint8_t) y, .result = result};
+        if (result == NET_RESULT_SUNK) {
+            message.ship = *ship;
+        }
+        return send_engine_message(engine, &message);
+    }
+
+    char cell[4];
+    format_engine_cell(x, y, cell);
+    if (result != NET_RESULT_SUNK) {
+        return send_engine_line(engine, "result %s %s", cell, result == NET_RESULT_HIT ? "hit" : "miss");
+    }
+    char ship_cell[4];
+    format_engine_cell(ship->x, ship->y, ship_cell);
+    return send_engine_line(engine, "result %s sunk %s%c %d", cell, ship_cell, ship->orientation == 0 ? 'h' : 'v',
+                            ship->index);
+}
+
+bool send_engine_incoming(EngineProcess *engine, int x, int y) {
+    if (engine->binary) {
+        NetMessage message = {.type = NET_MSG_SHOT, .x = (uint8_t) x, .y = (uint8_t) y};
+        return send_engine_message(engine, &message);
+    }
+
+    char cell[4];
+    format_engine_cell(x, y, cell);
+    return send_engine_line(engine, "incoming %s", cell);
+}
+
+bool end_engine_game(EngineProcess *engine, int winner) {
+    if (engine->binary) {
+        NetMessage message = {.type = NET_MSG_GAME_OVER, .seat = (uint8_t) winner};
+        return send_engine_message(engine, &message);
+    }
+    return send_engine_line(engine, "gameover %d", winner);
+}
+
+void format_engine_cell(int x, int y, char *text) {
+    // The rows go up to 10, the only one written with two digits
+    int row = y + 1;
+    int length = 0;
+    text[length++] = (char) ('A' + x);
+    if (row >= 10) {
+        text[length++] = (char) ('0' + row / 10);
+    }
+    text[length++] = (char) ('0' + row % 10);
+    text[length] = '\0';
+}
+
+int parse_engine_cell(const char *text, uint8_t *x, uint8_t *y) {
+    // The column letter, then the row number without leading zeros
+    char column = text[0] >= 'a' && text[0] <= 'z' ? (char) (text[0] - 'a' + 'A') : text[0];
+    if (column < 'A' || column >= 'A' + NET_BOARD_SIZE || text[1] < '1' || text[1] > '9') {
+        return 0;
+    }
+    int row = text[1] - '0';
+    int length = 2;
+    if (text[2] >= '0' && text[2] <= '9') {
+        row = row * 10 + text[2] - '0';
+        length = 3;
+    }
+    if (row > NET_BOARD_SIZE) {
+        return 0;
+    }
+    *x = (uint8_t) (column - 'A');
+    *y = (uint8_t) (row - 1);
+    return length;
+}
+
+int parse_engine_ship(const char *text, NetShip *ship) {
+    int length = parse_engine_cell(text, &ship->x, &ship->y);
+    if (length == 0 || (text[length] != 'h' && text[length] != 'v')) {
+        return 0;
+    }
+    ship->orientation = text[length] == 'v' ? 1 : 0;
+    return length + 1;
+}
+
+#ifdef _WIN32
+static double get_engine_time(void) {
+    return 0.0;
+}
+
+static bool write_engine_bytes(EngineProcess *engine, const void *data, size_t size) {
+    (void) data;
+    (void) size;
+    engine->error = ENGINE_CLOSED;
+    return false;
+}
+
+static bool fill_engine_buffer(EngineProcess *engine, double deadline) {
+    (void) deadline;
+    engine->error = ENGINE_CLOSED;
+    return false;
+}
+#else
+static double get_engine_time(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec * 1000.0 + (double) time.tv_nsec / 1e6;
+}
+
+static bool write_engine_bytes(EngineProcess *engine, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = write(engine->input, bytes + written, size - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            engine->error = ENGINE_CLOSED;
+            return false;
+        }
+        written += (size_t) result;
+    }
+    engine->bytes_sent += size;
+    return true;
+}
+
+static bool fill_engine_buffer(EngineProcess *engine, double deadline) {
+    if (engine->receive_size == ENGINE_BUFFER_SIZE) {
+        engine->error = ENGINE_INVALID;
+        return false;
+    }
+
+    // Wait for the engine to write, until the deadline
+    struct pollfd descriptor = {.fd = engine->output, .events = POLLIN};
+    for (;;) {
+        int timeout = (int) (deadline - get_engine_time());
+        int ready = poll(&descriptor, 1, timeout > 0 ? timeout : 0);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready == 0) {
+            engine->error = ENGINE_TIMEOUT;
+            return false;
+        }
+        break;
+    }
+
+    ssize_t received = read(engine->output, engine->receive_buffer + engine->receive_size,
+                            ENGINE_BUFFER_SIZE - engine->receive_size);
+    if (received <= 0) {
+        engine->error = ENGINE_CLOSED;
+        return false;
+    }
+    engine->receive_size += (size_t) received;
+    engine->bytes_received += (uint64_t) received;
+    return true;
+}
+#endif
+
+static bool send_engine_line(EngineProcess *engine, const char *format, ...) {
+    char line[ENGINE_LINE_LENGTH];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, arguments);
+    va_end(arguments);
+    if (length < 0 || length >= (int) sizeof(line) - 1) {
+        return false;
+    }
+    line[length++] = '\n';
+    return write_engine_bytes(engine, line, (size_t) length);
+}
+
+static bool read_engine_line(EngineProcess *engine, const char *keyword, char *line, int timeout) {
+    double deadline = get_engine_time() + timeout;
+    size_t keyword_length = strlen(keyword);
+    for (;;) {
+        // Take the whole lines of the buffer, a partial line waits for the rest
+        char *end = memchr(engine->receive_buffer, '\n', engine->receive_size);
+        while (end != NULL) {
+            size_t length = (size_t) (end - (char *) engine->receive_buffer);
+            size_t copied = length < ENGINE_LINE_LENGTH - 1 ? length : ENGINE_LINE_LENGTH - 1;
+            memcpy(line, engine->receive_buffer, copied);
+            line[copied] = '\0';
+            if (copied > 0 && line[copied - 1] == '\r') {
+                line[copied - 1] = '\0';
+            }
+            engine->receive_size -= length + 1;
+            memmove(engine->receive_buffer, end + 1, engine->receive_size);
+            if (strncmp(line, keyword, keyword_length) == 0 &&
+                (line[keyword_length] == ' ' || line[keyword_length] == '\0' || keyword_length == 0)) {
+                return true;
+            }
+            end = memchr(engine->receive_buffer, '\n', engine->receive_size);
+        }
+
+        if (!fill_engine_buffer(engine, deadline)) {
+            return false;
+        }
+    }
+}
+
+static bool send_engine_message(EngineProcess *engine, const NetMessage *message) {
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = encode_net_message(message, buffer);
+    return write_engine_bytes(engine, buffer, size);
+}
+
+static bool read_engine_message(EngineProcess *engine, NetMessageType type, NetMessage *message, int timeout) {
+    double deadline = get_engine_time() + timeout;
+    for (;;) {
+        int size = decode_net_message(engine->receive_buffer, engine->receive_size, message);
+        if (size < 0 || (size > 0 && message->type != type)) {
+            engine->error = ENGINE_INVALID;
+            return false;
+        }
+        if (size > 0) {
+            engine->receive_size -= (size_t) size;
+            memmove(engine->receive_buffer, engine->receive_buffer + size, engine->receive_size);
+            return true;
+        }
+
+        if (!fill_engine_buffer(engine, deadline)) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "net.h"
+
+#define ENGINE_DEFAULT_MOVETIME 1000
+#define ENGINE_GRACE_TIME 100
+#define ENGINE_HANDSHAKE_TIME 5000
+#define ENGINE_NAME_LENGTH 64
+#define ENGINE_LINE_LENGTH 256
+#define ENGINE_BUFFER_SIZE 1024
+
+// Protocol between a game and an external engine process, over the stdin and stdout of the engine
+//
+// The session starts in text mode, one command per line, like UCI. Cells are written as a column letter from A
+// (x = 0) and a row number from 1 (y = 0), ships as their first cell and h or v, for instance A1h or J7v.
+//
+//   > bsp                                Start of the session.
+//   < id name <name>                     Name of the engine, optional.
+//   < option binary                      The engine supports the binary mode, optional.
+//   < bspok                              End of the handshake.
+//   > newgame <seat> <movetime>          New game in seat 1 or 2, seat 1 shoots first, movetime ms per move.
+//   > fleet                              Asks for the fleet.
+//   < fleet <ship> x5                    The five ships, in the order of their sizes 5, 4, 3, 3 and 2.
+//   > shoot                              Asks for a shot.
+//   < shot <cell>                        A cell not shot yet.
+//   > result <cell> miss|hit             Result of the last shot of the engine.
+//   > result <cell> sunk <ship> <index>  Result of the last shot of the engine, with the sunk ship and its index.
+//   > incoming <cell>                    Shot of the opponent at the fleet of the engine, no answer.
+//   > gameover <seat>                    Seat of the winner.
+//   > quit                               End of the session.
+//
+// After the handshake, "binary <movetime>" answered by "binaryok" switches both directions to the messages of
+// net.h for the rest of the session. The engine then plays as a client of the match server: it sends PLACE, is
+// told its seat with START, sends SHOT when it is its turn and receives RESULT for its shots, SHOT for the shots
+// of the opponent and GAME_OVER, after which it sends PLACE for the next game. An engine speaking the binary
+// mode can play on battleship_server unchanged.
+//
+// An engine that answers late, with an invalid fleet or shot, or not at all, loses the game.
+
+// Enum for the reasons an engine failed to answer
+typedef enum {
+    ENGINE_OK,
+    ENGINE_TIMEOUT,
+    ENGINE_INVALID,
+    ENGINE_CLOSED
+} EngineError;
+
+// Structure for an engine process and the state of its session
+typedef struct {
+    int pid;
+    int input;
+    int output;
+    bool binary;
+    bool supports_binary;
+    int movetime;
+    int seat;
+    char name[ENGINE_NAME_LENGTH];
+    EngineError error;
+    float last_move_time;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    size_t receive_size;
+    uint8_t receive_buffer[ENGINE_BUFFER_SIZE];
+} EngineProcess;
+
+/// \brief Starts an engine process and runs the handshake.
+///
+/// The command is run by the shell, with its stdin and stdout connected to the game. Engines are not supported
+/// on Windows.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param command The command line of the engine.
+/// \param movetime The time allowed per move, in milliseconds.
+/// \param binary Whether to switch to the binary mode, if the engine supports it.
+/// \return bool Returns true if the engine completed the handshake, false otherwise.
+bool start_engine(EngineProcess *engine, const char *command, int movetime, bool binary);
+
+/// \brief Ends the session and waits for the engine process to exit, killing it if it does not.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \return void
+void stop_engine(EngineProcess *engine);
+
+/// \brief Starts a new game.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param seat The seat of the engine, 1 or 2.
+/// \return bool Returns true if the engine is still running, false otherwise.
+bool start_engine_game(EngineProcess *engine, int seat);
+
+/// \brief Asks the engine for its fleet.
+///
+/// The fleet is only parsed, the caller checks that the ships do not overlap.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param fleet The buffer receiving the positions of the ships.
+/// \return bool Returns true if the engine sent a fleet in time, false otherwise, see the error of the engine.
+bool get_engine_fleet(EngineProcess *engine, NetShip fleet[NET_FLEET_SIZE]);
+
+/// \brief Asks the engine for its next shot.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param x A pointer to the x-coordinate of the shot.
+/// \param y A pointer to the y-coordinate of the shot.
+/// \return bool Returns true if the engine sent a shot in time, false otherwise, see the error of the engine.
+bool get_engine_shot(EngineProcess *engine, uint8_t *x, uint8_t *y);
+
+/// \brief Sends the result of the last shot of the engine.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param x The x-coordinate of the shot.
+/// \param y The y-coordinate of the shot.
+/// \param result The NetShotResult of the shot.
+/// \param ship A pointer to the sunk ship, used if the result is NET_RESULT_SUNK.
+/// \return bool Returns true if the engine is still running, false otherwise.
+bool send_engine_result(EngineProcess *engine, int x, int y, NetShotResult result, const NetShip *ship);
+
+/// \brief Tells the engine where the opponent shot.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param x The x-coordinate of the shot.
+/// \param y The y-coordinate of the shot.
+/// \return bool Returns true if the engine is still running, false otherwise.
+bool send_engine_incoming(EngineProcess *engine, int x, int y);
+
+/// \brief Tells the engine that the game is over.
+///
+/// \param engine A pointer to the EngineProcess.
+/// \param winner The seat of the winner.
+/// \return bool Returns true if the engine is still running, false otherwise.
+bool end_engine_game(EngineProcess *engine, int winner);
+
+/// \brief Writes a cell in the notation of the text mode.
+///
+/// \param x The x-coordinate of the cell.
+/// \param y The y-coordinate of the cell.
+/// \param text The buffer receiving the text, at least 4 bytes long.
+/// \return void
+void format_engine_cell(int x, int y, char *text);
+
+/// \brief Reads a cell in the notation of the text mode.
+///
+/// \param text The text, such as "J10".
+/// \param x A pointer to the x-coordinate of the cell.
+/// \param y A pointer to the y-coordinate of the cell.
+/// \return int The number of characters read, or 0 if the text does not start with a cell.
+int parse_engine_cell(const char *text, uint8_t *x, uint8_t *y);
+
+/// \brief Reads a ship in the notation of the text mode.
+///
+/// \param text The text, such as "A1h".
+/// \param ship A pointer to the NetShip receiving the position, its index is not set.
+/// \return int The number of characters read, or 0 if the text does not start with a ship.
+int parse_engine_ship(const char *text, NetShip *ship);
+
+#endif // ENGINE_H
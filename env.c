@@ -0,0 +1,156 @@
+#include "env.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "rules.h"
+
+// The constants of the library do not depend on the headers of the game
+_Static_assert(BATTLESHIP_ENV_BOARD_SIZE == RULES_BOARD_SIZE, "board size of env.h and rules.h differ");
+_Static_assert(BATTLESHIP_ENV_NUM_SHIPS == RULES_NUM_SHIPS, "fleet size of env.h and rules.h differ");
+
+// Structure for the game in progress in one environment
+typedef struct {
+    CompactBoard board;
+    pcg32_random_t rng;
+    int32_t shots;
+} EnvGame;
+
+// Structure for a batch of environments, the observations of all environments are contiguous
+struct BattleshipEnvs {
+    int num_envs;
+    EnvGame *games;
+    float *planes;
+    float *sunk_ships;
+};
+
+/// \brief Starts a new game in one environment: a new fleet from its stream and empty observations.
+///
+/// \param envs A pointer to the batch.
+/// \param env_index The index of the environment.
+/// \return void
+static void start_env_game(BattleshipEnvs *envs, int env_index);
+
+int get_battleship_env_version(void) {
+    return BATTLESHIP_ENV_VERSION;
+}
+
+BattleshipEnvs *create_battleship_envs(int num_envs, uint64_t seed) {
+    if (num_envs <= 0) {
+        return NULL;
+    }
+
+    // Allocate the games and the observations
+    BattleshipEnvs *envs = calloc(1, sizeof(BattleshipEnvs));
+    if (envs == NULL) {
+        return NULL;
+    }
+    envs->num_envs = num_envs;
+    envs->games = calloc((size_t) num_envs, sizeof(EnvGame));
+    envs->planes = calloc((size_t) num_envs * BATTLESHIP_ENV_PLANES_SIZE, sizeof(float));
+    envs->sunk_ships = calloc((size_t) num_envs * BATTLESHIP_ENV_NUM_SHIPS, sizeof(float));
+    if (envs->games == NULL || envs->planes == NULL || envs->sunk_ships == NULL) {
+        destroy_battleship_envs(envs);
+        return NULL;
+    }
+
+    // Give each environment its own stream of the seed and start its first game
+    for (int i = 0; i < num_envs; i++) {
+        pcg32_srandom_r(&envs->games[i].rng, seed, (uint64_t) i);
+        start_env_game(envs, i);
+    }
+    return envs;
+}
+
+void destroy_battleship_envs(BattleshipEnvs *envs) {
+    if (envs == NULL) {
+        return;
+    }
+    free(envs->games);
+    free(envs->planes);
+    free(envs->sunk_ships);
+    free(envs);
+}
+
+int get_battleship_env_count(const BattleshipEnvs *envs) {
+    return envs->num_envs;
+}
+
+void seed_battleship_env(BattleshipEnvs *envs, int env_index, uint64_t seed) {
+    if (env_index < 0 || env_index >= envs->num_envs) {
+        return;
+    }
+    pcg32_srandom_r(&envs->games[env_index].rng, seed, (uint64_t) env_index);
+    start_env_game(envs, env_index);
+}
+
+void reset_battleship_envs(BattleshipEnvs *envs) {
+    for (int i = 0; i < envs->num_envs; i++) {
+        start_env_game(envs, i);
+    }
+}
+
+int step_battleship_envs(BattleshipEnvs *envs, const int32_t *actions, float *rewards, uint8_t *dones,
+                         int32_t *episode_shots) {
+    int num_done = 0;
+
+    for (int i = 0; i < envs->num_envs; i++) {
+        EnvGame *game = &envs->games[i];
+        float *planes = &envs->planes[(size_t) i * BATTLESHIP_ENV_PLANES_SIZE];
+        int32_t action = actions[i];
+
+        // Resolve the shot with the rules of the game, a cell outside the board or already shot is invalid
+        NetShip sunk_ship;
+        int result = -1;
+        if (action >= 0 && action < BATTLESHIP_ENV_NUM_CELLS) {
+            result = apply_compact_shot(&game->board, action / BATTLESHIP_ENV_BOARD_SIZE,
+                                        action % BATTLESHIP_ENV_BOARD_SIZE, &sunk_ship);
+        }
+        game->shots++;
+
+        // Only the cell that was shot changes in the observations
+        if (result < 0) {
+            rewards[i] = BATTLESHIP_ENV_REWARD_INVALID;
+        } else if (result == NET_RESULT_MISS) {
+            rewards[i] = BATTLESHIP_ENV_REWARD_MISS;
+            planes[BATTLESHIP_ENV_NUM_CELLS + action] = 1.0f;
+        } else {
+            rewards[i] = BATTLESHIP_ENV_REWARD_HIT;
+            planes[action] = 1.0f;
+            if (result == NET_RESULT_SUNK) {
+                envs->sunk_ships[(size_t) i * BATTLESHIP_ENV_NUM_SHIPS + sunk_ship.index] = 1.0f;
+            }
+        }
+
+        // Start the next game once the fleet is sunk or the game is too long
+        BattleshipEnvDone done = game->board.remaining_ships == 0 ? BATTLESHIP_ENV_WON
+                                 : game->shots >= BATTLESHIP_ENV_MAX_SHOTS ? BATTLESHIP_ENV_TRUNCATED
+                                 : BATTLESHIP_ENV_RUNNING;
+        dones[i] = (uint8_t) done;
+        if (episode_shots != NULL) {
+            episode_shots[i] = done != BATTLESHIP_ENV_RUNNING ? game->shots : 0;
+        }
+        if (done != BATTLESHIP_ENV_RUNNING) {
+            start_env_game(envs, i);
+            num_done++;
+        }
+    }
+    return num_done;
+}
+
+const float *get_battleship_env_planes(const BattleshipEnvs *envs) {
+    return envs->planes;
+}
+
+const float *get_battleship_env_sunk_ships(const BattleshipEnvs *envs) {
+    return envs->sunk_ships;
+}
+
+static void start_env_game(BattleshipEnvs *envs, int env_index) {
+    EnvGame *game = &envs->games[env_index];
+    place_random_compact_fleet(&game->board, &game->rng, NULL);
+    game->shots = 0;
+    memset(&envs->planes[(size_t) env_index * BATTLESHIP_ENV_PLANES_SIZE], 0,
+           BATTLESHIP_ENV_PLANES_SIZE * sizeof(float));
+    memset(&envs->sunk_ships[(size_t) env_index * BATTLESHIP_ENV_NUM_SHIPS], 0,
+           BATTLESHIP_ENV_NUM_SHIPS * sizeof(float));
+}
@@ -0,0 +1,132 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Version of the functions and constants below, raised whenever one of them changes
+#define BATTLESHIP_ENV_VERSION 1
+
+#define BATTLESHIP_ENV_BOARD_SIZE 10
+#define BATTLESHIP_ENV_NUM_CELLS (BATTLESHIP_ENV_BOARD_SIZE * BATTLESHIP_ENV_BOARD_SIZE)
+#define BATTLESHIP_ENV_NUM_SHIPS 5
+#define BATTLESHIP_ENV_NUM_PLANES 2
+#define BATTLESHIP_ENV_PLANES_SIZE (BATTLESHIP_ENV_NUM_PLANES * BATTLESHIP_ENV_NUM_CELLS)
+#define BATTLESHIP_ENV_MAX_SHOTS 200
+
+#define BATTLESHIP_ENV_REWARD_MISS 0.0f
+#define BATTLESHIP_ENV_REWARD_HIT 1.0f
+#define BATTLESHIP_ENV_REWARD_INVALID -1.0f
+
+// Symbols exported by the battleship_env shared library, every other symbol of the library is hidden
+#if defined(_WIN32) && defined(BATTLESHIP_ENV_BUILD)
+#define BATTLESHIP_ENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define BATTLESHIP_ENV_API __declspec(dllimport)
+#elif defined(BATTLESHIP_ENV_BUILD)
+#define BATTLESHIP_ENV_API __attribute__((visibility("default")))
+#else
+#define BATTLESHIP_ENV_API
+#endif
+
+// Batched environments for training shot policies, without any rendering
+//
+// Each environment is one game seen from the shooter: a random fleet is hidden on the board and every step fires
+// one shot at it. An action is the index of a cell, x * BATTLESHIP_ENV_BOARD_SIZE + y like the cells of the game.
+// All environments are stepped with one call, and an environment whose game is over starts the next game in the
+// same call, so the observations returned are always those of a game in progress.
+//
+// The observations are kept in contiguous float32 arrays owned by the batch and updated in place by each step:
+//   planes      [num_envs][BATTLESHIP_ENV_NUM_PLANES][BATTLESHIP_ENV_NUM_CELLS]  1 where a shot hit (plane 0) or
+//                                                                                 missed (plane 1), 0 elsewhere.
+//   sunk ships  [num_envs][BATTLESHIP_ENV_NUM_SHIPS]                              1 for each sunk ship, in the
+//                                                                                 order 5, 4, 3, 3 and 2 cells.
+//
+// A shot that hits or sinks a ship is rewarded with BATTLESHIP_ENV_REWARD_HIT, a miss with
+// BATTLESHIP_ENV_REWARD_MISS. A shot outside the board or at a cell already shot changes nothing and is rewarded
+// with BATTLESHIP_ENV_REWARD_INVALID. A game is done once the fleet is sunk, or truncated after
+// BATTLESHIP_ENV_MAX_SHOTS shots.
+//
+// Environment i draws its fleets from the pcg32 stream i of the seed of the batch, so its games do not depend on
+// the number of environments or on the other environments. A batch is not thread-safe, separate batches are.
+
+// Opaque handle to a batch of environments
+typedef struct BattleshipEnvs BattleshipEnvs;
+
+// Enum for the values of the done array
+typedef enum {
+    BATTLESHIP_ENV_RUNNING = 0,
+    BATTLESHIP_ENV_WON = 1,
+    BATTLESHIP_ENV_TRUNCATED = 2
+} BattleshipEnvDone;
+
+/// \brief Returns the version the library was built with, to compare with BATTLESHIP_ENV_VERSION.
+///
+/// \return int The version of the library.
+BATTLESHIP_ENV_API int get_battleship_env_version(void);
+
+/// \brief Creates a batch of environments, each with a new game.
+///
+/// \param num_envs The number of environments.
+/// \param seed The seed of the random streams of the environments.
+/// \return BattleshipEnvs* A pointer to the batch, or NULL if it could not be allocated.
+BATTLESHIP_ENV_API BattleshipEnvs *create_battleship_envs(int num_envs, uint64_t seed);
+
+/// \brief Frees a batch of environments.
+///
+/// \param envs A pointer to the batch, or NULL.
+/// \return void
+BATTLESHIP_ENV_API void destroy_battleship_envs(BattleshipEnvs *envs);
+
+/// \brief Returns the number of environments of a batch.
+///
+/// \param envs A pointer to the batch.
+/// \return int The number of environments.
+BATTLESHIP_ENV_API int get_battleship_env_count(const BattleshipEnvs *envs);
+
+/// \brief Reseeds the random stream of one environment and starts a new game in it.
+///
+/// \param envs A pointer to the batch.
+/// \param env_index The index of the environment.
+/// \param seed The seed of the stream.
+/// \return void
+BATTLESHIP_ENV_API void seed_battleship_env(BattleshipEnvs *envs, int env_index, uint64_t seed);
+
+/// \brief Starts a new game in every environment.
+///
+/// \param envs A pointer to the batch.
+/// \return void
+BATTLESHIP_ENV_API void reset_battleship_envs(BattleshipEnvs *envs);
+
+/// \brief Fires one shot in every environment and starts a new game in the environments whose game is over.
+///
+/// \param envs A pointer to the batch.
+/// \param actions The cell shot in each environment, num_envs values.
+/// \param rewards The buffer receiving the reward of each shot, num_envs values.
+/// \param dones The buffer receiving a BattleshipEnvDone per environment, num_envs values.
+/// \param episode_shots The buffer receiving the number of shots of each game that is over, 0 for the games in
+/// progress, num_envs values, or NULL.
+/// \return int The number of games that are over.
+BATTLESHIP_ENV_API int step_battleship_envs(BattleshipEnvs *envs, const int32_t *actions, float *rewards,
+                                            uint8_t *dones, int32_t *episode_shots);
+
+/// \brief Returns the hit and miss planes of all environments, updated in place by every step and reset.
+///
+/// \param envs A pointer to the batch.
+/// \return const float* A pointer to num_envs * BATTLESHIP_ENV_PLANES_SIZE floats, valid until the batch is freed.
+BATTLESHIP_ENV_API const float *get_battleship_env_planes(const BattleshipEnvs *envs);
+
+/// \brief Returns the sunk ships of all environments, updated in place by every step and reset.
+///
+/// \param envs A pointer to the batch.
+/// \return const float* A pointer to num_envs * BATTLESHIP_ENV_NUM_SHIPS floats, valid until the batch is freed.
+BATTLESHIP_ENV_API const float *get_battleship_env_sunk_ships(const BattleshipEnvs *envs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENV_H
@@ -0,0 +1,524 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "net.h"
+#include "rules.h"
+
+#define LOADGEN_DEFAULT_CLIENTS 1000
+#define LOADGEN_DEFAULT_MATCHES 10000
+#define LOADGEN_MAX_EVENTS 256
+#define LOADGEN_SAMPLE_INTERVAL 100
+#define LOADGEN_RECEIVE_SIZE (4 * NET_MAX_MESSAGE_SIZE)
+
+// Enum for the states of a simulated player
+typedef enum {
+    CLIENT_CONNECTING,
+    CLIENT_WAITING,
+    CLIENT_PLAYING,
+    CLIENT_CLOSED
+} ClientState;
+
+// Structure for a simulated player, which shoots at random cells it has not shot yet, or for a spectator
+//
+// A spectator follows any match and checks that every delta shoots a cell its view still shows as unknown.
+typedef struct {
+    NetSocket socket;
+    ClientState state;
+    bool spectator;
+    int seat;
+    bool shot_pending;
+    uint64_t shot_time;
+    CompactBoard board;
+    uint8_t shot_order[RULES_NUM_CELLS];
+    int next_shot;
+    int sunk_ships;
+    uint8_t view[2][RULES_NUM_CELLS];
+    pcg32_random_t rng;
+    size_t receive_size;
+    uint8_t receive_buffer[LOADGEN_RECEIVE_SIZE];
+} LoadClient;
+
+// Structure for the state and the measurements of the load generator
+typedef struct {
+    int epoll_fd;
+    LoadClient *clients;
+    int num_clients;
+    int num_spectators;
+    int open_clients;
+    int open_spectators;
+    NetMatchMode mode;
+    int target_matches;
+    int match_requests;
+    int finished_matches;
+    uint64_t shots;
+    uint64_t spectator_messages;
+    uint64_t spectator_bytes;
+    float *latencies;
+    size_t num_latencies;
+    size_t latency_capacity;
+} LoadGenerator;
+
+/// \brief Parses the options, connects the clients and plays matches until the target number is finished.
+///
+/// Usage: battleship_loadgen [--host <address>] [--port <port>] [--clients <n>] [--matches <n>] [--mode ai|pvp]
+/// [--spectators <n>] [--server-pid <pid>]. With --server-pid, the resident memory of the server is sampled to report
+/// how much it grows per concurrent match. The arena of the server is resident before the load starts, so the growth
+/// is what the matches use beyond it, plus fixed costs such as the first use of the AI threads. The spectators follow
+/// the matches of the clients and report the rate of the stream.
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 on success, 1 on failure.
+int main(int argc, char *argv[]);
+
+/// \brief Sends a message, waiting while the socket buffer is full.
+///
+/// \param client A pointer to the LoadClient.
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the message was sent, false otherwise.
+bool send_client_message(LoadClient *client, const NetMessage *message);
+
+/// \brief Places a new random fleet and asks the server for a match.
+///
+/// \param generator A pointer to the LoadGenerator.
+/// \param client A pointer to the LoadClient.
+/// \return bool Returns true if the request was sent, false otherwise.
+bool request_match(LoadGenerator *generator, LoadClient *client);
+
+/// \brief Asks the server for a match to follow.
+///
+/// \param client A pointer to the LoadClient of a spectator.
+/// \return bool Returns true if the request was sent, false otherwise.
+bool request_spectate(LoadClient *client);
+
+/// \brief Handles a message of the server for a spectator.
+///
+/// \param generator A pointer to the LoadGenerator.
+/// \param client A pointer to the LoadClient of the spectator.
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the message is consistent with the stream, false otherwise.
+bool handle_spectator_message(LoadGenerator *generator, LoadClient *client, const NetMessage *message);
+
+/// \brief Sends the next shot of a client.
+///
+/// \param generator A pointer to the LoadGenerator.
+/// \param client A pointer to the LoadClient.
+/// \return bool Returns true if the shot was sent, false otherwise.
+bool send_client_shot(LoadGenerator *generator, LoadClient *client);
+
+/// \brief Receives and handles the messages of the server for a client.
+///
+/// \param generator A pointer to the LoadGenerator.
+/// \param client A pointer to the LoadClient.
+/// \return bool Returns true if the client is still connected, false otherwise.
+bool receive_client_messages(LoadGenerator *generator, LoadClient *client);
+
+/// \brief Handles a message of the server for a client.
+///
+/// \param generator A pointer to the LoadGenerator.
+/// \param client A pointer to the LoadClient.
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the client is still connected, false otherwise.
+bool handle_server_message(LoadGenerator *generator, LoadClient *client, const NetMessage *message);
+
+/// \brief Closes the connection of a client.
+///
+/// \param generator A pointer to the LoadGenerator.
+/// \param client A pointer to the LoadClient.
+/// \return void
+void close_client(LoadGenerator *generator, LoadClient *client);
+
+/// \brief Records the time from a shot to its result.
+///
+/// \param generator A pointer to the LoadGenerator.
+/// \param milliseconds The latency in milliseconds.
+/// \return void
+void record_latency(LoadGenerator *generator, float milliseconds);
+
+/// \brief Compares two floats for qsort.
+///
+/// \param a A pointer to the first float.
+/// \param b A pointer to the second float.
+/// \return int The order of the floats.
+int compare_latencies(const void *a, const void *b);
+
+/// \brief Returns the value of the monotonic clock in microseconds.
+///
+/// \return uint64_t The time in microseconds.
+uint64_t get_time_us(void);
+
+/// \brief Returns the resident memory of a process.
+///
+/// \param pid The process id.
+/// \return size_t The resident memory in bytes, or 0 if it is not known.
+size_t get_process_memory(int pid);
+
+int main(int argc, char *argv[]) {
+    const char *host = "127.0.0.1";
+    int port = NET_DEFAULT_PORT;
+    int server_pid = 0;
+    LoadGenerator generator;
+    memset(&generator, 0, sizeof(generator));
+    generator.num_clients = LOADGEN_DEFAULT_CLIENTS;
+    generator.target_matches = LOADGEN_DEFAULT_MATCHES;
+    generator.mode = NET_MODE_AI;
+
+    // Parse the command-line options
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            generator.num_clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+            generator.target_matches = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            i++;
+            generator.mode = strcmp(argv[i], "pvp") == 0 ? NET_MODE_PVP : NET_MODE_AI;
+            valid = strcmp(argv[i], "pvp") == 0 || strcmp(argv[i], "ai") == 0;
+        } else if (strcmp(argv[i], "--spectators") == 0 && i + 1 < argc) {
+            generator.num_spectators = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--server-pid") == 0 && i + 1 < argc) {
+            server_pid = atoi(argv[++i]);
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || port <= 0 || port > 65535 || generator.num_clients <= 0 || generator.target_matches <= 0 ||
+        generator.num_spectators < 0 || (generator.mode == NET_MODE_PVP && generator.num_clients % 2 != 0)) {
+        printf("Usage: %s [--host <address>] [--port <port>] [--clients <n>] [--matches <n>] [--mode ai|pvp] "
+               "[--spectators <n>] [--server-pid <pid>]\n", argv[0]);
+        printf("In pvp mode the clients play each other, so their number must be even.\n");
+        return 1;
+    }
+
+    // Connect all clients, each one is registered for writability until its connection completes
+    //
+    // The spectators come after the players in the array of clients.
+    int num_connections = generator.num_clients + generator.num_spectators;
+    generator.epoll_fd = epoll_create1(0);
+    generator.clients = calloc(num_connections, sizeof(LoadClient));
+    if (generator.epoll_fd < 0 || generator.clients == NULL) {
+        printf("Could not allocate %d clients.\n", num_connections);
+        return 1;
+    }
+    size_t base_memory = server_pid > 0 ? get_process_memory(server_pid) : 0;
+    uint64_t start_time = get_time_us();
+    for (int i = 0; i < num_connections; i++) {
+        LoadClient *client = &generator.clients[i];
+        client->spectator = i >= generator.num_clients;
+        pcg32_srandom_r(&client->rng, start_time, (uint64_t) i);
+        client->socket = net_connect(host, (uint16_t) port);
+        if (client->socket == NET_INVALID_SOCKET) {
+            printf("Could not connect client %d: %s\n", i, strerror(errno));
+            client->state = CLIENT_CLOSED;
+            continue;
+        }
+        client->state = CLIENT_CONNECTING;
+        if (client->spectator) {
+            generator.open_spectators++;
+        } else {
+            generator.open_clients++;
+        }
+        struct epoll_event event = {.events = EPOLLOUT, .data.u32 = (uint32_t) i};
+        epoll_ctl(generator.epoll_fd, EPOLL_CTL_ADD, client->socket, &event);
+    }
+
+    // Play until the target number of matches is finished or every client is closed
+    struct epoll_event events[LOADGEN_MAX_EVENTS];
+    size_t peak_memory = base_memory;
+    uint64_t last_sample = get_time_us();
+    while (generator.open_clients > 0 && generator.finished_matches < generator.target_matches) {
+        int num_events = epoll_wait(generator.epoll_fd, events, LOADGEN_MAX_EVENTS, LOADGEN_SAMPLE_INTERVAL);
+        if (num_events < 0 && errno != EINTR) {
+            printf("epoll_wait failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < num_events; i++) {
+            LoadClient *client = &generator.clients[events[i].data.u32];
+            if (client->state == CLIENT_CLOSED) {
+                continue;
+            }
+            if (client->state == CLIENT_CONNECTING) {
+                if (!net_finish_connect(client->socket)) {
+                    printf("A client could not connect.\n");
+                    close_client(&generator, client);
+                    continue;
+                }
+                struct epoll_event event = {.events = EPOLLIN, .data.u32 = events[i].data.u32};
+                epoll_ctl(generator.epoll_fd, EPOLL_CTL_MOD, client->socket, &event);
+                if (client->spectator ? !request_spectate(client) : !request_match(&generator, client)) {
+                    close_client(&generator, client);
+                }
+            } else if (!receive_client_messages(&generator, client)) {
+                close_client(&generator, client);
+            }
+        }
+
+        // Sample the memory of the server while all matches are running
+        if (server_pid > 0 && get_time_us() - last_sample >= LOADGEN_SAMPLE_INTERVAL * 1000) {
+            size_t memory = get_process_memory(server_pid);
+            peak_memory = memory > peak_memory ? memory : peak_memory;
+            last_sample = get_time_us();
+        }
+    }
+    double elapsed = (double) (get_time_us() - start_time) / 1e6;
+
+    // Report the throughput and the latency percentiles
+    float p50 = 0.0f, p99 = 0.0f;
+    if (generator.num_latencies > 0) {
+        qsort(generator.latencies, generator.num_latencies, sizeof(float), compare_latencies);
+        p50 = generator.latencies[(generator.num_latencies - 1) * 50 / 100];
+        p99 = generator.latencies[(generator.num_latencies - 1) * 99 / 100];
+    }
+    printf("%d matches in %.2f s: %.0f matches/s, %llu shots, %.0f shots/s\n", generator.finished_matches, elapsed,
+           (double) generator.finished_matches / elapsed, (unsigned long long) generator.shots,
+           (double) generator.shots / elapsed);
+    printf("Shot latency: p50 %.3f ms, p99 %.3f ms\n", p50, p99);
+    if (generator.num_spectators > 0) {
+        printf("%d of %d spectators connected at the end: %llu messages, %.0f messages/s, %.1f bytes per message\n",
+               generator.open_spectators, generator.num_spectators,
+               (unsigned long long) generator.spectator_messages, (double) generator.spectator_messages / elapsed,
+               generator.spectator_messages > 0
+                   ? (double) generator.spectator_bytes / (double) generator.spectator_messages : 0.0);
+    }
+    if (server_pid > 0) {
+        int concurrent = generator.mode == NET_MODE_PVP ? generator.num_clients / 2 : generator.num_clients;
+        printf("Server memory: %.1f MB before, %.1f MB peak, %.0f bytes of growth per concurrent match\n",
+               (double) base_memory / (1024.0 * 1024.0), (double) peak_memory / (1024.0 * 1024.0),
+               (double) (peak_memory - base_memory) / concurrent);
+        printf("The growth excludes the arena allocated at startup and includes the fixed costs of the AI threads, "
+               "it is per match only with many clients\n");
+    }
+
+    for (int i = 0; i < num_connections; i++) {
+        close_client(&generator, &generator.clients[i]);
+    }
+    close(generator.epoll_fd);
+    free(generator.clients);
+    free(generator.latencies);
+    return generator.finished_matches >= generator.target_matches ? 0 : 1;
+}
+
+bool send_client_message(LoadClient *client, const NetMessage *message) {
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = encode_net_message(message, buffer);
+    size_t sent = 0;
+    while (sent < size) {
+        int result = net_send(client->socket, buffer + sent, size - sent);
+        if (result < 0 || (result == 0 && net_wait(client->socket, true, 1000) <= 0)) {
+            return false;
+        }
+        sent += result;
+    }
+    return true;
+}
+
+bool request_match(LoadGenerator *generator, LoadClient *client) {
+    // Stop asking for matches once enough were requested to reach the target, a pvp match takes two requests
+    int requests_per_match = generator->mode == NET_MODE_PVP ? 2 : 1;
+    if (generator->match_requests >= generator->target_matches * requests_per_match) {
+        return false;
+    }
+    generator->match_requests++;
+
+    // Place a new fleet and shuffle the order of the shots
+    NetMessage message = {.type = NET_MSG_PLACE, .mode = generator->mode};
+    place_random_compact_fleet(&client->board, &client->rng, message.fleet);
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        client->shot_order[i] = (uint8_t) i;
+    }
+    for (int i = RULES_NUM_CELLS - 1; i > 0; i--) {
+        int j = (int) pcg32_boundedrand_r(&client->rng, (uint32_t) (i + 1));
+        uint8_t cell = client->shot_order[i];
+        client->shot_order[i] = client->shot_order[j];
+        client->shot_order[j] = cell;
+    }
+    client->next_shot = 0;
+    client->sunk_ships = 0;
+    client->shot_pending = false;
+    client->state = CLIENT_WAITING;
+    return send_client_message(client, &message);
+}
+
+bool request_spectate(LoadClient *client) {
+    NetMessage message = {.type = NET_MSG_SPECTATE, .match = NET_ANY_MATCH};
+    client->state = CLIENT_WAITING;
+    return send_client_message(client, &message);
+}
+
+bool handle_spectator_message(LoadGenerator *generator, LoadClient *client, const NetMessage *message) {
+    generator->spectator_messages++;
+    switch (message->type) {
+        case NET_MSG_SNAPSHOT:
+            memcpy(client->view, message->view, sizeof(client->view));
+            client->state = CLIENT_PLAYING;
+            return true;
+
+        case NET_MSG_DELTA: {
+            // The seat of a delta is the shooter, the shot lands on the board of the other seat
+            uint8_t *cell = &client->view[2 - message->seat][message->x * RULES_BOARD_SIZE + message->y];
+            if (client->state != CLIENT_PLAYING || *cell != NET_CELL_UNKNOWN) {
+                return false;
+            }
+            *cell = message->result == NET_RESULT_MISS ? NET_CELL_MISS : NET_CELL_HIT;
+            return true;
+        }
+
+        case NET_MSG_GAME_OVER:
+            // Follow the next match
+            return request_spectate(client);
+
+        default:
+            return false;
+    }
+}
+
+bool send_client_shot(LoadGenerator *generator, LoadClient *client) {
+    if (client->next_shot >= RULES_NUM_CELLS) {
+        return false;
+    }
+    uint8_t cell = client->shot_order[client->next_shot++];
+    NetMessage message = {.type = NET_MSG_SHOT, .x = (uint8_t) (cell / RULES_BOARD_SIZE),
+                          .y = (uint8_t) (cell % RULES_BOARD_SIZE)};
+    client->shot_pending = true;
+    client->shot_time = get_time_us();
+    generator->shots++;
+    return send_client_message(client, &message);
+}
+
+bool receive_client_messages(LoadGenerator *generator, LoadClient *client) {
+    int received = net_receive(client->socket, client->receive_buffer + client->receive_size,
+                               LOADGEN_RECEIVE_SIZE - client->receive_size);
+    if (received < 0) {
+        return false;
+    }
+    client->receive_size += received;
+
+    size_t offset = 0;
+    for (;;) {
+        NetMessage message;
+        int size = decode_net_message(client->receive_buffer + offset, client->receive_size - offset, &message);
+        if (size == 0) {
+            break;
+        }
+        if (size < 0) {
+            return false;
+        }
+        if (client->spectator) {
+            generator->spectator_bytes += size;
+            if (!handle_spectator_message(generator, client, &message)) {
+                return false;
+            }
+        } else if (!handle_server_message(generator, client, &message)) {
+            return false;
+        }
+        offset += size;
+    }
+    memmove(client->receive_buffer, client->receive_buffer + offset, client->receive_size - offset);
+    client->receive_size -= offset;
+    return true;
+}
+
+bool handle_server_message(LoadGenerator *generator, LoadClient *client, const NetMessage *message) {
+    switch (message->type) {
+        case NET_MSG_START:
+            // Seat 1 shoots first
+            client->seat = message->seat;
+            client->state = CLIENT_PLAYING;
+            return client->seat != 1 || send_client_shot(generator, client);
+
+        case NET_MSG_RESULT:
+            if (!client->shot_pending) {
+                return false;
+            }
+            client->shot_pending = false;
+            record_latency(generator, (float) (get_time_us() - client->shot_time) / 1000.0f);
+
+            // A hit lets the client shoot again, unless it sunk the last ship and the game is over
+            if (message->result == NET_RESULT_SUNK) {
+                client->sunk_ships++;
+            }
+            if (message->result != NET_RESULT_MISS && client->sunk_ships < RULES_NUM_SHIPS) {
+                return send_client_shot(generator, client);
+            }
+            return true;
+
+        case NET_MSG_SHOT:
+            // The turn comes back once the opponent misses
+            if (apply_compact_shot(&client->board, message->x, message->y, NULL) == NET_RESULT_MISS) {
+                return send_client_shot(generator, client);
+            }
+            return true;
+
+        case NET_MSG_GAME_OVER:
+            // In pvp mode both players of a match receive the message, only the first seat counts it
+            if (generator->mode == NET_MODE_AI || client->seat == 1) {
+                generator->finished_matches++;
+            }
+            client->state = CLIENT_WAITING;
+            return request_match(generator, client);
+
+        default:
+            return false;
+    }
+}
+
+void close_client(LoadGenerator *generator, LoadClient *client) {
+    if (client->state == CLIENT_CLOSED) {
+        return;
+    }
+    epoll_ctl(generator->epoll_fd, EPOLL_CTL_DEL, client->socket, NULL);
+    net_close(client->socket);
+    client->state = CLIENT_CLOSED;
+    if (client->spectator) {
+        generator->open_spectators--;
+    } else {
+        generator->open_clients--;
+    }
+}
+
+void record_latency(LoadGenerator *generator, float milliseconds) {
+    if (generator->num_latencies == generator->latency_capacity) {
+        size_t capacity = generator->latency_capacity > 0 ? 2 * generator->latency_capacity : 4096;
+        float *latencies = realloc(generator->latencies, capacity * sizeof(float));
+        if (latencies == NULL) {
+            return;
+        }
+        generator->latencies = latencies;
+        generator->latency_capacity = capacity;
+    }
+    generator->latencies[generator->num_latencies++] = milliseconds;
+}
+
+int compare_latencies(const void *a, const void *b) {
+    float difference = *(const float *) a - *(const float *) b;
+    return (difference > 0) - (difference < 0);
+}
+
+uint64_t get_time_us(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000 + (uint64_t) time.tv_nsec / 1000;
+}
+
+size_t get_process_memory(int pid) {
+    // The second field of statm is the number of resident pages
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    unsigned long size, resident;
+    int count = fscanf(file, "%lu %lu", &size, &resident);
+    fclose(file);
+    return count == 2 ? (size_t) resident * (size_t) sysconf(_SC_PAGESIZE) : 0;
+}
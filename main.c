@@ -6,17 +6,70 @@
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <pthread.h>
 #include <SDL_ttf.h>
 #include <SDL_image.h>
 #include "pcg_basic.h"
+#include "asset_bundle.h"
+#include "net.h"
+#include "engine.h"
+#include "policy.h"
 #include <SDL_thread.h>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 // Define constants for the game
 #define NUM_SHIPS 5
 #define CELL_SIZE 32
 #define BOARD_SIZE 10
+#define MAX_HIT_SEGMENTS 5
+#define SAVE_FILE_NAME "saved_game.dat"
+#define SAVE_TEMP_FILE_NAME "saved_game.dat.tmp"
+#define GLYPH_FIRST 32
+#define GLYPH_COUNT 95
+#define GLYPH_ATLAS_WIDTH 512
+#define MAX_GLYPH_ATLASES 4
+#define TEXT_CACHE_SIZE 64
+#define MAX_CACHED_TEXT_LENGTH 48
+#define QUAD_BATCH_CAPACITY 256
+#define MAX_BOARD_LAYERS 8
+#define MAX_SHOT_HEATMAPS 4
+#define SHOT_HEATMAP_MAX_ALPHA 176
+#define MAX_SHARED_TEXTURES 64
+#define MAX_DECODE_THREADS 8
+#define MAX_DECODE_JOBS 128
+#define MENU_ANIMATION_FRAMES 50
+#define MENU_ANIMATION_FPS 24
+#define ANIMATION_RING_SIZE 4
+#define IDLE_WAIT_TIMEOUT 500
+#define FRAME_STATS_CAPACITY 4096
+#define MAX_PROFILE_ENTRIES 128
+#define MAX_TWEENS 32
+#define SHOT_MARKER_DURATION 500
+#define SINK_FLASH_DURATION 800
+#define TURN_BANNER_DURATION 1200
+#define COMPUTER_SHOT_DURATION 1000
+#define POLICY_MOVE_BUDGET 2
+#define POLICY_BUDGET_RUNS 20
+#define PONDER_CACHE_SIZE 8
+#define PONDER_MAX_REPLIES 7
+#define WIN_MESSAGE_DURATION 3000
+#define RENDER_PROFILE_FILE_NAME "render_profile.csv"
+#define RENDER_TEST_DEFAULT_FRAMES 100
+#define RENDER_TEST_TOLERANCE 8
+#define MAX_WIDGETS 16
+#define MAX_WIDGET_LABEL_LENGTH 32
+#define WIDGET_SHADOW_OFFSET 4
+#define NET_INBOX_CAPACITY 32
+#define NET_WAIT_INTERVAL 100
+#define NET_FULL_INBOX_DELAY 5
+#define NET_SEND_TIMEOUT 1000
 
 // Structure for representing a cell on the game board
 typedef struct {
@@ -55,21 +108,208 @@ typedef struct {
     Ship ships[NUM_SHIPS];
 } Player;
 
-// Structure for holding game textures
+// Enum for representing the tiles packed in the game texture atlas
+typedef enum {
+    TILE_OCEAN,
+    TILE_OCEAN_SELECTION_MODE,
+    TILE_SHIP_TOP,
+    TILE_SHIP_LEFT,
+    TILE_SHIP_MIDDLE,
+    TILE_SHIP_RIGHT,
+    TILE_SHIP_BOTTOM,
+    TILE_HIT_ENEMY_SHIP,
+    TILE_HIT_OWN_SHIP,
+    TILE_HIT_OCEAN,
+    TILE_MISS,
+    TILE_COUNT
+} Tile;
+
+// Structure for holding game textures, all tiles are packed into one atlas texture
 typedef struct {
-    SDL_Texture *ocean;
-    SDL_Texture *ocean_selection_mode;
-    SDL_Texture *ship_top;
-    SDL_Texture *ship_left;
-    SDL_Texture *ship_middle;
-    SDL_Texture *ship_right;
-    SDL_Texture *ship_bottom;
-    SDL_Texture *hit_enemy_ship;
-    SDL_Texture *hit_own_ship;
-    SDL_Texture *hit_ocean;
-    SDL_Texture *miss;
+    SDL_Texture *atlas;
+    SDL_Rect tiles[TILE_COUNT];
 } GameTextures;
 
+// Structure for collecting textured quads that are drawn with a single SDL_RenderGeometry call
+typedef struct {
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    SDL_Color modulation;
+    float u_scale;
+    float v_scale;
+    int num_quads;
+    SDL_Vertex vertices[QUAD_BATCH_CAPACITY * 4];
+} QuadBatch;
+
+// Structure for an animation streamed from its frame images through a small ring of textures
+typedef struct {
+    SDL_Renderer *renderer;
+    char filepath[96];
+    int num_frames;
+    Uint64 frame_duration;
+    Uint64 start_time;
+    SDL_Texture *ring[ANIMATION_RING_SIZE];
+    int ring_frames[ANIMATION_RING_SIZE];
+    int current_frame;
+    int target_frame;
+} AnimationPlayer;
+
+// Enum for representing the ways a widget is drawn
+typedef enum {
+    WIDGET_BUTTON,
+    WIDGET_TEXT,
+    WIDGET_LINK,
+    WIDGET_AREA
+} WidgetStyle;
+
+// Structure for a widget of a screen, drawn into its own texture that is redrawn only when its look changes
+typedef struct {
+    WidgetStyle style;
+    SDL_Rect rect;
+    SDL_Point label_offset;
+    char label[MAX_WIDGET_LABEL_LENGTH];
+    bool visible;
+    bool enabled;
+    bool hovered;
+    SDL_Texture *texture;
+    bool dirty;
+} Widget;
+
+// Structure for the widgets of a screen, hit-tested once per event
+typedef struct {
+    Widget widgets[MAX_WIDGETS];
+    int num_widgets;
+    int hovered_widget;
+} WidgetTree;
+
+// Structure for a texture shared between screens, loaded once and released by reference count
+typedef struct {
+    char filename[128];
+    SDL_Texture *texture;
+    int ref_count;
+} SharedTexture;
+
+// Structure for the window, renderer and textures shared by all screens
+typedef struct {
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    GameTextures *textures;
+    SharedTexture shared_textures[MAX_SHARED_TEXTURES];
+    int num_shared_textures;
+    SDL_Surface *target;
+} SceneManager;
+
+// Structure for the command-line options of the game
+typedef struct {
+    bool vsync;
+    bool show_frame_stats;
+    const char *frame_stats_log;
+    const char *render_profile_file;
+    const char *render_test_dir;
+    const char *golden_dir;
+    int render_test_frames;
+    float animation_speed;
+    bool instant_animations;
+    bool net_host;
+    bool net_spectate;
+    const char *net_address;
+    int net_port;
+    const char *engine_command;
+    int engine_movetime;
+    const char *policy_file;
+    bool show_shot_heatmap;
+} GameOptions;
+
+// Enum for representing the scenes drawn by the render test
+typedef enum {
+    RENDER_TEST_MAIN_MENU,
+    RENDER_TEST_PLACEMENT,
+    RENDER_TEST_GAME,
+    RENDER_TEST_SCENE_COUNT
+} RenderTestScene;
+
+// Structure for the scripted state the render test scenes are drawn from
+typedef struct {
+    AnimationPlayer background;
+    WidgetTree menu_widgets;
+    SDL_Texture *black_texture;
+    SDL_Texture *placement_background;
+    SDL_Texture *game_background;
+    Player placement_player;
+    Player player1;
+    Player player2;
+} RenderTestState;
+
+// Structure for the frame-time statistics of the current screen
+typedef struct {
+    const char *screen_name;
+    float frame_times[FRAME_STATS_CAPACITY];
+    int num_frame_times;
+    int next_frame_time;
+    Uint64 num_frames;
+    Uint64 frame_start;
+    Uint64 frame_start_draw_calls;
+    Uint64 last_frame_draw_calls;
+    Uint64 total_draw_calls;
+    Uint64 text_cache_hits;
+    Uint64 text_cache_misses;
+    float input_latencies[FRAME_STATS_CAPACITY];
+    int num_input_latencies;
+    int next_input_latency;
+    Uint64 pending_input_time;
+    Uint64 frame_input_time;
+} FrameStats;
+
+// Enum for representing the kinds of SDL calls counted by the render profiler
+typedef enum {
+    PROFILE_DRAW_CALL,
+    PROFILE_TEXTURE_UPLOAD,
+    PROFILE_TEXT_RENDER,
+    PROFILE_CALL_KIND_COUNT
+} ProfileCallKind;
+
+// Structure for the counters of one render function, or of the screen loop itself, on one screen
+typedef struct {
+    const char *screen_name;
+    const char *zone_name;
+    Uint64 num_entries;
+    Uint64 zone_ticks;
+    Uint64 call_counts[PROFILE_CALL_KIND_COUNT];
+    Uint64 call_ticks[PROFILE_CALL_KIND_COUNT];
+} ProfileEntry;
+
+// Structure for a render function being profiled, returned by begin_profile_zone
+typedef struct {
+    const char *previous_zone;
+    Uint64 start;
+} ProfileZone;
+
+// Structure for the render profiler, which attributes SDL calls to the innermost profiled render function
+typedef struct {
+    bool enabled;
+    const char *zone_name;
+    Uint64 call_start;
+    int last_entry;
+    int num_entries;
+    ProfileEntry entries[MAX_PROFILE_ENTRIES];
+} RenderProfiler;
+
+// Enum for representing the ways a board is shown
+typedef enum {
+    BOARD_VIEW_OWN,
+    BOARD_VIEW_OPPONENT,
+    BOARD_VIEW_PLACEMENT
+} BoardView;
+
+// Structure for a board rendered into a render-target texture, redrawn only when it is dirty
+typedef struct {
+    const GameBoard *board;
+    BoardView view;
+    int variant;
+    SDL_Texture *texture;
+    bool dirty;
+} BoardLayer;
+
 // Enum for representing the main menu options
 typedef enum {
     MAIN_MENU_NEW_GAME_PVP,
@@ -78,18 +318,27 @@ typedef enum {
     MAIN_MENU_EXIT
 } MainMenuOption;
 
-// Struct to store the data of the placement phase buttons
-typedef struct ButtonData {
-    SDL_Rect exit_button;
-    SDL_Rect orientation_button;
-    SDL_Rect reset_button;
-    SDL_Rect random_button;
-    SDL_Rect finish_button;
-    bool hover_orientation;
-    bool hover_reset;
-    bool hover_random;
-    bool hover_finish;
-} ButtonData;
+// Enum for representing the widgets of the placement phase screen, the ships to select come last
+typedef enum {
+    PLACEMENT_WIDGET_EXIT,
+    PLACEMENT_WIDGET_ORIENTATION,
+    PLACEMENT_WIDGET_RESET,
+    PLACEMENT_WIDGET_RANDOM,
+    PLACEMENT_WIDGET_FINISH,
+    PLACEMENT_WIDGET_FIRST_SHIP
+} PlacementWidget;
+
+// Enum for representing the widgets of the game screen
+typedef enum {
+    GAME_WIDGET_SAVE,
+    GAME_WIDGET_EXIT,
+    GAME_WIDGET_FINISH_TURN
+} GameWidget;
+
+// Enum for representing the widgets of the spectator screen
+typedef enum {
+    SPECTATE_WIDGET_EXIT
+} SpectateWidget;
 
 // Enum for representing the current state of the AI
 typedef enum {
@@ -116,12 +365,216 @@ typedef struct AI_Context {
     bool direction_fully_explored;
     int dx[4];
     int dy[4];
-    int hit_segments[5][2];
+    int hit_segments[MAX_HIT_SEGMENTS][2];
     int remaining_cells[BOARD_SIZE * BOARD_SIZE][2];
     int dir_indices[4];
+    int dir_indices_revisit[2];
     int remaining_cells_count;
 } AI_Context;
 
+// Structure for the AI shot probabilities shaded over a board, recomputed only when a shot changes what is known
+typedef struct {
+    const GameBoard *board;
+    uint8_t view[RULES_NUM_CELLS];
+    AI_State ai_state;
+    int num_quads;
+    SDL_Vertex vertices[BOARD_SIZE * BOARD_SIZE * 4];
+} ShotHeatmap;
+
+// Struct to store the result of one shot of the computer
+typedef struct ComputerShot {
+    bool has_shot;
+    bool hit;
+    int x;
+    int y;
+} ComputerShot;
+
+// Enum for representing the kinds of visual events played by the timeline
+typedef enum {
+    TWEEN_SHOT_MARKER,
+    TWEEN_SINK_FLASH,
+    TWEEN_TURN_BANNER,
+    TWEEN_WIN_MESSAGE
+} TweenKind;
+
+// Struct to store a visual event animated over time
+typedef struct Tween {
+    TweenKind kind;
+    Uint64 start;
+    Uint64 duration;
+    SDL_Rect rect;
+    int value;
+} Tween;
+
+// Struct to store the visual events being played, and until when the game waits for them
+typedef struct Timeline {
+    Tween tweens[MAX_TWEENS];
+    int num_tweens;
+    Uint64 hold_until;
+} Timeline;
+
+// Struct to store a copy of the game state handed to the save thread
+typedef struct SaveSnapshot {
+    Player player1;
+    Player player2;
+    int current_turn;
+    AI_State ai_state;
+} SaveSnapshot;
+
+// Struct to store the state of the background save thread
+typedef struct SaveWorker {
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *condition;
+    SaveSnapshot pending;
+    bool has_pending;
+    bool quit;
+    Uint32 complete_event;
+} SaveWorker;
+
+// Structure for a shot of the policy network worked out ahead of time, for an observation of the human's board
+typedef struct {
+    bool valid;
+    unsigned generation;
+    uint8_t view[RULES_NUM_CELLS];
+    uint8_t sunk_ships[RULES_NUM_SHIPS];
+    uint8_t x;
+    uint8_t y;
+} PonderEntry;
+
+// Structure for the thread working out the next shots of the policy network while the human is thinking
+typedef struct {
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *condition;
+    uint8_t root_view[RULES_NUM_CELLS];
+    uint8_t root_sunk_ships[RULES_NUM_SHIPS];
+    bool has_root;
+    bool quit;
+    unsigned generation;
+    PonderEntry cache[PONDER_CACHE_SIZE];
+    int hits;
+    int misses;
+} PonderWorker;
+
+// Structure for the thread waiting for the shots of the engine, so the game keeps drawing frames meanwhile
+typedef struct {
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *condition;
+    EngineProcess *engine;
+    Uint32 answer_event;
+    bool has_request;
+    bool has_answer;
+    bool valid;
+    uint8_t x;
+    uint8_t y;
+    bool quit;
+} EngineWorker;
+
+// Structure for the connection to the game process of the opponent in a networked game
+typedef struct {
+    bool active;
+    bool is_host;
+    bool is_spectator;
+    NetSocket listener;
+    NetSocket socket;
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_atomic_t quit;
+    Uint32 wake_event;
+    bool connected;
+    bool disconnected;
+    NetMessage inbox[NET_INBOX_CAPACITY];
+    int inbox_start;
+    int num_inbox;
+    Uint64 bytes_received;
+    Uint64 bytes_sent;
+    bool fleet_sent;
+    bool fleet_revealed;
+    uint8_t salt[NET_SALT_SIZE];
+    NetShip fleet[NET_FLEET_SIZE];
+    bool has_opponent_fleet;
+    uint8_t opponent_commitment[NET_COMMITMENT_SIZE];
+    bool opponent_left;
+    bool shot_pending;
+    int shot_x;
+    int shot_y;
+    Uint64 shot_time;
+    float shot_round_trips[BOARD_SIZE * BOARD_SIZE];
+    int num_shot_round_trips;
+} NetSession;
+
+// Enum for representing the state of an image decode job
+typedef enum {
+    DECODE_JOB_FREE,
+    DECODE_JOB_QUEUED,
+    DECODE_JOB_RUNNING,
+    DECODE_JOB_DONE
+} DecodeJobState;
+
+// Struct to store an image decoded on a worker thread
+typedef struct DecodeJob {
+    DecodeJobState state;
+    char filename[128];
+    Uint64 sequence;
+    SDL_Surface *surface;
+    bool discard;
+} DecodeJob;
+
+// Struct to store the state of the image decoding worker threads
+typedef struct DecodePool {
+    SDL_Thread *threads[MAX_DECODE_THREADS];
+    int num_threads;
+    SDL_mutex *mutex;
+    SDL_cond *job_queued;
+    SDL_cond *job_done;
+    DecodeJob jobs[MAX_DECODE_JOBS];
+    Uint64 next_sequence;
+    bool quit;
+} DecodePool;
+
+// Struct to store the position and advance of a glyph inside a glyph atlas
+typedef struct Glyph {
+    SDL_Rect rect;
+    int advance;
+} Glyph;
+
+// Struct to store the printable ASCII glyphs of a font, rasterised once into a single texture
+typedef struct GlyphAtlas {
+    TTF_Font *font;
+    SDL_Texture *texture;
+    int texture_width;
+    int texture_height;
+    int line_height;
+    Glyph glyphs[GLYPH_COUNT];
+} GlyphAtlas;
+
+// Struct to store a laid-out string as textured quads into a glyph atlas
+typedef struct CachedText {
+    bool used;
+    Uint32 hash;
+    GlyphAtlas *atlas;
+    SDL_Color color;
+    char text[MAX_CACHED_TEXT_LENGTH + 1];
+    int width;
+    int height;
+    int num_glyphs;
+    SDL_Vertex vertices[MAX_CACHED_TEXT_LENGTH * 4];
+    Uint64 last_used;
+} CachedText;
+
+// Struct to store the glyph atlases and the least recently used cache of laid-out strings
+typedef struct TextCache {
+    SDL_Renderer *renderer;
+    GlyphAtlas atlases[MAX_GLYPH_ATLASES];
+    int num_atlases;
+    CachedText entries[TEXT_CACHE_SIZE];
+    Uint64 clock;
+    Uint64 hits;
+    Uint64 misses;
+} TextCache;
+
 // Function prototypes
 
 /// \brief Save the current game state to a file.
@@ -149,2984 +602,7952 @@ bool save_game(Player *player1, Player *player2, int current_turn, AI_State *ai_
 /// \return true if the game state is loaded successfully, false otherwise.
 bool load_game(Player *player1, Player *player2, int *current_turn, AI_State *ai_state);
 
-/// \brief Loads an SDL_Texture from a given file.
+/// \brief Write a game state snapshot to the save file.
 ///
-/// Loads an image file and converts it to an SDL_Texture using the provided SDL_Renderer.
+/// Writes the snapshot to a temporary file, flushes it to disk and then renames it over "saved_game.dat",
+/// so an interrupted write never leaves a truncated save behind. The file layout is the same one read by load_game.
 ///
-/// \param filename A string representing the path to the image file.
-/// \param renderer A pointer to an SDL_Renderer.
-/// \return SDL_Texture* A pointer to the loaded SDL_Texture or NULL if the operation fails.
-SDL_Texture *load_texture(const char *filename, SDL_Renderer *renderer);
+/// \param snapshot Pointer to the SaveSnapshot to be written.
+/// \return true if the snapshot is written successfully, false otherwise.
+bool write_save_file(const SaveSnapshot *snapshot);
 
-/// \brief Loads all game textures.
+/// \brief The body of the background save thread.
 ///
-/// Allocates memory for a GameTextures structure and loads individual game textures using the provided SDL_Renderer.
+/// Waits for snapshots handed over by request_save, writes them with write_save_file and reports the result
+/// by pushing a save complete event (user.code is 1 on success, 0 on failure) to the SDL event queue.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \return GameTextures* A pointer to the loaded GameTextures structure or NULL if the operation fails.
-GameTextures *load_game_textures(SDL_Renderer *renderer);
+/// \param data Pointer to the SaveWorker that owns the thread.
+/// \return int Always 0.
+int save_worker_thread(void *data);
 
-/// \brief Loads an animated background.
+/// \brief Start the background save thread.
 ///
-/// Loads a sequence of image files representing the frames of an animated background.
+/// Registers the save complete event type and creates the thread, mutex and condition variable used to hand
+/// snapshots to it. Must be called after SDL_Init.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param filepath A string representing the path to the image files without the frame number and file extension.
-/// \param num_frames An int representing the number of frames in the animation.
-/// \return SDL_Texture** An array of pointers to the loaded SDL_Textures or NULL if the operation fails.
-SDL_Texture **load_animated_background(SDL_Renderer *renderer, const char *filepath, int num_frames);
+/// \return true if the thread was started, false otherwise (saves then happen synchronously).
+bool start_save_worker(void);
 
-/// \brief Renders text using the global font variable.
+/// \brief Stop the background save thread.
 ///
-/// Renders a given text at the specified position using the global font and the provided SDL_Renderer.
+/// Lets the thread finish any pending write, then joins it and frees its synchronization primitives.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param text A string representing the text to be rendered.
-/// \param font A pointer to an SDL_Font.
-/// \param x The x-coordinate of the text's position.
-/// \param y The y-coordinate of the text's position.
 /// \return void
-void render_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y);
+void stop_save_worker(void);
 
-/// \brief Renders colored text using the global font variable.
+/// \brief Request the game state to be saved in the background.
 ///
-/// Renders a given text at the specified position with the specified color using the global font and the provided SDL_Renderer.
+/// Copies the game state into a snapshot and hands it to the save thread, so no file I/O happens on the calling
+/// thread. If a previous snapshot is still waiting to be written, it is replaced by the newer one. When the save
+/// thread is not running, the game is saved synchronously and the completion event is still pushed.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param text A string representing the text to be rendered.
-/// \param font A pointer to an SDL_Font.
-/// \param x The x-coordinate of the text's position.
-/// \param y The y-coordinate of the text's position.
-/// \param r The red component of the text color.
-/// \param g The green component of the text color.
-/// \param b The blue component of the text color.
+/// \param player1 Pointer to the first player's data.
+/// \param player2 Pointer to the second player's data.
+/// \param current_turn Integer representing the current turn (1 or 2).
+/// \param ai_state Pointer to the AI_State, or NULL if there is no computer player.
 /// \return void
-void render_colored_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y, int r, int g, int b);
+void request_save(Player *player1, Player *player2, int current_turn, AI_State *ai_state);
 
-/// \brief Determines if the mouse is inside a button.
+/// \brief Get the event type pushed when a background save completes.
 ///
-/// Checks if the given mouse coordinates are within the boundaries of an SDL_Rect
-/// button.
+/// \return Uint32 The registered event type, or (Uint32) -1 if the save thread was never started.
+Uint32 get_save_complete_event(void);
+
+/// \brief Decodes an image file into a surface in the format used by the textures.
 ///
-/// \param x The x-coordinate of the mouse.
-/// \param y The y-coordinate of the mouse.
-/// \param button_rect An SDL_Rect representing the button's position and dimensions.
-/// \return int Returns 1 if the mouse is inside the button, 0 otherwise.
-int is_mouse_inside_button(int x, int y, SDL_Rect button_rect);
+/// \param filename The path to the image file.
+/// \return SDL_Surface* The decoded surface, or NULL if the image could not be loaded.
+SDL_Surface *decode_image(const char *filename);
 
-/// \brief Initializes the main menu.
+/// \brief The function run by the image decoding threads.
 ///
-/// Loads the animated background textures, sets up the main menu buttons and their
-/// positions.
+/// Takes the oldest queued job, decodes its image without holding the lock and marks it as done, until the pool
+/// is stopped.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param background_frames A pointer to an array of SDL_Texture pointers for the animated background frames.
-/// \param button_rects An array of SDL_Rect structures representing the main menu buttons.
-/// \param num_background_frames A pointer to an int to store the number of background frames.
-/// \return void
-void init_main_menu(SDL_Renderer *renderer, SDL_Texture ***background_frames, SDL_Rect *button_rects,
-                    int *num_background_frames);
+/// \param data Pointer to the DecodePool.
+/// \return int Always 0.
+int decode_worker_thread(void *data);
 
-/// \brief Handles events for the main menu.
+/// \brief Start the image decoding threads.
 ///
-/// Processes SDL events for the main menu, such as mouse movement and button presses.
+/// Starts one thread per CPU core but one, so images are decoded in parallel while the main thread creates the
+/// window, opens the font and uploads the images that are already decoded. Must be called after IMG_Init.
 ///
-/// \param event A pointer to an SDL_Event structure.
-/// \param button_rects An array of SDL_Rect structures representing the main menu buttons.
-/// \param hover_button A pointer to an int that represents the index of the button being hovered.
-/// \param selected_option A pointer to a MainMenuOption enum value to store the user's selection.
-/// \return int Returns 0 if the user clicks a button, 1 if the main menu should continue running.
-int
-handle_main_menu_events(SDL_Event *event, SDL_Rect *button_rects, int *hover_button, MainMenuOption *selected_option);
+/// \return bool Returns true if at least one thread was started, false otherwise (images are then decoded on the
+/// calling thread).
+bool start_decode_pool(void);
 
-/// \brief Renders the main menu.
+/// \brief Stop the image decoding threads.
 ///
-/// Renders the animated background, buttons, and button labels for the main menu.
+/// Waits for the running jobs, joins the threads and frees the images that were decoded but never used.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param background_frames An array of SDL_Texture pointers for the animated background frames.
-/// \param font A pointer to an SDL_Font.
-/// \param frame_counter An int representing the current frame of the animated background.
-/// \param button_rects An array of SDL_Rect structures representing the main menu buttons.
-/// \param hover_button An int representing the index of the button being hovered.
 /// \return void
-void render_main_menu(SDL_Renderer *renderer, SDL_Texture **background_frames, TTF_Font *font, int frame_counter,
-                      SDL_Rect *button_rects, int hover_button);
+void stop_decode_pool(void);
 
-/// \brief Executes the main menu loop.
+/// \brief Queues an image to be decoded in the background.
 ///
-/// Handles user interaction and rendering for the main menu until the user selects an option or closes the window.
+/// The decoded image is picked up by load_texture, or by wait_decoded_image, when it is needed.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param font A pointer to an SDL_Font.
-/// \return MainMenuOption Returns the selected option from the main menu (NEW_GAME, LOAD, or EXIT).
-MainMenuOption main_menu(SDL_Renderer *renderer, TTF_Font *font);
+/// \param filename The path to the image file.
+/// \return int The index of the job, or -1 if the pool is not running or full.
+int prefetch_image(const char *filename);
 
-/// \brief Initializes the game board.
-///
-/// Sets up the game board by initializing all cells with their position, size, and initial state.
+/// \brief Finds the job decoding an image.
 ///
-/// \param board A pointer to a GameBoard structure.
-/// \return void
-void initialize_game_board(GameBoard *board);
+/// \param filename The path to the image file.
+/// \return int The index of the job, or -1 if the image was not prefetched.
+int find_decode_job(const char *filename);
 
-/// \brief Initializes ships for a player.
+/// \brief Waits for a decode job and takes its image.
 ///
-/// This function initializes the ships for a player by setting the size and initial values
-/// for each ship. The hit_count is set to 0, and the position and orientation are set to
-/// invalid values (-1 and 0, respectively) as the ships have not been placed on the board yet.
+/// The job is freed, the caller owns the returned surface.
 ///
-/// \param player Pointer to the Player struct representing the player whose ships are being initialized.
-void initialize_ships(Player *player);
+/// \param job The index of the job.
+/// \return SDL_Surface* The decoded surface, or NULL if the image could not be loaded.
+SDL_Surface *wait_decoded_image(int job);
 
-/// \brief Determines if a ship position is valid on the game board.
+/// \brief Takes the image of a decode job if it is ready, without waiting.
 ///
-/// Checks if the given ship position is within the grid bounds and not overlapping
-/// any existing ships on the board.
+/// The job is freed if the image is returned, the caller owns the returned surface.
 ///
-/// \param current_player A pointer to the current Player structure.
-/// \param ship_size The size of the ship to be placed.
-/// \param x The x-coordinate of the ship's starting position.
-/// \param y The y-coordinate of the ship's starting position.
-/// \param orientation The ship's orientation (0 for horizontal, 1 for vertical).
-/// \return true if the position is valid, false otherwise.
-bool is_position_valid(Player *current_player, int ship_size, int x, int y, int orientation);
+/// \param job The index of the job.
+/// \return SDL_Surface* The decoded surface, or NULL if the job is not done yet or the image could not be loaded.
+SDL_Surface *poll_decoded_image(int job);
 
-/// \brief Checks if all ships have been placed.
+/// \brief Cancels the decoding of an image that is no longer needed.
 ///
-/// This function checks if all the ships have been placed on the board by iterating
-/// through the placed_ships array. If all the ships have been placed, the function
-/// returns true; otherwise, it returns false.
+/// Queued jobs are dropped, decoded images are freed and running jobs free their image when they finish.
 ///
-/// \param placed_ships Array containing the placement status of each ship.
-/// \return true if all ships have been placed, false otherwise.
-bool all_ships_placed(const bool placed_ships[]);
+/// \param filename The path to the image file.
+/// \return void
+void cancel_decode_job(const char *filename);
 
-/// \brief Places a ship on the game board.
-///
-/// This function places a ship on the game board at the specified position and orientation.
-/// The cells that the ship occupies are marked as occupied and updated with the necessary
-/// information, such as coordinates and hit status.
+/// \brief Takes a prefetched image, or decodes it on the calling thread if it was not prefetched.
 ///
-/// \param board Pointer to the GameBoard struct representing the game board.
-/// \param ship Pointer to the Ship struct representing the ship to place.
-/// \param x Integer representing the x-coordinate of the ship's position on the board.
-/// \param y Integer representing the y-coordinate of the ship's position on the board.
-/// \param orientation Integer representing the orientation of the ship (0 for horizontal, 1 for vertical).
-/// \param ship_index Integer representing the index of the ship in the ships array.
-void place_ship(GameBoard *board, Ship *ship, int x, int y, int orientation, int ship_index);
+/// \param filename The path to the image file.
+/// \return SDL_Surface* The decoded surface, or NULL if the image could not be loaded.
+SDL_Surface *take_image(const char *filename);
 
-/// \brief Places ships randomly on a player's board.
+/// \brief Records the time the game was started, used to measure the time to the first interactive frame.
 ///
-/// This function generates random positions and orientations for each ship in the game,
-/// and places them on the player's board. It ensures that the randomly generated positions
-/// and orientations are valid before placing the ships.
+/// \return void
+void mark_startup_time(void);
+
+/// \brief Prints the time from startup to the first interactive frame, the first time it is called.
 ///
-/// \param current_player Pointer to the Player struct representing the player whose board the ships are being placed on.
-/// \param ships Pointer to the array of Ship structs representing the ships to place.
-/// \param placed_ships Pointer to the array of booleans indicating whether each ship has been placed.
-/// \param ship_selected Pointer to an integer representing the index of the currently selected ship (-1 if none).
-/// \param orientation_to_reset Pointer to an integer representing the orientation to reset after placing ships.
-void place_random_ships(Player *current_player, Ship ships[], bool placed_ships[], int *ship_selected,
-                        int *orientation_to_reset);
+/// \return void
+void report_first_interactive_frame(void);
 
-/// \brief Renders a single part of a ship.
+/// \brief Maps the asset bundle, if it exists.
 ///
-/// Renders a single part of a ship (left, middle, or right) based on the part_index and
-/// ship size at the specified position.
+/// Assets are then read from the bundle instead of opening one file per asset. Without a bundle, or for assets
+/// the bundle does not contain, the files under Assets/ are used.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param textures A pointer to a GameTextures structure holding game textures.
-/// \param ship_rect An SDL_Rect representing the position and size of the ship part.
-/// \param part_index The index of the part within the ship.
-/// \param ship_size The size of the ship.
 /// \return void
-void
-render_ship_part(SDL_Renderer *renderer, GameTextures *textures, SDL_Rect ship_rect, int part_index, int ship_size);
+void open_assets(void);
 
-/// \brief Renders the border for the currently selected ship.
+/// \brief Unmaps the asset bundle.
 ///
-/// Renders a yellow border around the currently selected ship in the ship placement screen.
+/// Must be called after the font is closed, since fonts keep reading from their asset.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param ship_index The index of the current ship in the ships array.
-/// \param ship_selected The index of the currently selected ship.
-/// \param ships An array of Ship structures representing the game ships.
 /// \return void
-void render_selected_ship_border(SDL_Renderer *renderer, int ship_index, int ship_selected, Ship ships[]);
+void close_assets(void);
 
-/// \brief Renders the border for a ship when the mouse is hovering over it.
+/// \brief Opens an asset for reading.
 ///
-/// Renders a green border around a ship in the ship placement screen when the mouse is
-/// hovering over it and the ship has not yet been placed.
+/// \param filename The path to the asset file, which is also its name in the bundle.
+/// \return SDL_RWops* An SDL_RWops reading the asset from the bundle or from its file, or NULL if it does not
+/// exist.
+SDL_RWops *open_asset(const char *filename);
+
+/// \brief Loads an SDL_Texture from a given file.
+///
+/// Loads an image file and converts it to an SDL_Texture using the provided SDL_Renderer.
 ///
+/// \param filename A string representing the path to the image file.
 /// \param renderer A pointer to an SDL_Renderer.
-/// \param ship_index The index of the current ship in the ships array.
-/// \param placed_ships An array of booleans indicating whether each ship has been placed.
-/// \param ships An array of Ship structures representing the game ships.
-/// \return void
-void render_hover_ship_border(SDL_Renderer *renderer, int ship_index, const bool placed_ships[], Ship ships[]);
+/// \return SDL_Texture* A pointer to the loaded SDL_Texture or NULL if the operation fails.
+SDL_Texture *load_texture(const char *filename, SDL_Renderer *renderer);
 
-/// \brief Renders an overlay for a placed ship.
+/// \brief Loads all game textures.
 ///
-/// Renders a semi-transparent black overlay over a ship that has been placed on the
-/// ship placement screen.
+/// Allocates memory for a GameTextures structure, decodes every tile image and packs them side by side into one
+/// atlas texture, so a whole board can be drawn from a single texture.
 ///
 /// \param renderer A pointer to an SDL_Renderer.
-/// \param ship_index The index of the current ship in the ships array.
-/// \param part_index The index of the part within the ship.
-/// \param placed_ships An array of booleans indicating whether each ship has been placed.
-/// \param black_texture An SDL_Texture pointer to the black overlay texture.
+/// \return GameTextures* A pointer to the loaded GameTextures structure or NULL if the operation fails.
+GameTextures *load_game_textures(SDL_Renderer *renderer);
+
+/// \brief Queues the tile images to be decoded in the background.
+///
 /// \return void
-void render_placed_ship_overlay(SDL_Renderer *renderer, int ship_index, int part_index, const bool placed_ships[],
-                                SDL_Texture *black_texture);
+void prefetch_game_textures(void);
 
-/// \brief Renders the ship icons on the left side of the placement screen.
+/// \brief Gets the index pattern shared by all quad batches.
 ///
-/// Renders the ship icons on the left side of the placement screen, including
-/// their hover and selection states, and an overlay for placed ships.
+/// Returns an index buffer with two triangles per quad, for up to QUAD_BATCH_CAPACITY quads.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param textures A pointer to a GameTextures structure holding game textures.
-/// \param ships An array of Ship structures representing the game ships.
-/// \param placed_ships An array of booleans indicating whether each ship has been placed.
-/// \param black_texture A pointer to an SDL_Texture representing the black texture.
-/// \param ship_selected An int representing the selected ship index.
+/// \return const int* A pointer to the index buffer.
+const int *get_quad_indices(void);
+
+/// \brief Starts a new quad batch.
+///
+/// \param batch A pointer to the QuadBatch to start.
+/// \param renderer A pointer to the SDL_Renderer the batch is drawn with.
+/// \param texture A pointer to the SDL_Texture of all quads in the batch, or NULL for untextured quads.
 /// \return void
-void render_placement_ships_left_side(SDL_Renderer *renderer, GameTextures *textures, Ship ships[],
-                                      const bool placed_ships[], SDL_Texture *black_texture, int ship_selected);
+void begin_quad_batch(QuadBatch *batch, SDL_Renderer *renderer, SDL_Texture *texture);
 
-/// \brief Sets the button color based on the mouse hover state.
+/// \brief Adds a quad to a quad batch.
 ///
-/// Sets the button color based on whether the mouse is hovering over the button.
+/// The batch is flushed automatically when it is full.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param hover_state A bool indicating whether the mouse is hovering over the button.
+/// \param batch A pointer to the QuadBatch.
+/// \param source An SDL_Rect with the source area in the batch texture, or NULL for the whole texture.
+/// \param destination An SDL_Rect with the destination area on the screen.
+/// \param color The color the texture is modulated with (the quad color for untextured batches).
+/// \param rotate Whether the source is rotated 90 degrees clockwise, like SDL_RenderCopyEx with an angle of 90.
 /// \return void
-void set_button_color(SDL_Renderer *renderer, bool hover_state);
+void add_batch_quad(QuadBatch *batch, const SDL_Rect *source, const SDL_Rect *destination, SDL_Color color,
+                    bool rotate);
 
-/// \brief Renders the button shadow.
-///
-/// Renders the shadow for a button, offset from the button rectangle.
+/// \brief Adds a tile of the game texture atlas to a quad batch.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param orientation_button An SDL_Rect representing the button's position and size.
+/// \param batch A pointer to a QuadBatch started with the atlas texture.
+/// \param textures A pointer to a GameTextures structure holding game textures.
+/// \param tile The tile to add.
+/// \param destination An SDL_Rect with the destination area on the screen.
+/// \param rotate Whether the tile is rotated 90 degrees clockwise.
 /// \return void
-void render_button_shadow(SDL_Renderer *renderer, SDL_Rect orientation_button);
+void add_batch_tile(QuadBatch *batch, GameTextures *textures, Tile tile, const SDL_Rect *destination, bool rotate);
 
-/// \brief Renders the orientation text on the orientation button.
+/// \brief Draws all quads of a quad batch with a single SDL_RenderGeometry call and empties it.
 ///
-/// Renders the orientation text ("Orientation: Horizontal" or "Orientation: Vertical")
-/// on the orientation button based on the current orientation value.
+/// \param batch A pointer to the QuadBatch.
+/// \return void
+void flush_quad_batch(QuadBatch *batch);
+
+/// \brief Builds the file name of a frame of an animation.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param font A pointer to an SDL_Font.
-/// \param orientation_button An SDL_Rect representing the button's position and size.
-/// \param orientation An int representing the current orientation.
+/// \param filepath A string representing the path to the image files without the frame number and file extension.
+/// \param frame The index of the frame.
+/// \param filename The buffer receiving the file name.
+/// \param size The size of the buffer.
 /// \return void
-void render_orientation_text(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect orientation_button, int orientation);
+void get_animation_frame_name(const char *filepath, int frame, char *filename, size_t size);
 
-/// \brief Renders the orientation button during the ship placement phase.
+/// \brief Starts playing an animation.
 ///
-/// Renders the button for changing the ship orientation during the ship placement
-/// phase, including its hover state, shadow, and orientation text.
+/// Only ANIMATION_RING_SIZE frames are kept as textures at once: the frame on screen and the next ones, decoded
+/// ahead of time on the decode threads. The first frame is loaded before this function returns.
 ///
+/// \param player A pointer to the AnimationPlayer to initialize.
 /// \param renderer A pointer to an SDL_Renderer.
-/// \param font A pointer to an SDL_Font.
-/// \param orientation_button An SDL_Rect representing the button's position and size.
-/// \param hover_orientation A bool indicating whether the mouse is hovering over the button.
-/// \param orientation An int representing the current orientation.
-/// \return void
-void render_placement_orientation_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect orientation_button,
-                                         int hover_orientation, int orientation);
+/// \param filepath A string representing the path to the image files without the frame number and file extension.
+/// \param num_frames An int representing the number of frames in the animation.
+/// \param fps The number of frames shown per second.
+/// \return bool Returns true if the first frame was loaded, false otherwise.
+bool init_animation_player(AnimationPlayer *player, SDL_Renderer *renderer, const char *filepath, int num_frames,
+                           int fps);
 
-/// \brief Renders the "Restart the board" button during the ship placement phase.
+/// \brief Advances an animation to the frame due at the given time.
 ///
-/// Renders the button for restarting the board during the ship placement phase,
-/// including its hover state, shadow, and reset text.
+/// Uploads the frames that finished decoding into the ring and queues the next ones. If the due frame is not
+/// decoded yet, the previous frame stays on screen.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param font A pointer to an SDL_Font.
-/// \param reset_button An SDL_Rect representing the button's position and size.
-/// \param hover_reset A bool indicating whether the mouse is hovering over the button.
-/// \return void
-void render_placement_reset_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect reset_button, bool hover_reset);
+/// \param player A pointer to the AnimationPlayer.
+/// \param now The current time, in SDL_GetPerformanceCounter units.
+/// \return bool Returns true if the frame on screen changed.
+bool update_animation_player(AnimationPlayer *player, Uint64 now);
+
+/// \brief Returns the time the animation must be updated again.
+///
+/// \param player A pointer to the AnimationPlayer.
+/// \param now The current time, in SDL_GetPerformanceCounter units.
+/// \return Uint64 The time of the next frame, or a few milliseconds from now if a frame is still being decoded.
+Uint64 get_next_animation_time(const AnimationPlayer *player, Uint64 now);
 
-/// \brief Renders the "Randomize the board" button during the ship placement phase.
+/// \brief Returns the texture of the frame on screen.
 ///
-/// Renders the button to randomize ship positions on the board. Changes the
-/// button color based on whether the mouse is hovering over the button.
+/// \param player A pointer to the AnimationPlayer.
+/// \return SDL_Texture* The texture, or NULL if no frame was loaded.
+SDL_Texture *get_animation_texture(const AnimationPlayer *player);
+
+/// \brief Stops an animation, cancelling its pending decodes and destroying its textures.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param font A pointer to an SDL_Font.
-/// \param random_button An SDL_Rect representing the button's position and size.
-/// \param hover_random A bool indicating whether the mouse is hovering over the button.
+/// \param player A pointer to the AnimationPlayer.
 /// \return void
-void render_placement_random_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect random_button, bool hover_random);
+void destroy_animation_player(AnimationPlayer *player);
 
-/// \brief Renders the "Finish placing ships" button during the ship placement phase.
+/// \brief Frees the textures of a GameTextures structure and the structure itself.
 ///
-/// Renders the button to finish placing ships on the board. Changes the button
-/// color based on whether the mouse is hovering over the button and whether all ships
-/// have been placed.
-///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param font A pointer to an SDL_Font.
-/// \param finish_button An SDL_Rect representing the button's position and size.
-/// \param hover_finish A bool indicating whether the mouse is hovering over the button.
-/// \param placed_ships An array of booleans indicating whether each ship has been placed.
-/// \param black_texture A pointer to an SDL_Texture representing the black texture.
+/// \param textures A pointer to the GameTextures structure to free, or NULL.
 /// \return void
-void render_placement_finish_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect finish_button, bool hover_finish,
-                                    const bool placed_ships[], SDL_Texture *black_texture);
+void free_game_textures(GameTextures *textures);
 
-/// \brief Renders the buttons during the ship placement phase.
+/// \brief Creates the window and renderer shared by all screens.
 ///
-/// Renders the buttons for changing orientation, resetting the board, randomizing
-/// the board, and finishing the ship placement phase.
+/// Also loads the game textures, which stay loaded until shutdown_scene_manager is called.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param font A pointer to an SDL_Font.
-/// \param button_data A pointer to a ButtonData structure holding button information.
-/// \param placed_ships An array of booleans indicating whether each ship has been placed.
-/// \param orientation An int representing the current orientation.
-/// \param black_texture A pointer to an SDL_Texture representing the black texture.
-/// \return void
-void
-render_placement_buttons(SDL_Renderer *renderer, TTF_Font *font, ButtonData *button_data, const bool placed_ships[],
-                         int orientation, SDL_Texture *black_texture);
+/// \param title The initial window title.
+/// \param width The initial window width.
+/// \param height The initial window height.
+/// \return bool Returns true if the window, renderer and game textures were created, false otherwise.
+bool init_scene_manager(const char *title, int width, int height);
 
-/// \brief Renders the grid background during the ship placement phase.
+/// \brief Creates a software renderer drawing into an offscreen surface instead of a window.
 ///
-/// Renders the background for the grid during the ship placement phase. Chooses
-/// the appropriate background texture based on whether a ship is selected.
+/// Used by the render test, which must run without a display. get_scene_window returns NULL afterwards.
 ///
-/// \param renderer A pointer to an SDL_Renderer.
-/// \param textures A pointer to a GameTextures structure holding game textures.
-/// \param ship_selected An int representing the selected ship index.
-/// \return void
-void render_grid_background(SDL_Renderer *renderer, GameTextures *textures, int ship_selected);
+/// \param width The width of the offscreen surface.
+/// \param height The height of the offscreen surface.
+/// \return bool Returns true if the surface, renderer and game textures were created, false otherwise.
+bool init_headless_scene_manager(int width, int height);
 
-/// \brief Renders the ship hover during the placement phase.
+/// \brief Prepares the shared window for the next screen.
 ///
-/// This function renders the ship that the user is currently hovering over the grid during the placement phase.
-/// The ship's border color is set to either white or red based on whether the current position is valid.
+/// Sets the window title, resizes the window if its size changes and drops the mouse clicks that ended the
+/// previous screen, so they do not reach the next one.
 ///
-/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
-/// \param textures A pointer to a GameTextures structure that holds game-related textures.
-/// \param ships An array of Ship structures representing the game's ships.
-/// \param ship_selected The index of the selected ship.
-/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
-/// \param grid_mouse_x The x coordinate of the mouse on the game grid.
-/// \param grid_mouse_y The y coordinate of the mouse on the game grid.
-/// \param valid_position A boolean indicating whether the current ship placement position is valid.
+/// \param title The window title of the screen.
+/// \param width The window width of the screen.
+/// \param height The window height of the screen.
 /// \return void
-void render_ship_hover(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], int ship_selected, int orientation,
-                       int grid_mouse_x, int grid_mouse_y, bool valid_position);
+void enter_scene(const char *title, int width, int height);
 
-/// \brief Renders the placed ships on the game grid.
+/// \brief Returns the window shared by all screens.
 ///
-/// This function renders the ships that have been placed on the game grid during the placement phase.
-///
-/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
-/// \param textures A pointer to a GameTextures structure that holds game-related textures.
-/// \param ships An array of Ship structures representing the game's ships.
-/// \param placed_ships An array of boolean values representing whether each ship has been placed on the grid.
-/// \param board_x The x coordinate of the game grid.
-/// \param board_y The y coordinate of the game grid.
-/// \return void
-void render_placed_ships(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], const bool placed_ships[],
-                         int board_x, int board_y);
+/// \return SDL_Window* A pointer to the window.
+SDL_Window *get_scene_window(void);
 
-/// \brief Renders a single segment of a ship.
+/// \brief Returns the renderer shared by all screens.
 ///
-/// This function renders a specific segment of a ship based on the provided orientation and segment index.
+/// \return SDL_Renderer* A pointer to the renderer.
+SDL_Renderer *get_scene_renderer(void);
+
+/// \brief Returns the game textures shared by all screens.
 ///
-/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
-/// \param textures A pointer to a GameTextures structure that holds game-related textures.
-/// \param ship A Ship structure representing the current ship.
-/// \param segment The index of the current ship segment.
-/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
-/// \param ship_rect A pointer to an SDL_Rect structure that represents the ship's rectangle on the screen.
-/// \return void
-void render_ship_segment(SDL_Renderer *renderer, GameTextures *textures, Ship ship, int segment, int orientation,
-                         SDL_Rect *ship_rect);
+/// \return GameTextures* A pointer to the game textures.
+GameTextures *get_scene_textures(void);
 
-/// \brief Renders the border of the ship during the placement phase.
+/// \brief Acquires a texture loaded from a file.
 ///
-/// This function draws the border of the ship segments during the placement phase.
+/// The texture is loaded on first use and shared by every screen that acquires it. Each call must be matched
+/// by a call to release_texture.
 ///
-/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
-/// \param ship_size The size of the ship.
-/// \param segment The index of the current ship segment.
-/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
-/// \param ship_rect A pointer to an SDL_Rect structure that represents the ship's rectangle on the screen.
-/// \return void
-void render_ship_border(SDL_Renderer *renderer, int ship_size, int segment, int orientation, SDL_Rect *ship_rect);
+/// \param filename A string representing the path to the image file.
+/// \return SDL_Texture* A pointer to the texture or NULL if it could not be loaded.
+SDL_Texture *acquire_texture(const char *filename);
 
-/// \brief Renders the game grid and ships during the placement phase.
+/// \brief Releases a texture acquired with acquire_texture.
 ///
-/// This function renders the game grid, the ship hover, and the placed ships during the placement phase.
+/// Textures that are no longer referenced stay loaded, so the next screen can use them without decoding
+/// them again, until purge_unused_textures is called.
 ///
-/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
-/// \param textures A pointer to a GameTextures structure that holds game-related textures.
-/// \param ships An array of Ship structures representing the game's ships.
-/// \param placed_ships An array of boolean values representing whether each ship has been placed on the grid.
-/// \param ship_selected The index of the selected ship.
-/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
-/// \param grid_mouse_x The x coordinate of the mouse on the game grid.
-/// \param grid_mouse_y The y coordinate of the mouse on the game grid.
-/// \param valid_position A boolean indicating whether the current ship placement position is valid.
+/// \param texture A pointer to the texture to release, or NULL.
 /// \return void
-void
-render_placement_grid_ships(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], const bool placed_ships[],
-                            int ship_selected, int orientation, int grid_mouse_x, int grid_mouse_y,
-                            bool valid_position);
+void release_texture(SDL_Texture *texture);
 
-/// \brief Render the invalid position border on the game board.
-///
-/// This function draws a red border around the game board when an invalid position is clicked.
+/// \brief Destroys the shared textures that are no longer referenced.
 ///
-/// \param renderer The SDL_Renderer used for rendering.
 /// \return void
-void render_invalid_position_border(SDL_Renderer *renderer);
+void purge_unused_textures(void);
 
-/// \brief Removes a ship from the game board.
+/// \brief Destroys all textures, the renderer and the window.
 ///
-/// This function removes a ship from the game board by setting the 'occupied' status
-/// of the cells it occupied to false. The ship's position and orientation are used
-/// to determine which cells to update.
-///
-/// \param board Pointer to the GameBoard struct representing the game board.
-/// \param ship Pointer to the Ship struct representing the ship to remove.
-/// \param x Integer representing the x-coordinate of the ship's position on the board.
-/// \param y Integer representing the y-coordinate of the ship's position on the board.
-/// \param orientation Integer representing the orientation of the ship (0 for horizontal, 1 for vertical).
-void remove_ship_from_board(GameBoard *board, Ship *ship, int x, int y, int orientation);
+/// \return void
+void shutdown_scene_manager(void);
 
-/// \brief Finds the index of the ship located at a specific position on the player's board.
+/// \brief Renders text using the global font variable.
 ///
-/// This function iterates through the player's ships to find the one occupying the given
-/// coordinates on the board. If a ship is found at the specified position, its index is
-/// returned; otherwise, the function returns -1.
+/// Renders a given text at the specified position using the global font and the provided SDL_Renderer.
 ///
-/// \param player Pointer to the Player struct representing the player whose ships are being searched.
-/// \param x Integer representing the x-coordinate of the position to search.
-/// \param y Integer representing the y-coordinate of the position to search.
-/// \return The index of the ship found at the given position, or -1 if no ship is found.
-int find_ship_at_position(Player *player, int x, int y);
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param text A string representing the text to be rendered.
+/// \param font A pointer to an SDL_Font.
+/// \param x The x-coordinate of the text's position.
+/// \param y The y-coordinate of the text's position.
+/// \return void
+void render_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y);
 
-/// \brief Resets a game board's occupied cells to false.
+/// \brief Renders colored text using the global font variable.
 ///
-/// This function clears the occupied cells of a game board, setting them all to false.
+/// Renders a given text at the specified position with the specified color using the global font and the provided SDL_Renderer.
 ///
-/// \param board A pointer to the GameBoard structure representing the game board to reset.
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param text A string representing the text to be rendered.
+/// \param font A pointer to an SDL_Font.
+/// \param x The x-coordinate of the text's position.
+/// \param y The y-coordinate of the text's position.
+/// \param r The red component of the text color.
+/// \param g The green component of the text color.
+/// \param b The blue component of the text color.
 /// \return void
-void reset_game_board(GameBoard *board);
+void render_colored_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y, int r, int g, int b);
 
-/// \brief Resets the ship placement phase variables.
+/// \brief Renders text without going through the text cache.
 ///
-/// Resets the variables related to the ship placement phase, such as ships,
-/// placed_ships, ship_selected, orientation, and the game board.
+/// Rasterises the text into a new surface and texture, draws it and frees both again. Used for strings the
+/// text cache cannot hold (too long or containing non-ASCII characters).
 ///
-/// \param ships An array of Ship structures representing the game ships.
-/// \param placed_ships An array of booleans indicating whether each ship has been placed.
-/// \param ship_selected A pointer to an int representing the selected ship index.
-/// \param orientation A pointer to an int representing the current orientation.
-/// \param board A pointer to a GameBoard structure representing the game board.
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param text A string representing the text to be rendered.
+/// \param font A pointer to an SDL_Font.
+/// \param x The x-coordinate of the text's position.
+/// \param y The y-coordinate of the text's position.
+/// \param color The color of the text.
 /// \return void
-void reset_placement_phase(Ship *ships, bool *placed_ships, int *ship_selected, int *orientation, GameBoard *board);
+void render_text_uncached(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y, SDL_Color color);
 
-/// \brief Handles mouse button down events during the ship placement phase.
+/// \brief Builds a glyph atlas for a font.
 ///
-/// This function processes mouse button down events during the ship placement phase of the game.
-/// It is responsible for handling interactions with buttons, selecting and placing ships on the grid,
-/// and updating the game state accordingly.
+/// Rasterises every printable ASCII glyph of the font in white, packs them row by row into one surface and
+/// uploads it as a single texture. Text color is applied later through the vertex colors.
 ///
-/// \param event The SDL_Event representing the mouse button down event.
-/// \param running Pointer to a boolean indicating whether the placement phase is still running.
-/// \param current_player Pointer to the Player struct representing the current player.
-/// \param ship_selected Pointer to an integer representing the currently selected ship.
-/// \param placed_ships Pointer to a boolean array indicating which ships have been placed.
-/// \param orientation Pointer to an integer representing the orientation of the selected ship.
-/// \param button_data Pointer to a ButtonData struct containing information about the game buttons.
-/// \param invalid_click Pointer to a boolean indicating whether the last click was invalid (e.g., on an invalid grid position).
-/// \param grid_mouse_x Integer representing the grid x-coordinate of the mouse cursor.
-/// \param grid_mouse_y Integer representing the grid y-coordinate of the mouse cursor.
-/// \param valid_position Pointer to a boolean indicating whether the current position is valid for placing the selected ship.
-/// \param ships Pointer to an array of Ship structs representing the available ships.
-void handle_placement_mouse_button_down(SDL_Event *event, bool *running, Player *current_player, int *ship_selected,
-                                        bool *placed_ships, int *orientation, ButtonData *button_data,
-                                        bool *invalid_click, int grid_mouse_x, int grid_mouse_y,
-                                        const bool *valid_position, Ship *ships);
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \param atlas A pointer to the GlyphAtlas to fill.
+/// \return true if the atlas was built, false otherwise.
+bool build_glyph_atlas(SDL_Renderer *renderer, TTF_Font *font, GlyphAtlas *atlas);
 
-/// \brief Handles mouse motion events during the ship placement phase.
+/// \brief Finds the glyph atlas of a font, building it on first use.
 ///
-/// This function processes mouse motion events during the ship placement phase of the game.
-/// It is responsible for updating the hover state of buttons as the mouse cursor moves over them.
-///
-/// \param event The SDL_Event representing the mouse motion event.
-/// \param button_data Pointer to a ButtonData struct containing information about the game buttons.
-/// \param placed_ships Pointer to a boolean array indicating which ships have been placed.
-void handle_placement_mouse_motion(SDL_Event *event, ButtonData *button_data, bool *placed_ships);
-
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \return GlyphAtlas* A pointer to the atlas, or NULL if it could not be built.
+GlyphAtlas *get_glyph_atlas(SDL_Renderer *renderer, TTF_Font *font);
 
-/// \brief Handle events during the placement phase of the game.
+/// \brief Finds a laid-out string in the text cache, laying it out on a miss.
 ///
-/// This function handles various events like mouse clicks, mouse movements, and SDL_QUIT events
-/// during the placement phase of the game. It also checks whether a ship has been selected,
-/// whether the user clicks on a valid position, and updates the game state accordingly.
+/// Strings are keyed by font, text and color. On a miss the least recently used entry is replaced by the
+/// quads of the new string.
 ///
-/// \param event The SDL_Event to be processed.
-/// \param running A pointer to a boolean flag indicating whether the placement phase is still running or not.
-/// \param ship_selected A pointer to an integer representing the index of the selected ship.
-/// \param placed_ships A boolean array indicating whether each ship has been placed on the board or not.
-/// \param ships An array of Ship objects representing the available ships.
-/// \param current_player A pointer to the current Player object.
-/// \param grid_mouse_x The x-coordinate of the mouse position on the grid.
-/// \param grid_mouse_y The y-coordinate of the mouse position on the grid.
-/// \param valid_position A pointer to a boolean flag indicating whether the current ship placement position is valid.
-/// \param orientation A pointer to an integer representing the ship's orientation (0 for horizontal, 1 for vertical).
-/// \param invalid_click A pointer to a boolean flag indicating whether an invalid position has been clicked or not.
-/// \param button_data A pointer to a ButtonData structure containing information about the buttons.
-/// \return void
-void handle_placement_phase_event(SDL_Event *event, bool *running, int *ship_selected, bool *placed_ships, Ship *ships,
-                                  Player *current_player, int grid_mouse_x, int grid_mouse_y,
-                                  const bool *valid_position, int *orientation, bool *invalid_click,
-                                  ButtonData *button_data);
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \param text A string representing the text.
+/// \param color The color of the text.
+/// \return CachedText* A pointer to the cache entry, or NULL if the text cannot be cached.
+CachedText *get_cached_text(SDL_Renderer *renderer, TTF_Font *font, const char *text, SDL_Color color);
 
-/// \brief Displays and handles the ship placement phase screen for a battleship game.
+/// \brief Draws a cached string.
 ///
-/// This function sets up the ship placement screen, rendering the game board, ships, and buttons, as well as handling
-/// user interaction during the placement phase. It utilizes other functions to handle SDL events and render various
-/// elements on the screen.
-///
-/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
-/// \param textures A pointer to a GameTextures structure that holds game-related textures.
-/// \param current_player A pointer to a Player structure representing the current player.
+/// Translates the cached quads to the given position and submits them with a single SDL_RenderGeometry call.
 ///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param cached_text A pointer to the CachedText to draw.
+/// \param x The x-coordinate of the text's position.
+/// \param y The y-coordinate of the text's position.
 /// \return void
-void placement_phase_screen(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *current_player);
+void draw_cached_text(SDL_Renderer *renderer, const CachedText *cached_text, int x, int y);
 
-/// \brief Places ships for the computer player.
+/// \brief Frees the glyph atlases and empties the text cache.
 ///
-/// Randomly places ships for the computer player and initializes the corresponding values.
-/// This function is designed for a human player versus computer game mode, where the computer's
-/// ship placement should be hidden from the human player.
+/// Must be called before the renderer that owns the atlas textures is destroyed.
 ///
-/// \param computer A pointer to the computer player's Player struct.
 /// \return void
-void placement_phase_computer(Player *computer);
+void clear_text_cache(void);
 
-/// \brief Render the player's board.
+/// \brief Gets the number of text cache hits and misses since the program started.
 ///
-/// This function renders the player's board with the placed ships and hit/miss cells.
-/// The board is drawn on the provided renderer using the provided textures at the specified
-/// board_x and board_y coordinates.
+/// \param hits A pointer to a Uint64 that will store the number of hits.
+/// \param misses A pointer to a Uint64 that will store the number of misses.
+/// \return void
+void get_text_cache_stats(Uint64 *hits, Uint64 *misses);
+
+/// \brief Removes all widgets from a widget tree.
 ///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param textures A pointer to the GameTextures structure containing necessary textures.
-/// \param player A pointer to the Player structure containing the board and ships data.
-/// \param board_x The x-coordinate for the top-left corner of the player's board.
-/// \param board_y The y-coordinate for the top-left corner of the player's board.
+/// \param tree A pointer to the WidgetTree to initialize.
 /// \return void
-void render_player_board(SDL_Renderer *renderer, GameTextures *textures, Player *player, int board_x, int board_y);
+void init_widget_tree(WidgetTree *tree);
 
-/// \brief Render the opponent's board.
+/// \brief Adds a visible and enabled widget to a widget tree.
 ///
-/// This function renders the opponent's board with the hit/miss cells.
-/// The board is drawn on the provided renderer using the provided textures at the specified
-/// board_x and board_y coordinates.
+/// Widgets added later are on top of the widgets added before them.
 ///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param textures A pointer to the GameTextures structure containing necessary textures.
-/// \param opponent A pointer to the Player structure containing the opponent's board data.
-/// \param board_x The x-coordinate for the top-left corner of the opponent's board.
-/// \param board_y The y-coordinate for the top-left corner of the opponent's board.
+/// \param tree A pointer to the WidgetTree.
+/// \param style The way the widget is drawn.
+/// \param rect The position and size of the widget, which is also the area it is hit-tested with.
+/// \param label_offset The position of the label relative to the top left corner of the widget.
+/// \param label The label of the widget.
+/// \return int The index of the widget, or -1 if the tree is full.
+int add_widget(WidgetTree *tree, WidgetStyle style, SDL_Rect rect, SDL_Point label_offset, const char *label);
+
+/// \brief Changes the label of a widget.
+///
+/// The texture of the widget is recreated only if the label is different.
+///
+/// \param tree A pointer to the WidgetTree.
+/// \param index The index of the widget.
+/// \param label The new label.
 /// \return void
-void render_opponent_board(SDL_Renderer *renderer, GameTextures *textures, Player *opponent, int board_x, int board_y);
+void set_widget_label(WidgetTree *tree, int index, const char *label);
 
-/// \brief Render both player's and opponent's boards.
+/// \brief Enables or disables a widget.
 ///
-/// This function renders both the current player's and the opponent's boards side by side.
-/// It uses the provided renderer and textures to draw the boards.
+/// A disabled widget is still drawn, but it is never hovered or clicked.
 ///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param textures A pointer to the GameTextures structure containing necessary textures.
-/// \param current_player A pointer to the Player structure containing the current player's board and ships data.
-/// \param opponent A pointer to the Player structure containing the opponent's board data.
+/// \param tree A pointer to the WidgetTree.
+/// \param index The index of the widget.
+/// \param enabled Whether the widget is enabled.
 /// \return void
-void render_game_boards(SDL_Renderer *renderer, GameTextures *textures, Player *current_player, Player *opponent);
+void set_widget_enabled(WidgetTree *tree, int index, bool enabled);
 
-/// \brief Render the hover effect on the game board.
+/// \brief Shows or hides a widget.
 ///
-/// This function renders the hover effect for a specified cell and its corresponding x and y-axis cells on the game board.
+/// A hidden widget is neither drawn nor hit-tested.
 ///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param white_texture The SDL_Texture to be used for the hover effect.
-/// \param cell_x The x-coordinate of the specified cell.
-/// \param cell_y The y-coordinate of the specified cell.
-/// \param board_x The x-coordinate of the game board.
-/// \param board_y The y-coordinate of the game board.
+/// \param tree A pointer to the WidgetTree.
+/// \param index The index of the widget.
+/// \param visible Whether the widget is visible.
 /// \return void
-void render_game_hover_effect(SDL_Renderer *renderer, SDL_Texture *white_texture, int cell_x, int cell_y, int board_x,
-                              int board_y);
+void set_widget_visible(WidgetTree *tree, int index, bool visible);
 
-/// \brief Render the "Finish turn" button.
+/// \brief Finds the topmost visible and enabled widget at a position.
 ///
-/// This function renders the "Finish turn" button with a hover effect and text.
+/// \param tree A pointer to the WidgetTree.
+/// \param x The x-coordinate of the position.
+/// \param y The y-coordinate of the position.
+/// \return int The index of the widget, or -1 if there is none.
+int hit_test_widgets(const WidgetTree *tree, int x, int y);
+
+/// \brief Makes a widget the hovered widget of a tree.
 ///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param font The TTF_Font to be used for the text.
-/// \param finish_turn_button An SDL_Rect containing the position and dimensions of the "Finish turn" button.
-/// \param hover_finish_turn A boolean representing whether the mouse is hovering over the "Finish turn" button.
+/// Only the widgets whose hover state changes are marked dirty.
+///
+/// \param tree A pointer to the WidgetTree.
+/// \param index The index of the hovered widget, or -1 if no widget is hovered.
 /// \return void
-void
-render_finish_turn_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect finish_turn_button, bool hover_finish_turn);
+void set_hovered_widget(WidgetTree *tree, int index);
 
-/// \brief Render the remaining ships count for both players.
+/// \brief Updates the hovered widget of a tree for a mouse position.
 ///
-/// This function renders the text displaying the remaining ships count for both the current player and the opponent.
-///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param font The TTF_Font to be used for the text.
-/// \param current_player A pointer to the Player structure containing the current player's remaining ships data.
-/// \param opponent A pointer to the Player structure containing the opponent's remaining ships data.
+/// \param tree A pointer to the WidgetTree.
+/// \param x The x-coordinate of the mouse.
+/// \param y The y-coordinate of the mouse.
 /// \return void
-void render_remaining_ships_text(SDL_Renderer *renderer, TTF_Font *font, Player *current_player, Player *opponent);
+void update_widget_hover(WidgetTree *tree, int x, int y);
 
-/// \brief Update the hit count of a ship and check if it is sunk.
+/// \brief Hit-tests a mouse event against the widgets of a tree.
 ///
-/// This function updates the hit count of a ship and checks if the ship is sunk.
-/// If the ship is sunk, it decrements the player's remaining ships count.
+/// The widgets are hit-tested once per event, the result updates the hovered widget and is returned
+/// for clicks, so the screens do not test the positions of their buttons again.
 ///
-/// \param player A pointer to the Player structure containing the player's ships data.
-/// \param ship_index The index of the ship in the player's ships array.
-/// \return true if the ship is sunk, false otherwise.
-bool update_hit_count(Player *player, int ship_index);
+/// \param tree A pointer to the WidgetTree.
+/// \param event A pointer to the SDL_Event.
+/// \return int The index of the widget under a left mouse button press or release, or -1 otherwise.
+int handle_widget_event(WidgetTree *tree, const SDL_Event *event);
 
-/// \brief Update the window title with the current player number.
+/// \brief Marks the textures of all widgets of a tree as dirty.
 ///
-/// This function updates the window title to display the current player number.
+/// Used when the renderer reports that the contents of its render targets were lost.
 ///
-/// \param window The SDL_Window whose title needs to be updated.
-/// \param current_player_num The current player number.
+/// \param tree A pointer to the WidgetTree.
 /// \return void
-void update_window_title(SDL_Window *window, int current_player_num);
+void mark_widget_tree_dirty(WidgetTree *tree);
 
-/// \brief Display the winner message on the screen.
-///
-/// This function displays the winner message, indicating which player has won the game.
+/// \brief Draws a widget with its current state.
 ///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param font The TTF_Font to be used for the text.
-/// \param winner_player_num The player number of the winner.
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \param widget A pointer to the Widget to draw.
+/// \param x The x-coordinate of the top left corner of the widget.
+/// \param y The y-coordinate of the top left corner of the widget.
 /// \return void
-void show_winner_message(SDL_Renderer *renderer, TTF_Font *font, int winner_player_num);
+void draw_widget(SDL_Renderer *renderer, TTF_Font *font, const Widget *widget, int x, int y);
 
-/// \brief Handle mouse button down events during the game.
+/// \brief Creates the render-target texture a widget is cached in.
 ///
-/// This function handles mouse button down events while the game is being played, such as shooting at the opponent's board.
+/// The texture is large enough for the widget, its shadow and its label.
 ///
-/// \param renderer The SDL_Renderer to draw on.
-/// \param textures A pointer to the GameTextures structure containing necessary textures.
-/// \param font The TTF_Font to be used for the text.
-/// \param running A pointer to a boolean representing whether the game is running.
-/// \param current_player A pointer to the Player structure containing the current player's data.
-/// \param opponent A pointer to the Player structure containing the opponent's data.
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \param widget A pointer to the Widget.
+/// \return SDL_Texture* The texture, or NULL if it could not be created.
+SDL_Texture *create_widget_texture(SDL_Renderer *renderer, TTF_Font *font, const Widget *widget);
+
+/// \brief Renders the visible widgets of a tree.
+///
+/// Each widget is copied from its cached texture, which is redrawn only when the widget is dirty. The
+/// widgets are drawn directly if the renderer does not support render targets.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \param tree A pointer to the WidgetTree.
 /// \return void
-void handle_game_mouse_button_down(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, bool *running,
-                                   Player *current_player, Player *opponent);
+void render_widgets(SDL_Renderer *renderer, TTF_Font *font, WidgetTree *tree);
 
-/// \brief Handle mouse button up events during the game.
+/// \brief Destroys the cached textures of the widgets of a tree.
 ///
-/// This function handles mouse button up events while the game is being played, such as interacting with the "Finish turn" button.
+/// \param tree A pointer to the WidgetTree.
+/// \return void
+void destroy_widget_tree(WidgetTree *tree);
+
+/// \brief Waits until an event is pending or the timeout expires.
 ///
-/// \param current_player A pointer to the Player structure containing the current player's data.
-/// \param opponent A pointer to the Player structure containing the opponent's data.
-/// \param finish_turn_button An SDL_Rect containing the position and dimensions of the "Finish turn" button.
-/// \param hover_save A pointer to a boolean representing whether the mouse is hovering over the "Save" button.
-/// \param hover_exit A pointer to a boolean representing whether the mouse is hovering over the "Exit" button.
-/// \param running A pointer to a boolean representing whether the game is running.
-/// \param ai_state A pointer to the AI_State structure containing the AI's state data.
+/// The event is left in the queue, so the event handlers of the screen still poll it afterwards.
+/// Screens call this instead of sleeping for a fixed time, so an idle screen uses no CPU.
+///
+/// \param timeout The maximum number of milliseconds to wait, 0 to only check the queue.
+/// \return bool Returns true if an event is pending, false if the timeout expired.
+bool wait_for_events(int timeout);
+
+/// \brief Waits until an event is pending or a high-resolution deadline is reached.
+///
+/// Sleeps in the event queue while the deadline is more than a millisecond away and checks the queue without
+/// sleeping for the rest, so frames are presented on time instead of up to a millisecond late.
+///
+/// \param deadline The deadline, in SDL_GetPerformanceCounter units.
+/// \return bool Returns true if an event is pending, false if the deadline was reached.
+bool wait_for_events_until(Uint64 deadline);
+
+/// \brief Starts collecting frame statistics for a screen.
+///
+/// \param screen_name The name of the screen, used by the overlay and the log export.
 /// \return void
-void handle_game_mouse_button_up(Player *current_player, Player *opponent, SDL_Rect finish_turn_button,
-                                 const bool *hover_save, const bool *hover_exit, bool *running, AI_State *ai_state);
+void begin_screen_stats(const char *screen_name);
 
-/// \brief Handle game screen events.
+/// \brief Marks the start of a frame.
 ///
-/// This function handles game screen events, such as mouse button clicks, mouse movement, and quitting the game.
+/// \return void
+void begin_frame_stats(void);
+
+/// \brief Marks the end of a frame, after it was presented.
 ///
-/// \param event A pointer to the SDL_Event structure to be processed.
-/// \param renderer The SDL_Renderer to draw on.
-/// \param textures A pointer to the GameTextures structure containing necessary textures.
-/// \param font The TTF_Font to be used for the text.
-/// \param current_player A pointer to the Player structure containing the current player's data.
-/// \param opponent A pointer to the Player structure containing the opponent's data.
-/// \param running A pointer to a boolean that indicates whether the game is still running.
-/// \param finish_turn_button An SDL_Rect containing the position and dimensions of the "Finish turn" button.
-/// \param hover_save A pointer to a boolean indicating whether the mouse is hovering over the "Save game" button.
-/// \param hover_exit A pointer to a boolean indicating whether the mouse is hovering over the "Exit game" button.
-/// \param ai_state A pointer to the AI_State structure containing the AI's state data.
 /// \return void
-void handle_game_screen_events(SDL_Event *event, SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font,
-                               Player *current_player, Player *opponent, bool *running, SDL_Rect finish_turn_button,
-                               const bool *hover_save, const bool *hover_exit, AI_State *ai_state);
+void end_frame_stats(void);
 
-/// \brief Shuffles the direction indices array.
+/// \brief Finishes collecting frame statistics for the current screen.
 ///
-/// The function shuffles the direction indices array in place using the Fisher-Yates algorithm.
-/// This helps to ensure that the AI selects directions randomly without repeating the same direction.
+/// Appends a summary of the screen to the frame statistics log, if one was requested on the command line.
 ///
-/// \param dir_indices A pointer to an array of integers representing the direction indices.
-/// \param size The size of the array.
 /// \return void
-void shuffle_directions(int *dir_indices, int size);
+void end_screen_stats(void);
 
+/// \brief Compares two floats for qsort.
+///
+/// \param a A pointer to the first float.
+/// \param b A pointer to the second float.
+/// \return int Returns a negative value, zero or a positive value if the first float is smaller, equal or greater.
+int compare_floats(const void *a, const void *b);
 
-/**
- * @brief Removes a cell from the remaining_cells array.
- *
- * This function searches for a given cell (x, y) in the remaining_cells array and removes it by replacing it
- * with the last cell in the array. It also decreases the count of remaining cells.
- *
- * @param x The x-coordinate of the cell to be removed.
- * @param y The y-coordinate of the cell to be removed.
- * @param remaining_cells A pointer to the array of remaining cells.
- * @param remaining_cells_count A pointer to the count of remaining cells.
- */
-void remove_cell(int x, int y, int (*remaining_cells)[2], int *remaining_cells_count);
+/// \brief Computes the 50th, 95th and 99th percentiles of recorded times.
+///
+/// \param times An array of times in milliseconds.
+/// \param count The number of times in the array.
+/// \param p50 A pointer to a float to store the median time.
+/// \param p95 A pointer to a float to store the 95th percentile time.
+/// \param p99 A pointer to a float to store the 99th percentile time.
+/// \return void
+void get_percentiles(const float *times, int count, float *p50, float *p95, float *p99);
 
-/**
- * @brief Initializes the AI context with default values.
- *
- * This function sets the initial values for all the fields in the AI_Context structure.
- * The AI_Context structure stores the context of the AI.
- *
- * @param ctx Pointer to the AI_Context structure to be initialized.
- */
-void initialize_ai_context(AI_Context* ctx);
+/// \brief Computes frame-time percentiles of the current screen.
+///
+/// \param p50 A pointer to a float to store the median frame time in milliseconds.
+/// \param p95 A pointer to a float to store the 95th percentile frame time in milliseconds.
+/// \param p99 A pointer to a float to store the 99th percentile frame time in milliseconds.
+/// \return void
+void get_frame_time_percentiles(float *p50, float *p95, float *p99);
 
-/// \brief Executes the computer's turn in a Battleship game using a state-based AI strategy.
+/// \brief Computes input-to-present latency percentiles of the current screen.
 ///
-/// Handles the computer's turn in the game using AI, which follows a state-based strategy (SEARCH, TARGET, DESTROY).
+/// The latency of a frame is the time from the oldest input event it shows, when SDL received it, to the
+/// return of SDL_RenderPresent.
 ///
-/// \param renderer A pointer to the SDL_Renderer used for rendering the game.
-/// \param textures A pointer to the GameTextures structure containing all the game textures.
-/// \param font A pointer to the TTF_Font used for rendering text.
-/// \param computer A pointer to the Player structure representing the computer player.
-/// \param opponent A pointer to the Player structure representing the human player.
-/// \param ai_state A pointer to the AI_State enumeration, which represents the current state of the AI (SEARCH, TARGET, DESTROY).
+/// \param p50 A pointer to a float to store the median latency in milliseconds.
+/// \param p95 A pointer to a float to store the 95th percentile latency in milliseconds.
+/// \param p99 A pointer to a float to store the 99th percentile latency in milliseconds.
 /// \return void
-void
-handle_computer_turn(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *computer, Player *opponent,
-                     AI_State *ai_state);
+void get_input_latency_percentiles(float *p50, float *p95, float *p99);
 
-/// \brief The game screen loop.
+/// \brief Reads the latest mouse position, including motion not yet polled as events.
 ///
-/// This function contains the main game loop for the Battleship game. It renders the game boards, handles input events, and updates the game state.
+/// Used to late-latch hover effects right before they are drawn. The events read from the system stay queued
+/// and are handled before the next frame.
 ///
-/// \param renderer The SDL_Renderer used for drawing.
-/// \param window The SDL_Window whose title needs to be updated.
-/// \param textures A pointer to the GameTextures structure containing the game's textures.
-/// \param font A pointer to the TTF_Font used for rendering text.
-/// \param player1 A pointer to the Player structure containing player 1's data.
-/// \param player2 A pointer to the Player structure containing player 2's data.
-/// \param current_turn A pointer to an integer that indicates the current player's turn.
-/// \param ai_state A pointer to the AI_State structure containing the AI's state data.
+/// \param x A pointer to an int to store the x-coordinate of the mouse.
+/// \param y A pointer to an int to store the y-coordinate of the mouse.
 /// \return void
-void game_screen(SDL_Renderer *renderer, SDL_Window *window, GameTextures *textures, TTF_Font *font, Player *player1,
-                 Player *player2, int *current_turn, AI_State *ai_state);
+void get_latest_mouse_state(int *x, int *y);
 
-/// \brief Frees resources and performs cleanup before exiting the game.
+/// \brief Renders the frame statistics overlay, if it is enabled.
 ///
-/// This function is responsible for freeing memory allocated for textures,
-/// destroying the SDL renderer and window, and quitting SDL subsystems.
+/// Shows the frame-time percentiles, the draw calls of the last frame, the text cache hit rate and the
+/// input-to-present latency percentiles of the screen.
+/// The overlay is drawn without the text cache and its own draw calls are not counted, so it does not change
+/// the statistics it shows.
 ///
-/// \param textures Pointer to the GameTextures structure to be freed.
-/// \param renderer Pointer to the SDL_Renderer to be destroyed.
-/// \param font Pointer to the TTF_Font to be closed.
-/// \param window Pointer to the SDL_Window to be destroyed.
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to a TTF_Font.
 /// \return void
-void cleanup(GameTextures *textures, SDL_Renderer *renderer, TTF_Font *font, SDL_Window *window);
-
-int main() {
-    // Initialize SDL and SDL_image
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
-        return -1;
-    }
+void render_frame_stats_overlay(SDL_Renderer *renderer, TTF_Font *font);
 
-    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
-        printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
-        return -1;
-    }
+/// \brief Event watch that toggles the frame statistics overlay with F3, the render profiler with F4 and the AI shot
+/// heatmap with F5.
+///
+/// Also records when the first input event not yet shown on screen was received, to measure input latency.
+///
+/// \param userdata Unused.
+/// \param event A pointer to the SDL_Event being added to the queue.
+/// \return int Always returns 0.
+int frame_stats_event_watch(void *userdata, SDL_Event *event);
 
-    // Create an SDL window and renderer
-    SDL_Window *window = SDL_CreateWindow("Battleship", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                                          320, 320, SDL_WINDOW_SHOWN);
-    if (window == NULL) {
-        printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
-        return -1;
-    }
+/// \brief Turns the render profiler on or off.
+///
+/// Turning it on clears the counters. Turning it off exports them to the file given with --profile, or to
+/// render_profile.csv.
+///
+/// \param enabled Whether SDL calls are counted and timed.
+/// \return void
+void set_render_profiling(bool enabled);
 
-    // Create an SDL renderer
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (renderer == NULL) {
-        printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
-        return -1;
-    }
+/// \brief Enters a profiled render function.
+///
+/// Until end_profile_zone is called, the SDL calls are counted for the function on the current screen.
+/// The time of a function includes the time of the profiled functions it calls.
+///
+/// \param zone_name The name of the render function, usually __func__.
+/// \return ProfileZone The zone to pass to end_profile_zone.
+ProfileZone begin_profile_zone(const char *zone_name);
 
-    // Load game textures
-    GameTextures *textures = load_game_textures(renderer);
-    if (textures == NULL) {
-        printf("Failed to load game textures.\n");
-        return -1;
-    }
+/// \brief Leaves a profiled render function and adds its time to its counters.
+///
+/// \param zone The zone returned by begin_profile_zone.
+/// \return void
+void end_profile_zone(ProfileZone zone);
 
-    // Initialize SDL_ttf
-    if (TTF_Init() == -1) {
-        printf("TTF_Init: %s\n", TTF_GetError());
-        exit(2);
-    }
+/// \brief Finds the counters of a render function on the current screen, adding them if needed.
+///
+/// \param zone_name The name of the render function, or NULL for the screen loop itself.
+/// \return ProfileEntry* A pointer to the counters, or NULL if the table is full.
+ProfileEntry *get_profile_entry(const char *zone_name);
 
-    TTF_Font *font = NULL;
-    int font_size = 24;
+/// \brief Counts an SDL call of an instrumented function, started when render_profiler.call_start was set.
+///
+/// \param kind The kind of the call.
+/// \param result The result of the call.
+/// \return int The result of the call, so the instrumented function can still be used in expressions.
+int end_profile_call(ProfileCallKind kind, int result);
 
-    // Open the font
-    font = TTF_OpenFont("Assets/Fonts/cambria.ttc", font_size);
-    if (font == NULL) {
-        printf("TTF_OpenFont: %s\n", TTF_GetError());
-        exit(2);
-    }
+/// \brief Counts an SDL call of an instrumented function returning a pointer.
+///
+/// \param kind The kind of the call.
+/// \param result The result of the call.
+/// \return void* The result of the call.
+void *end_profile_pointer_call(ProfileCallKind kind, void *result);
 
-    // Initialize players
-    Player player1;
-    Player player2;
-    int current_turn = 1;
-    player1.is_turn = true;
-    player2.is_turn = false;
-    player1.has_shot = false;
-    player2.has_shot = false;
-    player1.can_shoot = true;
-    player2.can_shoot = true;
-    player1.remaining_ships = NUM_SHIPS;
-    player2.remaining_ships = NUM_SHIPS;
+/// \brief Writes the render profiler counters to a CSV file, one line per screen and render function.
+///
+/// \param filename The path of the file, which is overwritten.
+/// \return bool Returns true if the file was written, false otherwise.
+bool export_render_profile(const char *filename);
 
-    // Create the main menu
-    MainMenuOption menu_option = main_menu(renderer, font);
-    if (menu_option == MAIN_MENU_EXIT) {
-        // Exit the game
-        cleanup(textures, renderer, font, window);
-        return 0;
-    } else if (menu_option == MAIN_MENU_LOAD) {
-        AI_State ai_state;
-        bool load_success = load_game(&player1, &player2, &current_turn, &ai_state);
-        if (!load_success) {
-            printf("Error loading saved game.\n");
-            return -1;
-        }
-        player1.is_turn = (current_turn == 1);
-        player2.is_turn = (current_turn == 2);
+/// \brief Initializes the main menu.
+///
+/// Starts the animated background, sets up the main menu buttons and their
+/// positions.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param background A pointer to the AnimationPlayer playing the animated background.
+/// \param widgets A pointer to the WidgetTree receiving the main menu buttons, in the order of MainMenuOption.
+/// \return void
+void init_main_menu(SDL_Renderer *renderer, AnimationPlayer *background, WidgetTree *widgets);
 
-        // Re-create the window and renderer for the loaded game
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
+/// \brief Queues the animated background frames of the main menu to be decoded in the background.
+///
+/// \return void
+void prefetch_main_menu(void);
 
-        const char *window_title = (current_turn == 1) ? "Battleship - Player 1" : "Battleship - Player 2";
-        window = SDL_CreateWindow(window_title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                                  800, 600, SDL_WINDOW_SHOWN);
-        if (window == NULL) {
-            printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
-        }
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        if (renderer == NULL) {
-            printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
-        }
-        textures = load_game_textures(renderer);
-        if (textures == NULL) {
-            printf("Failed to load game textures.\n");
-            return -1;
-        }
+/// \brief Handles events for the main menu.
+///
+/// Processes SDL events for the main menu, such as mouse movement and button presses.
+///
+/// \param event A pointer to an SDL_Event structure.
+/// \param widgets A pointer to the WidgetTree of the main menu buttons.
+/// \param selected_option A pointer to a MainMenuOption enum value to store the user's selection.
+/// \return int Returns 0 if the user clicks a button, 1 if the main menu should continue running.
+int handle_main_menu_events(SDL_Event *event, WidgetTree *widgets, MainMenuOption *selected_option);
 
-        if (!player2.is_human) {
-            ai_state = SEARCH;
-        }
+/// \brief Renders the main menu.
+///
+/// Renders the animated background, buttons, and button labels for the main menu.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param background The texture of the current frame of the animated background, or NULL.
+/// \param font A pointer to an SDL_Font.
+/// \param widgets A pointer to the WidgetTree of the main menu buttons.
+/// \return void
+void render_main_menu(SDL_Renderer *renderer, SDL_Texture *background, TTF_Font *font, WidgetTree *widgets);
 
-        game_screen(renderer, window, textures, font, &player1, &player2, &current_turn, &ai_state);
-    } else if (menu_option == MAIN_MENU_NEW_GAME_PVP) {
-        SDL_DestroyRenderer(renderer); // Destroy the renderer for the main menu
-        SDL_DestroyWindow(window);     // Destroy the window for the main menu
-
-        // Create a new window and renderer for the game
-        window = SDL_CreateWindow("Battleship - Player 1", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                                  800, 600, SDL_WINDOW_SHOWN);
-        if (window == NULL) {
-            printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
-        }
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        if (renderer == NULL) {
-            printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
-        }
+/// \brief Executes the main menu loop.
+///
+/// Handles user interaction and rendering for the main menu until the user selects an option or closes the window.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \return MainMenuOption Returns the selected option from the main menu (NEW_GAME, LOAD, or EXIT).
+MainMenuOption main_menu(SDL_Renderer *renderer, TTF_Font *font);
 
-        // Load game textures
-        textures = load_game_textures(renderer);
+/// \brief Initializes the game board.
+///
+/// Sets up the game board by initializing all cells with their position, size, and initial state.
+///
+/// \param board A pointer to a GameBoard structure.
+/// \return void
+void initialize_game_board(GameBoard *board);
 
-        if (textures == NULL) {
-            printf("Failed to load game textures.\n");
-            return -1;
-        }
+/// \brief Initializes ships for a player.
+///
+/// This function initializes the ships for a player by setting the size and initial values
+/// for each ship. The hit_count is set to 0, and the position and orientation are set to
+/// invalid values (-1 and 0, respectively) as the ships have not been placed on the board yet.
+///
+/// \param player Pointer to the Player struct representing the player whose ships are being initialized.
+void initialize_ships(Player *player);
 
-        player1.is_human = true;
-        player2.is_human = true;
+/// \brief Determines if a ship position is valid on the game board.
+///
+/// Checks if the given ship position is within the grid bounds and not overlapping
+/// any existing ships on the board.
+///
+/// \param current_player A pointer to the current Player structure.
+/// \param ship_size The size of the ship to be placed.
+/// \param x The x-coordinate of the ship's starting position.
+/// \param y The y-coordinate of the ship's starting position.
+/// \param orientation The ship's orientation (0 for horizontal, 1 for vertical).
+/// \return true if the position is valid, false otherwise.
+bool is_position_valid(Player *current_player, int ship_size, int x, int y, int orientation);
 
-        placement_phase_screen(renderer, textures, font, &player1);
+/// \brief Checks if all ships have been placed.
+///
+/// This function checks if all the ships have been placed on the board by iterating
+/// through the placed_ships array. If all the ships have been placed, the function
+/// returns true; otherwise, it returns false.
+///
+/// \param placed_ships Array containing the placement status of each ship.
+/// \return true if all ships have been placed, false otherwise.
+bool all_ships_placed(const bool placed_ships[]);
 
-        if (player1.remaining_ships != 5) {
-            // Player 1 did not place all ships
-            printf("Player 1 did not place all ships.\n");
-            cleanup(textures, renderer, font, window);
-            return -1;
-        }
+/// \brief Places a ship on the game board.
+///
+/// This function places a ship on the game board at the specified position and orientation.
+/// The cells that the ship occupies are marked as occupied and updated with the necessary
+/// information, such as coordinates and hit status.
+///
+/// \param board Pointer to the GameBoard struct representing the game board.
+/// \param ship Pointer to the Ship struct representing the ship to place.
+/// \param x Integer representing the x-coordinate of the ship's position on the board.
+/// \param y Integer representing the y-coordinate of the ship's position on the board.
+/// \param orientation Integer representing the orientation of the ship (0 for horizontal, 1 for vertical).
+/// \param ship_index Integer representing the index of the ship in the ships array.
+void place_ship(GameBoard *board, Ship *ship, int x, int y, int orientation, int ship_index);
+
+/// \brief Places ships randomly on a player's board.
+///
+/// This function generates random positions and orientations for each ship in the game,
+/// and places them on the player's board. It ensures that the randomly generated positions
+/// and orientations are valid before placing the ships.
+///
+/// \param current_player Pointer to the Player struct representing the player whose board the ships are being placed on.
+/// \param ships Pointer to the array of Ship structs representing the ships to place.
+/// \param placed_ships Pointer to the array of booleans indicating whether each ship has been placed.
+/// \param ship_selected Pointer to an integer representing the index of the currently selected ship (-1 if none).
+/// \param orientation_to_reset Pointer to an integer representing the orientation to reset after placing ships.
+void place_random_ships(Player *current_player, Ship ships[], bool placed_ships[], int *ship_selected,
+                        int *orientation_to_reset);
+
+/// \brief Renders a single part of a ship.
+///
+/// Adds a single part of a ship (left, middle, or right) based on the part_index and
+/// ship size at the specified position to a quad batch.
+///
+/// \param batch A pointer to a QuadBatch started with the atlas texture.
+/// \param textures A pointer to a GameTextures structure holding game textures.
+/// \param ship_rect An SDL_Rect representing the position and size of the ship part.
+/// \param part_index The index of the part within the ship.
+/// \param ship_size The size of the ship.
+/// \return void
+void render_ship_part(QuadBatch *batch, GameTextures *textures, SDL_Rect ship_rect, int part_index, int ship_size);
+
+/// \brief Renders the border for the currently selected ship.
+///
+/// Renders a yellow border around the currently selected ship in the ship placement screen.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param ship_index The index of the current ship in the ships array.
+/// \param ship_selected The index of the currently selected ship.
+/// \param ships An array of Ship structures representing the game ships.
+/// \return void
+void render_selected_ship_border(SDL_Renderer *renderer, int ship_index, int ship_selected, Ship ships[]);
+
+/// \brief Renders the border for a ship when the mouse is hovering over it.
+///
+/// Renders a green border around a ship in the ship placement screen when the mouse is
+/// hovering over it and the ship has not yet been placed.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param ship_index The index of the current ship in the ships array.
+/// \param ship_hovered The index of the hovered ship, or -1. A placed ship is never hovered.
+/// \param ships An array of Ship structures representing the game ships.
+/// \return void
+void render_hover_ship_border(SDL_Renderer *renderer, int ship_index, int ship_hovered, Ship ships[]);
+
+/// \brief Renders an overlay for a placed ship.
+///
+/// Adds a semi-transparent black overlay over a ship that has been placed on the
+/// ship placement screen to a quad batch.
+///
+/// \param overlay_batch A pointer to a QuadBatch started with the black overlay texture.
+/// \param ship_index The index of the current ship in the ships array.
+/// \param part_index The index of the part within the ship.
+/// \param placed_ships An array of booleans indicating whether each ship has been placed.
+/// \return void
+void render_placed_ship_overlay(QuadBatch *overlay_batch, int ship_index, int part_index, const bool placed_ships[]);
+
+/// \brief Renders the ship icons on the left side of the placement screen.
+///
+/// Renders the ship icons on the left side of the placement screen, including
+/// their hover and selection states, and an overlay for placed ships.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param textures A pointer to a GameTextures structure holding game textures.
+/// \param ships An array of Ship structures representing the game ships.
+/// \param placed_ships An array of booleans indicating whether each ship has been placed.
+/// \param black_texture A pointer to an SDL_Texture representing the black texture.
+/// \param ship_selected An int representing the selected ship index.
+/// \param ship_hovered An int representing the hovered ship index, or -1.
+/// \return void
+void render_placement_ships_left_side(SDL_Renderer *renderer, GameTextures *textures, Ship ships[],
+                                      const bool placed_ships[], SDL_Texture *black_texture, int ship_selected,
+                                      int ship_hovered);
+
+/// \brief Sets the button color based on the mouse hover state.
+///
+/// Sets the button color based on whether the mouse is hovering over the button.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param hover_state A bool indicating whether the mouse is hovering over the button.
+/// \return void
+void set_button_color(SDL_Renderer *renderer, bool hover_state);
+
+/// \brief Renders the button shadow.
+///
+/// Renders the shadow for a button, offset from the button rectangle.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param orientation_button An SDL_Rect representing the button's position and size.
+/// \return void
+void render_button_shadow(SDL_Renderer *renderer, SDL_Rect orientation_button);
+
+/// \brief Renders the grid background during the ship placement phase.
+///
+/// Adds the background for the grid during the ship placement phase to a quad batch. Chooses
+/// the appropriate background tile based on whether a ship is selected.
+///
+/// \param batch A pointer to a QuadBatch started with the atlas texture.
+/// \param textures A pointer to a GameTextures structure holding game textures.
+/// \param ship_selected An int representing the selected ship index.
+/// \param board_x The x coordinate of the game grid.
+/// \param board_y The y coordinate of the game grid.
+/// \return void
+void render_grid_background(QuadBatch *batch, GameTextures *textures, int ship_selected, int board_x, int board_y);
+
+/// \brief Renders the ship hover during the placement phase.
+///
+/// This function renders the ship that the user is currently hovering over the grid during the placement phase.
+/// The ship's border color is set to either white or red based on whether the current position is valid.
+///
+/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
+/// \param textures A pointer to a GameTextures structure that holds game-related textures.
+/// \param ships An array of Ship structures representing the game's ships.
+/// \param ship_selected The index of the selected ship.
+/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
+/// \param grid_mouse_x The x coordinate of the mouse on the game grid.
+/// \param grid_mouse_y The y coordinate of the mouse on the game grid.
+/// \param valid_position A boolean indicating whether the current ship placement position is valid.
+/// \return void
+void render_ship_hover(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], int ship_selected, int orientation,
+                       int grid_mouse_x, int grid_mouse_y, bool valid_position);
+
+/// \brief Renders the placed ships on the game grid.
+///
+/// This function adds the ships that have been placed on the game grid to a quad batch.
+///
+/// \param batch A pointer to a QuadBatch started with the atlas texture.
+/// \param textures A pointer to a GameTextures structure that holds game-related textures.
+/// \param ships An array of Ship structures representing the game's ships.
+/// \param placed_ships An array of boolean values representing whether each ship has been placed on the grid.
+/// \param board_x The x coordinate of the game grid.
+/// \param board_y The y coordinate of the game grid.
+/// \return void
+void render_placed_ships(QuadBatch *batch, GameTextures *textures, Ship ships[], const bool placed_ships[],
+                         int board_x, int board_y);
+
+/// \brief Renders a single segment of a ship.
+///
+/// This function adds a specific segment of a ship based on the provided orientation and segment index to a quad batch.
+///
+/// \param batch A pointer to a QuadBatch started with the atlas texture.
+/// \param textures A pointer to a GameTextures structure that holds game-related textures.
+/// \param ship A Ship structure representing the current ship.
+/// \param segment The index of the current ship segment.
+/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
+/// \param ship_rect A pointer to an SDL_Rect structure that represents the ship's rectangle on the screen.
+/// \return void
+void render_ship_segment(QuadBatch *batch, GameTextures *textures, Ship ship, int segment, int orientation,
+                         SDL_Rect *ship_rect);
+
+/// \brief Renders the border of the ship during the placement phase.
+///
+/// This function draws the border of the ship segments during the placement phase.
+///
+/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
+/// \param ship_size The size of the ship.
+/// \param segment The index of the current ship segment.
+/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
+/// \param ship_rect A pointer to an SDL_Rect structure that represents the ship's rectangle on the screen.
+/// \return void
+void render_ship_border(SDL_Renderer *renderer, int ship_size, int segment, int orientation, SDL_Rect *ship_rect);
+
+/// \brief Renders the game grid and ships during the placement phase.
+///
+/// This function renders the game grid, the placed ships and the ship hover during the placement phase.
+/// The grid and the placed ships come from the cached layer of the board, the ship hover is drawn on top.
+///
+/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
+/// \param textures A pointer to a GameTextures structure that holds game-related textures.
+/// \param board A pointer to the GameBoard the ships are placed on.
+/// \param ships An array of Ship structures representing the game's ships.
+/// \param placed_ships An array of boolean values representing whether each ship has been placed on the grid.
+/// \param ship_selected The index of the selected ship.
+/// \param orientation The orientation of the ship (0 for horizontal, 1 for vertical).
+/// \param grid_mouse_x The x coordinate of the mouse on the game grid.
+/// \param grid_mouse_y The y coordinate of the mouse on the game grid.
+/// \param valid_position A boolean indicating whether the current ship placement position is valid.
+/// \return void
+void
+render_placement_grid_ships(SDL_Renderer *renderer, GameTextures *textures, const GameBoard *board, Ship ships[],
+                            const bool placed_ships[], int ship_selected, int orientation, int grid_mouse_x,
+                            int grid_mouse_y, bool valid_position);
+
+/// \brief Render the invalid position border on the game board.
+///
+/// This function draws a red border around the game board when an invalid position is clicked.
+///
+/// \param renderer The SDL_Renderer used for rendering.
+/// \return void
+void render_invalid_position_border(SDL_Renderer *renderer);
+
+/// \brief Removes a ship from the game board.
+///
+/// This function removes a ship from the game board by setting the 'occupied' status
+/// of the cells it occupied to false. The ship's position and orientation are used
+/// to determine which cells to update.
+///
+/// \param board Pointer to the GameBoard struct representing the game board.
+/// \param ship Pointer to the Ship struct representing the ship to remove.
+/// \param x Integer representing the x-coordinate of the ship's position on the board.
+/// \param y Integer representing the y-coordinate of the ship's position on the board.
+/// \param orientation Integer representing the orientation of the ship (0 for horizontal, 1 for vertical).
+void remove_ship_from_board(GameBoard *board, Ship *ship, int x, int y, int orientation);
+
+/// \brief Finds the index of the ship located at a specific position on the player's board.
+///
+/// This function iterates through the player's ships to find the one occupying the given
+/// coordinates on the board. If a ship is found at the specified position, its index is
+/// returned; otherwise, the function returns -1.
+///
+/// \param player Pointer to the Player struct representing the player whose ships are being searched.
+/// \param x Integer representing the x-coordinate of the position to search.
+/// \param y Integer representing the y-coordinate of the position to search.
+/// \return The index of the ship found at the given position, or -1 if no ship is found.
+int find_ship_at_position(Player *player, int x, int y);
+
+/// \brief Resets a game board's occupied cells to false.
+///
+/// This function clears the occupied cells of a game board, setting them all to false.
+///
+/// \param board A pointer to the GameBoard structure representing the game board to reset.
+/// \return void
+void reset_game_board(GameBoard *board);
+
+/// \brief Resets the ship placement phase variables.
+///
+/// Resets the variables related to the ship placement phase, such as ships,
+/// placed_ships, ship_selected, orientation, and the game board.
+///
+/// \param ships An array of Ship structures representing the game ships.
+/// \param placed_ships An array of booleans indicating whether each ship has been placed.
+/// \param ship_selected A pointer to an int representing the selected ship index.
+/// \param orientation A pointer to an int representing the current orientation.
+/// \param board A pointer to a GameBoard structure representing the game board.
+/// \return void
+void reset_placement_phase(Ship *ships, bool *placed_ships, int *ship_selected, int *orientation, GameBoard *board);
+
+/// \brief Handles mouse button down events during the ship placement phase.
+///
+/// This function processes mouse button down events during the ship placement phase of the game.
+/// It is responsible for handling interactions with buttons, selecting and placing ships on the grid,
+/// and updating the game state accordingly.
+///
+/// \param running Pointer to a boolean indicating whether the placement phase is still running.
+/// \param current_player Pointer to the Player struct representing the current player.
+/// \param ship_selected Pointer to an integer representing the currently selected ship.
+/// \param placed_ships Pointer to a boolean array indicating which ships have been placed.
+/// \param orientation Pointer to an integer representing the orientation of the selected ship.
+/// \param clicked_widget The index of the PlacementWidget that was clicked, or -1.
+/// \param invalid_click Pointer to a boolean indicating whether the last click was invalid (e.g., on an invalid grid position).
+/// \param grid_mouse_x Integer representing the grid x-coordinate of the mouse cursor.
+/// \param grid_mouse_y Integer representing the grid y-coordinate of the mouse cursor.
+/// \param valid_position Pointer to a boolean indicating whether the current position is valid for placing the selected ship.
+/// \param ships Pointer to an array of Ship structs representing the available ships.
+void handle_placement_mouse_button_down(bool *running, Player *current_player, int *ship_selected, bool *placed_ships,
+                                        int *orientation, int clicked_widget, bool *invalid_click, int grid_mouse_x,
+                                        int grid_mouse_y, const bool *valid_position, Ship *ships);
+
+/// \brief Handle events during the placement phase of the game.
+///
+/// This function handles various events like mouse clicks, mouse movements, and SDL_QUIT events
+/// during the placement phase of the game. It also checks whether a ship has been selected,
+/// whether the user clicks on a valid position, and updates the game state accordingly.
+/// Clicks are resolved at the position they happened at, with the state left by the events before them.
+///
+/// \param event The SDL_Event to be processed.
+/// \param running A pointer to a boolean flag indicating whether the placement phase is still running or not.
+/// \param ship_selected A pointer to an integer representing the index of the selected ship.
+/// \param placed_ships A boolean array indicating whether each ship has been placed on the board or not.
+/// \param ships An array of Ship objects representing the available ships.
+/// \param current_player A pointer to the current Player object.
+/// \param orientation A pointer to an integer representing the ship's orientation (0 for horizontal, 1 for vertical).
+/// \param invalid_click A pointer to a boolean flag indicating whether an invalid position has been clicked or not.
+/// \param widgets A pointer to the WidgetTree of the placement phase screen.
+/// \return void
+void handle_placement_phase_event(SDL_Event *event, bool *running, int *ship_selected, bool *placed_ships, Ship *ships,
+                                  Player *current_player, int *orientation, bool *invalid_click,
+                                  WidgetTree *widgets);
+
+/// \brief Displays and handles the ship placement phase screen for a battleship game.
+///
+/// This function sets up the ship placement screen, rendering the game board, ships, and buttons, as well as handling
+/// user interaction during the placement phase. It utilizes other functions to handle SDL events and render various
+/// elements on the screen.
+///
+/// \param renderer A pointer to an SDL_Renderer structure that represents the rendering context.
+/// \param textures A pointer to a GameTextures structure that holds game-related textures.
+/// \param current_player A pointer to a Player structure representing the current player.
+///
+/// \return void
+void placement_phase_screen(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *current_player);
+
+/// \brief Places ships for the computer player.
+///
+/// Randomly places ships for the computer player and initializes the corresponding values.
+/// This function is designed for a human player versus computer game mode, where the computer's
+/// ship placement should be hidden from the human player.
+///
+/// \param computer A pointer to the computer player's Player struct.
+/// \return void
+void placement_phase_computer(Player *computer);
+
+/// \brief Render the player's board.
+///
+/// This function renders the player's board with the placed ships and hit/miss cells.
+/// The board is drawn on the provided renderer using the provided textures at the specified
+/// board_x and board_y coordinates.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param textures A pointer to the GameTextures structure containing necessary textures.
+/// \param player A pointer to the Player structure containing the board and ships data.
+/// \param board_x The x-coordinate for the top-left corner of the player's board.
+/// \param board_y The y-coordinate for the top-left corner of the player's board.
+/// \return void
+void render_player_board(SDL_Renderer *renderer, GameTextures *textures, Player *player, int board_x, int board_y);
+
+/// \brief Render the opponent's board.
+///
+/// This function renders the opponent's board with the hit/miss cells.
+/// The board is drawn on the provided renderer using the provided textures at the specified
+/// board_x and board_y coordinates.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param textures A pointer to the GameTextures structure containing necessary textures.
+/// \param opponent A pointer to the Player structure containing the opponent's board data.
+/// \param board_x The x-coordinate for the top-left corner of the opponent's board.
+/// \param board_y The y-coordinate for the top-left corner of the opponent's board.
+/// \return void
+void render_opponent_board(SDL_Renderer *renderer, GameTextures *textures, Player *opponent, int board_x, int board_y);
+
+/// \brief Shades each cell of a board by the probability that the computer shoots it next, if the heatmap is on.
+///
+/// Only the boards shot by the computer of the game set with set_shot_heatmap_game are shaded. The probabilities
+/// are those of get_computer_shot_probabilities. They and the quads are fully recomputed when a shot changed the
+/// view of the board or the state of the AI, and the quads are drawn with a single SDL_RenderGeometry call.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param player A pointer to the Player structure whose board is drawn.
+/// \param board_x The x-coordinate for the top-left corner of the board.
+/// \param board_y The y-coordinate for the top-left corner of the board.
+/// \return void
+void render_shot_heatmap(SDL_Renderer *renderer, const Player *player, int board_x, int board_y);
+
+/// \brief Shows or hides the AI shot heatmap over the boards shot by the computer, and redraws their cached layers.
+///
+/// \return void
+void toggle_shot_heatmap(void);
+
+/// \brief Sets the game whose boards shot by the computer get the AI shot heatmap.
+///
+/// In a local game, only the boards of the players facing the computer are shaded. When spectating, both boards
+/// are shaded by the shots of the AI of the match server.
+///
+/// \param player1 A pointer to the Player structure of player 1, or NULL once the game is left.
+/// \param player2 A pointer to the Player structure of player 2, or NULL once the game is left.
+/// \param ai_state A pointer to the AI_State of the built-in AI, or NULL if no local computer plays.
+/// \param spectating Whether the game is a match of the match server followed by a spectator.
+/// \return void
+void set_shot_heatmap_game(const Player *player1, const Player *player2, const AI_State *ai_state, bool spectating);
+
+/// \brief Render both player's and opponent's boards.
+///
+/// This function renders both the current player's and the opponent's boards side by side.
+/// It uses the provided renderer and textures to draw the boards.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param textures A pointer to the GameTextures structure containing necessary textures.
+/// \param current_player A pointer to the Player structure containing the current player's board and ships data.
+/// \param opponent A pointer to the Player structure containing the opponent's board data.
+/// \param hide_fleets Whether the ships of the current player are hidden too, as seen by a spectator.
+/// \return void
+void render_game_boards(SDL_Renderer *renderer, GameTextures *textures, Player *current_player, Player *opponent,
+                        bool hide_fleets);
+
+/// \brief Marks the cached layers of a board as dirty.
+///
+/// Must be called by every code path that changes what a board looks like (shots, ship placement and removal),
+/// so the cached layers of the board are redrawn before their next use.
+///
+/// \param board A pointer to the GameBoard that changed.
+/// \return void
+void mark_board_dirty(const GameBoard *board);
+
+/// \brief Marks all cached board layers as dirty.
+///
+/// Used when the renderer reports that the contents of its render targets were lost.
+///
+/// \return void
+void mark_all_board_layers_dirty(void);
+
+/// \brief Sets the blend mode of a texture that was drawn into with blending from transparent.
+///
+/// The colors of such a texture are premultiplied by alpha, so they must not be multiplied again when it is
+/// copied. Falls back to normal blending if the renderer does not support the custom blend mode.
+///
+/// \param texture The render-target texture.
+/// \return void
+void set_premultiplied_blend_mode(SDL_Texture *texture);
+
+/// \brief Finds the cached layer of a board, creating it on first use.
+///
+/// The layer is marked dirty when it is created or when its variant (extra state the layer depends on,
+/// such as the selection mode of the placement grid) changes.
+///
+/// \param renderer The SDL_Renderer the layer is drawn with.
+/// \param board A pointer to the GameBoard shown by the layer.
+/// \param view The way the board is shown.
+/// \param variant Extra state the layer contents depend on.
+/// \return BoardLayer* A pointer to the layer, or NULL if render targets are not available.
+BoardLayer *get_board_layer(SDL_Renderer *renderer, const GameBoard *board, BoardView view, int variant);
+
+/// \brief Starts redrawing a board layer.
+///
+/// Makes the layer texture the render target and clears it to transparent. The board must then be drawn
+/// with its top left corner at (0, 0).
+///
+/// \param renderer The SDL_Renderer the layer is drawn with.
+/// \param layer A pointer to the BoardLayer to redraw.
+/// \return void
+void begin_board_layer_update(SDL_Renderer *renderer, BoardLayer *layer);
+
+/// \brief Finishes redrawing a board layer.
+///
+/// Restores the screen as the render target and marks the layer as clean.
+///
+/// \param renderer The SDL_Renderer the layer is drawn with.
+/// \param layer A pointer to the BoardLayer that was redrawn.
+/// \return void
+void end_board_layer_update(SDL_Renderer *renderer, BoardLayer *layer);
+
+/// \brief Draws a board layer on the screen.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param layer A pointer to the BoardLayer to draw.
+/// \param board_x The x-coordinate for the top-left corner of the board.
+/// \param board_y The y-coordinate for the top-left corner of the board.
+/// \return void
+void draw_board_layer(SDL_Renderer *renderer, BoardLayer *layer, int board_x, int board_y);
+
+/// \brief Destroys all cached board layers.
+///
+/// Called when a screen that uses board layers is left.
+///
+/// \return void
+void destroy_board_layers(void);
+
+/// \brief Render a player's board from its cached layer.
+///
+/// Redraws the layer with render_player_board if it is dirty, then draws it with a single copy.
+/// Falls back to render_player_board if render targets are not available.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param textures A pointer to the GameTextures structure containing necessary textures.
+/// \param player A pointer to the Player structure containing the board and ships data.
+/// \param board_x The x-coordinate for the top-left corner of the player's board.
+/// \param board_y The y-coordinate for the top-left corner of the player's board.
+/// \return void
+void render_cached_player_board(SDL_Renderer *renderer, GameTextures *textures, Player *player, int board_x,
+                                int board_y);
+
+/// \brief Render the opponent's board from its cached layer.
+///
+/// Redraws the layer with render_opponent_board if it is dirty, then draws it with a single copy.
+/// Falls back to render_opponent_board if render targets are not available.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param textures A pointer to the GameTextures structure containing necessary textures.
+/// \param opponent A pointer to the Player structure containing the opponent's board data.
+/// \param board_x The x-coordinate for the top-left corner of the opponent's board.
+/// \param board_y The y-coordinate for the top-left corner of the opponent's board.
+/// \return void
+void render_cached_opponent_board(SDL_Renderer *renderer, GameTextures *textures, Player *opponent, int board_x,
+                                  int board_y);
+
+/// \brief Render the hover effect on the game board.
+///
+/// This function renders the hover effect for a specified cell and its corresponding x and y-axis cells on the game board.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param white_texture The SDL_Texture to be used for the hover effect.
+/// \param cell_x The x-coordinate of the specified cell.
+/// \param cell_y The y-coordinate of the specified cell.
+/// \param board_x The x-coordinate of the game board.
+/// \param board_y The y-coordinate of the game board.
+/// \return void
+void render_game_hover_effect(SDL_Renderer *renderer, SDL_Texture *white_texture, int cell_x, int cell_y, int board_x,
+                              int board_y);
+
+/// \brief Render the remaining ships count for both players.
+///
+/// This function renders the text displaying the remaining ships count for both the current player and the opponent.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param font The TTF_Font to be used for the text.
+/// \param current_player A pointer to the Player structure containing the current player's remaining ships data.
+/// \param opponent A pointer to the Player structure containing the opponent's remaining ships data.
+/// \return void
+void render_remaining_ships_text(SDL_Renderer *renderer, TTF_Font *font, Player *current_player, Player *opponent);
+
+/// \brief Update the hit count of a ship and check if it is sunk.
+///
+/// This function updates the hit count of a ship and checks if the ship is sunk.
+/// If the ship is sunk, it decrements the player's remaining ships count.
+///
+/// \param player A pointer to the Player structure containing the player's ships data.
+/// \param ship_index The index of the ship in the player's ships array.
+/// \return true if the ship is sunk, false otherwise.
+bool update_hit_count(Player *player, int ship_index);
+
+/// \brief Update the window title with the current player number.
+///
+/// This function updates the window title to display the current player number.
+///
+/// \param window The SDL_Window whose title needs to be updated.
+/// \param current_player_num The current player number.
+/// \return void
+void update_window_title(SDL_Window *window, int current_player_num);
+
+/// \brief Display the winner message on the screen.
+///
+/// This function displays the winner message, indicating which player has won the game.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param font The TTF_Font to be used for the text.
+/// \param winner_player_num The player number of the winner.
+/// \return void
+void show_winner_message(SDL_Renderer *renderer, TTF_Font *font, int winner_player_num);
+
+/// \brief Handle mouse button down events during the game.
+///
+/// This function handles mouse button down events while the game is being played, such as shooting at the opponent's board.
+/// The shot is shown by a marker, and a flash if it sinks a ship, played by the timeline.
+///
+/// \param event A pointer to the SDL_Event of the click.
+/// \param timeline A pointer to the Timeline playing the visual events of the game.
+/// \param current_player A pointer to the Player structure containing the current player's data.
+/// \param opponent A pointer to the Player structure containing the opponent's data.
+/// \return void
+void handle_game_mouse_button_down(SDL_Event *event, Timeline *timeline, Player *current_player, Player *opponent);
+
+/// \brief Handle mouse button up events during the game.
+///
+/// This function handles mouse button up events while the game is being played, such as interacting with the "Finish turn" button.
+///
+/// \param current_player A pointer to the Player structure containing the current player's data.
+/// \param opponent A pointer to the Player structure containing the opponent's data.
+/// \param clicked_widget The index of the GameWidget the button was released over, or -1.
+/// \param running A pointer to a boolean representing whether the game is running.
+/// \param ai_state A pointer to the AI_State structure containing the AI's state data.
+/// \return void
+void handle_game_mouse_button_up(Player *current_player, Player *opponent, int clicked_widget, bool *running,
+                                 AI_State *ai_state);
+
+/// \brief Handle game screen events.
+///
+/// This function handles game screen events, such as mouse button clicks, mouse movement, and quitting the game.
+///
+/// \param event A pointer to the SDL_Event structure to be processed.
+/// \param timeline A pointer to the Timeline playing the visual events of the game.
+/// \param current_player A pointer to the Player structure containing the current player's data.
+/// \param opponent A pointer to the Player structure containing the opponent's data.
+/// \param running A pointer to a boolean that indicates whether the game is still running.
+/// \param widgets A pointer to the WidgetTree of the game screen.
+/// \param ai_state A pointer to the AI_State structure containing the AI's state data.
+/// \return void
+void handle_game_screen_events(SDL_Event *event, Timeline *timeline, Player *current_player, Player *opponent,
+                               bool *running, WidgetTree *widgets, AI_State *ai_state);
+
+/// \brief Empties a timeline.
+///
+/// \param timeline A pointer to the Timeline to clear.
+/// \return void
+void clear_timeline(Timeline *timeline);
+
+/// \brief Converts the duration of a visual event to performance counter ticks at the animation speed.
+///
+/// \param milliseconds The duration at normal speed.
+/// \return Uint64 The duration in ticks, 0 when animations are instant.
+Uint64 get_animation_duration(int milliseconds);
+
+/// \brief Adds a visual event to a timeline, starting now.
+///
+/// Events with no duration, when animations are instant, are not added.
+///
+/// \param timeline A pointer to the Timeline.
+/// \param kind The kind of the event.
+/// \param rect The area of the screen the event is drawn in.
+/// \param value A value shown by the event, such as a player number, or whether a shot hit.
+/// \param milliseconds The duration of the event at normal speed.
+/// \return void
+void add_tween(Timeline *timeline, TweenKind kind, SDL_Rect rect, int value, int milliseconds);
+
+/// \brief Makes the game wait for the visual events, without blocking event handling.
+///
+/// The computer does not shoot and the game does not end until the hold has passed.
+///
+/// \param timeline A pointer to the Timeline.
+/// \param milliseconds The time to wait from now at normal speed.
+/// \return void
+void hold_timeline(Timeline *timeline, int milliseconds);
+
+/// \brief Adds the visual events of a shot: a marker on the cell and a flash over the ship if the shot sunk it.
+///
+/// \param timeline A pointer to the Timeline.
+/// \param target A pointer to the Player structure that was shot at, after the shot was applied.
+/// \param cell_x The x-coordinate of the cell that was shot.
+/// \param cell_y The y-coordinate of the cell that was shot.
+/// \param board_x The x-coordinate of the board on the screen.
+/// \param board_y The y-coordinate of the board on the screen.
+/// \return void
+void add_shot_tweens(Timeline *timeline, const Player *target, int cell_x, int cell_y, int board_x, int board_y);
+
+/// \brief Adds the visual events of a shot whose result is known without the board that was shot at.
+///
+/// \param timeline A pointer to the Timeline.
+/// \param cell_x The x-coordinate of the cell that was shot.
+/// \param cell_y The y-coordinate of the cell that was shot.
+/// \param hit Whether the shot hit a ship.
+/// \param sunk_ship A pointer to the Ship the shot sunk, or NULL.
+/// \param board_x The x-coordinate of the board on the screen.
+/// \param board_y The y-coordinate of the board on the screen.
+/// \return void
+void add_shot_result_tweens(Timeline *timeline, int cell_x, int cell_y, bool hit, const Ship *sunk_ship, int board_x,
+                            int board_y);
+
+/// \brief Checks whether the game is waiting for the timeline.
+///
+/// \param timeline A pointer to the Timeline.
+/// \param now The current performance counter value.
+/// \return bool Returns true if a hold has not passed yet, false otherwise.
+bool is_timeline_holding(const Timeline *timeline, Uint64 now);
+
+/// \brief Removes the visual events that have finished.
+///
+/// \param timeline A pointer to the Timeline.
+/// \param now The current performance counter value.
+/// \return void
+void update_timeline(Timeline *timeline, Uint64 now);
+
+/// \brief Returns when the timeline needs the next frame.
+///
+/// \param timeline A pointer to the Timeline.
+/// \param now The current performance counter value.
+/// \return Uint64 The performance counter value of the next frame at 60 frames per second while events are
+/// playing, the end of the hold while only a hold is pending, or 0 if the timeline is idle.
+Uint64 get_next_timeline_time(const Timeline *timeline, Uint64 now);
+
+/// \brief Renders the visual events of a timeline.
+///
+/// \param renderer The SDL_Renderer to draw on.
+/// \param font The TTF_Font to be used for the text.
+/// \param timeline A pointer to the Timeline.
+/// \param now The current performance counter value.
+/// \return void
+void render_timeline(SDL_Renderer *renderer, TTF_Font *font, const Timeline *timeline, Uint64 now);
+
+/// \brief Shuffles the direction indices array.
+///
+/// The function shuffles the direction indices array in place using the Fisher-Yates algorithm.
+/// This helps to ensure that the AI selects directions randomly without repeating the same direction.
+///
+/// \param dir_indices A pointer to an array of integers representing the direction indices.
+/// \param size The size of the array.
+/// \return void
+void shuffle_directions(int *dir_indices, int size);
+
+
+/**
+ * @brief Removes a cell from the remaining_cells array.
+ *
+ * This function searches for a given cell (x, y) in the remaining_cells array and removes it by replacing it
+ * with the last cell in the array. It also decreases the count of remaining cells.
+ *
+ * @param x The x-coordinate of the cell to be removed.
+ * @param y The y-coordinate of the cell to be removed.
+ * @param remaining_cells A pointer to the array of remaining cells.
+ * @param remaining_cells_count A pointer to the count of remaining cells.
+ */
+void remove_cell(int x, int y, int (*remaining_cells)[2], int *remaining_cells_count);
+
+/**
+ * @brief Initializes the AI context with default values.
+ *
+ * This function sets the initial values for all the fields in the AI_Context structure.
+ * The AI_Context structure stores the context of the AI.
+ *
+ * @param ctx Pointer to the AI_Context structure to be initialized.
+ */
+void initialize_ai_context(AI_Context* ctx);
+
+/// \brief Checks whether a cell keeps the minimum gap of the SEARCH state from the cells already shot.
+///
+/// \param ctx A pointer to the AI_Context.
+/// \param opponent A pointer to the Player structure whose board is shot.
+/// \param cell_x The x-coordinate of the cell.
+/// \param cell_y The y-coordinate of the cell.
+/// \return bool Returns true if no missed cell and no hit on a ship smaller than the minimum gap is next to the cell.
+bool meets_min_gap(const AI_Context *ctx, const Player *opponent, int cell_x, int cell_y);
+
+/// \brief Looks for the next cell of the TARGET and DESTROY states along the directions around the first hit.
+///
+/// The directions are tried in the order of the context and reversed once the ship's orientation is known. The state
+/// turns to REVISIT once a direction has been fully explored, and back to SEARCH once every direction failed. The
+/// function uses no random numbers, so it can be run on a copy of the context to predict the next shot.
+///
+/// \param ctx A pointer to the AI_Context, updated as the directions are tried.
+/// \param ai_state A pointer to the AI_State, TARGET or DESTROY.
+/// \param opponent A pointer to the Player structure whose board is shot.
+/// \param cell_x A pointer to the x-coordinate of the cell.
+/// \param cell_y A pointer to the y-coordinate of the cell.
+/// \return bool Returns true if a cell was found, false if the next direction or the new state must be tried.
+bool find_target_cell(AI_Context *ctx, AI_State *ai_state, const Player *opponent, int *cell_x, int *cell_y);
+
+/// \brief Fires one shot of the computer's turn in a Battleship game using a state-based AI strategy.
+///
+/// Handles the computer's turn in the game using AI, which follows a state-based strategy (SEARCH, TARGET, DESTROY).
+/// The turn goes on with another call as long as the shots hit, so the game screen can show each shot.
+///
+/// \param opponent A pointer to the Player structure representing the human player.
+/// \param ai_state A pointer to the AI_State enumeration, which represents the current state of the AI (SEARCH, TARGET, DESTROY).
+/// \param continuing Whether the previous shot of this turn hit a ship.
+/// \return ComputerShot The cell that was shot and whether it hit a ship, has_shot is false if no cell was found.
+ComputerShot handle_computer_turn(Player *opponent, AI_State *ai_state, bool continuing);
+
+/// \brief The game screen loop.
+///
+/// This function contains the main game loop for the Battleship game. It renders the game boards, handles input events, and updates the game state.
+///
+/// \param renderer The SDL_Renderer used for drawing.
+/// \param window The SDL_Window whose title needs to be updated.
+/// \param textures A pointer to the GameTextures structure containing the game's textures.
+/// \param font A pointer to the TTF_Font used for rendering text.
+/// \param player1 A pointer to the Player structure containing player 1's data.
+/// \param player2 A pointer to the Player structure containing player 2's data.
+/// \param current_turn A pointer to an integer that indicates the current player's turn.
+/// \param ai_state A pointer to the AI_State structure containing the AI's state data.
+/// \return void
+void game_screen(SDL_Renderer *renderer, SDL_Window *window, GameTextures *textures, TTF_Font *font, Player *player1,
+                 Player *player2, int *current_turn, AI_State *ai_state);
+
+/// \brief Starts the connection of a networked game in the background.
+///
+/// The host listens on the port given with --host, the other player connects to the address given with
+/// --connect. The session thread waits for the connection, then receives the messages of the opponent into
+/// the inbox and wakes the SDL event loop with a wake event, so the screens sleep until a message arrives.
+///
+/// \return bool Returns true if the session was started, false otherwise.
+bool start_net_session(void);
+
+/// \brief The function run by the session thread.
+///
+/// \param data A pointer to the NetSession.
+/// \return int Always 0.
+int net_session_thread(void *data);
+
+/// \brief Stops the session thread, closes the connection and prints the network statistics.
+///
+/// \return void
+void stop_net_session(void);
+
+/// \brief Checks whether the game is played against another game process.
+///
+/// \return bool Returns true if a networked game was started, false otherwise.
+bool is_net_game(void);
+
+/// \brief Checks whether the connection to the opponent is established.
+///
+/// \return bool Returns true if the connection is established and was not lost, false otherwise.
+bool is_net_connected(void);
+
+/// \brief Checks whether the connection to the opponent failed or was lost.
+///
+/// \return bool Returns true if the connection failed or was closed, false otherwise.
+bool is_net_disconnected(void);
+
+/// \brief Takes the oldest message of the opponent from the inbox.
+///
+/// \param message A pointer to the NetMessage receiving the message.
+/// \return bool Returns true if a message was taken, false if the inbox is empty.
+bool poll_net_message(NetMessage *message);
+
+/// \brief Sends a message to the opponent.
+///
+/// \param message A pointer to the NetMessage to send.
+/// \return bool Returns true if the message was sent, false otherwise.
+bool send_net_message(const NetMessage *message);
+
+/// \brief Returns the position of a ship as it is sent.
+///
+/// \param player A pointer to the Player owning the ship.
+/// \param ship_index The index of the ship.
+/// \return NetShip The position of the ship.
+NetShip get_net_ship(const Player *player, int ship_index);
+
+/// \brief Sends the commitment to the fleet of the local player, with a new random salt.
+///
+/// \param player A pointer to the local Player, with all ships placed.
+/// \return bool Returns true if the commitment was sent, false otherwise.
+bool commit_net_fleet(const Player *player);
+
+/// \brief Sends the fleet and salt behind the commitment, once per game.
+///
+/// \return void
+void reveal_net_fleet(void);
+
+/// \brief Checks the fleet revealed by the opponent against its commitment and the results it sent.
+///
+/// \param remote A pointer to the Player holding what is known of the opponent's board.
+/// \param reveal A pointer to the NET_MSG_REVEAL message.
+/// \return bool Returns true if the fleet is valid and matches the commitment and every result, false otherwise.
+bool verify_net_fleet(const Player *remote, const NetMessage *reveal);
+
+/// \brief Sends a shot of the local player to the opponent, unless the result of the last shot is pending.
+///
+/// \param local A pointer to the local Player.
+/// \param cell_x The x-coordinate of the cell.
+/// \param cell_y The y-coordinate of the cell.
+/// \return void
+void send_net_shot(Player *local, int cell_x, int cell_y);
+
+/// \brief Resolves a shot of the opponent at the board of the local player and sends back the result.
+///
+/// \param timeline A pointer to the Timeline playing the visual events of the game.
+/// \param local A pointer to the local Player.
+/// \param remote A pointer to the Player of the opponent.
+/// \param shot A pointer to the NET_MSG_SHOT message.
+/// \return void
+void handle_net_shot(Timeline *timeline, Player *local, Player *remote, const NetMessage *shot);
+
+/// \brief Marks the cell of a shot on a board that only holds what was learned from the results.
+///
+/// The whole ship is placed once it is sunk, if it covers the shot cell and fits on the board.
+///
+/// \param target A pointer to the Player whose board was shot.
+/// \param result A pointer to the NET_MSG_RESULT or NET_MSG_DELTA message.
+/// \return const Ship* The ship sunk by the shot, or NULL.
+const Ship *apply_net_shot_result(Player *target, const NetMessage *result);
+
+/// \brief Applies the result of a shot of the local player to what is known of the opponent's board.
+///
+/// \param timeline A pointer to the Timeline playing the visual events of the game.
+/// \param local A pointer to the local Player.
+/// \param remote A pointer to the Player of the opponent.
+/// \param result A pointer to the NET_MSG_RESULT message.
+/// \return void
+void handle_net_result(Timeline *timeline, Player *local, Player *remote, const NetMessage *result);
+
+/// \brief Handles the messages of the opponent waiting in the inbox.
+///
+/// \param timeline A pointer to the Timeline playing the visual events of the game.
+/// \param local A pointer to the local Player.
+/// \param remote A pointer to the Player of the opponent.
+/// \return bool Returns true if the opponent resigned or the connection was lost, false otherwise.
+bool handle_net_messages(Timeline *timeline, Player *local, Player *remote);
+
+/// \brief Shows a waiting screen until the opponent is connected and has committed to its fleet.
+///
+/// The commitment of the local fleet is sent as soon as the connection is established.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param font A pointer to an SDL_Font.
+/// \param local A pointer to the local Player, with all ships placed.
+/// \return bool Returns true once both fleets are committed, false if the window was closed or the connection failed.
+bool wait_for_opponent_screen(SDL_Renderer *renderer, TTF_Font *font, const Player *local);
+
+/// \brief Plays a networked game: the placement of the local fleet, then the game against the other process.
+///
+/// The host is player 1 and shoots first. Each process holds only the board of its own player, the board of
+/// the opponent is filled in from the results of the shots.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param window A pointer to the SDL_Window.
+/// \param textures A pointer to the GameTextures structure.
+/// \param font A pointer to an SDL_Font.
+/// \param player1 A pointer to the Player structure of player 1.
+/// \param player2 A pointer to the Player structure of player 2.
+/// \return int Returns 0 if the game was played, -1 otherwise.
+int play_net_game(SDL_Renderer *renderer, SDL_Window *window, GameTextures *textures, TTF_Font *font,
+                  Player *player1, Player *player2);
+
+/// \brief Rebuilds both boards of a followed match from a snapshot.
+///
+/// \param player1 A pointer to the Player structure of player 1.
+/// \param player2 A pointer to the Player structure of player 2.
+/// \param snapshot A pointer to the NET_MSG_SNAPSHOT message.
+/// \return void
+void load_net_snapshot(Player *player1, Player *player2, const NetMessage *snapshot);
+
+/// \brief Follows the matches of a match server: a snapshot of each match, then its shots as they are fired.
+///
+/// Both fleets are hidden, the boards only show the shots. The next match is followed once a match is over,
+/// until the screen is left.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param textures A pointer to the GameTextures structure.
+/// \param font A pointer to an SDL_Font.
+/// \param player1 A pointer to the Player structure receiving the board of player 1.
+/// \param player2 A pointer to the Player structure receiving the board of player 2.
+/// \return int Returns 0 if the screen was left, -1 if the connection failed or was lost.
+int spectate_net_game(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *player1,
+                      Player *player2);
+
+/// \brief Starts the external engine given with --engine, which then plays the computer player.
+///
+/// The engine plays seat 2 in the text mode of engine.h, with the time per move given with --movetime. Its fleet
+/// and shots go through the same rules as those of the built-in AI, which takes over if the engine fails to answer.
+///
+/// \return bool Returns true if the engine was started, false otherwise.
+bool start_computer_engine(void);
+
+/// \brief Stops the engine of the computer player and prints the time it took per move.
+///
+/// \return void
+void stop_computer_engine(void);
+
+/// \brief Checks whether an external engine plays the computer player.
+///
+/// \return bool Returns true if the engine is running, false otherwise.
+bool is_engine_game(void);
+
+/// \brief Places the fleet of the computer player sent by the engine.
+///
+/// \param computer A pointer to the Player structure of the computer, with an empty board.
+/// \return bool Returns true if the engine sent a valid fleet, false otherwise.
+bool place_engine_fleet(Player *computer);
+
+/// \brief Fires the next shot of the engine at the opponent and sends the engine its result.
+///
+/// The shot is asked for on the engine thread. Until it arrives the turn stays pending and the game loop goes on
+/// drawing frames, the thread wakes it with an event once the engine has answered.
+///
+/// \param opponent A pointer to the Player structure representing the human player.
+/// \param pending A pointer set to true while the engine has not answered yet.
+/// \return ComputerShot The cell that was shot and whether it hit a ship, has_shot is false if the engine failed or
+/// has not answered yet.
+ComputerShot handle_engine_turn(Player *opponent, bool *pending);
+
+/// \brief Starts the thread waiting for the shots of the engine, called once the engine is started.
+///
+/// \return bool Returns true if the thread was started, false otherwise (the game then waits for the shots).
+bool start_engine_worker(void);
+
+/// \brief Stops the engine thread, after the shot it is waiting for.
+///
+/// \return void
+void stop_engine_worker(void);
+
+/// \brief The body of the engine thread.
+///
+/// \param data Pointer to the EngineWorker that owns the thread.
+/// \return int Always 0.
+int engine_worker_thread(void *data);
+
+/// \brief Tells the engine where the human player shot.
+///
+/// \param x The x-coordinate of the shot.
+/// \param y The y-coordinate of the shot.
+/// \return void
+void send_engine_human_shot(int x, int y);
+
+/// \brief Tells the engine that the game is over.
+///
+/// \param winner The number of the winning player.
+/// \return void
+void end_computer_engine_game(int winner);
+
+/// \brief Loads the policy network given with --policy, which then chooses the shots of the computer.
+///
+/// The network runs on the main thread, it is rejected if its most expensive shot takes longer than
+/// POLICY_MOVE_BUDGET milliseconds. After a warm-up shot, the slowest of POLICY_BUDGET_RUNS timed shots is checked.
+///
+/// \return bool Returns true if the network was loaded, false otherwise.
+bool load_computer_policy(void);
+
+/// \brief Frees the policy network of the computer and prints the time it took per shot.
+///
+/// \return void
+void unload_computer_policy(void);
+
+/// \brief Fills what a shooter knows of a player's board: the NetCellView of each cell and which ships are sunk.
+///
+/// \param player A pointer to the Player structure whose board is shot.
+/// \param view The buffer receiving the view of each cell, indexed x * BOARD_SIZE + y.
+/// \param sunk_ships The buffer receiving 1 for each sunk ship, in the order of their indices.
+/// \return void
+void get_player_view(const Player *player, uint8_t view[RULES_NUM_CELLS], uint8_t sunk_ships[RULES_NUM_SHIPS]);
+
+/// \brief Chooses the next shot of the computer with the policy network, from what the computer knows of the board.
+///
+/// \param opponent A pointer to the Player structure representing the human player.
+/// \param cell_x A pointer to the x-coordinate of the shot.
+/// \param cell_y A pointer to the y-coordinate of the shot.
+/// \return bool Returns true if a network is loaded and chose a cell, false otherwise.
+bool choose_computer_policy_shot(const Player *opponent, int *cell_x, int *cell_y);
+
+/// \brief Returns the probability that the computer shoots each cell of the opponent's board next.
+///
+/// With a policy network, it is the softmax of its scores over the cells not shot yet, the best one is shot. The
+/// built-in AI is followed on a copy of its context: TARGET and DESTROY shoot a single cell found by
+/// find_target_cell, a revisit picks a hit segment and a direction at random, and SEARCH picks uniformly among the
+/// cells that meet the minimum gap, or among all the cells not shot yet if none does.
+///
+/// \param opponent A pointer to the Player structure whose board the computer shoots.
+/// \param ai_state A pointer to the AI_State of the built-in AI.
+/// \param probabilities The buffer receiving the probability of each cell, indexed x * BOARD_SIZE + y.
+/// \return void
+void get_computer_shot_probabilities(const Player *opponent, const AI_State *ai_state,
+                                     float probabilities[RULES_NUM_CELLS]);
+
+/// \brief Adds the probabilities of the cells the built-in AI may shoot when it revisits a hit segment.
+///
+/// Each segment and direction is equally likely. A revisit that finds no cell moves on to the segments left, like
+/// handle_computer_turn does, and the AI searches again once none is left.
+///
+/// \param ctx A pointer to a copy of the AI_Context, in the SEARCH or REVISIT state with hit segments left.
+/// \param opponent A pointer to the Player structure whose board the computer shoots.
+/// \param weight The probability that the AI revisits the segments of the context.
+/// \param probabilities The buffer the probability of each cell is added to.
+/// \return float The probability of the revisits that found a cell, the rest is left to the SEARCH state.
+float add_revisit_probabilities(const AI_Context *ctx, const Player *opponent, float weight,
+                                float probabilities[RULES_NUM_CELLS]);
+
+/// \brief Returns the probability that the AI of the match server and of battleship_bot shoots each cell next.
+///
+/// It is uniform over the candidates of get_compact_shot_candidates, the ones choose_compact_shot picks from.
+///
+/// \param view The NetCellView of each cell of the board.
+/// \param probabilities The buffer receiving the probability of each cell.
+/// \return void
+void get_server_shot_probabilities(const uint8_t view[RULES_NUM_CELLS], float probabilities[RULES_NUM_CELLS]);
+
+/// \brief Starts the thread pondering the shots of the policy network, called once the network is loaded.
+///
+/// \return bool Returns true if the thread was started, false otherwise (the shots are then only computed on the
+/// computer's turn).
+bool start_computer_ponder(void);
+
+/// \brief Stops the pondering thread and prints how many shots were answered from its cache.
+///
+/// \return void
+void stop_computer_ponder(void);
+
+/// \brief Hands the computer's current view of the human's board to the pondering thread.
+///
+/// Called on every iteration of the game loop, it only wakes the thread when the view changed. The thread then
+/// works out the reply of the network to the view, then to the miss and the hit of that reply, and so on breadth
+/// first, up to PONDER_MAX_REPLIES replies. Work on a previous view is abandoned.
+///
+/// \param human A pointer to the Player structure whose board the computer shoots.
+/// \return void
+void ponder_computer_shot(const Player *human);
+
+/// \brief Looks up the shot worked out for an observation, and cancels the speculative work on a miss.
+///
+/// \param view The NetCellView of each cell of the board.
+/// \param sunk_ships Non-zero for each sunk ship, in the order of their indices.
+/// \param x A pointer to the x-coordinate of the shot.
+/// \param y A pointer to the y-coordinate of the shot.
+/// \return bool Returns true if the shot was in the cache, false otherwise.
+bool find_pondered_shot(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS], uint8_t *x,
+                        uint8_t *y);
+
+/// \brief The body of the pondering thread.
+///
+/// \param data Pointer to the PonderWorker that owns the thread.
+/// \return int Always 0.
+int ponder_worker_thread(void *data);
+
+/// \brief Finds the cache entry of an observation. Must be called with the mutex of the worker held.
+///
+/// \param worker Pointer to the PonderWorker.
+/// \param view The NetCellView of each cell of the board.
+/// \param sunk_ships Non-zero for each sunk ship, in the order of their indices.
+/// \return PonderEntry* A pointer to the entry, or NULL if the observation is not in the cache.
+PonderEntry *find_ponder_entry(PonderWorker *worker, const uint8_t view[RULES_NUM_CELLS],
+                               const uint8_t sunk_ships[RULES_NUM_SHIPS]);
+
+/// \brief Parses the command-line options of the game.
+///
+/// Supported options are --vsync (present on vertical blank), --stats (show the frame statistics overlay,
+/// it can also be toggled with F3), --stats-log <file> (append per-screen frame statistics to a file),
+/// --profile <file> (profile the render functions from the start, it can also be toggled with F4),
+/// --animation-speed <factor> (speed of the shot, turn and victory animations, 0 makes them instant),
+/// --host <port> and --connect <address>[:<port>] (play a networked game, see start_net_session),
+/// --spectate <address>[:<port>] (follow the matches of a match server, see spectate_net_game),
+/// --engine <command> with --movetime <ms> (let an external engine play the computer, see start_computer_engine),
+/// --policy <file> (let a policy network choose the shots of the computer, see load_computer_policy),
+/// --heatmap (shade the boards shot by the computer by the probability of its next shot, it can also be toggled
+/// with F5) and
+/// --render-test <dir> with --golden <dir> and --frames <n> (run the headless render test, see run_render_test).
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return bool Returns true if the options are valid, false otherwise.
+bool parse_game_options(int argc, char *argv[]);
+
+/// \brief Returns the command-line options of the game.
+///
+/// \return const GameOptions* A pointer to the parsed options.
+const GameOptions *get_game_options(void);
+
+/// \brief Returns the flags used to create renderers.
+///
+/// \return Uint32 The SDL_RendererFlags matching the command-line options.
+Uint32 get_renderer_flags(void);
+
+/// \brief Sets up a player with the scripted fleet used by the render test.
+///
+/// \param player A pointer to the Player structure to set up.
+/// \param num_placed The number of ships of the fleet placed on the board.
+/// \return void
+void setup_render_test_player(Player *player, int num_placed);
+
+/// \brief Fires the scripted shots of the render test at a player's board.
+///
+/// \param target A pointer to the Player structure receiving the shots.
+/// \return void
+void fire_render_test_shots(Player *target);
+
+/// \brief Creates the scripted state of the render test scenes.
+///
+/// \param state A pointer to the RenderTestState structure to fill.
+/// \param renderer A pointer to an SDL_Renderer.
+/// \return bool Returns true if the state was created, false otherwise.
+bool init_render_test_state(RenderTestState *state, SDL_Renderer *renderer);
+
+/// \brief Renders one frame of a render test scene with the same functions the screens use.
+///
+/// \param renderer A pointer to an SDL_Renderer.
+/// \param textures A pointer to the GameTextures structure.
+/// \param font A pointer to an SDL_Font.
+/// \param scene The scene to render.
+/// \param state A pointer to the RenderTestState holding the scripted state.
+/// \return void
+void render_test_scene(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, RenderTestScene scene,
+                       RenderTestState *state);
+
+/// \brief Frees the textures of the render test state.
+///
+/// \param state A pointer to the RenderTestState to destroy.
+/// \return void
+void destroy_render_test_state(RenderTestState *state);
+
+/// \brief Compares a rendered frame with a golden image.
+///
+/// \param frame The rendered frame, in SDL_PIXELFORMAT_ARGB8888.
+/// \param golden The golden image, in any format.
+/// \param tolerance The largest difference allowed in each color channel.
+/// \return int The number of pixels that differ more than the tolerance, or -1 if the sizes do not match.
+int compare_frame_with_golden(SDL_Surface *frame, SDL_Surface *golden, int tolerance);
+
+/// \brief Renders the scripted scenes offscreen, dumps them and compares them with golden images.
+///
+/// Each scene is rendered the number of frames given with --frames, on a software renderer that needs no
+/// display. The last frame of each scene is saved as <scene>.png in the directory given with --render-test
+/// and, if --golden is given, compared with the image of the same name in that directory. The wall time and
+/// CPU time per frame are printed for every scene.
+///
+/// \return int Returns 0 if every scene was rendered and matches its golden image, 1 otherwise.
+int run_render_test(void);
+
+/// \brief Frees resources and performs cleanup before exiting the game.
+///
+/// This function is responsible for stopping the save thread, destroying the textures, renderer and window
+/// owned by the scene manager, closing the font, quitting SDL subsystems and unmapping the asset bundle.
+///
+/// \param font Pointer to the TTF_Font to be closed.
+/// \return void
+void cleanup(TTF_Font *font);
+
+int main(int argc, char *argv[]) {
+    mark_startup_time();
+
+    // Parse the command-line options
+    if (!parse_game_options(argc, argv)) {
+        printf("Usage: %s [--vsync] [--stats] [--stats-log <file>] [--profile <file>] [--animation-speed <factor>]\n"
+               "          [--host <port> | --connect <address>[:<port>] | --spectate <address>[:<port>]]\n"
+               "          [--engine <command> [--movetime <ms>]] [--policy <weights file>] [--heatmap]\n"
+               "       %s --render-test <output dir> [--golden <dir>] [--frames <n>] [--profile <file>]\n", argv[0],
+               argv[0]);
+        return -1;
+    }
+
+    // Map the asset bundle before any asset is loaded
+    open_assets();
+
+    // Run the render test instead of the game
+    if (get_game_options()->render_test_dir != NULL) {
+        int result = run_render_test();
+        close_assets();
+        return result;
+    }
+
+    // Initialize SDL and SDL_image
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
+        return -1;
+    }
+
+    // Decode the images of the main menu in the background while the window and the font are created
+    if (!start_decode_pool()) {
+        printf("Decode threads could not be started, decoding on the main thread. SDL Error: %s\n", SDL_GetError());
+    }
+    prefetch_game_textures();
+    prefetch_main_menu();
+
+    // Toggle the frame statistics overlay with F3, the render profiler with F4 and the heatmap with F5 on every screen
+    SDL_AddEventWatch(frame_stats_event_watch, NULL);
+
+    // Start the background save thread
+    if (!start_save_worker()) {
+        printf("Save thread could not be started, saving synchronously. SDL Error: %s\n", SDL_GetError());
+    }
+
+    // Create the window and renderer shared by all screens
+    if (!init_scene_manager("Battleship", 320, 320)) {
+        return -1;
+    }
+    SDL_Window *window = get_scene_window();
+    SDL_Renderer *renderer = get_scene_renderer();
+    GameTextures *textures = get_scene_textures();
+
+    // Initialize SDL_ttf
+    if (TTF_Init() == -1) {
+        printf("TTF_Init: %s\n", TTF_GetError());
+        exit(2);
+    }
+
+    TTF_Font *font = NULL;
+    int font_size = 24;
+
+    // Open the font
+    font = TTF_OpenFontRW(open_asset("Assets/Fonts/cambria.ttc"), 1, font_size);
+    if (font == NULL) {
+        printf("TTF_OpenFont: %s\n", TTF_GetError());
+        exit(2);
+    }
+
+    // Initialize players
+    Player player1;
+    Player player2;
+    int current_turn = 1;
+    player1.is_turn = true;
+    player2.is_turn = false;
+    player1.has_shot = false;
+    player2.has_shot = false;
+    player1.can_shoot = true;
+    player2.can_shoot = true;
+    player1.remaining_ships = NUM_SHIPS;
+    player2.remaining_ships = NUM_SHIPS;
+
+    // Follow the matches of a match server instead of showing the main menu
+    if (get_game_options()->net_spectate) {
+        int result = start_net_session() ? spectate_net_game(renderer, textures, font, &player1, &player2) : -1;
+        cleanup(font);
+        return result;
+    }
+
+    // Play against another game process instead of showing the main menu
+    if (get_game_options()->net_host || get_game_options()->net_address != NULL) {
+        int result = start_net_session() ? play_net_game(renderer, window, textures, font, &player1, &player2) : -1;
+        cleanup(font);
+        return result;
+    }
+
+    // Let the policy network choose the shots of the computer, in new and loaded games
+    if (get_game_options()->policy_file != NULL && !load_computer_policy()) {
+        printf("The policy network could not be loaded, playing against the built-in AI.\n");
+    }
+
+    // Create the main menu
+    MainMenuOption menu_option = main_menu(renderer, font);
+
+    // The main menu is not shown again, free the textures it no longer holds
+    purge_unused_textures();
+
+    if (menu_option == MAIN_MENU_EXIT) {
+        // Exit the game
+        cleanup(font);
+        return 0;
+    } else if (menu_option == MAIN_MENU_LOAD) {
+        AI_State ai_state;
+        bool load_success = load_game(&player1, &player2, &current_turn, &ai_state);
+        if (!load_success) {
+            printf("Error loading saved game.\n");
+            cleanup(font);
+            return -1;
+        }
+        player1.is_turn = (current_turn == 1);
+        player2.is_turn = (current_turn == 2);
+
+        // Resize the window for the loaded game
+        const char *window_title = (current_turn == 1) ? "Battleship - Player 1" : "Battleship - Player 2";
+        enter_scene(window_title, 800, 600);
+
+        if (!player2.is_human) {
+            ai_state = SEARCH;
+        }
+
+        game_screen(renderer, window, textures, font, &player1, &player2, &current_turn, &ai_state);
+    } else if (menu_option == MAIN_MENU_NEW_GAME_PVP) {
+        // Resize the window for the placement phase of player1
+        enter_scene("Battleship - Player 1", 800, 600);
+
+        player1.is_human = true;
+        player2.is_human = true;
+
+        placement_phase_screen(renderer, textures, font, &player1);
+
+        if (player1.remaining_ships != 5) {
+            // Player 1 did not place all ships
+            printf("Player 1 did not place all ships.\n");
+            cleanup(font);
+            return -1;
+        }
+
+        // Switch to the placement phase of player2
+        enter_scene("Battleship - Player 2", 800, 600);
+
+        placement_phase_screen(renderer, textures, font, &player2);
+
+        if (player2.remaining_ships != 5) {
+            // Player 1 did not place all ships
+            printf("Player 1 did not place all ships.\n");
+            cleanup(font);
+            return -1;
+        }
+
+        // Switch to the game screen
+        enter_scene("Battleship - Player 1", 800, 600);
+
+        // Seed the random number generator
+        pcg32_srandom(time(NULL), (intptr_t) &main);
+
+        game_screen(renderer, window, textures, font, &player1, &player2, &current_turn, NULL);
+    } else if (menu_option == MAIN_MENU_NEW_GAME_PVC) {
+        // Resize the window for the placement phase
+        enter_scene("Battleship - Player 1", 800, 600);
+
+        player1.is_human = true;
+        player2.is_human = false;
+
+        placement_phase_screen(renderer, textures, font, &player1);
+
+        if (player1.remaining_ships != 5) {
+            // Player 1 did not place all ships
+            printf("Player 1 did not place all ships.\n");
+            cleanup(font);
+            return -1;
+        }
+
+        // Let the external engine play the computer, the built-in AI plays if it cannot be started
+        if (get_game_options()->engine_command != NULL && !start_computer_engine()) {
+            printf("The engine could not be started, playing against the built-in AI.\n");
+        }
+
+        placement_phase_computer(&player2);
+
+        // Switch to the game screen
+        enter_scene("Battleship - Player 1", 800, 600);
+
+        AI_State ai_state = SEARCH;
+
+        game_screen(renderer, window, textures, font, &player1, &player2, &current_turn, &ai_state);
+    }
+
+    // Cleanup and exit
+    cleanup(font);
+    return 0;
+}
+
+// Function definitions
+
+// Draw calls issued by the game, read by the frame statistics
+static Uint64 draw_call_count = 0;
+#define SDL_RenderCopy(...) (draw_call_count++, PROFILE_CALL(PROFILE_DRAW_CALL, SDL_RenderCopy(__VA_ARGS__)))
+#define SDL_RenderGeometry(...) (draw_call_count++, PROFILE_CALL(PROFILE_DRAW_CALL, SDL_RenderGeometry(__VA_ARGS__)))
+#define SDL_RenderFillRect(...) (draw_call_count++, PROFILE_CALL(PROFILE_DRAW_CALL, SDL_RenderFillRect(__VA_ARGS__)))
+#define SDL_RenderDrawRect(...) (draw_call_count++, PROFILE_CALL(PROFILE_DRAW_CALL, SDL_RenderDrawRect(__VA_ARGS__)))
+#define SDL_RenderDrawLine(...) (draw_call_count++, PROFILE_CALL(PROFILE_DRAW_CALL, SDL_RenderDrawLine(__VA_ARGS__)))
+
+// Render profiler, the SDL calls below are only timed while it is enabled
+static RenderProfiler render_profiler;
+#define PROFILE_CALL(kind, call) \
+    (render_profiler.enabled ? (render_profiler.call_start = SDL_GetPerformanceCounter(), \
+                                end_profile_call(kind, call)) : (call))
+#define PROFILE_POINTER_CALL(kind, call) \
+    (render_profiler.enabled ? (render_profiler.call_start = SDL_GetPerformanceCounter(), \
+                                end_profile_pointer_call(kind, call)) : (void *) (call))
+#define SDL_CreateTexture(...) \
+    ((SDL_Texture *) PROFILE_POINTER_CALL(PROFILE_TEXTURE_UPLOAD, SDL_CreateTexture(__VA_ARGS__)))
+#define SDL_CreateTextureFromSurface(...) \
+    ((SDL_Texture *) PROFILE_POINTER_CALL(PROFILE_TEXTURE_UPLOAD, SDL_CreateTextureFromSurface(__VA_ARGS__)))
+#define SDL_UpdateTexture(...) PROFILE_CALL(PROFILE_TEXTURE_UPLOAD, SDL_UpdateTexture(__VA_ARGS__))
+#define TTF_RenderText_Solid(...) \
+    ((SDL_Surface *) PROFILE_POINTER_CALL(PROFILE_TEXT_RENDER, TTF_RenderText_Solid(__VA_ARGS__)))
+#define TTF_RenderGlyph_Solid(...) \
+    ((SDL_Surface *) PROFILE_POINTER_CALL(PROFILE_TEXT_RENDER, TTF_RenderGlyph_Solid(__VA_ARGS__)))
+
+// State of the background save thread
+static SaveWorker save_worker = {.complete_event = (Uint32) -1};
+
+bool save_game(Player *player1, Player *player2, int current_turn, AI_State *ai_state) {
+    // Copy the game state into a snapshot and write it synchronously
+    SaveSnapshot snapshot;
+    snapshot.player1 = *player1;
+    snapshot.player2 = *player2;
+    snapshot.current_turn = current_turn;
+    snapshot.ai_state = ai_state != NULL ? *ai_state : SEARCH;
+
+    return write_save_file(&snapshot);
+}
+
+bool write_save_file(const SaveSnapshot *snapshot) {
+    // Write the snapshot to a temporary file first
+    FILE *save_file = fopen(SAVE_TEMP_FILE_NAME, "wb");
+    if (save_file == NULL) {
+        return false;
+    }
+
+    // Write player1, player2, current_turn and ai_state to the save file
+    bool success = fwrite(&snapshot->player1, sizeof(Player), 1, save_file) == 1 &&
+                   fwrite(&snapshot->player2, sizeof(Player), 1, save_file) == 1 &&
+                   fwrite(&snapshot->current_turn, sizeof(int), 1, save_file) == 1 &&
+                   fwrite(&snapshot->ai_state, sizeof(AI_State), 1, save_file) == 1;
+
+    // Make sure the data has reached the disk before replacing the old save
+    success = success && fflush(save_file) == 0;
+#ifdef _WIN32
+    success = success && _commit(_fileno(save_file)) == 0;
+#else
+    success = success && fsync(fileno(save_file)) == 0;
+#endif
+
+    // Close the save file
+    success = fclose(save_file) == 0 && success;
+    if (!success) {
+        remove(SAVE_TEMP_FILE_NAME);
+        return false;
+    }
+
+    // Replace the old save file with the new one
+#ifdef _WIN32
+    remove(SAVE_FILE_NAME); // rename does not overwrite existing files on Windows
+#endif
+    return rename(SAVE_TEMP_FILE_NAME, SAVE_FILE_NAME) == 0;
+}
+
+int save_worker_thread(void *data) {
+    SaveWorker *worker = (SaveWorker *) data;
+    SaveSnapshot snapshot;
+
+    SDL_LockMutex(worker->mutex);
+    while (true) {
+        // Wait until there is a snapshot to write or the thread is asked to quit
+        while (!worker->has_pending && !worker->quit) {
+            SDL_CondWait(worker->condition, worker->mutex);
+        }
+        if (!worker->has_pending) {
+            break;
+        }
+
+        // Take the snapshot and release the lock while writing, so new requests are never blocked by the disk
+        snapshot = worker->pending;
+        worker->has_pending = false;
+        SDL_UnlockMutex(worker->mutex);
+
+        bool success = write_save_file(&snapshot);
+
+        // Report the result back to the UI thread
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = worker->complete_event;
+        event.user.code = success ? 1 : 0;
+        SDL_PushEvent(&event);
+
+        SDL_LockMutex(worker->mutex);
+    }
+    SDL_UnlockMutex(worker->mutex);
+
+    return 0;
+}
+
+bool start_save_worker(void) {
+    // Register the event used to report finished saves
+    save_worker.complete_event = SDL_RegisterEvents(1);
+    if (save_worker.complete_event == (Uint32) -1) {
+        return false;
+    }
+
+    // Create the synchronization primitives and the thread
+    save_worker.has_pending = false;
+    save_worker.quit = false;
+    save_worker.mutex = SDL_CreateMutex();
+    save_worker.condition = SDL_CreateCond();
+    if (save_worker.mutex == NULL || save_worker.condition == NULL) {
+        stop_save_worker();
+        return false;
+    }
+
+    save_worker.thread = SDL_CreateThread(save_worker_thread, "save_worker", &save_worker);
+    if (save_worker.thread == NULL) {
+        stop_save_worker();
+        return false;
+    }
+
+    return true;
+}
+
+void stop_save_worker(void) {
+    // Ask the thread to quit after writing any pending snapshot, and wait for it
+    if (save_worker.thread != NULL) {
+        SDL_LockMutex(save_worker.mutex);
+        save_worker.quit = true;
+        SDL_CondSignal(save_worker.condition);
+        SDL_UnlockMutex(save_worker.mutex);
+
+        SDL_WaitThread(save_worker.thread, NULL);
+        save_worker.thread = NULL;
+    }
+
+    // Free the synchronization primitives
+    if (save_worker.condition != NULL) {
+        SDL_DestroyCond(save_worker.condition);
+        save_worker.condition = NULL;
+    }
+    if (save_worker.mutex != NULL) {
+        SDL_DestroyMutex(save_worker.mutex);
+        save_worker.mutex = NULL;
+    }
+}
+
+void request_save(Player *player1, Player *player2, int current_turn, AI_State *ai_state) {
+    // Fall back to a synchronous save if the save thread is not running
+    if (save_worker.thread == NULL) {
+        bool success = save_game(player1, player2, current_turn, ai_state);
+        if (save_worker.complete_event != (Uint32) -1) {
+            SDL_Event event;
+            SDL_zero(event);
+            event.type = save_worker.complete_event;
+            event.user.code = success ? 1 : 0;
+            SDL_PushEvent(&event);
+        } else if (success) {
+            printf("Game saved successfully!\n");
+        } else {
+            printf("Error saving game!\n");
+        }
+        return;
+    }
+
+    // Hand the snapshot to the save thread, replacing any snapshot that has not been written yet
+    SDL_LockMutex(save_worker.mutex);
+    save_worker.pending.player1 = *player1;
+    save_worker.pending.player2 = *player2;
+    save_worker.pending.current_turn = current_turn;
+    save_worker.pending.ai_state = ai_state != NULL ? *ai_state : SEARCH;
+    save_worker.has_pending = true;
+    SDL_CondSignal(save_worker.condition);
+    SDL_UnlockMutex(save_worker.mutex);
+}
+
+Uint32 get_save_complete_event(void) {
+    return save_worker.complete_event;
+}
+
+bool load_game(Player *player1, Player *player2, int *current_turn, AI_State *ai_state) {
+    // Load the game state from a file ("saved_game.dat")
+    FILE *save_file = fopen(SAVE_FILE_NAME, "rb");
+    if (save_file == NULL) {
+        return false;
+    }
+
+    // Read player1, player2, current_turn, and ai_state from the save file
+    fread(player1, sizeof(Player), 1, save_file);
+    fread(player2, sizeof(Player), 1, save_file);
+    fread(current_turn, sizeof(int), 1, save_file);
+    fread(ai_state, sizeof(AI_State), 1, save_file);
+
+    // Close the save file
+    fclose(save_file);
+    return true;
+}
+
+// Asset bundle mapped at startup
+static AssetBundle asset_bundle;
+
+void open_assets(void) {
+    if (!open_asset_bundle(&asset_bundle, ASSET_BUNDLE_FILE_NAME)) {
+        printf("Asset bundle %s not found, loading assets from files.\n", ASSET_BUNDLE_FILE_NAME);
+    }
+}
+
+void close_assets(void) {
+    close_asset_bundle(&asset_bundle);
+}
+
+SDL_RWops *open_asset(const char *filename) {
+    // Read the asset from the bundle if it contains it
+    size_t size;
+    const void *data = find_asset(&asset_bundle, filename, &size);
+    if (data != NULL) {
+        return SDL_RWFromConstMem(data, (int) size);
+    }
+
+    return SDL_RWFromFile(filename, "rb");
+}
+
+// State of the image decoding threads
+static DecodePool decode_pool;
+
+SDL_Surface *decode_image(const char *filename) {
+    SDL_Surface *image = IMG_Load_RW(open_asset(filename), 1);
+    if (image == NULL) {
+        printf("Failed to load image: %s. SDL Error: %s\n", filename, IMG_GetError());
+        return NULL;
+    }
+
+    // Convert to the texture format on this thread, so the upload does not convert again
+    SDL_Surface *surface = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(image);
+    return surface;
+}
+
+int decode_worker_thread(void *data) {
+    DecodePool *pool = (DecodePool *) data;
+
+    SDL_LockMutex(pool->mutex);
+    while (!pool->quit) {
+        // Take the oldest queued job
+        DecodeJob *job = NULL;
+        for (int i = 0; i < MAX_DECODE_JOBS; i++) {
+            DecodeJob *candidate = &pool->jobs[i];
+            if (candidate->state == DECODE_JOB_QUEUED && (job == NULL || candidate->sequence < job->sequence)) {
+                job = candidate;
+            }
+        }
+        if (job == NULL) {
+            SDL_CondWait(pool->job_queued, pool->mutex);
+            continue;
+        }
+        job->state = DECODE_JOB_RUNNING;
+
+        // Decode without holding the lock
+        char filename[128];
+        memcpy(filename, job->filename, sizeof(filename));
+        SDL_UnlockMutex(pool->mutex);
+        SDL_Surface *surface = decode_image(filename);
+        SDL_LockMutex(pool->mutex);
+
+        // Drop the image if the job was cancelled while it was decoded
+        if (job->discard) {
+            SDL_FreeSurface(surface);
+            job->discard = false;
+            job->state = DECODE_JOB_FREE;
+            continue;
+        }
+
+        job->surface = surface;
+        job->state = DECODE_JOB_DONE;
+        SDL_CondBroadcast(pool->job_done);
+    }
+    SDL_UnlockMutex(pool->mutex);
+
+    return 0;
+}
+
+bool start_decode_pool(void) {
+    // Create the synchronization primitives
+    SDL_zero(decode_pool);
+    decode_pool.mutex = SDL_CreateMutex();
+    decode_pool.job_queued = SDL_CreateCond();
+    decode_pool.job_done = SDL_CreateCond();
+    if (decode_pool.mutex == NULL || decode_pool.job_queued == NULL || decode_pool.job_done == NULL) {
+        stop_decode_pool();
+        return false;
+    }
+
+    // Leave one core to the main thread
+    int num_threads = SDL_GetCPUCount() - 1;
+    if (num_threads < 1) {
+        num_threads = 1;
+    } else if (num_threads > MAX_DECODE_THREADS) {
+        num_threads = MAX_DECODE_THREADS;
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        SDL_Thread *thread = SDL_CreateThread(decode_worker_thread, "decode_worker", &decode_pool);
+        if (thread == NULL) {
+            break;
+        }
+        decode_pool.threads[decode_pool.num_threads++] = thread;
+    }
+    if (decode_pool.num_threads == 0) {
+        stop_decode_pool();
+        return false;
+    }
+
+    return true;
+}
+
+void stop_decode_pool(void) {
+    // Ask the threads to quit after their current job, and wait for them
+    if (decode_pool.num_threads > 0) {
+        SDL_LockMutex(decode_pool.mutex);
+        decode_pool.quit = true;
+        SDL_CondBroadcast(decode_pool.job_queued);
+        SDL_UnlockMutex(decode_pool.mutex);
+
+        for (int i = 0; i < decode_pool.num_threads; i++) {
+            SDL_WaitThread(decode_pool.threads[i], NULL);
+        }
+        decode_pool.num_threads = 0;
+    }
+
+    // Free the images nobody used
+    for (int i = 0; i < MAX_DECODE_JOBS; i++) {
+        SDL_FreeSurface(decode_pool.jobs[i].surface);
+        decode_pool.jobs[i].surface = NULL;
+        decode_pool.jobs[i].state = DECODE_JOB_FREE;
+    }
+
+    // Free the synchronization primitives
+    if (decode_pool.job_done != NULL) {
+        SDL_DestroyCond(decode_pool.job_done);
+        decode_pool.job_done = NULL;
+    }
+    if (decode_pool.job_queued != NULL) {
+        SDL_DestroyCond(decode_pool.job_queued);
+        decode_pool.job_queued = NULL;
+    }
+    if (decode_pool.mutex != NULL) {
+        SDL_DestroyMutex(decode_pool.mutex);
+        decode_pool.mutex = NULL;
+    }
+}
+
+int prefetch_image(const char *filename) {
+    if (decode_pool.num_threads == 0) {
+        return -1;
+    }
+
+    // Queue the image in a free job, unless it is already queued
+    int job = find_decode_job(filename);
+    if (job >= 0) {
+        return job;
+    }
+
+    SDL_LockMutex(decode_pool.mutex);
+    for (int i = 0; i < MAX_DECODE_JOBS; i++) {
+        DecodeJob *candidate = &decode_pool.jobs[i];
+        if (candidate->state == DECODE_JOB_FREE) {
+            snprintf(candidate->filename, sizeof(candidate->filename), "%s", filename);
+            candidate->sequence = decode_pool.next_sequence++;
+            candidate->surface = NULL;
+            candidate->discard = false;
+            candidate->state = DECODE_JOB_QUEUED;
+            job = i;
+            SDL_CondSignal(decode_pool.job_queued);
+            break;
+        }
+    }
+    SDL_UnlockMutex(decode_pool.mutex);
+
+    return job;
+}
+
+int find_decode_job(const char *filename) {
+    if (decode_pool.num_threads == 0) {
+        return -1;
+    }
+
+    int job = -1;
+    SDL_LockMutex(decode_pool.mutex);
+    for (int i = 0; i < MAX_DECODE_JOBS; i++) {
+        DecodeJob *candidate = &decode_pool.jobs[i];
+        if (candidate->state != DECODE_JOB_FREE && !candidate->discard && strcmp(candidate->filename, filename) == 0) {
+            job = i;
+            break;
+        }
+    }
+    SDL_UnlockMutex(decode_pool.mutex);
+
+    return job;
+}
+
+SDL_Surface *wait_decoded_image(int job) {
+    SDL_LockMutex(decode_pool.mutex);
+    DecodeJob *decode_job = &decode_pool.jobs[job];
+    while (decode_job->state != DECODE_JOB_DONE) {
+        SDL_CondWait(decode_pool.job_done, decode_pool.mutex);
+    }
+
+    // Hand the surface to the caller and free the job
+    SDL_Surface *surface = decode_job->surface;
+    decode_job->surface = NULL;
+    decode_job->state = DECODE_JOB_FREE;
+    SDL_UnlockMutex(decode_pool.mutex);
+
+    return surface;
+}
+
+SDL_Surface *poll_decoded_image(int job) {
+    SDL_Surface *surface = NULL;
+
+    SDL_LockMutex(decode_pool.mutex);
+    DecodeJob *decode_job = &decode_pool.jobs[job];
+    if (decode_job->state == DECODE_JOB_DONE) {
+        surface = decode_job->surface;
+        decode_job->surface = NULL;
+        decode_job->state = DECODE_JOB_FREE;
+    }
+    SDL_UnlockMutex(decode_pool.mutex);
+
+    return surface;
+}
+
+void cancel_decode_job(const char *filename) {
+    int job = find_decode_job(filename);
+    if (job < 0) {
+        return;
+    }
+
+    SDL_LockMutex(decode_pool.mutex);
+    DecodeJob *decode_job = &decode_pool.jobs[job];
+    if (decode_job->state == DECODE_JOB_RUNNING) {
+        decode_job->discard = true;
+    } else {
+        SDL_FreeSurface(decode_job->surface);
+        decode_job->surface = NULL;
+        decode_job->state = DECODE_JOB_FREE;
+    }
+    SDL_UnlockMutex(decode_pool.mutex);
+}
+
+SDL_Surface *take_image(const char *filename) {
+    int job = find_decode_job(filename);
+    return job >= 0 ? wait_decoded_image(job) : decode_image(filename);
+}
+
+// Time the game was started, in SDL_GetPerformanceCounter units
+static Uint64 startup_time = 0;
+
+void mark_startup_time(void) {
+    startup_time = SDL_GetPerformanceCounter();
+}
+
+void report_first_interactive_frame(void) {
+    static bool reported = false;
+    if (reported) {
+        return;
+    }
+    reported = true;
+
+    Uint64 elapsed = SDL_GetPerformanceCounter() - startup_time;
+    printf("First interactive frame after %.1f ms\n", (double) elapsed * 1000.0 / (double) SDL_GetPerformanceFrequency());
+}
+
+SDL_Texture *load_texture(const char *filename, SDL_Renderer *renderer) {
+    // Take the image decoded in the background, or decode it now
+    SDL_Surface *surface = take_image(filename);
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    // Convert the SDL_Surface to an SDL_Texture
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture == NULL) {
+        printf("Failed to create texture from surface. SDL Error: %s\n", SDL_GetError());
+    }
+
+    // Free the SDL_Surface
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+// Image file of each tile, in the order of the Tile enum
+static const char *const tile_files[TILE_COUNT] = {
+        "Assets/ocean.png",
+        "Assets/ocean_selection_mode.png",
+        "Assets/ship_top.png",
+        "Assets/ship_left.png",
+        "Assets/ship_middle.png",
+        "Assets/ship_right.png",
+        "Assets/ship_bottom.png",
+        "Assets/hit_enemy_ship.png",
+        "Assets/hit_own_ship.png",
+        "Assets/hit_ocean.png",
+        "Assets/miss.png"
+};
+
+void prefetch_game_textures(void) {
+    for (int i = 0; i < TILE_COUNT; i++) {
+        prefetch_image(tile_files[i]);
+    }
+}
+
+GameTextures *load_game_textures(SDL_Renderer *renderer) {
+
+    // Allocate memory for the GameTextures structure
+    GameTextures *textures = (GameTextures *) malloc(sizeof(GameTextures));
+    if (textures == NULL) {
+        printf("Failed to allocate memory for game textures.\n");
+        return NULL;
+    }
+
+    // Create the atlas surface, with the tiles side by side
+    SDL_Surface *atlas_surface = SDL_CreateRGBSurfaceWithFormat(0, TILE_COUNT * CELL_SIZE, CELL_SIZE, 32,
+                                                                SDL_PIXELFORMAT_ARGB8888);
+    if (atlas_surface == NULL) {
+        printf("Failed to create texture atlas. SDL Error: %s\n", SDL_GetError());
+        free(textures);
+        return NULL;
+    }
+
+    // Decode each tile and copy it into its place in the atlas
+    for (int i = 0; i < TILE_COUNT; i++) {
+        textures->tiles[i] = (SDL_Rect) {i * CELL_SIZE, 0, CELL_SIZE, CELL_SIZE};
+
+        SDL_Surface *tile_surface = take_image(tile_files[i]);
+        if (tile_surface == NULL) {
+            continue;
+        }
+        SDL_SetSurfaceBlendMode(tile_surface, SDL_BLENDMODE_NONE);
+        SDL_BlitScaled(tile_surface, NULL, atlas_surface, &textures->tiles[i]);
+        SDL_FreeSurface(tile_surface);
+    }
+
+    // Upload the atlas as a single texture
+    textures->atlas = SDL_CreateTextureFromSurface(renderer, atlas_surface);
+    SDL_FreeSurface(atlas_surface);
+    if (textures->atlas == NULL) {
+        printf("Failed to create texture from surface. SDL Error: %s\n", SDL_GetError());
+        free(textures);
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(textures->atlas, SDL_BLENDMODE_BLEND);
+
+    return textures;
+}
+
+const int *get_quad_indices(void) {
+    static int indices[QUAD_BATCH_CAPACITY * 6];
+    static bool initialized = false;
+
+    // Two triangles per quad, the pattern is the same for every batch
+    if (!initialized) {
+        for (int i = 0; i < QUAD_BATCH_CAPACITY; i++) {
+            indices[i * 6 + 0] = i * 4 + 0;
+            indices[i * 6 + 1] = i * 4 + 1;
+            indices[i * 6 + 2] = i * 4 + 2;
+            indices[i * 6 + 3] = i * 4 + 0;
+            indices[i * 6 + 4] = i * 4 + 2;
+            indices[i * 6 + 5] = i * 4 + 3;
+        }
+        initialized = true;
+    }
+
+    return indices;
+}
+
+void begin_quad_batch(QuadBatch *batch, SDL_Renderer *renderer, SDL_Texture *texture) {
+    batch->renderer = renderer;
+    batch->texture = texture;
+    batch->num_quads = 0;
+    batch->modulation = (SDL_Color) {255, 255, 255, 255};
+    batch->u_scale = 1.0f;
+    batch->v_scale = 1.0f;
+
+    if (texture != NULL) {
+        // Texture coordinates are normalized, so remember the texture size
+        int texture_width, texture_height;
+        if (SDL_QueryTexture(texture, NULL, NULL, &texture_width, &texture_height) == 0) {
+            batch->u_scale = 1.0f / (float) texture_width;
+            batch->v_scale = 1.0f / (float) texture_height;
+        }
+
+        // SDL_RenderGeometry ignores the texture color and alpha modulation, so apply them to the vertices instead
+        SDL_GetTextureColorMod(texture, &batch->modulation.r, &batch->modulation.g, &batch->modulation.b);
+        SDL_GetTextureAlphaMod(texture, &batch->modulation.a);
+    }
+}
+
+void add_batch_quad(QuadBatch *batch, const SDL_Rect *source, const SDL_Rect *destination, SDL_Color color,
+                    bool rotate) {
+    // Make room if the batch is full
+    if (batch->num_quads == QUAD_BATCH_CAPACITY) {
+        flush_quad_batch(batch);
+    }
+
+    // Texture coordinates of the source area
+    float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+    if (source != NULL) {
+        u0 = (float) source->x * batch->u_scale;
+        v0 = (float) source->y * batch->v_scale;
+        u1 = (float) (source->x + source->w) * batch->u_scale;
+        v1 = (float) (source->y + source->h) * batch->v_scale;
+    }
+
+    // Apply the texture modulation to the quad color
+    color.r = (Uint8) (color.r * batch->modulation.r / 255);
+    color.g = (Uint8) (color.g * batch->modulation.g / 255);
+    color.b = (Uint8) (color.b * batch->modulation.b / 255);
+    color.a = (Uint8) (color.a * batch->modulation.a / 255);
+
+    float left = (float) destination->x;
+    float top = (float) destination->y;
+    float right = (float) (destination->x + destination->w);
+    float bottom = (float) (destination->y + destination->h);
+
+    // Corners in the order top left, top right, bottom right, bottom left
+    SDL_Vertex *quad = &batch->vertices[batch->num_quads * 4];
+    if (rotate) {
+        // Rotated 90 degrees clockwise: the top left of the source ends up in the top right corner
+        quad[0] = (SDL_Vertex) {{left, top}, color, {u0, v1}};
+        quad[1] = (SDL_Vertex) {{right, top}, color, {u0, v0}};
+        quad[2] = (SDL_Vertex) {{right, bottom}, color, {u1, v0}};
+        quad[3] = (SDL_Vertex) {{left, bottom}, color, {u1, v1}};
+    } else {
+        quad[0] = (SDL_Vertex) {{left, top}, color, {u0, v0}};
+        quad[1] = (SDL_Vertex) {{right, top}, color, {u1, v0}};
+        quad[2] = (SDL_Vertex) {{right, bottom}, color, {u1, v1}};
+        quad[3] = (SDL_Vertex) {{left, bottom}, color, {u0, v1}};
+    }
+    batch->num_quads++;
+}
+
+void add_batch_tile(QuadBatch *batch, GameTextures *textures, Tile tile, const SDL_Rect *destination, bool rotate) {
+    SDL_Color white = {255, 255, 255, 255};
+    add_batch_quad(batch, &textures->tiles[tile], destination, white, rotate);
+}
+
+void flush_quad_batch(QuadBatch *batch) {
+    // Draw all quads at once
+    if (batch->num_quads > 0) {
+        SDL_RenderGeometry(batch->renderer, batch->texture, batch->vertices, batch->num_quads * 4, get_quad_indices(),
+                           batch->num_quads * 6);
+    }
+    batch->num_quads = 0;
+}
+
+void get_animation_frame_name(const char *filepath, int frame, char *filename, size_t size) {
+    snprintf(filename, size, "%s%d.png", filepath, frame);
+}
+
+bool init_animation_player(AnimationPlayer *player, SDL_Renderer *renderer, const char *filepath, int num_frames,
+                           int fps) {
+    SDL_zerop(player);
+    player->renderer = renderer;
+    snprintf(player->filepath, sizeof(player->filepath), "%s", filepath);
+    player->num_frames = num_frames;
+    player->frame_duration = SDL_GetPerformanceFrequency() / fps;
+    player->current_frame = -1;
+    player->target_frame = 0;
+    for (int i = 0; i < ANIMATION_RING_SIZE; i++) {
+        player->ring_frames[i] = -1;
+    }
+
+    // Load the first frame, its size is the size of every texture of the ring
+    char filename[128];
+    get_animation_frame_name(filepath, 0, filename, sizeof(filename));
+    SDL_Surface *surface = take_image(filename);
+    if (surface == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < ANIMATION_RING_SIZE; i++) {
+        player->ring[i] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                            surface->w, surface->h);
+        if (player->ring[i] == NULL) {
+            printf("Failed to create animation texture. SDL Error: %s\n", SDL_GetError());
+            SDL_FreeSurface(surface);
+            destroy_animation_player(player);
+            return false;
+        }
+    }
+
+    SDL_UpdateTexture(player->ring[0], NULL, surface->pixels, surface->pitch);
+    SDL_FreeSurface(surface);
+    player->ring_frames[0] = 0;
+    player->current_frame = 0;
+
+    // Start the animation now, with the next frames decoding in the background
+    player->start_time = SDL_GetPerformanceCounter();
+    update_animation_player(player, player->start_time);
+    return true;
+}
+
+bool update_animation_player(AnimationPlayer *player, Uint64 now) {
+    int num_frames = player->num_frames;
+    int previous_target = player->target_frame;
+    int target = (int) (((now - player->start_time) / player->frame_duration) % (Uint64) num_frames);
+    player->target_frame = target;
+
+    // Cancel the decodes of the frames that were skipped, for example while the window was minimized
+    char filename[128];
+    if (target != previous_target) {
+        for (int k = 0; k < ANIMATION_RING_SIZE; k++) {
+            int frame = (previous_target + k) % num_frames;
+            if ((frame - target + num_frames) % num_frames >= ANIMATION_RING_SIZE) {
+                get_animation_frame_name(player->filepath, frame, filename, sizeof(filename));
+                cancel_decode_job(filename);
+            }
+        }
+    }
+
+    // Fill the ring with the due frame and the ones after it
+    for (int k = 0; k < ANIMATION_RING_SIZE; k++) {
+        int frame = (target + k) % num_frames;
+
+        bool in_ring = false;
+        for (int i = 0; i < ANIMATION_RING_SIZE; i++) {
+            in_ring = in_ring || player->ring_frames[i] == frame;
+        }
+        if (in_ring) {
+            continue;
+        }
+
+        // Take the frame if it is decoded, otherwise make sure it is queued
+        get_animation_frame_name(player->filepath, frame, filename, sizeof(filename));
+        SDL_Surface *surface = NULL;
+        int job = find_decode_job(filename);
+        if (job >= 0) {
+            surface = poll_decoded_image(job);
+        } else if (prefetch_image(filename) < 0 && k == 0) {
+            // Without decode threads, only the due frame is decoded, on this thread
+            surface = decode_image(filename);
+        }
+        if (surface == NULL) {
+            continue;
+        }
+
+        // Use a slot that holds no upcoming frame; the frame on screen is only replaced by the due frame
+        int slot = -1;
+        for (int i = 0; i < ANIMATION_RING_SIZE && slot < 0; i++) {
+            int slot_frame = player->ring_frames[i];
+            bool upcoming = slot_frame >= 0 && (slot_frame - target + num_frames) % num_frames < ANIMATION_RING_SIZE;
+            bool on_screen = slot_frame == player->current_frame && k > 0;
+            if (!upcoming && !on_screen) {
+                slot = i;
+            }
+        }
+        if (slot >= 0) {
+            SDL_UpdateTexture(player->ring[slot], NULL, surface->pixels, surface->pitch);
+            player->ring_frames[slot] = frame;
+        }
+        SDL_FreeSurface(surface);
+    }
+
+    // Show the due frame if it is in the ring
+    for (int i = 0; i < ANIMATION_RING_SIZE; i++) {
+        if (player->ring_frames[i] == target && player->current_frame != target) {
+            player->current_frame = target;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Uint64 get_next_animation_time(const AnimationPlayer *player, Uint64 now) {
+    // Check again shortly while the due frame is still being decoded
+    if (player->current_frame != player->target_frame) {
+        return now + SDL_GetPerformanceFrequency() / 500;
+    }
+
+    Uint64 elapsed_frames = (now - player->start_time) / player->frame_duration;
+    return player->start_time + (elapsed_frames + 1) * player->frame_duration;
+}
+
+SDL_Texture *get_animation_texture(const AnimationPlayer *player) {
+    for (int i = 0; i < ANIMATION_RING_SIZE; i++) {
+        if (player->current_frame >= 0 && player->ring_frames[i] == player->current_frame) {
+            return player->ring[i];
+        }
+    }
+
+    return NULL;
+}
+
+void destroy_animation_player(AnimationPlayer *player) {
+    // Cancel the frames still being decoded
+    char filename[128];
+    for (int k = 0; k < ANIMATION_RING_SIZE; k++) {
+        get_animation_frame_name(player->filepath, (player->target_frame + k) % player->num_frames, filename,
+                                 sizeof(filename));
+        cancel_decode_job(filename);
+    }
+
+    for (int i = 0; i < ANIMATION_RING_SIZE; i++) {
+        if (player->ring[i] != NULL) {
+            SDL_DestroyTexture(player->ring[i]);
+            player->ring[i] = NULL;
+        }
+        player->ring_frames[i] = -1;
+    }
+    player->current_frame = -1;
+}
+
+void free_game_textures(GameTextures *textures) {
+    if (textures == NULL) {
+        return;
+    }
+    SDL_DestroyTexture(textures->atlas);
+    free(textures);
+}
+
+// Window, renderer and textures shared by all screens
+static SceneManager scene_manager;
+
+bool init_scene_manager(const char *title, int width, int height) {
+    // Create an SDL window
+    scene_manager.window = SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height,
+                                            SDL_WINDOW_SHOWN);
+    if (scene_manager.window == NULL) {
+        printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Create an SDL renderer
+    scene_manager.renderer = SDL_CreateRenderer(scene_manager.window, -1, get_renderer_flags());
+    if (scene_manager.renderer == NULL) {
+        printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        shutdown_scene_manager();
+        return false;
+    }
+
+    // Load game textures
+    scene_manager.textures = load_game_textures(scene_manager.renderer);
+    if (scene_manager.textures == NULL) {
+        printf("Failed to load game textures.\n");
+        shutdown_scene_manager();
+        return false;
+    }
+
+    return true;
+}
+
+bool init_headless_scene_manager(int width, int height) {
+    // Create the surface the frames are drawn into
+    scene_manager.target = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (scene_manager.target == NULL) {
+        printf("Offscreen surface could not be created! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Create a software renderer drawing into the surface
+    scene_manager.renderer = SDL_CreateSoftwareRenderer(scene_manager.target);
+    if (scene_manager.renderer == NULL) {
+        printf("Software renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        shutdown_scene_manager();
+        return false;
+    }
+
+    // Load game textures
+    scene_manager.textures = load_game_textures(scene_manager.renderer);
+    if (scene_manager.textures == NULL) {
+        printf("Failed to load game textures.\n");
+        shutdown_scene_manager();
+        return false;
+    }
+
+    return true;
+}
+
+void enter_scene(const char *title, int width, int height) {
+    SDL_SetWindowTitle(scene_manager.window, title);
+
+    // Resize the window only if the screen needs another size
+    int current_width, current_height;
+    SDL_GetWindowSize(scene_manager.window, &current_width, &current_height);
+    if (current_width != width || current_height != height) {
+        SDL_SetWindowSize(scene_manager.window, width, height);
+    }
+
+    // Drop the clicks that ended the previous screen
+    SDL_PumpEvents();
+    SDL_FlushEvents(SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP);
+}
+
+SDL_Window *get_scene_window(void) {
+    return scene_manager.window;
+}
+
+SDL_Renderer *get_scene_renderer(void) {
+    return scene_manager.renderer;
+}
+
+GameTextures *get_scene_textures(void) {
+    return scene_manager.textures;
+}
+
+SDL_Texture *acquire_texture(const char *filename) {
+    // Share the texture if it is already loaded
+    for (int i = 0; i < scene_manager.num_shared_textures; i++) {
+        SharedTexture *shared = &scene_manager.shared_textures[i];
+        if (strcmp(shared->filename, filename) == 0) {
+            shared->ref_count++;
+            return shared->texture;
+        }
+    }
+
+    if (scene_manager.num_shared_textures == MAX_SHARED_TEXTURES) {
+        printf("Too many shared textures, cannot load %s\n", filename);
+        return NULL;
+    }
+
+    // Load the texture
+    SDL_Texture *texture = load_texture(filename, scene_manager.renderer);
+    if (texture == NULL) {
+        return NULL;
+    }
+
+    SharedTexture *shared = &scene_manager.shared_textures[scene_manager.num_shared_textures++];
+    snprintf(shared->filename, sizeof(shared->filename), "%s", filename);
+    shared->texture = texture;
+    shared->ref_count = 1;
+    return texture;
+}
+
+void release_texture(SDL_Texture *texture) {
+    if (texture == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < scene_manager.num_shared_textures; i++) {
+        SharedTexture *shared = &scene_manager.shared_textures[i];
+        if (shared->texture == texture) {
+            if (shared->ref_count > 0) {
+                shared->ref_count--;
+            }
+            return;
+        }
+    }
+    printf("Released a texture that was not acquired.\n");
+}
+
+void purge_unused_textures(void) {
+    // Destroy the unreferenced textures and keep the others packed at the start of the array
+    int num_kept = 0;
+    for (int i = 0; i < scene_manager.num_shared_textures; i++) {
+        SharedTexture *shared = &scene_manager.shared_textures[i];
+        if (shared->ref_count == 0) {
+            SDL_DestroyTexture(shared->texture);
+        } else {
+            scene_manager.shared_textures[num_kept++] = *shared;
+        }
+    }
+    scene_manager.num_shared_textures = num_kept;
+}
+
+void shutdown_scene_manager(void) {
+    // Destroy the textures before the renderer that owns them
+    for (int i = 0; i < scene_manager.num_shared_textures; i++) {
+        SharedTexture *shared = &scene_manager.shared_textures[i];
+        if (shared->ref_count > 0) {
+            printf("Texture %s is still in use at shutdown.\n", shared->filename);
+        }
+        SDL_DestroyTexture(shared->texture);
+    }
+    scene_manager.num_shared_textures = 0;
+    destroy_board_layers();
+    clear_text_cache();
+    free_game_textures(scene_manager.textures);
+    scene_manager.textures = NULL;
+
+    if (scene_manager.renderer != NULL) {
+        SDL_DestroyRenderer(scene_manager.renderer);
+        scene_manager.renderer = NULL;
+    }
+    if (scene_manager.window != NULL) {
+        SDL_DestroyWindow(scene_manager.window);
+        scene_manager.window = NULL;
+    }
+    if (scene_manager.target != NULL) {
+        SDL_FreeSurface(scene_manager.target);
+        scene_manager.target = NULL;
+    }
+}
+
+void render_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y) {
+    // Set the text color
+    SDL_Color color = {0, 0, 0, 255}; // Black
+
+    // Draw the text from the text cache, or rasterise it if it cannot be cached
+    CachedText *cached_text = get_cached_text(renderer, font, text, color);
+    if (cached_text != NULL) {
+        draw_cached_text(renderer, cached_text, x, y);
+    } else {
+        render_text_uncached(renderer, text, font, x, y, color);
+    }
+}
+
+void render_colored_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y, int r, int g, int b) {
+    // Set the text color
+    SDL_Color color = {r, g, b, 255};
+
+    // Draw the text from the text cache, or rasterise it if it cannot be cached
+    CachedText *cached_text = get_cached_text(renderer, font, text, color);
+    if (cached_text != NULL) {
+        draw_cached_text(renderer, cached_text, x, y);
+    } else {
+        render_text_uncached(renderer, text, font, x, y, color);
+    }
+}
+
+void render_text_uncached(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y, SDL_Color color) {
+    // Create a surface containing the rendered text
+    SDL_Surface *text_surface = TTF_RenderText_Solid(font, text, color);
+    if (text_surface == NULL) {
+        printf("TTF_RenderText_Solid: %s\n", TTF_GetError());
+        exit(2);
+    }
+
+    // Convert the surface to a texture
+    SDL_Texture *text_texture = SDL_CreateTextureFromSurface(renderer, text_surface);
+    if (text_texture == NULL) {
+        printf("SDL_CreateTextureFromSurface: %s\n", SDL_GetError());
+        exit(2);
+    }
+
+    // Render the text texture
+    SDL_Rect text_rect = {x, y, text_surface->w, text_surface->h};
+    SDL_RenderCopy(renderer, text_texture, NULL, &text_rect);
+
+    // Free resources
+    SDL_DestroyTexture(text_texture);
+    SDL_FreeSurface(text_surface);
+}
+
+// Glyph atlases and laid-out strings shared by all text rendering
+static TextCache text_cache;
+
+bool build_glyph_atlas(SDL_Renderer *renderer, TTF_Font *font, GlyphAtlas *atlas) {
+    SDL_Surface *glyph_surfaces[GLYPH_COUNT] = {NULL};
+    SDL_Color white = {255, 255, 255, 255};
+    bool success = false;
+
+    atlas->font = font;
+    atlas->texture = NULL;
+    atlas->line_height = TTF_FontHeight(font);
+
+    // Rasterise every glyph and assign it a place in the atlas, row by row
+    int pen_x = 0;
+    int pen_y = 0;
+    int row_height = 0;
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        Glyph *glyph = &atlas->glyphs[i];
+        Uint16 ch = (Uint16) (GLYPH_FIRST + i);
+
+        int advance = 0;
+        TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance);
+        glyph->advance = advance;
+        glyph->rect = (SDL_Rect) {0, 0, 0, 0};
+
+        // Glyphs without pixels (such as the space) only advance the pen, they are rendered like
+        // TTF_RenderText_Solid renders whole strings so the text looks the same as before the atlas
+        glyph_surfaces[i] = TTF_RenderGlyph_Solid(font, ch, white);
+        if (glyph_surfaces[i] == NULL) {
+            continue;
+        }
+
+        // Start a new row if the glyph does not fit in the current one
+        if (pen_x + glyph_surfaces[i]->w > GLYPH_ATLAS_WIDTH) {
+            pen_x = 0;
+            pen_y += row_height + 1;
+            row_height = 0;
+        }
+
+        glyph->rect = (SDL_Rect) {pen_x, pen_y, glyph_surfaces[i]->w, glyph_surfaces[i]->h};
+        pen_x += glyph_surfaces[i]->w + 1;
+        if (glyph_surfaces[i]->h > row_height) {
+            row_height = glyph_surfaces[i]->h;
+        }
+    }
+
+    atlas->texture_width = GLYPH_ATLAS_WIDTH;
+    atlas->texture_height = pen_y + row_height;
+
+    // Copy all glyphs into one transparent surface
+    SDL_Surface *atlas_surface = SDL_CreateRGBSurfaceWithFormat(0, atlas->texture_width, atlas->texture_height, 32,
+                                                                SDL_PIXELFORMAT_ARGB8888);
+    if (atlas_surface != NULL) {
+        SDL_FillRect(atlas_surface, NULL, SDL_MapRGBA(atlas_surface->format, 255, 255, 255, 0));
+        for (int i = 0; i < GLYPH_COUNT; i++) {
+            if (glyph_surfaces[i] != NULL) {
+                SDL_SetSurfaceBlendMode(glyph_surfaces[i], SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(glyph_surfaces[i], NULL, atlas_surface, &atlas->glyphs[i].rect);
+            }
+        }
+
+        // Upload the atlas once
+        atlas->texture = SDL_CreateTextureFromSurface(renderer, atlas_surface);
+        if (atlas->texture != NULL) {
+            SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+            success = true;
+        }
+        SDL_FreeSurface(atlas_surface);
+    }
+
+    // Free the glyph surfaces
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        SDL_FreeSurface(glyph_surfaces[i]);
+    }
+
+    if (!success) {
+        printf("Failed to build glyph atlas. SDL Error: %s\n", SDL_GetError());
+    }
+    return success;
+}
+
+GlyphAtlas *get_glyph_atlas(SDL_Renderer *renderer, TTF_Font *font) {
+    // The atlases belong to one renderer, destroy them if another one is used
+    if (text_cache.renderer != renderer) {
+        clear_text_cache();
+        text_cache.renderer = renderer;
+    }
+
+    // Look for an existing atlas of the font
+    for (int i = 0; i < text_cache.num_atlases; i++) {
+        if (text_cache.atlases[i].font == font) {
+            return &text_cache.atlases[i];
+        }
+    }
+
+    // Build a new atlas if there is room for it
+    if (text_cache.num_atlases == MAX_GLYPH_ATLASES) {
+        return NULL;
+    }
+
+    GlyphAtlas *atlas = &text_cache.atlases[text_cache.num_atlases];
+    if (!build_glyph_atlas(renderer, font, atlas)) {
+        return NULL;
+    }
+    text_cache.num_atlases++;
+    return atlas;
+}
+
+CachedText *get_cached_text(SDL_Renderer *renderer, TTF_Font *font, const char *text, SDL_Color color) {
+    // Only short printable ASCII strings can be drawn from the atlas
+    size_t length = strlen(text);
+    if (length == 0 || length > MAX_CACHED_TEXT_LENGTH) {
+        return NULL;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if ((unsigned char) text[i] < GLYPH_FIRST || (unsigned char) text[i] >= GLYPH_FIRST + GLYPH_COUNT) {
+            return NULL;
+        }
+    }
+
+    GlyphAtlas *atlas = get_glyph_atlas(renderer, font);
+    if (atlas == NULL) {
+        return NULL;
+    }
+
+    // Hash the text and color (FNV-1a)
+    Uint32 hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char) text[i]) * 16777619u;
+    }
+    hash = (hash ^ ((Uint32) color.r << 16 | (Uint32) color.g << 8 | color.b)) * 16777619u;
+
+    // Look up the string and remember the least recently used entry
+    text_cache.clock++;
+    CachedText *least_recently_used = &text_cache.entries[0];
+    for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+        CachedText *entry = &text_cache.entries[i];
+        if (entry->used && entry->hash == hash && entry->atlas == atlas && entry->color.r == color.r &&
+            entry->color.g == color.g && entry->color.b == color.b && strcmp(entry->text, text) == 0) {
+            entry->last_used = text_cache.clock;
+            text_cache.hits++;
+            return entry;
+        }
+        if (!entry->used || (least_recently_used->used && entry->last_used < least_recently_used->last_used)) {
+            least_recently_used = entry;
+        }
+    }
+
+    // Lay out the string into the least recently used entry
+    text_cache.misses++;
+    CachedText *entry = least_recently_used;
+    entry->used = true;
+    entry->hash = hash;
+    entry->atlas = atlas;
+    entry->color = color;
+    entry->last_used = text_cache.clock;
+    memcpy(entry->text, text, length + 1);
+    entry->num_glyphs = 0;
+    entry->height = atlas->line_height;
+
+    float u_scale = 1.0f / (float) atlas->texture_width;
+    float v_scale = 1.0f / (float) atlas->texture_height;
+    int pen_x = 0;
+    Uint16 previous = 0;
+    for (size_t i = 0; i < length; i++) {
+        Uint16 ch = (Uint16) (unsigned char) text[i];
+        const Glyph *glyph = &atlas->glyphs[ch - GLYPH_FIRST];
+
+        // Apply the kerning between this glyph and the previous one
+        if (previous != 0) {
+            pen_x += TTF_GetFontKerningSizeGlyphs(font, previous, ch);
+        }
+        previous = ch;
+
+        // Add a quad for glyphs with pixels
+        if (glyph->rect.w > 0) {
+            SDL_Vertex *quad = &entry->vertices[entry->num_glyphs * 4];
+            float left = (float) pen_x;
+            float right = (float) (pen_x + glyph->rect.w);
+            float bottom = (float) glyph->rect.h;
+            float u0 = (float) glyph->rect.x * u_scale;
+            float v0 = (float) glyph->rect.y * v_scale;
+            float u1 = (float) (glyph->rect.x + glyph->rect.w) * u_scale;
+            float v1 = (float) (glyph->rect.y + glyph->rect.h) * v_scale;
+
+            quad[0] = (SDL_Vertex) {{left, 0.0f}, color, {u0, v0}};
+            quad[1] = (SDL_Vertex) {{right, 0.0f}, color, {u1, v0}};
+            quad[2] = (SDL_Vertex) {{right, bottom}, color, {u1, v1}};
+            quad[3] = (SDL_Vertex) {{left, bottom}, color, {u0, v1}};
+            entry->num_glyphs++;
+        }
+        pen_x += glyph->advance;
+    }
+    entry->width = pen_x;
+
+    return entry;
+}
+
+void draw_cached_text(SDL_Renderer *renderer, const CachedText *cached_text, int x, int y) {
+    static SDL_Vertex vertices[MAX_CACHED_TEXT_LENGTH * 4];
+
+    // Move the quads to the text position
+    int num_vertices = cached_text->num_glyphs * 4;
+    for (int i = 0; i < num_vertices; i++) {
+        vertices[i] = cached_text->vertices[i];
+        vertices[i].position.x += (float) x;
+        vertices[i].position.y += (float) y;
+    }
+
+    // Draw the whole string with one call
+    SDL_RenderGeometry(renderer, cached_text->atlas->texture, vertices, num_vertices, get_quad_indices(),
+                       cached_text->num_glyphs * 6);
+}
+
+void clear_text_cache(void) {
+    // Destroy the atlas textures and forget all laid-out strings
+    for (int i = 0; i < text_cache.num_atlases; i++) {
+        SDL_DestroyTexture(text_cache.atlases[i].texture);
+    }
+    SDL_zero(text_cache.atlases);
+    SDL_zero(text_cache.entries);
+    text_cache.num_atlases = 0;
+    text_cache.renderer = NULL;
+}
+
+void get_text_cache_stats(Uint64 *hits, Uint64 *misses) {
+    *hits = text_cache.hits;
+    *misses = text_cache.misses;
+}
+
+bool wait_for_events(int timeout) {
+    // A NULL event only peeks at the queue
+    return SDL_WaitEventTimeout(NULL, timeout) == 1;
+}
+
+bool wait_for_events_until(Uint64 deadline) {
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    for (;;) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now >= deadline) {
+            return wait_for_events(0);
+        }
+
+        // SDL_WaitEventTimeout only has millisecond precision, so the last millisecond is not slept
+        Uint64 remaining = (deadline - now) * 1000 / frequency;
+        if (wait_for_events(remaining > 1 ? (int) (remaining - 1) : 0)) {
+            return true;
+        }
+    }
+}
+
+// Statistics of the current screen and the options that control them
+static FrameStats frame_stats;
+static bool frame_stats_overlay = false;
+
+void begin_screen_stats(const char *screen_name) {
+    SDL_zero(frame_stats);
+    frame_stats.screen_name = screen_name;
+    get_text_cache_stats(&frame_stats.text_cache_hits, &frame_stats.text_cache_misses);
+}
+
+void begin_frame_stats(void) {
+    frame_stats.frame_start = SDL_GetPerformanceCounter();
+    frame_stats.frame_start_draw_calls = draw_call_count;
+
+    // The input received until now is applied in this frame
+    frame_stats.frame_input_time = frame_stats.pending_input_time;
+    frame_stats.pending_input_time = 0;
+}
+
+void end_frame_stats(void) {
+    // Record the frame time in milliseconds, keeping the most recent frames
+    Uint64 elapsed = SDL_GetPerformanceCounter() - frame_stats.frame_start;
+    float frame_time = (float) ((double) elapsed * 1000.0 / (double) SDL_GetPerformanceFrequency());
+    frame_stats.frame_times[frame_stats.next_frame_time] = frame_time;
+    frame_stats.next_frame_time = (frame_stats.next_frame_time + 1) % FRAME_STATS_CAPACITY;
+    if (frame_stats.num_frame_times < FRAME_STATS_CAPACITY) {
+        frame_stats.num_frame_times++;
+    }
+
+    // Count the draw calls of the frame
+    frame_stats.last_frame_draw_calls = draw_call_count - frame_stats.frame_start_draw_calls;
+    frame_stats.total_draw_calls += frame_stats.last_frame_draw_calls;
+    frame_stats.num_frames++;
+
+    // Record the input-to-present latency if the frame shows new input
+    if (frame_stats.frame_input_time != 0) {
+        Uint64 latency = SDL_GetPerformanceCounter() - frame_stats.frame_input_time;
+        frame_stats.input_latencies[frame_stats.next_input_latency] =
+                (float) ((double) latency * 1000.0 / (double) SDL_GetPerformanceFrequency());
+        frame_stats.next_input_latency = (frame_stats.next_input_latency + 1) % FRAME_STATS_CAPACITY;
+        if (frame_stats.num_input_latencies < FRAME_STATS_CAPACITY) {
+            frame_stats.num_input_latencies++;
+        }
+        frame_stats.frame_input_time = 0;
+    }
+}
+
+void end_screen_stats(void) {
+    const char *log_name = get_game_options()->frame_stats_log;
+    if (log_name == NULL || frame_stats.num_frames == 0) {
+        return;
+    }
+
+    FILE *file = fopen(log_name, "a");
+    if (file == NULL) {
+        printf("Error opening frame statistics log %s\n", log_name);
+        return;
+    }
+
+    // Compute the text cache hit rate of the screen
+    Uint64 hits, misses;
+    get_text_cache_stats(&hits, &misses);
+    hits -= frame_stats.text_cache_hits;
+    misses -= frame_stats.text_cache_misses;
+    double hit_rate = hits + misses > 0 ? 100.0 * (double) hits / (double) (hits + misses) : 100.0;
+
+    // Write one line per screen
+    float p50, p95, p99;
+    float input_p50, input_p95, input_p99;
+    get_frame_time_percentiles(&p50, &p95, &p99);
+    get_input_latency_percentiles(&input_p50, &input_p95, &input_p99);
+    fprintf(file, "screen=%s frames=%llu p50_ms=%.3f p95_ms=%.3f p99_ms=%.3f draw_calls_per_frame=%.1f "
+                  "text_cache_hit_rate=%.1f%% input_p50_ms=%.3f input_p99_ms=%.3f\n", frame_stats.screen_name,
+            (unsigned long long) frame_stats.num_frames, p50, p95, p99,
+            (double) frame_stats.total_draw_calls / (double) frame_stats.num_frames, hit_rate, input_p50, input_p99);
+    fclose(file);
+}
+
+int compare_floats(const void *a, const void *b) {
+    float x = *(const float *) a;
+    float y = *(const float *) b;
+    return (x > y) - (x < y);
+}
+
+void get_percentiles(const float *times, int count, float *p50, float *p95, float *p99) {
+    if (count == 0) {
+        *p50 = *p95 = *p99 = 0.0f;
+        return;
+    }
+
+    // Sort a copy of the recorded times
+    static float sorted[FRAME_STATS_CAPACITY];
+    memcpy(sorted, times, count * sizeof(float));
+    qsort(sorted, count, sizeof(float), compare_floats);
+
+    *p50 = sorted[(count - 1) * 50 / 100];
+    *p95 = sorted[(count - 1) * 95 / 100];
+    *p99 = sorted[(count - 1) * 99 / 100];
+}
+
+void get_frame_time_percentiles(float *p50, float *p95, float *p99) {
+    get_percentiles(frame_stats.frame_times, frame_stats.num_frame_times, p50, p95, p99);
+}
+
+void get_input_latency_percentiles(float *p50, float *p95, float *p99) {
+    get_percentiles(frame_stats.input_latencies, frame_stats.num_input_latencies, p50, p95, p99);
+}
+
+void get_latest_mouse_state(int *x, int *y) {
+    SDL_PumpEvents();
+    SDL_GetMouseState(x, y);
+}
+
+void render_frame_stats_overlay(SDL_Renderer *renderer, TTF_Font *font) {
+    if (!frame_stats_overlay) {
+        return;
+    }
+
+    // The overlay is not part of the frame being measured, and is profiled as a function of its own
+    Uint64 draw_calls = draw_call_count;
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    // Format the statistics
+    float p50, p95, p99;
+    get_frame_time_percentiles(&p50, &p95, &p99);
+    Uint64 hits, misses;
+    get_text_cache_stats(&hits, &misses);
+    hits -= frame_stats.text_cache_hits;
+    misses -= frame_stats.text_cache_misses;
+    int hit_rate = hits + misses > 0 ? (int) (100 * hits / (hits + misses)) : 100;
+
+    float input_p50, input_p95, input_p99;
+    get_input_latency_percentiles(&input_p50, &input_p95, &input_p99);
+
+    char frame_times_text[64];
+    char counters_text[64];
+    char latency_text[64];
+    snprintf(frame_times_text, sizeof(frame_times_text), "p50 %.1f p95 %.1f p99 %.1f ms", p50, p95, p99);
+    snprintf(counters_text, sizeof(counters_text), "%llu draws, text %d%%",
+             (unsigned long long) frame_stats.last_frame_draw_calls, hit_rate);
+    snprintf(latency_text, sizeof(latency_text), "input p50 %.1f p99 %.1f ms", input_p50, input_p99);
+
+    // Render a dark background and the three lines of text
+    int line_height = TTF_FontLineSkip(font);
+    SDL_Rect background_rect = {0, 0, 320, 3 * line_height + 8};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(renderer, &background_rect);
+    SDL_Color color = {255, 255, 0, 255};
+    render_text_uncached(renderer, frame_times_text, font, 4, 4, color);
+    render_text_uncached(renderer, counters_text, font, 4, 4 + line_height, color);
+    render_text_uncached(renderer, latency_text, font, 4, 4 + 2 * line_height, color);
+
+    end_profile_zone(zone);
+    draw_call_count = draw_calls;
+}
+
+int frame_stats_event_watch(void *userdata, SDL_Event *event) {
+    (void) userdata;
+
+    if (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_F3 && !event->key.repeat) {
+        frame_stats_overlay = !frame_stats_overlay;
+    } else if (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_F4 && !event->key.repeat) {
+        set_render_profiling(!render_profiler.enabled);
+    } else if (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_F5 && !event->key.repeat) {
+        toggle_shot_heatmap();
+    }
+
+    // Remember when the oldest input not yet shown was received
+    bool is_input = event->type == SDL_MOUSEMOTION || event->type == SDL_MOUSEBUTTONDOWN ||
+                    event->type == SDL_MOUSEBUTTONUP || event->type == SDL_KEYDOWN;
+    if (is_input && frame_stats.pending_input_time == 0) {
+        frame_stats.pending_input_time = SDL_GetPerformanceCounter();
+    }
+    return 0;
+}
+
+void set_render_profiling(bool enabled) {
+    if (enabled == render_profiler.enabled) {
+        return;
+    }
+
+    if (enabled) {
+        // Start from empty counters, keeping the function being rendered
+        render_profiler.num_entries = 0;
+        render_profiler.last_entry = 0;
+        printf("Render profiling started.\n");
+    } else {
+        // Export what was measured
+        const char *filename = get_game_options()->render_profile_file;
+        if (filename == NULL) {
+            filename = RENDER_PROFILE_FILE_NAME;
+        }
+        if (export_render_profile(filename)) {
+            printf("Render profile written to %s\n", filename);
+        }
+    }
+    render_profiler.enabled = enabled;
+}
+
+ProfileZone begin_profile_zone(const char *zone_name) {
+    ProfileZone zone = {render_profiler.zone_name, render_profiler.enabled ? SDL_GetPerformanceCounter() : 0};
+    render_profiler.zone_name = zone_name;
+    return zone;
+}
+
+void end_profile_zone(ProfileZone zone) {
+    // Zones entered before the profiler was enabled are not timed
+    if (render_profiler.enabled && zone.start != 0) {
+        ProfileEntry *entry = get_profile_entry(render_profiler.zone_name);
+        if (entry != NULL) {
+            entry->num_entries++;
+            entry->zone_ticks += SDL_GetPerformanceCounter() - zone.start;
+        }
+    }
+    render_profiler.zone_name = zone.previous_zone;
+}
+
+ProfileEntry *get_profile_entry(const char *zone_name) {
+    const char *screen_name = frame_stats.screen_name;
+
+    // The names are string literals or __func__, so comparing pointers is enough
+    ProfileEntry *last = &render_profiler.entries[render_profiler.last_entry];
+    if (render_profiler.num_entries > 0 && last->zone_name == zone_name && last->screen_name == screen_name) {
+        return last;
+    }
+    for (int i = 0; i < render_profiler.num_entries; i++) {
+        ProfileEntry *entry = &render_profiler.entries[i];
+        if (entry->zone_name == zone_name && entry->screen_name == screen_name) {
+            render_profiler.last_entry = i;
+            return entry;
+        }
+    }
+
+    // Add the counters of a function seen for the first time
+    if (render_profiler.num_entries == MAX_PROFILE_ENTRIES) {
+        return NULL;
+    }
+    render_profiler.last_entry = render_profiler.num_entries++;
+    ProfileEntry *entry = &render_profiler.entries[render_profiler.last_entry];
+    SDL_zerop(entry);
+    entry->screen_name = screen_name;
+    entry->zone_name = zone_name;
+    return entry;
+}
+
+int end_profile_call(ProfileCallKind kind, int result) {
+    Uint64 elapsed = SDL_GetPerformanceCounter() - render_profiler.call_start;
+    ProfileEntry *entry = get_profile_entry(render_profiler.zone_name);
+    if (entry != NULL) {
+        entry->call_counts[kind]++;
+        entry->call_ticks[kind] += elapsed;
+    }
+    return result;
+}
+
+void *end_profile_pointer_call(ProfileCallKind kind, void *result) {
+    end_profile_call(kind, 0);
+    return result;
+}
+
+bool export_render_profile(const char *filename) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        printf("Error opening render profile %s\n", filename);
+        return false;
+    }
+
+    // Write the times in milliseconds, calls outside the profiled functions are listed as the screen loop
+    double ticks_per_ms = (double) SDL_GetPerformanceFrequency() / 1000.0;
+    fprintf(file, "screen,function,calls,time_ms,draw_calls,draw_ms,texture_uploads,upload_ms,text_renders,text_ms\n");
+    for (int i = 0; i < render_profiler.num_entries; i++) {
+        const ProfileEntry *entry = &render_profiler.entries[i];
+        fprintf(file, "%s,%s,%llu,%.3f", entry->screen_name != NULL ? entry->screen_name : "none",
+                entry->zone_name != NULL ? entry->zone_name : "screen_loop", (unsigned long long) entry->num_entries,
+                (double) entry->zone_ticks / ticks_per_ms);
+        for (int kind = 0; kind < PROFILE_CALL_KIND_COUNT; kind++) {
+            fprintf(file, ",%llu,%.3f", (unsigned long long) entry->call_counts[kind],
+                    (double) entry->call_ticks[kind] / ticks_per_ms);
+        }
+        fprintf(file, "\n");
+    }
+
+    return fclose(file) == 0;
+}
+
+void init_widget_tree(WidgetTree *tree) {
+    memset(tree, 0, sizeof(WidgetTree));
+    tree->hovered_widget = -1;
+}
+
+int add_widget(WidgetTree *tree, WidgetStyle style, SDL_Rect rect, SDL_Point label_offset, const char *label) {
+    if (tree->num_widgets == MAX_WIDGETS) {
+        printf("Too many widgets.\n");
+        return -1;
+    }
+
+    Widget *widget = &tree->widgets[tree->num_widgets];
+    memset(widget, 0, sizeof(Widget));
+    widget->style = style;
+    widget->rect = rect;
+    widget->label_offset = label_offset;
+    snprintf(widget->label, sizeof(widget->label), "%s", label);
+    widget->visible = true;
+    widget->enabled = true;
+    widget->dirty = true;
+    return tree->num_widgets++;
+}
+
+void set_widget_label(WidgetTree *tree, int index, const char *label) {
+    Widget *widget = &tree->widgets[index];
+    if (strcmp(widget->label, label) == 0) {
+        return;
+    }
+
+    // The new label may not fit in the texture, so it is created again with the right size
+    snprintf(widget->label, sizeof(widget->label), "%s", label);
+    SDL_DestroyTexture(widget->texture);
+    widget->texture = NULL;
+    widget->dirty = true;
+}
+
+void set_widget_enabled(WidgetTree *tree, int index, bool enabled) {
+    Widget *widget = &tree->widgets[index];
+    if (widget->enabled == enabled) {
+        return;
+    }
+
+    widget->enabled = enabled;
+    widget->dirty = true;
+    if (!enabled && tree->hovered_widget == index) {
+        set_hovered_widget(tree, -1);
+    }
+}
+
+void set_widget_visible(WidgetTree *tree, int index, bool visible) {
+    Widget *widget = &tree->widgets[index];
+    widget->visible = visible;
+    if (!visible && tree->hovered_widget == index) {
+        set_hovered_widget(tree, -1);
+    }
+}
+
+int hit_test_widgets(const WidgetTree *tree, int x, int y) {
+    // Test from the top, the first widget that contains the position gets it
+    SDL_Point point = {x, y};
+    for (int i = tree->num_widgets - 1; i >= 0; i--) {
+        const Widget *widget = &tree->widgets[i];
+        if (widget->visible && widget->enabled && SDL_PointInRect(&point, &widget->rect)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void set_hovered_widget(WidgetTree *tree, int index) {
+    if (tree->hovered_widget == index) {
+        return;
+    }
+
+    // Only the widget that loses the hover and the one that gains it are redrawn
+    if (tree->hovered_widget >= 0) {
+        tree->widgets[tree->hovered_widget].hovered = false;
+        tree->widgets[tree->hovered_widget].dirty = true;
+    }
+    if (index >= 0) {
+        tree->widgets[index].hovered = true;
+        tree->widgets[index].dirty = true;
+    }
+    tree->hovered_widget = index;
+}
+
+void update_widget_hover(WidgetTree *tree, int x, int y) {
+    set_hovered_widget(tree, hit_test_widgets(tree, x, y));
+}
+
+int handle_widget_event(WidgetTree *tree, const SDL_Event *event) {
+    // Get the position of mouse events
+    int x, y;
+    if (event->type == SDL_MOUSEMOTION) {
+        x = event->motion.x;
+        y = event->motion.y;
+    } else if ((event->type == SDL_MOUSEBUTTONDOWN || event->type == SDL_MOUSEBUTTONUP) &&
+               event->button.button == SDL_BUTTON_LEFT) {
+        x = event->button.x;
+        y = event->button.y;
+    } else {
+        return -1;
+    }
+
+    // The single hit test of the event updates the hover and reports the clicked widget
+    int index = hit_test_widgets(tree, x, y);
+    set_hovered_widget(tree, index);
+    return event->type == SDL_MOUSEMOTION ? -1 : index;
+}
+
+void mark_widget_tree_dirty(WidgetTree *tree) {
+    for (int i = 0; i < tree->num_widgets; i++) {
+        tree->widgets[i].dirty = true;
+    }
+}
+
+void draw_widget(SDL_Renderer *renderer, TTF_Font *font, const Widget *widget, int x, int y) {
+    SDL_Rect rect = {x, y, widget->rect.w, widget->rect.h};
+    int label_x = x + widget->label_offset.x;
+    int label_y = y + widget->label_offset.y;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    if (widget->style == WIDGET_BUTTON) {
+        // Render the button background, lighter while hovered, and its shadow
+        set_button_color(renderer, widget->hovered);
+        SDL_RenderFillRect(renderer, &rect);
+        render_button_shadow(renderer, rect);
+
+        // Darken a disabled button and write its label in white
+        if (widget->enabled) {
+            render_text(renderer, widget->label, font, label_x, label_y);
+        } else {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 128);
+            SDL_RenderFillRect(renderer, &rect);
+            render_colored_text(renderer, widget->label, font, label_x, label_y, 255, 255, 255);
+        }
+    } else if (widget->style == WIDGET_TEXT) {
+        render_text(renderer, widget->label, font, label_x, label_y);
+    } else if (widget->style == WIDGET_LINK) {
+        // Yellow while hovered, white otherwise
+        render_colored_text(renderer, widget->label, font, label_x, label_y, 255, 255, widget->hovered ? 0 : 255);
+    }
+}
+
+SDL_Texture *create_widget_texture(SDL_Renderer *renderer, TTF_Font *font, const Widget *widget) {
+    // Make room for the shadow of buttons and for labels that reach out of the widget
+    int width = widget->rect.w;
+    int height = widget->rect.h;
+    if (widget->style == WIDGET_BUTTON) {
+        width += WIDGET_SHADOW_OFFSET;
+        height += WIDGET_SHADOW_OFFSET;
+    }
+    int label_width, label_height;
+    if (widget->label[0] != '\0' && TTF_SizeText(font, widget->label, &label_width, &label_height) == 0) {
+        width = SDL_max(width, widget->label_offset.x + label_width);
+        height = SDL_max(height, widget->label_offset.y + label_height);
+    }
+
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width,
+                                             height);
+    if (texture == NULL) {
+        printf("Failed to create widget texture. SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+    set_premultiplied_blend_mode(texture);
+    return texture;
+}
+
+void render_widgets(SDL_Renderer *renderer, TTF_Font *font, WidgetTree *tree) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    bool use_textures = SDL_RenderTargetSupported(renderer);
+    for (int i = 0; i < tree->num_widgets; i++) {
+        Widget *widget = &tree->widgets[i];
+        if (!widget->visible || widget->style == WIDGET_AREA) {
+            continue;
+        }
+
+        // Draw the widget directly if it cannot be cached
+        if (use_textures && widget->texture == NULL) {
+            widget->texture = create_widget_texture(renderer, font, widget);
+            widget->dirty = true;
+        }
+        if (widget->texture == NULL) {
+            draw_widget(renderer, font, widget, widget->rect.x, widget->rect.y);
+            continue;
+        }
+
+        // Redraw the texture only if the look of the widget changed
+        if (widget->dirty) {
+            SDL_SetRenderTarget(renderer, widget->texture);
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+            SDL_RenderClear(renderer);
+            draw_widget(renderer, font, widget, 0, 0);
+            SDL_SetRenderTarget(renderer, NULL);
+            widget->dirty = false;
+        }
+
+        // Copy the texture to the screen
+        SDL_Rect texture_rect = {widget->rect.x, widget->rect.y, 0, 0};
+        SDL_QueryTexture(widget->texture, NULL, NULL, &texture_rect.w, &texture_rect.h);
+        SDL_RenderCopy(renderer, widget->texture, NULL, &texture_rect);
+    }
+
+    end_profile_zone(zone);
+}
+
+void destroy_widget_tree(WidgetTree *tree) {
+    for (int i = 0; i < tree->num_widgets; i++) {
+        SDL_DestroyTexture(tree->widgets[i].texture);
+    }
+    init_widget_tree(tree);
+}
+
+void init_main_menu(SDL_Renderer *renderer, AnimationPlayer *background, WidgetTree *widgets) {
+    // Start the animated background
+    if (!init_animation_player(background, renderer, "Assets/Backgrounds/frame_", MENU_ANIMATION_FRAMES,
+                               MENU_ANIMATION_FPS)) {
+        printf("Failed to load animated background.\n");
+    }
+
+    // Create buttons and positions for the main menu
+    const char *button_labels[] = {"New Game - PvP", "New Game - PvC", "Load", "Exit"};
+    init_widget_tree(widgets);
+    for (int i = 0; i < 4; i++) {
+        SDL_Rect button_rect = {(BOARD_SIZE * CELL_SIZE) / 2 - 105, 85 + i * 60, 210, 40};
+        add_widget(widgets, WIDGET_BUTTON, button_rect, (SDL_Point) {24, 8}, button_labels[i]);
+    }
+}
+
+void prefetch_main_menu(void) {
+    // Only the frames the animation player keeps at once
+    for (int i = 0; i < ANIMATION_RING_SIZE; i++) {
+        char filename[128];
+        get_animation_frame_name("Assets/Backgrounds/frame_", i, filename, sizeof(filename));
+        prefetch_image(filename);
+    }
+}
+
+int handle_main_menu_events(SDL_Event *event, WidgetTree *widgets, MainMenuOption *selected_option) {
+    int running = 1;
+
+    // Hit-test mouse events against the buttons, which also updates the hovered button
+    int clicked_widget = handle_widget_event(widgets, event);
+
+    // Handle SDL_QUIT event
+    if (event->type == SDL_QUIT) {
+        running = 0;
+    }
+
+        // Handle a button press, the buttons are in the order of the options
+    else if (event->type == SDL_MOUSEBUTTONDOWN && clicked_widget >= 0) {
+        *selected_option = (MainMenuOption) clicked_widget;
+        return 0;
+    }
+
+        // Handle lost render target contents
+    else if (event->type == SDL_RENDER_TARGETS_RESET) {
+        mark_widget_tree_dirty(widgets);
+    }
+
+    return running;
+}
+
+void render_main_menu(SDL_Renderer *renderer, SDL_Texture *background, TTF_Font *font, WidgetTree *widgets) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    // Render the animated background
+    if (background != NULL) {
+        SDL_RenderCopy(renderer, background, NULL, NULL);
+    }
+
+    // Render buttons
+    render_widgets(renderer, font, widgets);
+
+    end_profile_zone(zone);
+}
+
+MainMenuOption main_menu(SDL_Renderer *renderer, TTF_Font *font) {
+    MainMenuOption selected_option = MAIN_MENU_EXIT;
+
+    // Initialize main menu
+    AnimationPlayer background;
+    WidgetTree widgets;
+    init_main_menu(renderer, &background, &widgets);
+
+    // Initialize variables
+    int running = 1;
+    bool redraw = true;
+    bool first_frame = true;
+    SDL_Window *window = SDL_RenderGetWindow(renderer);
+    begin_screen_stats("main_menu");
+
+    // Main loop
+    while (running) {
+        // The background is not animated while the window cannot be seen
+        bool animate = (SDL_GetWindowFlags(window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) == 0;
+
+        // Sleep until an event arrives or the next background frame is due
+        bool has_events = animate
+                          ? wait_for_events_until(get_next_animation_time(&background, SDL_GetPerformanceCounter()))
+                          : wait_for_events(IDLE_WAIT_TIMEOUT);
+        if (has_events) {
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                running = handle_main_menu_events(&event, &widgets, &selected_option);
+                if (running == 0) {
+                    break;
+                }
+            }
+            redraw = true;
+        }
+
+        // Show the background frame due at this time, the animation speed does not depend on the frame rate
+        if (animate && update_animation_player(&background, SDL_GetPerformanceCounter())) {
+            redraw = true;
+        }
+
+        // Render the main menu only if something changed
+        if (redraw && running) {
+            begin_frame_stats();
+            render_main_menu(renderer, get_animation_texture(&background), font, &widgets);
+            render_frame_stats_overlay(renderer, font);
+            SDL_RenderPresent(renderer);
+            end_frame_stats();
+            redraw = false;
+
+            // Once the menu is shown, decode the backgrounds of the next screens while the player chooses
+            if (first_frame) {
+                first_frame = false;
+                report_first_interactive_frame();
+                prefetch_image("Assets/selecting_screen_background.jpg");
+                prefetch_image("Assets/game_screen_background.jpeg");
+            }
+        }
+    }
+    end_screen_stats();
+
+    // Free resources
+    destroy_animation_player(&background);
+    destroy_widget_tree(&widgets);
+
+    return selected_option;
+}
+
+void initialize_game_board(GameBoard *board) {
+    // Iterate through all cells of the board
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            // Initialize the cells
+            Cell *cell = &board->cells[i][j];
+            cell->x = i;
+            cell->y = j;
+            cell->width = CELL_SIZE;
+            cell->height = CELL_SIZE;
+            cell->ship_index = -1;
+            cell->occupied = false;
+            cell->hit = false;
+        }
+    }
+
+    mark_board_dirty(board);
+}
+
+void initialize_ships(Player *player) {
+    // Iterate through all ships
+    for (int i = 0; i < NUM_SHIPS; ++i) {
+        // Set the size of the ship
+        if (i == 0) {
+            player->ships[i].size = 5;
+        } else if (i == 1) {
+            player->ships[i].size = 4;
+        } else if (i == 2 || i == 3) {
+            player->ships[i].size = 3;
+        } else if (i == 4) {
+            player->ships[i].size = 2;
+        }
+
+        // Initialize the ship values
+        player->ships[i].hit_count = 0;
+        player->ships[i].x = -1;
+        player->ships[i].y = -1;
+        player->ships[i].orientation = 0;
+    }
+}
+
+bool is_position_valid(Player *current_player, int ship_size, int x, int y, int orientation) {
+    // Iterate through all cells of the ship
+    for (int k = 0; k < ship_size; k++) {
+        int cell_x = x + (orientation == 0 ? k : 0);
+        int cell_y = y + (orientation == 1 ? k : 0);
+
+        // Check if the cell is inside the grid
+        if (cell_x < 0 || cell_x >= BOARD_SIZE || cell_y < 0 || cell_y >= BOARD_SIZE) {
+            return false;
+        }
+
+        // Check if the cell is already occupied
+        if (current_player->board.cells[cell_x][cell_y].occupied == true) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool all_ships_placed(const bool placed_ships[]) {
+    // Iterate through all ships
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        if (!placed_ships[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void place_ship(GameBoard *board, Ship *ship, int x, int y, int orientation, int ship_index) {
+    // Update the ship's position
+    ship->x = x;
+    ship->y = y;
+    ship->orientation = orientation;
+
+    // Iterate through all cells of the ship
+    for (int i = 0; i < ship->size; i++) {
+        int cell_x = x + (orientation == 0 ? i : 0);
+        int cell_y = y + (orientation == 1 ? i : 0);
+
+        Cell *cell = &board->cells[cell_x][cell_y];
+        cell->occupied = true;
+        cell->ship_index = ship_index; // Add this line to update the ship_index
+    }
+
+    mark_board_dirty(board);
+}
+
+void place_random_ships(Player *current_player, Ship ships[], bool placed_ships[], int *ship_selected,
+                        int *orientation_to_reset) {
+    // Reset the board and ships
+    reset_placement_phase(ships, placed_ships, ship_selected, orientation_to_reset, &current_player->board);
+
+    // Reset the remaining ships
+    current_player->remaining_ships = 0;
+
+    // Seed the random number generator
+    pcg32_srandom(time(NULL), (intptr_t) &main);
+
+    // Loop until all ships are placed
+    for (int i = 0; i < NUM_SHIPS; i++) {
+
+        int x, y, orientation;
+        bool valid;
+        do {
+            // Generate random coordinates and orientation
+            x = (int) pcg32_boundedrand(BOARD_SIZE);
+            y = (int) pcg32_boundedrand(BOARD_SIZE);
+            orientation = (int) pcg32_boundedrand(2);
+
+            // Check if the position is valid
+            valid = is_position_valid(current_player, ships[i].size, x, y, orientation);
+        } while (!valid);
+
+        // Place the ship and mark it as placed
+        current_player->ships[i].size = ships[i].size;
+        place_ship(&current_player->board, &current_player->ships[i], x, y, orientation, i);
+        placed_ships[i] = true;
+
+        current_player->placed_ships[i] = true;
+        current_player->remaining_ships++;
+        current_player->ships[i].hit_count = 0;
+    }
+}
+
+void render_ship_part(QuadBatch *batch, GameTextures *textures, SDL_Rect ship_rect, int part_index, int ship_size) {
+    Tile part_tile;
+
+    // Determine which part of the ship to render
+    if (part_index == 0) {
+        part_tile = TILE_SHIP_LEFT;
+    } else if (part_index == ship_size - 1) {
+        part_tile = TILE_SHIP_RIGHT;
+    } else {
+        part_tile = TILE_SHIP_MIDDLE;
+    }
+
+    // Render the ship part
+    add_batch_tile(batch, textures, part_tile, &ship_rect, false);
+}
+
+void render_selected_ship_border(SDL_Renderer *renderer, int ship_index, int ship_selected, Ship ships[]) {
+    // Check if the current ship is selected
+    if (ship_selected == ship_index) {
+        SDL_Rect selected_ship_rect = {50, 50 + ship_index * 50, ships[ship_index].size * CELL_SIZE, CELL_SIZE};
+        SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255); // Yellow
+        SDL_RenderDrawRect(renderer, &selected_ship_rect);
+    }
+}
+
+void render_hover_ship_border(SDL_Renderer *renderer, int ship_index, int ship_hovered, Ship ships[]) {
+    SDL_Rect hover_ship_rect = {50, 50 + ship_index * 50, ships[ship_index].size * CELL_SIZE, CELL_SIZE};
+
+    // Check if the mouse is hovering over the ship, the widget of a placed ship cannot be hovered
+    if (ship_hovered == ship_index) {
+        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255); // Green
+        SDL_RenderDrawRect(renderer, &hover_ship_rect);
+    }
+}
+
+void render_placed_ship_overlay(QuadBatch *overlay_batch, int ship_index, int part_index, const bool placed_ships[]) {
+    // Check if the current ship has been placed
+    if (placed_ships[ship_index]) {
+        SDL_Rect placed_ship_rect = {50 + part_index * CELL_SIZE, 50 + ship_index * 50, CELL_SIZE, CELL_SIZE};
+        SDL_Color white = {255, 255, 255, 255};
+        add_batch_quad(overlay_batch, NULL, &placed_ship_rect, white, false);
+    }
+}
+
+void render_placement_ships_left_side(SDL_Renderer *renderer, GameTextures *textures, Ship ships[],
+                                      const bool placed_ships[], SDL_Texture *black_texture, int ship_selected,
+                                      int ship_hovered) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    QuadBatch ship_batch;
+    QuadBatch overlay_batch;
+    begin_quad_batch(&ship_batch, renderer, textures->atlas);
+    begin_quad_batch(&overlay_batch, renderer, black_texture);
+
+    // Loop through each ship
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        int ship_size = ships[i].size;
+
+        // Loop through each part of the ship
+        for (int j = 0; j < ship_size; j++) {
+            SDL_Rect ship_rect = {50 + j * CELL_SIZE, 50 + i * 50, CELL_SIZE, CELL_SIZE};
+
+            // Render the ship part
+            render_ship_part(&ship_batch, textures, ship_rect, j, ship_size);
+
+            // Render the placed ship overlay if the ship has been placed
+            render_placed_ship_overlay(&overlay_batch, i, j, placed_ships);
+        }
+    }
+
+    // Draw all ship parts at once, then the borders and the overlays on top of them
+    flush_quad_batch(&ship_batch);
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        // Render the selected ship border if the ship is currently selected
+        render_selected_ship_border(renderer, i, ship_selected, ships);
+
+        // Render the hover ship border if the mouse is hovering over the ship and it is not placed
+        render_hover_ship_border(renderer, i, ship_hovered, ships);
+    }
+    flush_quad_batch(&overlay_batch);
+
+    end_profile_zone(zone);
+}
+
+void set_button_color(SDL_Renderer *renderer, bool hover_state) {
+    // Change the color based on the hover state
+    if (hover_state) {
+        SDL_SetRenderDrawColor(renderer, 230, 230, 230, 255); // Lighter gray
+    } else {
+        SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255); // Original gray
+    }
+}
+
+void render_button_shadow(SDL_Renderer *renderer, SDL_Rect orientation_button) {
+    // Create a new rectangle for the shadow, offset from the button
+    SDL_Rect shadow_rect = orientation_button;
+    shadow_rect.x += WIDGET_SHADOW_OFFSET;
+    shadow_rect.y += WIDGET_SHADOW_OFFSET;
+
+    // Set the color for the shadow and render it
+    SDL_SetRenderDrawColor(renderer, 100, 100, 100, 128);
+    SDL_RenderFillRect(renderer, &shadow_rect);
+}
+
+void render_grid_background(QuadBatch *batch, GameTextures *textures, int ship_selected, int board_x, int board_y) {
+    // Choose the background tile based on whether a ship is selected
+    Tile background_tile = ship_selected >= 0 ? TILE_OCEAN_SELECTION_MODE : TILE_OCEAN;
+
+    // Render the grid background by looping through all cells
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            SDL_Rect grid_rect = {board_x + i * CELL_SIZE, board_y + j * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+            add_batch_tile(batch, textures, background_tile, &grid_rect, false);
+        }
+    }
+}
+
+void render_ship_hover(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], int ship_selected, int orientation,
+                       int grid_mouse_x, int grid_mouse_y, bool valid_position) {
+    // Check if a ship is selected
+    if (ship_selected >= 0) {
+        int ship_size = ships[ship_selected].size;
+
+        // Set the color for the ship border based on valid_position
+        if (valid_position) {
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
+        } else {
+            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
+        }
+
+        // Render the ship segments based on orientation and position
+        QuadBatch batch;
+        begin_quad_batch(&batch, renderer, textures->atlas);
+        for (int k = 0; k < ship_size; k++) {
+            int cell_x = grid_mouse_x + (orientation == 0 ? k : 0);
+            int cell_y = grid_mouse_y + (orientation == 1 ? k : 0);
+
+            // Make sure the cell is within the grid
+            if (cell_x >= 0 && cell_x < BOARD_SIZE && cell_y >= 0 && cell_y < BOARD_SIZE) {
+                SDL_Rect ship_rect = {400 + cell_x * CELL_SIZE, 50 + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+                render_ship_segment(&batch, textures, ships[ship_selected], k, orientation, &ship_rect);
+            }
+        }
+        flush_quad_batch(&batch);
+
+        // Render the ship border on top of the segments
+        for (int k = 0; k < ship_size; k++) {
+            int cell_x = grid_mouse_x + (orientation == 0 ? k : 0);
+            int cell_y = grid_mouse_y + (orientation == 1 ? k : 0);
+
+            // Make sure the cell is within the grid
+            if (cell_x >= 0 && cell_x < BOARD_SIZE && cell_y >= 0 && cell_y < BOARD_SIZE) {
+                SDL_Rect ship_rect = {400 + cell_x * CELL_SIZE, 50 + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+                render_ship_border(renderer, ship_size, k, orientation, &ship_rect);
+            }
+        }
+    }
+}
+
+void render_ship_border(SDL_Renderer *renderer, int ship_size, int segment, int orientation, SDL_Rect *ship_rect) {
+    // Vertical orientation
+    if (orientation == 1) {
+
+        // Draw top and bottom borders for the first and last segments
+        if (segment == 0) {
+            SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x + ship_rect->w,
+                               ship_rect->y); // Top border
+        } else if (segment == ship_size - 1) {
+            SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y + ship_rect->h - 1, ship_rect->x + ship_rect->w,
+                               ship_rect->y + ship_rect->h - 1); // Bottom border
+        }
+
+        // Draw left and right borders for all segments
+        SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x,
+                           ship_rect->y + ship_rect->h); // Left border
+        SDL_RenderDrawLine(renderer, ship_rect->x + ship_rect->w - 1, ship_rect->y, ship_rect->x + ship_rect->w - 1,
+                           ship_rect->y + ship_rect->h); // Right border
+    } else { // Horizontal orientation
+
+        // Draw left and right borders for the first and last segments
+        if (segment == 0) {
+            SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x,
+                               ship_rect->y + ship_rect->h); // Left border
+        } else if (segment == ship_size - 1) {
+            SDL_RenderDrawLine(renderer, ship_rect->x + ship_rect->w - 1, ship_rect->y, ship_rect->x + ship_rect->w - 1,
+                               ship_rect->y + ship_rect->h); // Right border
+        }
+
+        // Draw top and bottom borders for all segments
+        SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x + ship_rect->w,
+                           ship_rect->y); // Top border
+        SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y + ship_rect->h - 1, ship_rect->x + ship_rect->w,
+                           ship_rect->y + ship_rect->h - 1); // Bottom border
+    }
+}
+
+void render_placed_ships(QuadBatch *batch, GameTextures *textures, Ship ships[], const bool placed_ships[],
+                         int board_x, int board_y) {
+    // Loop through all ships
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        // Render the ship if it is placed
+        if (placed_ships[i]) {
+            // Loop through each segment of the ship
+            for (int j = 0; j < ships[i].size; j++) {
+                int cell_x = ships[i].x + (ships[i].orientation == 0 ? j : 0);
+                int cell_y = ships[i].y + (ships[i].orientation == 1 ? j : 0);
+                SDL_Rect ship_rect = {board_x + cell_x * CELL_SIZE, board_y + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+                render_ship_segment(batch, textures, ships[i], j, ships[i].orientation, &ship_rect);
+            }
+        }
+    }
+}
+
+void render_ship_segment(QuadBatch *batch, GameTextures *textures, Ship ship, int segment, int orientation,
+                         SDL_Rect *ship_rect) {
+    // Vertical orientation
+    if (orientation == 1) {
+
+        // Render the top, bottom, and middle segments based on the segment index
+        if (segment == 0) {
+            add_batch_tile(batch, textures, TILE_SHIP_TOP, ship_rect, false);
+        } else if (segment == ship.size - 1) {
+            add_batch_tile(batch, textures, TILE_SHIP_BOTTOM, ship_rect, false);
+        } else {
+            add_batch_tile(batch, textures, TILE_SHIP_MIDDLE, ship_rect, true);
+        }
+    } else { // Horizontal orientation
+
+        // Render the left, right, and middle segments based on the segment index
+        if (segment == 0) {
+            add_batch_tile(batch, textures, TILE_SHIP_LEFT, ship_rect, false);
+        } else if (segment == ship.size - 1) {
+            add_batch_tile(batch, textures, TILE_SHIP_RIGHT, ship_rect, false);
+        } else {
+            add_batch_tile(batch, textures, TILE_SHIP_MIDDLE, ship_rect, false);
+        }
+    }
+}
+
+void
+render_placement_grid_ships(SDL_Renderer *renderer, GameTextures *textures, const GameBoard *board, Ship ships[],
+                            const bool placed_ships[], int ship_selected, int orientation, int grid_mouse_x,
+                            int grid_mouse_y, bool valid_position) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    QuadBatch batch;
+
+    // The grid background depends on whether a ship is selected, so it is part of the layer variant
+    BoardLayer *layer = get_board_layer(renderer, board, BOARD_VIEW_PLACEMENT, ship_selected >= 0);
+    if (layer == NULL) {
+        // Render grid background and placed ships directly
+        begin_quad_batch(&batch, renderer, textures->atlas);
+        render_grid_background(&batch, textures, ship_selected, 400, 50);
+        render_placed_ships(&batch, textures, ships, placed_ships, 400, 50);
+        flush_quad_batch(&batch);
+    } else {
+        // Redraw grid background and placed ships only if the board changed
+        if (layer->dirty) {
+            begin_board_layer_update(renderer, layer);
+            begin_quad_batch(&batch, renderer, textures->atlas);
+            render_grid_background(&batch, textures, ship_selected, 0, 0);
+            render_placed_ships(&batch, textures, ships, placed_ships, 0, 0);
+            flush_quad_batch(&batch);
+            end_board_layer_update(renderer, layer);
+        }
+        draw_board_layer(renderer, layer, 400, 50);
+    }
+
+    // Render ship hover
+    render_ship_hover(renderer, textures, ships, ship_selected, orientation, grid_mouse_x, grid_mouse_y,
+                      valid_position);
+
+    end_profile_zone(zone);
+}
+
+void render_invalid_position_border(SDL_Renderer *renderer) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    // Render red border around the grid
+    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
+    SDL_Rect border_rect = {400, 50, 320, 320};
+    SDL_RenderDrawRect(renderer, &border_rect);
+
+    end_profile_zone(zone);
+}
+
+void remove_ship_from_board(GameBoard *board, Ship *ship, int x, int y, int orientation) {
+    // Loop through each segment of the ship
+    for (int i = 0; i < ship->size; i++) {
+
+        // Get the cell coordinates
+        int cell_x = x + (orientation == 0 ? i : 0);
+        int cell_y = y + (orientation == 1 ? i : 0);
+
+        // Remove the ship from the cell if it is within the board
+        if (cell_x >= 0 && cell_x < BOARD_SIZE && cell_y >= 0 && cell_y < BOARD_SIZE) {
+            board->cells[cell_x][cell_y].occupied = false;
+        }
+    }
+
+    mark_board_dirty(board);
+}
 
-        SDL_DestroyRenderer(renderer); // Destroy the renderer for player1
-        SDL_DestroyWindow(window);     // Destroy the window for player1
+int find_ship_at_position(Player *player, int x, int y) {
+    // Loop through all ships
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        Ship *ship = &player->ships[i];
 
-        // Create a new window and renderer for player2
-        window = SDL_CreateWindow("Battleship - Player 2", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                                  800, 600, SDL_WINDOW_SHOWN);
-        if (window == NULL) {
-            printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
+        // Check if the ship is at the given position
+        if (ship->x <= x && x < ship->x + (ship->orientation == 0 ? ship->size : 1) &&
+            ship->y <= y && y < ship->y + (ship->orientation == 1 ? ship->size : 1)) {
+            return i;
         }
+    }
+    return -1;
+}
 
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        if (renderer == NULL) {
-            printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
+void reset_game_board(GameBoard *board) {
+    // Reset all cells to be unoccupied
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            board->cells[i][j].occupied = false;
         }
+    }
 
-        // Load game textures
-        textures = load_game_textures(renderer);
+    mark_board_dirty(board);
+}
 
-        if (textures == NULL) {
-            printf("Failed to load game textures.\n");
-            return -1;
+void reset_placement_phase(Ship *ships, bool *placed_ships, int *ship_selected, int *orientation, GameBoard *board) {
+    // Reset ship_selected and orientation
+    *ship_selected = -1;
+    *orientation = 0;
+
+    // Reset ships and placed_ships arrays
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        placed_ships[i] = false;
+        ships[i].hit_count = 0;
+        ships[i].x = 0;
+        ships[i].y = 0;
+    }
+
+    // Reset the game board
+    reset_game_board(board);
+}
+
+void handle_placement_mouse_button_down(bool *running, Player *current_player, int *ship_selected, bool *placed_ships,
+                                        int *orientation, int clicked_widget, bool *invalid_click, int grid_mouse_x,
+                                        int grid_mouse_y, const bool *valid_position, Ship *ships) {
+    // Handle the widget the widget tree found under the click
+    switch (clicked_widget) {
+        // Check if the user clicked on the exit button
+        case PLACEMENT_WIDGET_EXIT:
+            *running = false;
+            break;
+
+            // Check if the user clicked on the orientation button
+        case PLACEMENT_WIDGET_ORIENTATION:
+            *orientation = (*orientation + 1) % 2;
+            break;
+
+            // Check if the user clicked on the reset button
+        case PLACEMENT_WIDGET_RESET:
+            reset_placement_phase(ships, placed_ships, ship_selected, orientation, &current_player->board);
+            break;
+
+            // Check if the user clicked on the "Random Board" button
+        case PLACEMENT_WIDGET_RANDOM:
+            place_random_ships(current_player, ships, placed_ships, ship_selected, orientation);
+            break;
+
+            // Check if the user clicked on the "Finish placement phase" button
+        case PLACEMENT_WIDGET_FINISH:
+            if (all_ships_placed(placed_ships)) {
+                *running = 0;
+            }
+            break;
+
+            // Check if the user clicked on a ship that has not been placed, an earlier event may have placed it
+        default:
+            if (clicked_widget >= PLACEMENT_WIDGET_FIRST_SHIP &&
+                !placed_ships[clicked_widget - PLACEMENT_WIDGET_FIRST_SHIP]) {
+                *ship_selected = clicked_widget - PLACEMENT_WIDGET_FIRST_SHIP;
+            }
+            break;
+    }
+
+    // Update invalid_click only if the user clicked on an invalid position in placement mode (i.e., not on a button or a ship)
+    if (clicked_widget >= 0) {
+        *invalid_click = false;
+    } else if (*ship_selected >= 0) {
+        *invalid_click = !(*valid_position);
+    }
+
+    // Check if the user clicked on the grid
+    if (grid_mouse_x >= 0 && grid_mouse_x < BOARD_SIZE && grid_mouse_y >= 0 && grid_mouse_y < BOARD_SIZE) {
+
+        // Check if the user clicked on a placed ship
+        if (*ship_selected == -1) {
+            int clicked_ship_index = find_ship_at_position(current_player, grid_mouse_x, grid_mouse_y);
+
+            // Check if the user clicked on a placed ship
+            if (clicked_ship_index >= 0 && placed_ships[clicked_ship_index]) {
+                Ship *clicked_ship = &ships[clicked_ship_index];
+                remove_ship_from_board(&current_player->board, clicked_ship, clicked_ship->x, clicked_ship->y,
+                                       clicked_ship->orientation);
+                current_player->remaining_ships--;
+                placed_ships[clicked_ship_index] = false;
+                *ship_selected = clicked_ship_index;
+            }
         }
-        placement_phase_screen(renderer, textures, font, &player2);
 
-        if (player2.remaining_ships != 5) {
-            // Player 1 did not place all ships
-            printf("Player 1 did not place all ships.\n");
-            cleanup(textures, renderer, font, window);
-            return -1;
+        // Check if the user clicked on a valid position and if a ship is selected
+        if (*ship_selected >= 0 && !placed_ships[*ship_selected] && *valid_position) {
+            current_player->ships[*ship_selected].size = ships[*ship_selected].size;
+            place_ship(&current_player->board, &current_player->ships[*ship_selected], grid_mouse_x, grid_mouse_y,
+                       *orientation, *ship_selected);
+            placed_ships[*ship_selected] = true; // Set the ship as placed
+
+            // Update player's placed ships
+            current_player->placed_ships[*ship_selected] = placed_ships[*ship_selected];
+
+            // Update player's ships
+            current_player->remaining_ships++;
+            current_player->ships[*ship_selected].hit_count = 0;
+
+            *ship_selected = -1;
         }
+    }
+}
+
+void handle_placement_phase_event(SDL_Event *event, bool *running, int *ship_selected, bool *placed_ships, Ship *ships,
+                                  Player *current_player, int *orientation, bool *invalid_click,
+                                  WidgetTree *widgets) {
+    while (SDL_PollEvent(event)) {
+        // Hit-test mouse events against the widgets once, which also updates the hovered widget
+        int clicked_widget = handle_widget_event(widgets, event);
 
-        SDL_DestroyRenderer(renderer); // Destroy the renderer for player2
-        SDL_DestroyWindow(window);     // Destroy the window for player2
+        switch (event->type) {
+            // Handle SDL_QUIT evenT
+            case SDL_QUIT:
+                *running = false;
+                break;
 
-        // Create a new window
-        window = SDL_CreateWindow("Battleship - Player 1", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                                  800, 600, SDL_WINDOW_SHOWN);
+                // Handle mouse button press event
+            case SDL_MOUSEBUTTONDOWN:
+                if (event->button.button == SDL_BUTTON_LEFT) {
+                    // Get the grid position of the click, not of the mouse when the events were polled
+                    int grid_mouse_x = (event->button.x - 400) / CELL_SIZE;
+                    int grid_mouse_y = (event->button.y - 50) / CELL_SIZE;
+                    bool valid_position = *ship_selected >= 0 &&
+                                          is_position_valid(current_player, ships[*ship_selected].size, grid_mouse_x,
+                                                            grid_mouse_y, *orientation);
+                    handle_placement_mouse_button_down(running, current_player, ship_selected, placed_ships,
+                                                       orientation, clicked_widget, invalid_click, grid_mouse_x,
+                                                       grid_mouse_y, &valid_position, ships);
+                }
+                break;
 
-        if (window == NULL) {
-            printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
+                // Handle mouse button up event
+            case SDL_MOUSEBUTTONUP:
+                if (event->button.button == SDL_BUTTON_LEFT) {
+                    *invalid_click = false;
+                }
+                break;
+
+                // Handle lost render target contents
+            case SDL_RENDER_TARGETS_RESET:
+                mark_all_board_layers_dirty();
+                mark_widget_tree_dirty(widgets);
+                break;
         }
+    }
+}
 
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        if (renderer == NULL) {
-            printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
+void placement_phase_screen(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *current_player) {
+    // Load background texture
+    SDL_Texture *background_texture = acquire_texture("Assets/selecting_screen_background.jpg");
+
+    // Create black surface
+    SDL_Surface *black_surface = SDL_CreateRGBSurface(0, CELL_SIZE, CELL_SIZE, 32, 0, 0, 0, 0);
+    SDL_SetSurfaceAlphaMod(black_surface, 128); // Set the alpha value to 128 (50% opacity)
+    SDL_FillRect(black_surface, NULL, SDL_MapRGB(black_surface->format, 0, 0, 0));
+    SDL_Texture *black_texture = SDL_CreateTextureFromSurface(renderer, black_surface);
+    SDL_SetTextureBlendMode(black_texture, SDL_BLENDMODE_BLEND);
+
+    // Initialize variables
+    int ship_selected = -1;
+    int orientation = 0; // 0 for horizontal, 1 for vertical
+    bool invalid_click = false;
+    bool placed_ships[NUM_SHIPS] = {false};
+    current_player->remaining_ships = 0;
+
+    initialize_game_board(&current_player->board);
+
+    // Initialize ships
+    initialize_ships(current_player);
+
+    // Initialize the widgets in the order of PlacementWidget, the ships on the left side can be clicked to select them
+    WidgetTree widgets;
+    init_widget_tree(&widgets);
+    SDL_Point button_label_offset = {24, 10};
+    add_widget(&widgets, WIDGET_TEXT, (SDL_Rect) {0, 0, 100, 50}, (SDL_Point) {25, 10}, "Exit");
+    add_widget(&widgets, WIDGET_BUTTON, (SDL_Rect) {50, 300, 275, 50}, button_label_offset, "Orientation: Horizontal");
+    add_widget(&widgets, WIDGET_BUTTON, (SDL_Rect) {50, 400, 275, 50}, button_label_offset, "Restart the board");
+    add_widget(&widgets, WIDGET_BUTTON, (SDL_Rect) {50, 500, 275, 50}, button_label_offset, "Randomize the board");
+    add_widget(&widgets, WIDGET_BUTTON, (SDL_Rect) {425, 400, 275, 50}, button_label_offset, "Finish placing ships");
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        SDL_Rect ship_rect = {50, 50 + i * 50, current_player->ships[i].size * CELL_SIZE, CELL_SIZE};
+        add_widget(&widgets, WIDGET_AREA, ship_rect, (SDL_Point) {0, 0}, "");
+    }
+
+    // Main loop for the placement_phase_screen
+    bool running = 1;
+    bool redraw = true;
+    begin_screen_stats("placement_phase");
+    while (running) {
+        SDL_Event event;
+
+        // Sleep until an event arrives, the screen only changes on input
+        if (!redraw && !wait_for_events(IDLE_WAIT_TIMEOUT)) {
+            continue;
         }
+        redraw = false;
 
-        // Load game textures
-        textures = load_game_textures(renderer);
+        // Apply all queued input right before the frame is built
+        handle_placement_phase_event(&event, &running, &ship_selected, placed_ships, current_player->ships,
+                                     current_player, &orientation, &invalid_click, &widgets);
+        if (!running) {
+            break;
+        }
+        begin_frame_stats();
 
-        if (textures == NULL) {
-            printf("Failed to load game textures.\n");
-            return -1;
+        // Update the widgets from the placement state, their textures are only redrawn if this changes them
+        set_widget_label(&widgets, PLACEMENT_WIDGET_ORIENTATION,
+                         orientation == 0 ? "Orientation: Horizontal" : "Orientation: Vertical");
+        set_widget_enabled(&widgets, PLACEMENT_WIDGET_FINISH, all_ships_placed(placed_ships));
+        for (int i = 0; i < NUM_SHIPS; i++) {
+            set_widget_enabled(&widgets, PLACEMENT_WIDGET_FIRST_SHIP + i, !placed_ships[i]);
         }
 
-        // Seed the random number generator
-        pcg32_srandom(time(NULL), (intptr_t) &main);
+        // Late-latch the mouse position, so the hover follows the motion that arrived while drawing
+        int mouse_x, mouse_y;
+        get_latest_mouse_state(&mouse_x, &mouse_y);
+        update_widget_hover(&widgets, mouse_x, mouse_y);
+        int ship_hovered = widgets.hovered_widget >= PLACEMENT_WIDGET_FIRST_SHIP
+                           ? widgets.hovered_widget - PLACEMENT_WIDGET_FIRST_SHIP : -1;
 
-        game_screen(renderer, window, textures, font, &player1, &player2, &current_turn, NULL);
-    } else if (menu_option == MAIN_MENU_NEW_GAME_PVC) {
-        SDL_DestroyRenderer(renderer); // Destroy the renderer for the main menu
-        SDL_DestroyWindow(window);     // Destroy the window for the main menu
+        // Clear screen
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderClear(renderer);
 
-        window = SDL_CreateWindow("Battleship - Player 1", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                                  800, 600, SDL_WINDOW_SHOWN);
-        if (window == NULL) {
-            printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
-        }
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        if (renderer == NULL) {
-            printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
+        // Render screen background
+        SDL_RenderCopy(renderer, background_texture, NULL, NULL);
+
+        // Render the ships on the left side of the screen
+        render_placement_ships_left_side(renderer, textures, current_player->ships, placed_ships, black_texture,
+                                         ship_selected, ship_hovered);
+
+        // Get the grid position of the mouse
+        int grid_mouse_x = (mouse_x - 400) / CELL_SIZE;
+        int grid_mouse_y = (mouse_y - 50) / CELL_SIZE;
+        bool valid_position = ship_selected >= 0 &&
+                              is_position_valid(current_player, current_player->ships[ship_selected].size,
+                                                grid_mouse_x, grid_mouse_y, orientation);
+
+        // Render the grid and the ships on the grid (if any).
+        render_placement_grid_ships(renderer, textures, &current_player->board, current_player->ships, placed_ships,
+                                    ship_selected, orientation, grid_mouse_x, grid_mouse_y, valid_position);
+
+        // Render the exit option and the buttons
+        render_widgets(renderer, font, &widgets);
+
+        // Render invalid position border
+        if (invalid_click) {
+            render_invalid_position_border(renderer);
         }
 
-        // Load game textures
-        textures = load_game_textures(renderer);
+        // Render the screen
+        render_frame_stats_overlay(renderer, font);
+        SDL_RenderPresent(renderer);
+        end_frame_stats();
+    }
+    end_screen_stats();
 
-        if (textures == NULL) {
-            printf("Failed to load game textures.\n");
-            return -1;
+    // Destroy textures
+    release_texture(background_texture);
+    SDL_FreeSurface(black_surface);
+    SDL_DestroyTexture(black_texture);
+    destroy_board_layers();
+    destroy_widget_tree(&widgets);
+}
+
+void placement_phase_computer(Player *computer) {
+    // Initialize the computer's game board
+    initialize_game_board(&computer->board);
+
+    // Initialize the computer's ships
+    initialize_ships(computer);
+
+    // Let the engine place the ships if one plays the computer
+    if (is_engine_game() && place_engine_fleet(computer)) {
+        return;
+    }
+
+    // Place the computer's ships randomly
+    int ship_selected = -1;
+    int orientation = 0;
+    bool placed_ships[NUM_SHIPS] = {false};
+    place_random_ships(computer, computer->ships, placed_ships, &ship_selected, &orientation);
+}
+
+void render_player_board(SDL_Renderer *renderer, GameTextures *textures, Player *player, int board_x, int board_y) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    // The whole board is drawn from the atlas with a single batch
+    QuadBatch batch;
+    begin_quad_batch(&batch, renderer, textures->atlas);
+
+    // Render the placed ships on the player's board
+    render_placed_ships(&batch, textures, player->ships, player->placed_ships, board_x, board_y);
+
+    // Loop through the cells of the player's board and render the appropriate texture
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            Cell cell = player->board.cells[x][y];
+            SDL_Rect cell_rect = {board_x + x * CELL_SIZE, board_y + y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+
+            // Render hit or miss textures
+            if (cell.hit) {
+                if (cell.occupied) {
+                    add_batch_tile(&batch, textures, TILE_HIT_OWN_SHIP, &cell_rect, false);
+                } else {
+                    add_batch_tile(&batch, textures, TILE_HIT_OCEAN, &cell_rect, false);
+                }
+            } else {
+                // Render the ocean texture if the cell is not hit or occupied
+                if (!cell.occupied) {
+                    add_batch_tile(&batch, textures, TILE_OCEAN, &cell_rect, false);
+                }
+            }
         }
+    }
 
-        player1.is_human = true;
-        player2.is_human = false;
+    flush_quad_batch(&batch);
+    render_shot_heatmap(renderer, player, board_x, board_y);
 
-        placement_phase_screen(renderer, textures, font, &player1);
+    end_profile_zone(zone);
+}
 
-        if (player1.remaining_ships != 5) {
-            // Player 1 did not place all ships
-            printf("Player 1 did not place all ships.\n");
-            cleanup(textures, renderer, font, window);
-            return -1;
+void render_opponent_board(SDL_Renderer *renderer, GameTextures *textures, Player *opponent, int board_x, int board_y) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    // The whole board is drawn from the atlas with a single batch
+    QuadBatch batch;
+    begin_quad_batch(&batch, renderer, textures->atlas);
+
+    // Loop through the cells of the opponent's board and render the appropriate texture
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            Cell cell = opponent->board.cells[x][y];
+            SDL_Rect cell_rect = {board_x + x * CELL_SIZE, board_y + y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+
+            // Render hit or miss textures
+            if (cell.hit) {
+                if (cell.occupied) {
+                    add_batch_tile(&batch, textures, TILE_HIT_ENEMY_SHIP, &cell_rect, false);
+                } else {
+                    add_batch_tile(&batch, textures, TILE_MISS, &cell_rect, false);
+                }
+
+                // Render the ocean texture if the cell is not hit or occupied
+            } else {
+                add_batch_tile(&batch, textures, TILE_OCEAN, &cell_rect, false);
+            }
         }
+    }
 
-        SDL_DestroyRenderer(renderer); // Destroy the renderer for player1
-        SDL_DestroyWindow(window);     // Destroy the window for player1
+    flush_quad_batch(&batch);
+    render_shot_heatmap(renderer, opponent, board_x, board_y);
 
-        placement_phase_computer(&player2);
+    end_profile_zone(zone);
+}
 
-        // Create a new window
-        window = SDL_CreateWindow("Battleship - Player 1", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                                  800, 600, SDL_WINDOW_SHOWN);
+// AI shot heatmaps of the boards shown, the first one is reused when they are all taken
+static ShotHeatmap shot_heatmaps[MAX_SHOT_HEATMAPS];
+static int num_shot_heatmaps = 0;
+static bool shot_heatmap_enabled = false;
 
-        if (window == NULL) {
-            printf("Window could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
-        }
+// Players of the game being played and the state of its built-in AI, the heatmap is off without them
+static const Player *shot_heatmap_players[2];
+static const AI_State *shot_heatmap_ai_state;
+static bool shot_heatmap_spectating = false;
 
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        if (renderer == NULL) {
-            printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
-            return -1;
-        }
+void render_shot_heatmap(SDL_Renderer *renderer, const Player *player, int board_x, int board_y) {
+    if (!shot_heatmap_enabled || (shot_heatmap_ai_state == NULL && !shot_heatmap_spectating) || is_engine_game()) {
+        return;
+    }
 
-        // Load game textures
-        textures = load_game_textures(renderer);
+    // Only the board of a player facing the computer is shaded, or both boards of a match of the server
+    const Player *shooter = player == shot_heatmap_players[0] ? shot_heatmap_players[1]
+                            : player == shot_heatmap_players[1] ? shot_heatmap_players[0] : NULL;
+    if (shooter == NULL || (shooter->is_human && !shot_heatmap_spectating)) {
+        return;
+    }
+    AI_State ai_state = shot_heatmap_ai_state != NULL ? *shot_heatmap_ai_state : SEARCH;
+
+    // Find the heatmap of the board
+    uint8_t view[RULES_NUM_CELLS];
+    uint8_t sunk_ships[RULES_NUM_SHIPS];
+    get_player_view(player, view, sunk_ships);
+    ShotHeatmap *heatmap = NULL;
+    for (int i = 0; i < num_shot_heatmaps && heatmap == NULL; i++) {
+        heatmap = shot_heatmaps[i].board == &player->board ? &shot_heatmaps[i] : NULL;
+    }
+    if (heatmap == NULL) {
+        heatmap = &shot_heatmaps[num_shot_heatmaps < MAX_SHOT_HEATMAPS ? num_shot_heatmaps++ : 0];
+        heatmap->board = &player->board;
+        heatmap->view[0] = UINT8_MAX; // No view matches, so the first use computes the quads
+    }
 
-        if (textures == NULL) {
-            printf("Failed to load game textures.\n");
-            return -1;
+    // Recompute all the quads only if a shot changed the view of the board or the state of the AI
+    if (memcmp(heatmap->view, view, sizeof(view)) != 0 || heatmap->ai_state != ai_state) {
+        memcpy(heatmap->view, view, sizeof(view));
+        heatmap->ai_state = ai_state;
+        float probabilities[RULES_NUM_CELLS];
+        if (shot_heatmap_spectating) {
+            get_server_shot_probabilities(view, probabilities);
+        } else {
+            get_computer_shot_probabilities(player, shot_heatmap_ai_state, probabilities);
+        }
+        float max_probability = 0.0f;
+        for (int i = 0; i < RULES_NUM_CELLS; i++) {
+            max_probability = probabilities[i] > max_probability ? probabilities[i] : max_probability;
         }
 
-        AI_State ai_state = SEARCH;
+        // One quad per cell not shot yet, more opaque for the cells the AI is more likely to shoot
+        heatmap->num_quads = 0;
+        for (int i = 0; i < RULES_NUM_CELLS && max_probability > 0.0f; i++) {
+            if (view[i] != NET_CELL_UNKNOWN) {
+                continue;
+            }
+            Uint8 alpha = (Uint8) (probabilities[i] / max_probability * SHOT_HEATMAP_MAX_ALPHA);
+            float x = (float) (i / BOARD_SIZE * CELL_SIZE);
+            float y = (float) (i % BOARD_SIZE * CELL_SIZE);
+            SDL_Vertex *vertices = &heatmap->vertices[heatmap->num_quads * 4];
+            vertices[0] = (SDL_Vertex) {{x, y}, {255, 64, 0, alpha}, {0.0f, 0.0f}};
+            vertices[1] = (SDL_Vertex) {{x + CELL_SIZE, y}, {255, 64, 0, alpha}, {0.0f, 0.0f}};
+            vertices[2] = (SDL_Vertex) {{x + CELL_SIZE, y + CELL_SIZE}, {255, 64, 0, alpha}, {0.0f, 0.0f}};
+            vertices[3] = (SDL_Vertex) {{x, y + CELL_SIZE}, {255, 64, 0, alpha}, {0.0f, 0.0f}};
+            heatmap->num_quads++;
+        }
+    }
 
-        game_screen(renderer, window, textures, font, &player1, &player2, &current_turn, &ai_state);
+    // Move the quads to the board and draw them with one call
+    static SDL_Vertex vertices[BOARD_SIZE * BOARD_SIZE * 4];
+    int num_vertices = heatmap->num_quads * 4;
+    for (int i = 0; i < num_vertices; i++) {
+        vertices[i] = heatmap->vertices[i];
+        vertices[i].position.x += (float) board_x;
+        vertices[i].position.y += (float) board_y;
     }
+    if (num_vertices > 0) {
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_RenderGeometry(renderer, NULL, vertices, num_vertices, get_quad_indices(), heatmap->num_quads * 6);
+    }
+}
 
-    // Cleanup and exit
-    cleanup(textures, renderer, font, window);
-    return 0;
+void toggle_shot_heatmap(void) {
+    shot_heatmap_enabled = !shot_heatmap_enabled;
+    mark_all_board_layers_dirty();
 }
 
-// Function definitions
+void set_shot_heatmap_game(const Player *player1, const Player *player2, const AI_State *ai_state, bool spectating) {
+    shot_heatmap_players[0] = player1;
+    shot_heatmap_players[1] = player2;
+    shot_heatmap_ai_state = ai_state;
+    shot_heatmap_spectating = spectating;
 
-bool save_game(Player *player1, Player *player2, int current_turn, AI_State *ai_state) {
-    // Save the game state to a file ("saved_game.dat")
-    FILE *save_file = fopen("saved_game.dat", "wb");
-    if (save_file == NULL) {
-        return false;
+    // The boards of a new game may reuse the memory of the previous ones
+    num_shot_heatmaps = 0;
+}
+
+void render_game_boards(SDL_Renderer *renderer, GameTextures *textures, Player *current_player, Player *opponent,
+                        bool hide_fleets) {
+    ProfileZone zone = begin_profile_zone(__func__);
+
+    int board_x_offset = 50; // Adjust the horizontal spacing between the boards
+    int board_y_offset = 100; // Adjust the vertical spacing from the top of the screen
+
+    // Render the current player's board, with only the shots if the fleets are hidden
+    if (hide_fleets) {
+        render_cached_opponent_board(renderer, textures, current_player, board_x_offset, board_y_offset);
+    } else {
+        render_cached_player_board(renderer, textures, current_player, board_x_offset, board_y_offset);
     }
 
-    // Write player1, player2, current_turn and ai_state to the save file
-    fwrite(player1, sizeof(Player), 1, save_file);
-    fwrite(player2, sizeof(Player), 1, save_file);
-    fwrite(&current_turn, sizeof(int), 1, save_file);
-    fwrite(ai_state, sizeof(AI_State), 1, save_file);
+    // Render the opponent's board
+    int opponent_board_x = 2 * board_x_offset + BOARD_SIZE * CELL_SIZE;
+    render_cached_opponent_board(renderer, textures, opponent, opponent_board_x, board_y_offset);
 
-    // Close the save file
-    fclose(save_file);
-    return true;
+    end_profile_zone(zone);
 }
 
-bool load_game(Player *player1, Player *player2, int *current_turn, AI_State *ai_state) {
-    // Load the game state from a file ("saved_game.dat")
-    FILE *save_file = fopen("saved_game.dat", "rb");
-    if (save_file == NULL) {
-        return false;
+// Cached board layers of the current screen
+static BoardLayer board_layers[MAX_BOARD_LAYERS];
+static int num_board_layers = 0;
+
+void mark_board_dirty(const GameBoard *board) {
+    // Mark every view of the board
+    for (int i = 0; i < num_board_layers; i++) {
+        if (board_layers[i].board == board) {
+            board_layers[i].dirty = true;
+        }
     }
+}
 
-    // Read player1, player2, current_turn, and ai_state from the save file
-    fread(player1, sizeof(Player), 1, save_file);
-    fread(player2, sizeof(Player), 1, save_file);
-    fread(current_turn, sizeof(int), 1, save_file);
-    fread(ai_state, sizeof(AI_State), 1, save_file);
+void mark_all_board_layers_dirty(void) {
+    for (int i = 0; i < num_board_layers; i++) {
+        board_layers[i].dirty = true;
+    }
+}
 
-    // Close the save file
-    fclose(save_file);
-    return true;
+void set_premultiplied_blend_mode(SDL_Texture *texture) {
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                                             SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE,
+                                                             SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                                             SDL_BLENDOPERATION_ADD);
+    if (SDL_SetTextureBlendMode(texture, premultiplied) != 0) {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
 }
 
-SDL_Texture *load_texture(const char *filename, SDL_Renderer *renderer) {
-    // Load the image as an SDL_Surface
-    SDL_Surface *surface = IMG_Load(filename);
-    if (surface == NULL) {
-        printf("Failed to load image: %s. SDL Error: %s\n", filename, IMG_GetError());
+BoardLayer *get_board_layer(SDL_Renderer *renderer, const GameBoard *board, BoardView view, int variant) {
+    // Look for an existing layer of the board
+    for (int i = 0; i < num_board_layers; i++) {
+        BoardLayer *layer = &board_layers[i];
+        if (layer->board == board && layer->view == view) {
+            if (layer->variant != variant) {
+                layer->variant = variant;
+                layer->dirty = true;
+            }
+            return layer;
+        }
+    }
+
+    // Create a new layer if the renderer supports render targets
+    if (num_board_layers == MAX_BOARD_LAYERS || !SDL_RenderTargetSupported(renderer)) {
         return NULL;
     }
 
-    // Convert the SDL_Surface to an SDL_Texture
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                             BOARD_SIZE * CELL_SIZE, BOARD_SIZE * CELL_SIZE);
     if (texture == NULL) {
-        printf("Failed to create texture from surface. SDL Error: %s\n", SDL_GetError());
+        printf("Failed to create board layer. SDL Error: %s\n", SDL_GetError());
+        return NULL;
     }
 
-    // Free the SDL_Surface
-    SDL_FreeSurface(surface);
-    return texture;
+    // The layer is drawn with blending into a transparent target
+    set_premultiplied_blend_mode(texture);
+
+    BoardLayer *layer = &board_layers[num_board_layers++];
+    layer->board = board;
+    layer->view = view;
+    layer->variant = variant;
+    layer->texture = texture;
+    layer->dirty = true;
+    return layer;
 }
 
-GameTextures *load_game_textures(SDL_Renderer *renderer) {
-    // Allocate memory for the GameTextures structure
-    GameTextures *textures = (GameTextures *) malloc(sizeof(GameTextures));
-    if (textures == NULL) {
-        printf("Failed to allocate memory for game textures.\n");
-        return NULL;
-    }
+void begin_board_layer_update(SDL_Renderer *renderer, BoardLayer *layer) {
+    // Draw into the layer texture, starting from a transparent board
+    SDL_SetRenderTarget(renderer, layer->texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+}
 
-    // Load individual game textures
-    textures->ocean = load_texture("Assets/ocean.png", renderer);
-    textures->ocean_selection_mode = load_texture("Assets/ocean_selection_mode.png", renderer);
-    textures->ship_bottom = load_texture("Assets/ship_bottom.png", renderer);
-    textures->ship_left = load_texture("Assets/ship_left.png", renderer);
-    textures->ship_middle = load_texture("Assets/ship_middle.png", renderer);
-    textures->ship_right = load_texture("Assets/ship_right.png", renderer);
-    textures->ship_top = load_texture("Assets/ship_top.png", renderer);
-    textures->hit_enemy_ship = load_texture("Assets/hit_enemy_ship.png", renderer);
-    textures->hit_own_ship = load_texture("Assets/hit_own_ship.png", renderer);
-    textures->hit_ocean = load_texture("Assets/hit_ocean.png", renderer);
-    textures->miss = load_texture("Assets/miss.png", renderer);
+void end_board_layer_update(SDL_Renderer *renderer, BoardLayer *layer) {
+    // Go back to drawing on the screen
+    SDL_SetRenderTarget(renderer, NULL);
+    layer->dirty = false;
+}
 
-    return textures;
+void draw_board_layer(SDL_Renderer *renderer, BoardLayer *layer, int board_x, int board_y) {
+    SDL_Rect board_rect = {board_x, board_y, BOARD_SIZE * CELL_SIZE, BOARD_SIZE * CELL_SIZE};
+    SDL_RenderCopy(renderer, layer->texture, NULL, &board_rect);
 }
 
-SDL_Texture **load_animated_background(SDL_Renderer *renderer, const char *filepath, int num_frames) {
-    // Allocate memory for the array of SDL_Texture pointers
-    SDL_Texture **textures = (SDL_Texture **) malloc(sizeof(SDL_Texture *) * num_frames);
+void destroy_board_layers(void) {
+    for (int i = 0; i < num_board_layers; i++) {
+        SDL_DestroyTexture(board_layers[i].texture);
+    }
+    SDL_zero(board_layers);
+    num_board_layers = 0;
+}
 
-    // Load each frame of the animation
-    for (int i = 0; i < num_frames; i++) {
-        char filename[128];
-        snprintf(filename, sizeof(filename), "%s%d.png", filepath, i);
-        textures[i] = load_texture(filename, renderer);
-        if (textures[i] == NULL) {
-            printf("Failed to load background frame: %s\n", filename);
-            return NULL;
-        }
+void render_cached_player_board(SDL_Renderer *renderer, GameTextures *textures, Player *player, int board_x,
+                                int board_y) {
+    // Draw directly if the board cannot be cached
+    BoardLayer *layer = get_board_layer(renderer, &player->board, BOARD_VIEW_OWN, 0);
+    if (layer == NULL) {
+        render_player_board(renderer, textures, player, board_x, board_y);
+        return;
     }
 
-    return textures;
+    // Redraw the layer only if the board changed
+    if (layer->dirty) {
+        begin_board_layer_update(renderer, layer);
+        render_player_board(renderer, textures, player, 0, 0);
+        end_board_layer_update(renderer, layer);
+    }
+    draw_board_layer(renderer, layer, board_x, board_y);
 }
 
-void render_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y) {
-    // Set the text color
-    SDL_Color color = {0, 0, 0, 255}; // Black
-
-    // Create a surface containing the rendered text
-    SDL_Surface *text_surface = TTF_RenderText_Solid(font, text, color);
-    if (text_surface == NULL) {
-        printf("TTF_RenderText_Solid: %s\n", TTF_GetError());
-        exit(2);
+void render_cached_opponent_board(SDL_Renderer *renderer, GameTextures *textures, Player *opponent, int board_x,
+                                  int board_y) {
+    // Draw directly if the board cannot be cached
+    BoardLayer *layer = get_board_layer(renderer, &opponent->board, BOARD_VIEW_OPPONENT, 0);
+    if (layer == NULL) {
+        render_opponent_board(renderer, textures, opponent, board_x, board_y);
+        return;
     }
 
-    // Convert the surface to a texture
-    SDL_Texture *text_texture = SDL_CreateTextureFromSurface(renderer, text_surface);
-    if (text_texture == NULL) {
-        printf("SDL_CreateTextureFromSurface: %s\n", SDL_GetError());
-        exit(2);
+    // Redraw the layer only if the board changed
+    if (layer->dirty) {
+        begin_board_layer_update(renderer, layer);
+        render_opponent_board(renderer, textures, opponent, 0, 0);
+        end_board_layer_update(renderer, layer);
     }
+    draw_board_layer(renderer, layer, board_x, board_y);
+}
 
-    // Set the position and size of the text
-    SDL_Rect text_rect;
-    text_rect.x = x;
-    text_rect.y = y;
-    text_rect.w = text_surface->w;
-    text_rect.h = text_surface->h;
+void render_game_hover_effect(SDL_Renderer *renderer, SDL_Texture *white_texture, int cell_x, int cell_y, int board_x,
+                              int board_y) {
+    ProfileZone zone = begin_profile_zone(__func__);
 
-    // Render the text texture
-    SDL_RenderCopy(renderer, text_texture, NULL, &text_rect);
+    QuadBatch batch;
+    SDL_Color white = {255, 255, 255, 255};
+    begin_quad_batch(&batch, renderer, white_texture);
 
-    // Free resources
-    SDL_DestroyTexture(text_texture);
-    SDL_FreeSurface(text_surface);
+    // Render hover effect on the specified cell and its corresponding x and y-axis cells
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        if (i != cell_y) {
+            SDL_Rect hover_rect = {board_x + cell_x * CELL_SIZE, board_y + i * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+            add_batch_quad(&batch, NULL, &hover_rect, white, false);
+        }
+
+        if (i != cell_x) {
+            SDL_Rect hover_rect = {board_x + i * CELL_SIZE, board_y + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+            add_batch_quad(&batch, NULL, &hover_rect, white, false);
+        }
+    }
+
+    flush_quad_batch(&batch);
+
+    end_profile_zone(zone);
 }
 
-void render_colored_text(SDL_Renderer *renderer, const char *text, TTF_Font *font, int x, int y, int r, int g, int b) {
-    // Set the text color
-    SDL_Color color = {r, g, b, 255};
+void render_remaining_ships_text(SDL_Renderer *renderer, TTF_Font *font, Player *current_player, Player *opponent) {
+    ProfileZone zone = begin_profile_zone(__func__);
 
-    // Create the surface and texture
-    SDL_Surface *surface = TTF_RenderText_Solid(font, text, color);
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    char text_buffer[50];
+    int text_y = 100 + BOARD_SIZE * CELL_SIZE + 10;
 
-    // Set the text position
-    SDL_Rect text_rect = {x, y, surface->w, surface->h};
+    // Render remaining ships text for the current player
+    snprintf(text_buffer, sizeof(text_buffer), "Remaining ships: %d", current_player->remaining_ships);
+    render_colored_text(renderer, text_buffer, font, 50, text_y, 255, 255, 255);
 
-    // Render the texture
-    SDL_RenderCopy(renderer, texture, NULL, &text_rect);
+    // Render remaining ships text for the opponent
+    snprintf(text_buffer, sizeof(text_buffer), "Remaining ships: %d", opponent->remaining_ships);
+    int text_x = 2 * 50 + BOARD_SIZE * CELL_SIZE;
+    render_colored_text(renderer, text_buffer, font, text_x, text_y, 255, 255, 255);
 
-    // Free resources
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
+    end_profile_zone(zone);
 }
 
-int is_mouse_inside_button(int x, int y, SDL_Rect button_rect) {
-    // Check if the mouse is inside the button
-    return x >= button_rect.x && x <= button_rect.x + button_rect.w &&
-           y >= button_rect.y && y <= button_rect.y + button_rect.h;
-}
+bool update_hit_count(Player *player, int ship_index) {
+    // Update the hit count of the ship
+    player->ships[ship_index].hit_count++;
 
-void init_main_menu(SDL_Renderer *renderer, SDL_Texture ***background_frames, SDL_Rect *button_rects,
-                    int *num_background_frames) {
-    // Load animated background textures
-    *num_background_frames = 10;
-    *background_frames = load_animated_background(renderer, "Assets/Backgrounds/frame_", *num_background_frames);
-    if (*background_frames == NULL) {
-        printf("Failed to load animated background.\n");
-        return;
+    // Check if the ship has been sunk
+    if (player->ships[ship_index].hit_count == player->ships[ship_index].size) {
+        player->remaining_ships--;
+        return true;
     }
+    return false;
+}
 
-    // Create buttons and positions for the main menu
-    for (int i = 0; i < 4; i++) {
-        button_rects[i].x = (BOARD_SIZE * CELL_SIZE) / 2 - 105;
-        button_rects[i].y = 85 + i * 60;
-        button_rects[i].w = 210;
-        button_rects[i].h = 40;
-    }
+void update_window_title(SDL_Window *window, int current_player_num) {
+    // Update the window title to show the current player
+    char title[50];
+    snprintf(title, sizeof(title), "Battleship - Player %d", current_player_num);
+    SDL_SetWindowTitle(window, title);
 }
 
-int
-handle_main_menu_events(SDL_Event *event, SDL_Rect *button_rects, int *hover_button, MainMenuOption *selected_option) {
-    int running = 1;
+void show_winner_message(SDL_Renderer *renderer, TTF_Font *font, int winner_player_num) {
+    // Create the winner message
+    char message[50];
+    sprintf(message, "Player %d won!", winner_player_num);
 
-    // Handle SDL_QUIT event
-    if (event->type == SDL_QUIT) {
-        running = 0;
-    }
+    // Render the winner message
+    SDL_Color color = {255, 255, 255, 255};
+    render_colored_text(renderer, message, font, 300, 500, color.r, color.g, color.b);
+}
 
-        // Handle mouse button press
-    else if (event->type == SDL_MOUSEBUTTONDOWN) {
-        if (event->button.button == SDL_BUTTON_LEFT) {
-            int x = event->button.x;
-            int y = event->button.y;
+void handle_game_mouse_button_down(SDL_Event *event, Timeline *timeline, Player *current_player, Player *opponent) {
+    // Get the position of the click
+    int mouse_x = event->button.x;
+    int mouse_y = event->button.y;
 
-            // Check if any buttons were clicked
-            for (int i = 0; i < 4; i++) {
-                if (is_mouse_inside_button(x, y, button_rects[i])) {
-                    *selected_option = (MainMenuOption) i;
-                    return 0;
-                }
+    // Get the x and y coordinates of the opponent's board
+    int opponent_board_x = 2 * 50 + BOARD_SIZE * CELL_SIZE;
+    int opponent_board_y = 100;
+
+    // Check if the mouse click is within the opponent's board and if the player can shoot
+    if (current_player->can_shoot && mouse_x >= opponent_board_x &&
+        mouse_x < opponent_board_x + BOARD_SIZE * CELL_SIZE &&
+        mouse_y >= opponent_board_y && mouse_y < opponent_board_y + BOARD_SIZE * CELL_SIZE) {
+
+        int cell_x = (mouse_x - opponent_board_x) / CELL_SIZE;
+        int cell_y = (mouse_y - opponent_board_y) / CELL_SIZE;
+
+        // Check if the cell is already hit
+        if (!opponent->board.cells[cell_x][cell_y].hit) {
+            // In a networked game the opponent resolves the shot, its result arrives as a message
+            if (is_net_game()) {
+                send_net_shot(current_player, cell_x, cell_y);
+                return;
             }
-        }
-    }
 
-        // Handle mouse movement
-    else if (event->type == SDL_MOUSEMOTION) {
-        int x = event->motion.x;
-        int y = event->motion.y;
+            opponent->board.cells[cell_x][cell_y].hit = true;
+            mark_board_dirty(&opponent->board);
+            send_engine_human_shot(cell_x, cell_y);
 
-        // Check if the mouse is hovering over any buttons
-        *hover_button = -1;
-        for (int i = 0; i < 4; i++) {
-            if (is_mouse_inside_button(x, y, button_rects[i])) {
-                *hover_button = i;
-                break;
+            // Set has_shot to true
+            current_player->has_shot = true;
+
+            // Check if the cell is occupied by an enemy ship
+            if (opponent->board.cells[cell_x][cell_y].occupied) {
+                // Update the hit_count of the respective ship and check if it's destroyed
+                int ship_index = opponent->board.cells[cell_x][cell_y].ship_index;
+                update_hit_count(opponent, ship_index);
+
+                // Allow the player to continue shooting
+                current_player->can_shoot = true;
+            } else {
+                // Show the "Finish turn" button
+                current_player->can_shoot = false;
             }
+
+            // Show the shot
+            add_shot_tweens(timeline, opponent, cell_x, cell_y, opponent_board_x, opponent_board_y);
         }
     }
-
-    return running;
 }
 
-void render_main_menu(SDL_Renderer *renderer, SDL_Texture **background_frames, TTF_Font *font, int frame_counter,
-                      SDL_Rect *button_rects, int hover_button) {
-    // Render the animated background
-    SDL_RenderCopy(renderer, background_frames[frame_counter], NULL, NULL);
-
-    // Button labels
-    const char *button_labels[] = {"New Game - PvP", "New Game - PvC", "Load", "Exit"};
+void handle_game_mouse_button_up(Player *current_player, Player *opponent, int clicked_widget, bool *running,
+                                 AI_State *ai_state) {
+    // If the "Finish turn" button is visible and the player cannot shoot, check if the mouse was released over it
+    if (clicked_widget == GAME_WIDGET_FINISH_TURN && !current_player->can_shoot) {
+        current_player->is_turn = !current_player->is_turn;
+        opponent->is_turn = !opponent->is_turn;
 
-    // Render buttons
-    for (int i = 0; i < 4; i++) {
-        // Set button background color based on whether the mouse is hovering over the button
-        if (hover_button == i) {
-            SDL_SetRenderDrawColor(renderer, 230, 230, 230, 255); // Lighter gray for hover
-        } else {
-            SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255); // Original gray
-        }
+        // Reset can_shoot variable
+        current_player->can_shoot = true;
+    }
 
-        // Render the button background
-        SDL_RenderFillRect(renderer, &button_rects[i]);
+    if (clicked_widget == GAME_WIDGET_SAVE) {
+        // The save is written on the save thread, the result arrives as a save complete event
+        request_save(current_player, opponent, current_player->is_turn ? 1 : 2, ai_state);
+    }
 
-        // Render button shadow
-        SDL_Rect shadow_rect = button_rects[i];
-        shadow_rect.x += 4;
-        shadow_rect.y += 4;
-        SDL_SetRenderDrawColor(renderer, 100, 100, 100, 128);
-        SDL_RenderFillRect(renderer, &shadow_rect);
-        // Render button label
-        render_text(renderer, button_labels[i], font, button_rects[i].x + 24, button_rects[i].y + 8);
+    if (clicked_widget == GAME_WIDGET_EXIT) {
+        *running = false;
     }
 }
 
-MainMenuOption main_menu(SDL_Renderer *renderer, TTF_Font *font) {
-    MainMenuOption selected_option = MAIN_MENU_EXIT;
+void handle_game_screen_events(SDL_Event *event, Timeline *timeline, Player *current_player, Player *opponent,
+                               bool *running, WidgetTree *widgets, AI_State *ai_state) {
+    // Handle game screen events
+    while (SDL_PollEvent(event)) {
+        // Hit-test mouse events against the buttons once, which also updates the hovered button
+        int clicked_widget = handle_widget_event(widgets, event);
 
-    // Initialize main menu
-    int num_background_frames;
-    SDL_Texture **background_frames;
-    SDL_Rect button_rects[4];
-    init_main_menu(renderer, &background_frames, button_rects, &num_background_frames);
+        // Report the result of a background save
+        if (event->type == get_save_complete_event()) {
+            if (event->user.code) {
+                printf("Game saved successfully!\n");
+            } else {
+                printf("Error saving game!\n");
+            }
+            continue;
+        }
 
-    // Initialize variables
-    int running = 1;
-    int frame_counter = 0;
-    int hover_button = -1;
+        switch (event->type) {
+            // Handle SDL_QUIT event
+            case SDL_QUIT:
+                *running = false;
+                break;
+
+                // Handle mouse button down event
+            case SDL_MOUSEBUTTONDOWN:
+                if (event->button.button == SDL_BUTTON_LEFT && current_player->is_human) {
+                    handle_game_mouse_button_down(event, timeline, current_player, opponent);
+                }
+                break;
+
+                // Handle mouse button up event
+            case SDL_MOUSEBUTTONUP:
+                if (event->button.button == SDL_BUTTON_LEFT) {
+                    handle_game_mouse_button_up(current_player, opponent, clicked_widget, running, ai_state);
+                }
+                break;
 
-    // Main loop
-    while (running) {
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            running = handle_main_menu_events(&event, button_rects, &hover_button, &selected_option);
-            if (running == 0) {
+                // Handle lost render target contents
+            case SDL_RENDER_TARGETS_RESET:
+                mark_all_board_layers_dirty();
+                mark_widget_tree_dirty(widgets);
                 break;
-            }
         }
+    }
+}
 
-        // Render the main menu
-        frame_counter = (frame_counter + 1) % num_background_frames;
-        render_main_menu(renderer, background_frames, font, frame_counter, button_rects, hover_button);
+void clear_timeline(Timeline *timeline) {
+    timeline->num_tweens = 0;
+    timeline->hold_until = 0;
+}
 
-        // Render the screen
-        SDL_RenderPresent(renderer);
-        SDL_Delay(1000 / 60); // Limit frame rate to 60 FPS
+Uint64 get_animation_duration(int milliseconds) {
+    const GameOptions *options = get_game_options();
+    if (options->instant_animations) {
+        return 0;
     }
+    return (Uint64) ((double) milliseconds * (double) SDL_GetPerformanceFrequency() /
+                     (1000.0 * (double) options->animation_speed));
+}
 
-    // Free resources
-    for (int i = 0; i < num_background_frames; i++) {
-        SDL_DestroyTexture(background_frames[i]);
+void add_tween(Timeline *timeline, TweenKind kind, SDL_Rect rect, int value, int milliseconds) {
+    Uint64 duration = get_animation_duration(milliseconds);
+    if (duration == 0) {
+        return;
     }
-    free(background_frames);
 
-    return selected_option;
+    // Replace the oldest event if the timeline is full
+    if (timeline->num_tweens == MAX_TWEENS) {
+        memmove(&timeline->tweens[0], &timeline->tweens[1], (MAX_TWEENS - 1) * sizeof(Tween));
+        timeline->num_tweens--;
+    }
+    Tween *tween = &timeline->tweens[timeline->num_tweens++];
+    tween->kind = kind;
+    tween->start = SDL_GetPerformanceCounter();
+    tween->duration = duration;
+    tween->rect = rect;
+    tween->value = value;
 }
 
-void initialize_game_board(GameBoard *board) {
-    // Iterate through all cells of the board
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            // Initialize the cells
-            Cell *cell = &board->cells[i][j];
-            cell->x = i;
-            cell->y = j;
-            cell->width = CELL_SIZE;
-            cell->height = CELL_SIZE;
-            cell->ship_index = -1;
-            cell->occupied = false;
-            cell->hit = false;
-        }
+void hold_timeline(Timeline *timeline, int milliseconds) {
+    Uint64 hold_until = SDL_GetPerformanceCounter() + get_animation_duration(milliseconds);
+    if (hold_until > timeline->hold_until) {
+        timeline->hold_until = hold_until;
     }
 }
 
-void initialize_ships(Player *player) {
-    // Iterate through all ships
-    for (int i = 0; i < NUM_SHIPS; ++i) {
-        // Set the size of the ship
-        if (i == 0) {
-            player->ships[i].size = 5;
-        } else if (i == 1) {
-            player->ships[i].size = 4;
-        } else if (i == 2 || i == 3) {
-            player->ships[i].size = 3;
-        } else if (i == 4) {
-            player->ships[i].size = 2;
-        }
+void add_shot_tweens(Timeline *timeline, const Player *target, int cell_x, int cell_y, int board_x, int board_y) {
+    // Find whether the shot hit and sunk a ship
+    const Cell *cell = &target->board.cells[cell_x][cell_y];
+    const Ship *sunk_ship = NULL;
+    if (cell->occupied && target->ships[cell->ship_index].hit_count == target->ships[cell->ship_index].size) {
+        sunk_ship = &target->ships[cell->ship_index];
+    }
 
-        // Initialize the ship values
-        player->ships[i].hit_count = 0;
-        player->ships[i].x = -1;
-        player->ships[i].y = -1;
-        player->ships[i].orientation = 0;
+    add_shot_result_tweens(timeline, cell_x, cell_y, cell->occupied, sunk_ship, board_x, board_y);
+}
+
+void add_shot_result_tweens(Timeline *timeline, int cell_x, int cell_y, bool hit, const Ship *sunk_ship, int board_x,
+                            int board_y) {
+    // Mark the cell, the value tells whether the shot hit
+    SDL_Rect cell_rect = {board_x + cell_x * CELL_SIZE, board_y + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+    add_tween(timeline, TWEEN_SHOT_MARKER, cell_rect, hit, SHOT_MARKER_DURATION);
+
+    // Flash the whole ship if the shot sunk it
+    if (sunk_ship != NULL) {
+        SDL_Rect ship_rect = {board_x + sunk_ship->x * CELL_SIZE, board_y + sunk_ship->y * CELL_SIZE,
+                              sunk_ship->orientation == 0 ? sunk_ship->size * CELL_SIZE : CELL_SIZE,
+                              sunk_ship->orientation == 0 ? CELL_SIZE : sunk_ship->size * CELL_SIZE};
+        add_tween(timeline, TWEEN_SINK_FLASH, ship_rect, 0, SINK_FLASH_DURATION);
     }
 }
 
-bool is_position_valid(Player *current_player, int ship_size, int x, int y, int orientation) {
-    // Iterate through all cells of the ship
-    for (int k = 0; k < ship_size; k++) {
-        int cell_x = x + (orientation == 0 ? k : 0);
-        int cell_y = y + (orientation == 1 ? k : 0);
+bool is_timeline_holding(const Timeline *timeline, Uint64 now) {
+    return now < timeline->hold_until;
+}
 
-        // Check if the cell is inside the grid
-        if (cell_x < 0 || cell_x >= BOARD_SIZE || cell_y < 0 || cell_y >= BOARD_SIZE) {
-            return false;
+void update_timeline(Timeline *timeline, Uint64 now) {
+    // Keep the events that are still playing, in the order they were added
+    int num_kept = 0;
+    for (int i = 0; i < timeline->num_tweens; i++) {
+        if (now < timeline->tweens[i].start + timeline->tweens[i].duration) {
+            timeline->tweens[num_kept++] = timeline->tweens[i];
         }
+    }
+    timeline->num_tweens = num_kept;
+}
 
-        // Check if the cell is already occupied
-        if (current_player->board.cells[cell_x][cell_y].occupied == true) {
-            return false;
-        }
+Uint64 get_next_timeline_time(const Timeline *timeline, Uint64 now) {
+    if (timeline->num_tweens > 0) {
+        return now + SDL_GetPerformanceFrequency() / 60;
     }
-    return true;
+    return is_timeline_holding(timeline, now) ? timeline->hold_until : 0;
 }
 
-bool all_ships_placed(const bool placed_ships[]) {
-    // Iterate through all ships
-    for (int i = 0; i < NUM_SHIPS; i++) {
-        if (!placed_ships[i]) {
-            return false;
+void render_timeline(SDL_Renderer *renderer, TTF_Font *font, const Timeline *timeline, Uint64 now) {
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    for (int i = 0; i < timeline->num_tweens; i++) {
+        const Tween *tween = &timeline->tweens[i];
+        float progress = now >= tween->start ? (float) (now - tween->start) / (float) tween->duration : 0.0f;
+        if (progress > 1.0f) {
+            progress = 1.0f;
+        }
+
+        if (tween->kind == TWEEN_SHOT_MARKER) {
+            // A square closing in on the cell and fading out, red for a hit and white for a miss
+            int inset = (int) ((1.0f - progress) * -12.0f);
+            SDL_Rect marker_rect = {tween->rect.x + inset, tween->rect.y + inset, tween->rect.w - 2 * inset,
+                                    tween->rect.h - 2 * inset};
+            Uint8 alpha = (Uint8) (255.0f * (1.0f - progress));
+            if (tween->value) {
+                SDL_SetRenderDrawColor(renderer, 255, 64, 0, alpha);
+            } else {
+                SDL_SetRenderDrawColor(renderer, 255, 255, 255, alpha);
+            }
+            SDL_RenderDrawRect(renderer, &marker_rect);
+            SDL_Rect inner_rect = {marker_rect.x + 1, marker_rect.y + 1, marker_rect.w - 2, marker_rect.h - 2};
+            SDL_RenderDrawRect(renderer, &inner_rect);
+        } else if (tween->kind == TWEEN_SINK_FLASH) {
+            // The ship blinks twice while fading out
+            if ((int) (progress * 4.0f) % 2 == 0) {
+                SDL_SetRenderDrawColor(renderer, 255, 0, 0, (Uint8) (160.0f * (1.0f - progress)));
+                SDL_RenderFillRect(renderer, &tween->rect);
+            }
+        } else if (tween->kind == TWEEN_TURN_BANNER) {
+            // A band fading in and out, with the text while it is mostly visible
+            float visibility = progress < 0.2f ? progress / 0.2f : progress > 0.8f ? (1.0f - progress) / 0.2f : 1.0f;
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, (Uint8) (180.0f * visibility));
+            SDL_RenderFillRect(renderer, &tween->rect);
+            if (visibility > 0.5f) {
+                char text[32];
+                if (tween->value > 0) {
+                    snprintf(text, sizeof(text), "Player %d's turn", tween->value);
+                } else {
+                    snprintf(text, sizeof(text), "Computer's turn");
+                }
+                int text_width, text_height;
+                TTF_SizeText(font, text, &text_width, &text_height);
+                render_colored_text(renderer, text, font, tween->rect.x + (tween->rect.w - text_width) / 2,
+                                    tween->rect.y + (tween->rect.h - text_height) / 2, 255, 255, 255);
+            }
+        } else if (tween->kind == TWEEN_WIN_MESSAGE) {
+            // A band fading in behind the winner message
+            float visibility = progress < 0.1f ? progress / 0.1f : 1.0f;
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, (Uint8) (180.0f * visibility));
+            SDL_RenderFillRect(renderer, &tween->rect);
+            show_winner_message(renderer, font, tween->value);
         }
     }
-    return true;
 }
 
-void place_ship(GameBoard *board, Ship *ship, int x, int y, int orientation, int ship_index) {
-    // Update the ship's position
-    ship->x = x;
-    ship->y = y;
-    ship->orientation = orientation;
+void shuffle_directions(int *dir_indices, int size) {
+    // Shuffle the directions
+    for (int i = size - 1; i > 0; i--) {
+        int j = (int) pcg32_boundedrand(i + 1);
+        int temp = dir_indices[i];
+        dir_indices[i] = dir_indices[j];
+        dir_indices[j] = temp;
+    }
+}
 
-    // Iterate through all cells of the ship
-    for (int i = 0; i < ship->size; i++) {
-        int cell_x = x + (orientation == 0 ? i : 0);
-        int cell_y = y + (orientation == 1 ? i : 0);
+void remove_cell(int x, int y, int (*remaining_cells)[2], int *remaining_cells_count) {
+    // Find the cell in the array
+    for (int i = 0; i < *remaining_cells_count; i++) {
+        if (remaining_cells[i][0] == x && remaining_cells[i][1] == y) {
+            // Replace the cell with the last cell in the array
+            remaining_cells[i][0] = remaining_cells[*remaining_cells_count - 1][0];
+            remaining_cells[i][1] = remaining_cells[*remaining_cells_count - 1][1];
 
-        Cell *cell = &board->cells[cell_x][cell_y];
-        cell->occupied = true;
-        cell->ship_index = ship_index; // Add this line to update the ship_index
+            // Decrease the count of remaining cells
+            (*remaining_cells_count)--;
+
+            break;
+        }
     }
 }
 
-void place_random_ships(Player *current_player, Ship ships[], bool placed_ships[], int *ship_selected,
-                        int *orientation_to_reset) {
-    // Reset the board and ships
-    reset_placement_phase(ships, placed_ships, ship_selected, orientation_to_reset, &current_player->board);
+void initialize_ai_context(AI_Context* ctx) {
+    ctx->initialized = true;
+    ctx->min_gap = 1;
+    ctx->direction = 0; // 0 -> left, 1 -> down, 2 -> right, 3 -> up
+    ctx->last_hit_x = -1;
+    ctx->last_hit_y = -1;
+    ctx->initial_hit_x = -1;
+    ctx->initial_hit_y = -1;
+    ctx->is_revisit = false;
+    ctx->first_revisit = true;
+    ctx->hit_segments_count = 0;
+    ctx->direction_fully_explored = false;
+    ctx->dx[0] = -1;
+    ctx->dx[1] = 0;
+    ctx->dx[2] = 1;
+    ctx->dx[3] = 0;
+    ctx->dy[0] = 0;
+    ctx->dy[1] = 1;
+    ctx->dy[2] = 0;
+    ctx->dy[3] = -1;
+    ctx->dir_indices[0] = 0;
+    ctx->dir_indices[1] = 1;
+    ctx->dir_indices[2] = 2;
+    ctx->dir_indices[3] = 3;
+    ctx->dir_indices_revisit[0] = 0;
+    ctx->dir_indices_revisit[1] = 0;
+    ctx->remaining_cells_count = BOARD_SIZE * BOARD_SIZE;
+}
 
-    // Reset the remaining ships
-    current_player->remaining_ships = 0;
+bool meets_min_gap(const AI_Context *ctx, const Player *opponent, int cell_x, int cell_y) {
+    // The minimum gap requirement means that the cell must have a minimum gap of 1 cell from any hit cell
+    bool meets_gap_requirement = true;
 
-    // Seed the random number generator
-    pcg32_srandom(time(NULL), (intptr_t) &main);
+    for (int i = 0; i < 4; i++) {
+        int x = cell_x + ctx->dx[i];
+        int y = cell_y + ctx->dy[i];
+
+        // Check if the cell is within the board and hasn't been hit before
+        if (x < 0 || x >= BOARD_SIZE || y < 0 || y >= BOARD_SIZE) continue;
+        if (!opponent->board.cells[x][y].hit) continue;
+        // Check if the cell meets the minimum gap requirement
+        if (opponent->board.cells[x][y].ship_index != -1) {
+            if (opponent->ships[opponent->board.cells[x][y].ship_index].size >= ctx->min_gap) continue;
+            meets_gap_requirement = false;
+        } else {
+            meets_gap_requirement = false;
+        }
+    }
+    return meets_gap_requirement;
+}
 
-    // Loop until all ships are placed
-    for (int i = 0; i < NUM_SHIPS; i++) {
+bool find_target_cell(AI_Context *ctx, AI_State *ai_state, const Player *opponent, int *cell_x, int *cell_y) {
+    // Try to find a valid cell to shoot in the current direction
+    while (ctx->attempts < 4) {
+        if (*ai_state == TARGET && !ctx->direction_fully_explored && !ctx->is_revisit) {
+            // Choose a random direction to shoot
+            ctx->direction = ctx->dir_indices[ctx->attempts];
+            *cell_x = ctx->initial_hit_x + ctx->dx[ctx->direction];
+            *cell_y = ctx->initial_hit_y + ctx->dy[ctx->direction];
+        } else { // *ai_state == DESTROY, direction_fully_explored or is_revisit
+
+            // Check if the direction has been fully explored to start revisiting
+            if (ctx->direction_fully_explored && *ai_state == TARGET && ctx->attempts > 0) {
+                *ai_state = REVISIT;
+                return false;
+            }
 
-        int x, y, orientation;
-        bool valid;
-        do {
-            // Generate random coordinates and orientation
-            x = (int) pcg32_boundedrand(BOARD_SIZE);
-            y = (int) pcg32_boundedrand(BOARD_SIZE);
-            orientation = (int) pcg32_boundedrand(2);
+            // Check if the AI has not explored the other direction yet
+            if (ctx->is_revisit && ctx->attempts == 1 && !ctx->direction_fully_explored) {
+                // try the other direction
+                ctx->direction = (ctx->direction + 2) % 4;
+                ctx->direction_fully_explored = true;
+            }
 
-            // Check if the position is valid
-            valid = is_position_valid(current_player, ships[i].size, x, y, orientation);
-        } while (!valid);
+            *cell_x = ctx->last_hit_x + ctx->dx[ctx->direction];
+            *cell_y = ctx->last_hit_y + ctx->dy[ctx->direction];
+        }
 
-        // Place the ship and mark it as placed
-        current_player->ships[i].size = ships[i].size;
-        place_ship(&current_player->board, &current_player->ships[i], x, y, orientation, i);
-        placed_ships[i] = true;
+        // Check if the cell is within the board and hasn't been hit before
+        if (*cell_x >= 0 && *cell_x < BOARD_SIZE && *cell_y >= 0 && *cell_y < BOARD_SIZE &&
+            !opponent->board.cells[*cell_x][*cell_y].hit) {
+            return true;
+        }
 
-        current_player->placed_ships[i] = true;
-        current_player->remaining_ships++;
-        current_player->ships[i].hit_count = 0;
-    }
-}
+        // Increment the attempt counter
+        ctx->attempts++;
 
-void
-render_ship_part(SDL_Renderer *renderer, GameTextures *textures, SDL_Rect ship_rect, int part_index, int ship_size) {
-    SDL_Texture *part_texture = NULL;
+        if (ctx->direction_fully_explored || *ai_state != DESTROY) continue;
+        // If the AI has found the orientation and can't explore further in the first direction,
+        // explore the other direction
+        ctx->direction = (ctx->direction + 2) % 4;
+        ctx->last_hit_x = ctx->initial_hit_x;
+        ctx->last_hit_y = ctx->initial_hit_y;
+        ctx->direction_fully_explored = true;
+    }
 
-    // Determine which part of the ship to render
-    if (part_index == 0) {
-        part_texture = textures->ship_left;
-    } else if (part_index == ship_size - 1) {
-        part_texture = textures->ship_right;
-    } else {
-        part_texture = textures->ship_middle;
+    // If no valid cell is found in TARGET state, try the next direction
+    if (*ai_state == TARGET) {
+        ctx->direction = (ctx->direction + 1) % 4;
+        ctx->attempts++;
+        if (ctx->attempts < 4) return false;
     }
 
-    // Render the ship part
-    SDL_RenderCopy(renderer, part_texture, NULL, &ship_rect);
+    // If all directions have been tried, or none is left in DESTROY state, switch back to SEARCH state
+    *ai_state = SEARCH;
+    ctx->attempts = 0;
+    ctx->direction = 0;
+    ctx->last_hit_x = -1;
+    ctx->last_hit_y = -1;
+    ctx->initial_hit_x = -1;
+    ctx->initial_hit_y = -1;
+    ctx->direction_fully_explored = false;
+    return false;
 }
 
-void render_selected_ship_border(SDL_Renderer *renderer, int ship_index, int ship_selected, Ship ships[]) {
-    // Check if the current ship is selected
-    if (ship_selected == ship_index) {
-        SDL_Rect selected_ship_rect = {50, 50 + ship_index * 50, ships[ship_index].size * CELL_SIZE, CELL_SIZE};
-        SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255); // Yellow
-        SDL_RenderDrawRect(renderer, &selected_ship_rect);
-    }
-}
+// Context of the built-in AI, also read by the shot heatmap to predict the next shot
+static AI_Context ai_ctx;
 
-void render_hover_ship_border(SDL_Renderer *renderer, int ship_index, const bool placed_ships[], Ship ships[]) {
-    int x, y;
-    SDL_GetMouseState(&x, &y);
-    SDL_Rect hover_ship_rect = {50, 50 + ship_index * 50, ships[ship_index].size * CELL_SIZE, CELL_SIZE};
+ComputerShot handle_computer_turn(Player *opponent, AI_State *ai_state, bool continuing) {
+    ComputerShot shot = {false, false, -1, -1};
 
-    // Check if the mouse is hovering over the ship, and it has not been placed yet
-    if (is_mouse_inside_button(x, y, hover_ship_rect) && !placed_ships[ship_index]) {
-        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255); // Green
-        SDL_RenderDrawRect(renderer, &hover_ship_rect);
+    // Call initializers if necessary
+    if (!ai_ctx.initialized) {
+        initialize_ai_context(&ai_ctx);
     }
-}
 
-void render_placed_ship_overlay(SDL_Renderer *renderer, int ship_index, int part_index, const bool placed_ships[],
-                                SDL_Texture *black_texture) {
-    // Check if the current ship has been placed
-    if (placed_ships[ship_index]) {
-        SDL_Rect placed_ship_rect = {50 + part_index * CELL_SIZE, 50 + ship_index * 50, CELL_SIZE, CELL_SIZE};
-        SDL_RenderCopy(renderer, black_texture, NULL, &placed_ship_rect);
+    // Declare variables for the current shot
+    int ship_index;
+    int cell_x, cell_y;
+    bool has_shot = false;
+    bool shot_successful = continuing;
+    bool valid_cell_found = false;
+
+    // Initialize remaining_cells array if it's the first computer's turn
+    if (ai_ctx.remaining_cells_count == BOARD_SIZE * BOARD_SIZE) {
+        int index = 0;
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            for (int y = 0; y < BOARD_SIZE; y++) {
+                ai_ctx.remaining_cells[index][0] = x;
+                ai_ctx.remaining_cells[index][1] = y;
+                index++;
+            }
+        }
     }
-}
 
-void render_placement_ships_left_side(SDL_Renderer *renderer, GameTextures *textures, Ship ships[],
-                                      const bool placed_ships[], SDL_Texture *black_texture, int ship_selected) {
-    // Loop through each ship
-    for (int i = 0; i < NUM_SHIPS; i++) {
-        int ship_size = ships[i].size;
+    do {
+        // A policy network chooses the cell in place of the SEARCH, TARGET and DESTROY states, which are left as
+        // they are, only the remaining cells and the destroyed ships are kept up to date
+        if (choose_computer_policy_shot(opponent, &cell_x, &cell_y) && !opponent->board.cells[cell_x][cell_y].hit) {
+            opponent->board.cells[cell_x][cell_y].hit = true;
+            mark_board_dirty(&opponent->board);
+            has_shot = true;
+            remove_cell(cell_x, cell_y, ai_ctx.remaining_cells, &ai_ctx.remaining_cells_count);
+            shot_successful = opponent->board.cells[cell_x][cell_y].occupied;
+            if (shot_successful) {
+                ship_index = opponent->board.cells[cell_x][cell_y].ship_index;
+                update_hit_count(opponent, ship_index);
+                if (opponent->ships[ship_index].hit_count == opponent->ships[ship_index].size) {
+                    ai_ctx.destroyed_ships[ship_index] = true;
+                }
+            }
+            break;
+        }
 
-        // Loop through each part of the ship
-        for (int j = 0; j < ship_size; j++) {
-            SDL_Rect ship_rect = {50 + j * CELL_SIZE, 50 + i * 50, CELL_SIZE, CELL_SIZE};
+        // Handle AI states (SEARCH, TARGET, DESTROY)
+        switch (*ai_state) {
+            SEARCH_CASE:
+            case SEARCH:
+                // Check if there are segments of a ship that haven't been destroyed yet
+                if (ai_ctx.hit_segments_count > 0) {
+                    *ai_state = REVISIT;
+                    goto REVISIT_CASE;
+                }
 
-            // Render the ship part
-            render_ship_part(renderer, textures, ship_rect, j, ship_size);
+                // Reset variables
+                ai_ctx.attempts = 0;
+                int search_attempts = 0;
+                ai_ctx.is_revisit = false;
 
-            // Render the selected ship border if the ship is currently selected
-            render_selected_ship_border(renderer, i, ship_selected, ships);
+                // Shuffle the direction indices
+                shuffle_directions(ai_ctx.dir_indices, 4);
 
-            // Render the hover ship border if the mouse is hovering over the ship and it is not placed
-            render_hover_ship_border(renderer, i, placed_ships, ships);
+                // Create a temporary array for remaining cells
+                int (*temp_remaining_cells)[2] = malloc(ai_ctx.remaining_cells_count * sizeof(int[2]));
+                memcpy(temp_remaining_cells, ai_ctx.remaining_cells, ai_ctx.remaining_cells_count * sizeof(int[2]));
+                int temp_remaining_cells_count = ai_ctx.remaining_cells_count;
 
-            // Render the placed ship overlay if the ship has been placed
-            render_placed_ship_overlay(renderer, i, j, placed_ships, black_texture);
-        }
-    }
-}
+                // Try to find a valid cell to shoot
+                while (!valid_cell_found && search_attempts < ai_ctx.remaining_cells_count) {
+                    // Choose a random cell to shoot from the temp_remaining_cells array
+                    int random_index = (int) pcg32_boundedrand(temp_remaining_cells_count);
+                    cell_x = temp_remaining_cells[random_index][0];
+                    cell_y = temp_remaining_cells[random_index][1];
 
-void set_button_color(SDL_Renderer *renderer, bool hover_state) {
-    // Change the color based on the hover state
-    if (hover_state) {
-        SDL_SetRenderDrawColor(renderer, 230, 230, 230, 255); // Lighter gray
-    } else {
-        SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255); // Original gray
-    }
-}
+                    // Remove the cell from the temp_remaining_cells array and decrease the temp_remaining_cells_count
+                    temp_remaining_cells[random_index][0] = temp_remaining_cells[temp_remaining_cells_count - 1][0];
+                    temp_remaining_cells[random_index][1] = temp_remaining_cells[temp_remaining_cells_count - 1][1];
+                    temp_remaining_cells_count--;
 
-void render_button_shadow(SDL_Renderer *renderer, SDL_Rect orientation_button) {
-    // Create a new rectangle for the shadow, offset from the button
-    SDL_Rect shadow_rect = orientation_button;
-    shadow_rect.x += 4;
-    shadow_rect.y += 4;
+                    // Check if the cell meets the minimum gap requirement
+                    if (meets_min_gap(&ai_ctx, opponent, cell_x, cell_y)) {
+                        valid_cell_found = true;
+                    }
+                    search_attempts++;
+                }
 
-    // Set the color for the shadow and render it
-    SDL_SetRenderDrawColor(renderer, 100, 100, 100, 128);
-    SDL_RenderFillRect(renderer, &shadow_rect);
-}
+                if (search_attempts == temp_remaining_cells_count && !valid_cell_found) {
+                    // If the AI can't find a valid cell to shoot, it will shoot randomly until it finds a valid cell
+                    do {
+                        // Choose a random cell from the remaining_cells array
+                        int random_index = (int) pcg32_boundedrand(ai_ctx.remaining_cells_count);
+                        cell_x = ai_ctx.remaining_cells[random_index][0];
+                        cell_y = ai_ctx.remaining_cells[random_index][1];
 
-void render_orientation_text(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect orientation_button, int orientation) {
-    // Render the appropriate text based on the orientation value
-    if (orientation == 0) {
-        render_text(renderer, "Orientation: Horizontal", font, orientation_button.x + 24, orientation_button.y + 10);
-    } else {
-        render_text(renderer, "Orientation: Vertical", font, orientation_button.x + 24, orientation_button.y + 10);
-    }
-}
+                        // Check if the cell hasn't been hit before
+                        if (opponent->board.cells[cell_x][cell_y].hit) continue;
+                        valid_cell_found = true;
+                    } while (!valid_cell_found);
+                    printf("AI can't find a valid cell to shoot, shooting randomly\n");
+                }
+                break;
 
-void render_placement_orientation_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect orientation_button,
-                                         int hover_orientation, int orientation) {
-    // Set button color based on mouse hover
-    set_button_color(renderer, hover_orientation);
+            TARGET_CASE:
+            case TARGET:
+            case DESTROY:
+                // Try the directions around the first hit, revisiting or searching again once they are exhausted
+                valid_cell_found = find_target_cell(&ai_ctx, ai_state, opponent, &cell_x, &cell_y);
+                if (*ai_state == REVISIT) {
+                    goto REVISIT_CASE;
+                }
+                if (!valid_cell_found) {
+                    continue; // Continue with the next iteration of the do-while loop
+                }
+                break;
 
-    // Render the button background
-    SDL_RenderFillRect(renderer, &orientation_button);
+            REVISIT_CASE:
+            case REVISIT:
+                if (ai_ctx.hit_segments_count > 0) {
+                    // Choose a random segment from the hit_segments array
+                    int random_index = (int) pcg32_boundedrand(ai_ctx.hit_segments_count);
+                    cell_x = ai_ctx.hit_segments[random_index][0];
+                    cell_y = ai_ctx.hit_segments[random_index][1];
 
-    // Render button shadow
-    render_button_shadow(renderer, orientation_button);
+                    // Remove the cell from the hit_segments array and decrease the hit_segments_count
+                    ai_ctx.hit_segments[random_index][0] = ai_ctx.hit_segments[ai_ctx.hit_segments_count - 1][0];
+                    ai_ctx.hit_segments[random_index][1] = ai_ctx.hit_segments[ai_ctx.hit_segments_count - 1][1];
+                    ai_ctx.hit_segments_count--;
 
-    // Render orientation text
-    render_orientation_text(renderer, font, orientation_button, orientation);
-}
+                    // Set the initially hit coordinates and last hit coordinates to the cell coordinates
+                    ai_ctx.initial_hit_x = ai_ctx.last_hit_x = cell_x;
+                    ai_ctx.initial_hit_y = ai_ctx.last_hit_y = cell_y;
 
-void render_placement_reset_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect reset_button, bool hover_reset) {
-    // Set button color based on mouse hover
-    set_button_color(renderer, hover_reset);
+                    // Choose a random direction based on the saved direction, but only for the first revisit
+                    if (ai_ctx.first_revisit) {
+                        if (ai_ctx.direction == 0 || ai_ctx.direction == 2) {
 
-    // Render the button background
-    SDL_RenderFillRect(renderer, &reset_button);
+                            // If the direction is 0 or 2, the other directions are 1 and 3
+                            ai_ctx.dir_indices_revisit[0] = 1;
+                            ai_ctx.dir_indices_revisit[1] = 3;
+                            shuffle_directions(ai_ctx.dir_indices_revisit, 2);
 
-    // Render button shadow
-    render_button_shadow(renderer, reset_button);
+                            // Choose a random direction from the other two
+                            ai_ctx.direction = ai_ctx.dir_indices_revisit[0];
+                        } else {
+                            // If the direction is 1 or 3, the other directions are 0 and 2
+                            ai_ctx.dir_indices_revisit[0] = 0;
+                            ai_ctx.dir_indices_revisit[1] = 2;
+                            shuffle_directions(ai_ctx.dir_indices_revisit, 2);
+                            ai_ctx.direction = ai_ctx.dir_indices[0];
+                        }
+                        ai_ctx.first_revisit = false;
+                    } else {
+                        shuffle_directions(ai_ctx.dir_indices_revisit, 2);
+                        ai_ctx.direction = ai_ctx.dir_indices_revisit[0];
+                    }
 
-    // Render reset text
-    render_text(renderer, "Restart the board", font, reset_button.x + 24, reset_button.y + 10);
-}
+                    // Update the AI state to TARGET
+                    ai_ctx.is_revisit = true;
+                    *ai_state = TARGET;
+                    ai_ctx.attempts = 0;
+                    ai_ctx.direction_fully_explored = false;
+                    goto TARGET_CASE;
+                } else {
+                    // If there are no hit segments left to revisit, switch back to SEARCH state
+                    ai_ctx.is_revisit = false;
+                    ai_ctx.first_revisit = true;
+                    *ai_state = SEARCH;
+                    goto SEARCH_CASE;
+                }
+        }
 
-void render_placement_random_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect random_button, bool hover_random) {
-    // Set button color based on mouse hover
-    set_button_color(renderer, hover_random);
+        // If the chosen cell hasn't been hit before
+        if (!opponent->board.cells[cell_x][cell_y].hit) {
+            // Mark the cell as hit
+            opponent->board.cells[cell_x][cell_y].hit = true;
+            mark_board_dirty(&opponent->board);
+            has_shot = true;
 
-    // Render the button background
-    SDL_RenderFillRect(renderer, &random_button);
+            // Remove the cell from the remaining_cells array
+            remove_cell(cell_x, cell_y, ai_ctx.remaining_cells, &ai_ctx.remaining_cells_count);
 
-    // Render button shadow
-    render_button_shadow(renderer, random_button);
+            // If the cell is occupied by a ship
+            if (opponent->board.cells[cell_x][cell_y].occupied) {
+                // Update hit count of the ship
+                ship_index = opponent->board.cells[cell_x][cell_y].ship_index;
+                update_hit_count(opponent, ship_index);
+                shot_successful = true;
 
-    // Render random text
-    render_text(renderer, "Randomize the board", font, random_button.x + 24, random_button.y + 10);
-}
+                // Update AI state based on the current state
+                if (*ai_state == SEARCH) {
+                    *ai_state = TARGET;
+                    ai_ctx.initial_hit_x = ai_ctx.last_hit_x = cell_x;
+                    ai_ctx.initial_hit_y = ai_ctx.last_hit_y = cell_y;
+                } else if (*ai_state == TARGET || *ai_state == DESTROY) {
+                    if (*ai_state == TARGET) {
+                        // Update the state to DESTROY
+                        *ai_state = DESTROY;
+                        ai_ctx.attempts = 0;
+                    }
+                    ai_ctx.last_hit_x = cell_x;
+                    ai_ctx.last_hit_y = cell_y;
+                }
 
-void render_placement_finish_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect finish_button, bool hover_finish,
-                                    const bool placed_ships[], SDL_Texture *black_texture) {
-    // Set button color based on mouse hover
-    set_button_color(renderer, hover_finish);
+                // If the ship is sunk, reset AI state to SEARCH, update destroyed_ships array and min gap
+                if (opponent->ships[ship_index].hit_count == opponent->ships[ship_index].size) {
+                    ai_ctx.destroyed_ships[ship_index] = true;
 
-    // Render the button background
-    SDL_RenderFillRect(renderer, &finish_button);
+                    // Update min_gap when a ship is destroyed
+                    int smallest_ship_remaining = BOARD_SIZE + 1;
+                    for (int i = 0; i < NUM_SHIPS; i++) {
+                        if (ai_ctx.destroyed_ships[i] || opponent->ships[i].size >= smallest_ship_remaining) continue;
+                        smallest_ship_remaining = opponent->ships[i].size;
+                    }
+                    ai_ctx.min_gap = smallest_ship_remaining - 1;
 
-    // Render button shadow
-    render_button_shadow(renderer, finish_button);
+                    if (!ai_ctx.is_revisit) {
+                        // reset hit segments array
+                        for (int i = 0; i < ai_ctx.hit_segments_count; i++) {
+                            ai_ctx.hit_segments[i][0] = -1;
+                            ai_ctx.hit_segments[i][1] = -1;
+                            ai_ctx.hit_segments_count = 0;
+                        }
+                        ai_ctx.direction = 0;
+                    }
 
-    // Check if all ships have been placed
-    if (all_ships_placed(placed_ships)) {
-        // Render finish text
-        render_text(renderer, "Finish placing ships", font, finish_button.x + 24, finish_button.y + 10);
-    } else {
-        // Render black texture
-        SDL_RenderCopy(renderer, black_texture, NULL, &finish_button);
+                    // Reset AI state
+                    *ai_state = SEARCH;
+                    ai_ctx.attempts = 0;
+                    ai_ctx.last_hit_x = -1;
+                    ai_ctx.last_hit_y = -1;
+                    ai_ctx.initial_hit_x = -1;
+                    ai_ctx.initial_hit_y = -1;
+                    valid_cell_found = false;
+                    ai_ctx.direction_fully_explored = false;
+                } else if (!ai_ctx.is_revisit && ai_ctx.hit_segments_count < MAX_HIT_SEGMENTS) {
+                    // Add ship segments to the hit_segments array, while it has room
+                    ai_ctx.hit_segments[ai_ctx.hit_segments_count][0] = cell_x;
+                    ai_ctx.hit_segments[ai_ctx.hit_segments_count][1] = cell_y;
+                    ai_ctx.hit_segments_count++;
+                }
+            } else {
+                // If the cell was not occupied by a ship, update AI state
+                shot_successful = false;
+                if (*ai_state == TARGET) {
+                    ai_ctx.attempts++;
+                } else if (*ai_state == DESTROY) {
+                    *ai_state = TARGET;
+                    ai_ctx.direction = (ai_ctx.direction + 2) % 4; // Reverse direction
+                    ai_ctx.last_hit_x = ai_ctx.initial_hit_x;
+                    ai_ctx.last_hit_y = ai_ctx.initial_hit_y;
+                    ai_ctx.direction_fully_explored = true;
+                }
+            }
+        } else {
+            // If the shot was unsuccessful, update AI states
+            if (*ai_state == TARGET) {
+                ai_ctx.direction = ai_ctx.dir_indices[ai_ctx.attempts];
+                ai_ctx.attempts++;
+                ai_ctx.direction_fully_explored = false;
+            } else if (*ai_state == DESTROY) {
+                if (ai_ctx.direction_fully_explored) {
+                    *ai_state = REVISIT;
+                } else {
+                    *ai_state = TARGET;
+                    ai_ctx.direction = (ai_ctx.direction + 2) % 4; // Reverse direction
+                    ai_ctx.last_hit_x = ai_ctx.initial_hit_x;
+                    ai_ctx.last_hit_y = ai_ctx.initial_hit_y;
+                }
+            }
+        }
+    } while (!has_shot && shot_successful && opponent->remaining_ships > 0);
 
-        // Render finish text with a different color
-        render_colored_text(renderer, "Finish placing ships", font, finish_button.x + 24, finish_button.y + 10, 255,
-                            255, 255);
+    if (!has_shot) {
+        printf("This should never happen\n");
+        return shot;
     }
+
+    // Report the shot, the game screen shows it before the next one
+    shot.has_shot = true;
+    shot.hit = shot_successful;
+    shot.x = cell_x;
+    shot.y = cell_y;
+    return shot;
 }
 
-void
-render_placement_buttons(SDL_Renderer *renderer, TTF_Font *font, ButtonData *button_data, const bool placed_ships[],
-                         int orientation, SDL_Texture *black_texture) {
-    // Render the orientation button
-    render_placement_orientation_button(renderer, font, button_data->orientation_button, button_data->hover_orientation,
-                                        orientation);
+void game_screen(SDL_Renderer *renderer, SDL_Window *window, GameTextures *textures, TTF_Font *font, Player *player1,
+                 Player *player2, int *current_turn, AI_State *ai_state) {
+    // Load background texture
+    SDL_Texture *background_texture = acquire_texture("Assets/game_screen_background.jpeg");
 
-    // Render reset button
-    render_placement_reset_button(renderer, font, button_data->reset_button, button_data->hover_reset);
+    // Create black surface
+    SDL_Surface *black_surface = SDL_CreateRGBSurface(0, CELL_SIZE, CELL_SIZE, 32, 0, 0, 0, 0);
+    SDL_SetSurfaceAlphaMod(black_surface, 50); // Set the alpha value to 128 (50% opacity)
+    SDL_FillRect(black_surface, NULL, SDL_MapRGB(black_surface->format, 0, 0, 0));
+    SDL_Texture *black_texture = SDL_CreateTextureFromSurface(renderer, black_surface);
+    SDL_SetTextureBlendMode(black_texture, SDL_BLENDMODE_BLEND);
 
-    // Render random button
-    render_placement_random_button(renderer, font, button_data->random_button, button_data->hover_random);
+    // Initialize the variables
+    bool running = true;
+    SDL_Event event;
 
-    // Render finish button
-    render_placement_finish_button(renderer, font, button_data->finish_button, button_data->hover_finish, placed_ships,
-                                   black_texture);
-}
+    // Initialize the buttons in the order of GameWidget, "Finish turn" is shown once the current player has missed
+    WidgetTree widgets;
+    init_widget_tree(&widgets);
+    add_widget(&widgets, WIDGET_LINK, (SDL_Rect) {630, 550, 50, 30}, (SDL_Point) {0, 0}, "Save");
+    add_widget(&widgets, WIDGET_LINK, (SDL_Rect) {710, 550, 50, 30}, (SDL_Point) {0, 0}, "Exit");
+    add_widget(&widgets, WIDGET_BUTTON, (SDL_Rect) {800 / 2 - 100, 600 - 70, 200, 40}, (SDL_Point) {24, 10},
+               "Finish turn");
+    set_widget_visible(&widgets, GAME_WIDGET_FINISH_TURN, false);
+
+    // A networked game cannot be saved, each process only knows its own fleet
+    bool net_game = is_net_game();
+    Player *local_player = player1->is_human ? player1 : player2;
+    Player *remote_player = player1->is_human ? player2 : player1;
+    bool opponent_left = false;
+    set_widget_visible(&widgets, GAME_WIDGET_SAVE, !net_game);
+
+    // Shade the boards shot by the built-in AI, the remote player of a networked game plays on its own
+    set_shot_heatmap_game(player1, player2, net_game ? NULL : ai_state, false);
+
+    // Timeline of the shot, turn and victory animations
+    Timeline timeline;
+    clear_timeline(&timeline);
+    SDL_Rect banner_rect = {0, 30, 800, 50};
+    SDL_Rect win_rect = {0, 490, 800, 45};
+    bool computer_continues = false;
+    bool computer_turn_over = false;
+    bool game_over = false;
 
-void render_grid_background(SDL_Renderer *renderer, GameTextures *textures, int ship_selected) {
-    // Choose the background texture based on whether a ship is selected
-    SDL_Texture *background_texture = ship_selected >= 0 ? textures->ocean_selection_mode : textures->ocean;
+    // Main game loop
+    bool redraw = true;
+    begin_screen_stats("game");
+    while (running) {
+        Uint64 now = SDL_GetPerformanceCounter();
 
-    // Render the grid background by looping through all cells
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            SDL_Rect grid_rect = {400 + i * CELL_SIZE, 50 + j * CELL_SIZE, CELL_SIZE, CELL_SIZE};
-            SDL_RenderCopy(renderer, background_texture, NULL, &grid_rect);
+        // End the game once the winner message has been shown
+        if (game_over && !is_timeline_holding(&timeline, now)) {
+            break;
         }
-    }
-}
-
-void render_ship_hover(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], int ship_selected, int orientation,
-                       int grid_mouse_x, int grid_mouse_y, bool valid_position) {
-    // Check if a ship is selected
-    if (ship_selected >= 0) {
-        int ship_size = ships[ship_selected].size;
 
-        // Set the color for the ship border based on valid_position
-        if (valid_position) {
-            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
-        } else {
-            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
+        // The computer ends its turn once its last shot has been shown
+        Player *turn_player = *current_turn == 1 ? player1 : player2;
+        if (computer_turn_over && !is_timeline_holding(&timeline, now)) {
+            turn_player->is_turn = false;
+            (*current_turn == 1 ? player2 : player1)->is_turn = true;
+            computer_turn_over = false;
         }
 
-        // Loop through each segment of the ship
-        for (int k = 0; k < ship_size; k++) {
-            int cell_x = grid_mouse_x + (orientation == 0 ? k : 0);
-            int cell_y = grid_mouse_y + (orientation == 1 ? k : 0);
-
-            // Make sure the cell is within the grid
-            if (cell_x >= 0 && cell_x < BOARD_SIZE && cell_y >= 0 && cell_y < BOARD_SIZE) {
-                SDL_Rect ship_rect = {400 + cell_x * CELL_SIZE, 50 + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
-
-                // Render the ship segment based on orientation and position
-                render_ship_segment(renderer, textures, ships[ship_selected], k, orientation, &ship_rect);
-
-                // Render the ship border
-                render_ship_border(renderer, ship_size, k, orientation, &ship_rect);
+        // Change the current turn once the current player has finished it
+        if (turn_player->is_turn == false) {
+            *current_turn = *current_turn == 1 ? 2 : 1;
+            update_window_title(window, *current_turn);
+            Player *next_player = *current_turn == 1 ? player1 : player2;
+
+            // The previous markers belong to the boards of the other player, the computer waits for the banner
+            clear_timeline(&timeline);
+            add_tween(&timeline, TWEEN_TURN_BANNER, banner_rect,
+                      next_player->is_human || net_game ? *current_turn : 0, TURN_BANNER_DURATION);
+            if (!next_player->is_human && !net_game) {
+                hold_timeline(&timeline, TURN_BANNER_DURATION);
             }
+            redraw = true;
         }
-    }
-}
 
-void render_ship_border(SDL_Renderer *renderer, int ship_size, int segment, int orientation, SDL_Rect *ship_rect) {
-    // Vertical orientation
-    if (orientation == 1) {
+        // Set the current player and opponent based on the current turn
+        Player *current_player = *current_turn == 1 ? player1 : player2;
+        Player *opponent = *current_turn == 1 ? player2 : player1;
 
-        // Draw top and bottom borders for the first and last segments
-        if (segment == 0) {
-            SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x + ship_rect->w,
-                               ship_rect->y); // Top border
-        } else if (segment == ship_size - 1) {
-            SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y + ship_rect->h - 1, ship_rect->x + ship_rect->w,
-                               ship_rect->y + ship_rect->h - 1); // Bottom border
+        // Let the computer work out its next shots on the human's board while the human is thinking, only against the
+        // computer since loaded games between two players keep an AI state too
+        if (current_player->is_human != opponent->is_human && !net_game && !game_over) {
+            ponder_computer_shot(current_player->is_human ? current_player : opponent);
         }
 
-        // Draw left and right borders for all segments
-        SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x,
-                           ship_rect->y + ship_rect->h); // Left border
-        SDL_RenderDrawLine(renderer, ship_rect->x + ship_rect->w - 1, ship_rect->y, ship_rect->x + ship_rect->w - 1,
-                           ship_rect->y + ship_rect->h); // Right border
-    } else { // Horizontal orientation
+        // Sleep until an event arrives or the timeline needs a frame
+        if (!redraw) {
+            Uint64 next_update = get_next_timeline_time(&timeline, now);
+            bool has_events = next_update != 0 ? wait_for_events_until(next_update)
+                                               : wait_for_events(IDLE_WAIT_TIMEOUT);
+            if (!has_events && next_update == 0) {
+                continue;
+            }
 
-        // Draw left and right borders for the first and last segments
-        if (segment == 0) {
-            SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x,
-                               ship_rect->y + ship_rect->h); // Left border
-        } else if (segment == ship_size - 1) {
-            SDL_RenderDrawLine(renderer, ship_rect->x + ship_rect->w - 1, ship_rect->y, ship_rect->x + ship_rect->w - 1,
-                               ship_rect->y + ship_rect->h); // Right border
+            // Handle game screen events
+            if (has_events) {
+                handle_game_screen_events(&event, &timeline, current_player, opponent, &running, &widgets, ai_state);
+                if (!running || current_player->is_turn == false) {
+                    continue;
+                }
+            }
+            now = SDL_GetPerformanceCounter();
         }
+        redraw = false;
 
-        // Draw top and bottom borders for all segments
-        SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y, ship_rect->x + ship_rect->w,
-                           ship_rect->y); // Top border
-        SDL_RenderDrawLine(renderer, ship_rect->x, ship_rect->y + ship_rect->h - 1, ship_rect->x + ship_rect->w,
-                           ship_rect->y + ship_rect->h - 1); // Bottom border
-    }
-}
+        // Apply the shots and results sent by the opponent, they may have arrived before the first frame
+        if (net_game && handle_net_messages(&timeline, local_player, remote_player)) {
+            opponent_left = true;
+        }
 
-void render_placed_ships(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], const bool placed_ships[],
-                         int board_x, int board_y) {
-    // Loop through all ships
-    for (int i = 0; i < NUM_SHIPS; i++) {
-        // Render the ship if it is placed
-        if (placed_ships[i]) {
-            // Loop through each segment of the ship
-            for (int j = 0; j < ships[i].size; j++) {
-                int cell_x = ships[i].x + (ships[i].orientation == 0 ? j : 0);
-                int cell_y = ships[i].y + (ships[i].orientation == 1 ? j : 0);
-                SDL_Rect ship_rect = {board_x + cell_x * CELL_SIZE, board_y + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
-                render_ship_segment(renderer, textures, ships[i], j, ships[i].orientation, &ship_rect);
+        // Let the computer fire its next shot once the previous one has been shown
+        if (!current_player->is_human && !net_game && !game_over && !computer_turn_over &&
+            !is_timeline_holding(&timeline, now)) {
+            ComputerShot shot = {false, false, -1, -1};
+            bool engine_pending = false;
+            if (is_engine_game()) {
+                shot = handle_engine_turn(opponent, &engine_pending);
+            }
+
+            // The turn stays pending while the engine thinks, the engine thread wakes the loop once it answers
+            if (!engine_pending) {
+                if (!shot.has_shot) {
+                    shot = handle_computer_turn(opponent, ai_state, computer_continues);
+                }
+                if (shot.has_shot) {
+                    add_shot_tweens(&timeline, opponent, shot.x, shot.y, 50, 100);
+                    hold_timeline(&timeline, COMPUTER_SHOT_DURATION);
+                }
+                computer_continues = shot.has_shot && shot.hit && opponent->remaining_ships > 0;
+                computer_turn_over = !computer_continues;
+                redraw = true;
             }
         }
-    }
-}
 
-void render_ship_segment(SDL_Renderer *renderer, GameTextures *textures, Ship ship, int segment, int orientation,
-                         SDL_Rect *ship_rect) {
-    // Vertical orientation
-    if (orientation == 1) {
+        // Show the winner message once the last ship is sunk, the game ends when it has been shown
+        if (!game_over && opponent->remaining_ships == 0) {
+            game_over = true;
+            computer_turn_over = false;
+            current_player->can_shoot = false;
+            current_player->has_shot = false;
+            add_tween(&timeline, TWEEN_WIN_MESSAGE, win_rect, *current_turn, WIN_MESSAGE_DURATION);
+            hold_timeline(&timeline, WIN_MESSAGE_DURATION);
+            end_computer_engine_game(*current_turn);
+        }
 
-        // Render the top, bottom, and middle segments based on the segment index
-        if (segment == 0) {
-            SDL_RenderCopy(renderer, textures->ship_top, NULL, ship_rect);
-        } else if (segment == ship.size - 1) {
-            SDL_RenderCopy(renderer, textures->ship_bottom, NULL, ship_rect);
-        } else {
-            SDL_RenderCopyEx(renderer, textures->ship_middle, NULL, ship_rect, 90, NULL, SDL_FLIP_NONE);
+        // The local player wins a networked game the opponent left
+        if (!game_over && opponent_left) {
+            game_over = true;
+            local_player->can_shoot = false;
+            local_player->has_shot = false;
+            add_tween(&timeline, TWEEN_WIN_MESSAGE, win_rect, local_player == player1 ? 1 : 2, WIN_MESSAGE_DURATION);
+            hold_timeline(&timeline, WIN_MESSAGE_DURATION);
         }
-    } else { // Horizontal orientation
 
-        // Render the left, right, and middle segments based on the segment index
-        if (segment == 0) {
-            SDL_RenderCopy(renderer, textures->ship_left, NULL, ship_rect);
-        } else if (segment == ship.size - 1) {
-            SDL_RenderCopy(renderer, textures->ship_right, NULL, ship_rect);
-        } else {
-            SDL_RenderCopy(renderer, textures->ship_middle, NULL, ship_rect);
+        // Show the opponent the fleet behind the commitment once the game is over
+        if (game_over && net_game) {
+            reveal_net_fleet();
         }
-    }
-}
+        update_timeline(&timeline, now);
+        begin_frame_stats();
 
-void
-render_placement_grid_ships(SDL_Renderer *renderer, GameTextures *textures, Ship ships[], const bool placed_ships[],
-                            int ship_selected, int orientation, int grid_mouse_x, int grid_mouse_y,
-                            bool valid_position) {
-    // Render grid background
-    render_grid_background(renderer, textures, ship_selected);
+        // Set the render draw color to white
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
 
-    // Render ship hover
-    render_ship_hover(renderer, textures, ships, ship_selected, orientation, grid_mouse_x, grid_mouse_y,
-                      valid_position);
+        // Clear the screen
+        SDL_RenderClear(renderer);
 
-    // Render placed ships
-    render_placed_ships(renderer, textures, ships, placed_ships, 400, 50);
-}
+        // Render the background texture
+        SDL_RenderCopy(renderer, background_texture, NULL, NULL);
 
-void render_invalid_position_border(SDL_Renderer *renderer) {
-    // Render red border around the grid
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
-    SDL_Rect border_rect = {400, 50, 320, 320};
-    SDL_RenderDrawRect(renderer, &border_rect);
-}
+        // Render game boards for both players, seen by the human player during the computer's turn
+        Player *view_player = current_player->is_human ? current_player : opponent;
+        Player *view_opponent = current_player->is_human ? opponent : current_player;
+        render_game_boards(renderer, textures, view_player, view_opponent, false);
 
-void remove_ship_from_board(GameBoard *board, Ship *ship, int x, int y, int orientation) {
-    // Loop through each segment of the ship
-    for (int i = 0; i < ship->size; i++) {
+        // Render remaining ships text for both players
+        render_remaining_ships_text(renderer, font, view_player, view_opponent);
 
-        // Get the cell coordinates
-        int cell_x = x + (orientation == 0 ? i : 0);
-        int cell_y = y + (orientation == 1 ? i : 0);
+        // Late-latch the mouse position for the hover effects
+        int mouse_x, mouse_y;
+        get_latest_mouse_state(&mouse_x, &mouse_y);
 
-        // Remove the ship from the cell if it is within the board
-        if (cell_x >= 0 && cell_x < BOARD_SIZE && cell_y >= 0 && cell_y < BOARD_SIZE) {
-            board->cells[cell_x][cell_y].occupied = false;
-        }
-    }
-}
+        // Calculate the cell coordinates based on the mouse position
+        int opponent_board_x = 2 * 50 + BOARD_SIZE * CELL_SIZE;
+        int opponent_board_y = 100;
 
-int find_ship_at_position(Player *player, int x, int y) {
-    // Loop through all ships
-    for (int i = 0; i < NUM_SHIPS; i++) {
-        Ship *ship = &player->ships[i];
+        // Check if the mouse is hovering over the opponent's board
+        if (mouse_x >= opponent_board_x && mouse_x < opponent_board_x + BOARD_SIZE * CELL_SIZE &&
+            mouse_y >= opponent_board_y && mouse_y < opponent_board_y + BOARD_SIZE * CELL_SIZE) {
 
-        // Check if the ship is at the given position
-        if (ship->x <= x && x < ship->x + (ship->orientation == 0 ? ship->size : 1) &&
-            ship->y <= y && y < ship->y + (ship->orientation == 1 ? ship->size : 1)) {
-            return i;
+            int cell_x = (mouse_x - opponent_board_x) / CELL_SIZE;
+            int cell_y = (mouse_y - opponent_board_y) / CELL_SIZE;
+
+            // Render the hover effect
+            if (current_player->is_human && current_player->can_shoot) {
+                render_game_hover_effect(renderer, black_texture, cell_x, cell_y, opponent_board_x, opponent_board_y);
+            }
         }
+
+        // Show the "Finish turn" button if the current player has shot and can't shoot anymore
+        set_widget_visible(&widgets, GAME_WIDGET_FINISH_TURN, !current_player->can_shoot && current_player->has_shot);
+
+        // Render the save, exit and "Finish turn" buttons, hovered at the latest mouse position
+        update_widget_hover(&widgets, mouse_x, mouse_y);
+        render_widgets(renderer, font, &widgets);
+
+        // Render the shot, turn and victory animations
+        render_timeline(renderer, font, &timeline, now);
+
+        // Update the screen
+        render_frame_stats_overlay(renderer, font);
+        SDL_RenderPresent(renderer);
+        end_frame_stats();
     }
-    return -1;
+    end_screen_stats();
+
+    // Free resources
+    SDL_FreeSurface(black_surface);
+    SDL_DestroyTexture(black_texture);
+    release_texture(background_texture);
+    destroy_board_layers();
+    destroy_widget_tree(&widgets);
+    set_shot_heatmap_game(NULL, NULL, NULL, false);
 }
 
-void reset_game_board(GameBoard *board) {
-    // Reset all cells to be unoccupied
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            board->cells[i][j].occupied = false;
+// Connection to the opponent in a networked game
+static NetSession net_session = {.listener = NET_INVALID_SOCKET, .socket = NET_INVALID_SOCKET,
+                                 .wake_event = (Uint32) -1};
+
+bool start_net_session(void) {
+    const GameOptions *options = get_game_options();
+    if (!net_startup()) {
+        printf("Sockets could not be initialized.\n");
+        return false;
+    }
+    net_session.active = true;
+    net_session.is_host = options->net_host;
+    net_session.is_spectator = options->net_spectate;
+
+    // Listen for the opponent, or start connecting to it
+    if (net_session.is_host) {
+        net_session.listener = net_listen((uint16_t) options->net_port);
+        if (net_session.listener == NET_INVALID_SOCKET) {
+            printf("Could not listen on port %d.\n", options->net_port);
+            return false;
+        }
+        printf("Waiting for the opponent on port %d.\n", options->net_port);
+    } else {
+        net_session.socket = net_connect(options->net_address, (uint16_t) options->net_port);
+        if (net_session.socket == NET_INVALID_SOCKET) {
+            printf("Could not connect to %s:%d.\n", options->net_address, options->net_port);
+            return false;
         }
     }
-}
 
-void reset_placement_phase(Ship *ships, bool *placed_ships, int *ship_selected, int *orientation, GameBoard *board) {
-    // Reset ship_selected and orientation
-    *ship_selected = -1;
-    *orientation = 0;
+    // Register the event that wakes the screens when a message arrives
+    net_session.wake_event = SDL_RegisterEvents(1);
+    net_session.mutex = SDL_CreateMutex();
+    if (net_session.wake_event == (Uint32) -1 || net_session.mutex == NULL) {
+        printf("Network thread could not be started! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
 
-    // Reset ships and placed_ships arrays
-    for (int i = 0; i < NUM_SHIPS; i++) {
-        placed_ships[i] = false;
-        ships[i].hit_count = 0;
-        ships[i].x = 0;
-        ships[i].y = 0;
+    SDL_AtomicSet(&net_session.quit, 0);
+    net_session.thread = SDL_CreateThread(net_session_thread, "net_session", &net_session);
+    if (net_session.thread == NULL) {
+        printf("Network thread could not be started! SDL Error: %s\n", SDL_GetError());
+        return false;
     }
 
-    // Reset the game board
-    reset_game_board(board);
+    return true;
 }
 
-void handle_placement_mouse_button_down(SDL_Event *event, bool *running, Player *current_player, int *ship_selected,
-                                        bool *placed_ships, int *orientation, ButtonData *button_data,
-                                        bool *invalid_click, int grid_mouse_x, int grid_mouse_y,
-                                        const bool *valid_position, Ship *ships) {
-    int x = event->button.x;
-    int y = event->button.y;
-
-    // Check if the user clicked on the exit button
-    if (is_mouse_inside_button(x, y, button_data->exit_button)) {
-        *running = false;
+int net_session_thread(void *data) {
+    NetSession *session = (NetSession *) data;
+    SDL_Event wake;
+    SDL_zero(wake);
+    wake.type = session->wake_event;
+
+    // Wait for the connection, checking regularly whether the game is closing
+    bool connected = false;
+    while (!connected && !SDL_AtomicGet(&session->quit)) {
+        if (session->is_host) {
+            if (net_wait(session->listener, false, NET_WAIT_INTERVAL) > 0) {
+                session->socket = net_accept(session->listener);
+                connected = session->socket != NET_INVALID_SOCKET;
+            }
+        } else {
+            int ready = net_wait(session->socket, true, NET_WAIT_INTERVAL);
+            if (ready < 0 || (ready > 0 && !net_finish_connect(session->socket))) {
+                break;
+            }
+            connected = ready > 0;
+        }
     }
 
-    // Check if the user clicked on the orientation button
-    if (is_mouse_inside_button(x, y, button_data->orientation_button)) {
-        *orientation = (*orientation + 1) % 2;
-    } else {
-        for (int i = 0; i < NUM_SHIPS; i++) {
-            if (placed_ships[i]) {
+    SDL_LockMutex(session->mutex);
+    session->connected = connected;
+    session->disconnected = !connected;
+    SDL_UnlockMutex(session->mutex);
+    SDL_PushEvent(&wake);
+
+    // Receive the messages into the inbox until the connection is closed
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE * NET_INBOX_CAPACITY];
+    size_t size = 0;
+    bool open = connected;
+    bool inbox_full = false;
+    while (open && !SDL_AtomicGet(&session->quit)) {
+        // While the inbox is full, the next messages wait in the buffer and the socket until the screen takes some
+        int received = 0;
+        if (inbox_full) {
+            SDL_Delay(NET_FULL_INBOX_DELAY);
+        } else {
+            int ready = net_wait(session->socket, false, NET_WAIT_INTERVAL);
+            if (ready == 0) {
                 continue;
             }
+            received = ready > 0 ? net_receive(session->socket, buffer + size, sizeof(buffer) - size) : -1;
+            if (received < 0) {
+                break;
+            }
+            size += received;
+        }
 
-            int ship_size = ships[i].size;
-
-            // Loop through each segment of the ship
-            for (int j = 0; j < ship_size; j++) {
-                SDL_Rect ship_rect = {50 + j * CELL_SIZE, 50 + i * 50, CELL_SIZE, CELL_SIZE};
-                if (is_mouse_inside_button(x, y, ship_rect)) {
-                    *ship_selected = i;
-                    break;
-                }
+        // Decode the whole messages, a partial message stays at the start of the buffer
+        size_t offset = 0;
+        int num_messages = 0;
+        inbox_full = false;
+        SDL_LockMutex(session->mutex);
+        session->bytes_received += received;
+        for (;;) {
+            if (session->num_inbox == NET_INBOX_CAPACITY) {
+                inbox_full = true;
+                break;
+            }
+            NetMessage message;
+            int message_size = decode_net_message(buffer + offset, size - offset, &message);
+            if (message_size == 0) {
+                break;
+            }
+            if (message_size < 0) {
+                printf("Invalid message from the opponent.\n");
+                open = false;
+                break;
             }
+            session->inbox[(session->inbox_start + session->num_inbox) % NET_INBOX_CAPACITY] = message;
+            session->num_inbox++;
+            num_messages++;
+            offset += message_size;
+        }
+        SDL_UnlockMutex(session->mutex);
+        memmove(buffer, buffer + offset, size - offset);
+        size -= offset;
+
+        if (num_messages > 0) {
+            SDL_PushEvent(&wake);
         }
     }
 
-    // Check if the user clicked on the reset button
-    if (is_mouse_inside_button(x, y, button_data->reset_button)) {
-        reset_placement_phase(ships, placed_ships, ship_selected, orientation, &current_player->board);
+    // Report a lost connection, the sockets are closed by stop_net_session
+    if (connected) {
+        SDL_LockMutex(session->mutex);
+        session->disconnected = true;
+        SDL_UnlockMutex(session->mutex);
+        SDL_PushEvent(&wake);
     }
 
-    // Check if the user clicked on the "Random Board" button
-    if (is_mouse_inside_button(x, y, button_data->random_button)) {
-        place_random_ships(current_player, ships, placed_ships, ship_selected, orientation);
+    return 0;
+}
+
+void stop_net_session(void) {
+    if (!net_session.active) {
+        return;
     }
 
-    // Check if the user clicked on the "Finish placement phase" button
-    if (is_mouse_inside_button(x, y, button_data->finish_button) && all_ships_placed(placed_ships)) {
-        *running = 0;
+    // Stop the thread before closing the sockets it uses
+    if (net_session.thread != NULL) {
+        SDL_AtomicSet(&net_session.quit, 1);
+        SDL_WaitThread(net_session.thread, NULL);
+        net_session.thread = NULL;
+    }
+    net_close(net_session.socket);
+    net_close(net_session.listener);
+    net_session.socket = NET_INVALID_SOCKET;
+    net_session.listener = NET_INVALID_SOCKET;
+    if (net_session.mutex != NULL) {
+        SDL_DestroyMutex(net_session.mutex);
+        net_session.mutex = NULL;
     }
+    net_shutdown();
+    net_session.active = false;
+
+    // Print the traffic of the game and the time from each shot to its result
+    float p50, p95, p99;
+    get_percentiles(net_session.shot_round_trips, net_session.num_shot_round_trips, &p50, &p95, &p99);
+    printf("Network: %llu bytes sent, %llu bytes received, %d shots, round trip p50 %.2f ms, p99 %.2f ms\n",
+           (unsigned long long) net_session.bytes_sent, (unsigned long long) net_session.bytes_received,
+           net_session.num_shot_round_trips, p50, p99);
+}
 
-    // Check if the user clicked on any button
-    bool clicked_on_button = is_mouse_inside_button(x, y, button_data->exit_button) ||
-                             is_mouse_inside_button(x, y, button_data->orientation_button) ||
-                             is_mouse_inside_button(x, y, button_data->reset_button) ||
-                             is_mouse_inside_button(x, y, button_data->random_button);
+bool is_net_game(void) {
+    return net_session.active;
+}
 
-    bool clicked_on_available_ship = false;
+bool is_net_connected(void) {
+    SDL_LockMutex(net_session.mutex);
+    bool connected = net_session.connected && !net_session.disconnected;
+    SDL_UnlockMutex(net_session.mutex);
+    return connected;
+}
 
-    // Loop through each ship
-    for (int i = 0; i < NUM_SHIPS; i++) {
+bool is_net_disconnected(void) {
+    SDL_LockMutex(net_session.mutex);
+    bool disconnected = net_session.disconnected;
+    SDL_UnlockMutex(net_session.mutex);
+    return disconnected;
+}
 
-        // Loop through each part of the ship
-        for (int j = 0; j < ships[i].size; j++) {
-            SDL_GetMouseState(&x, &y);
-            SDL_Rect hover_ship_rect = {50, 50 + i * 50, ships[i].size * CELL_SIZE, CELL_SIZE};
-            if (is_mouse_inside_button(x, y, hover_ship_rect)) {
-                clicked_on_available_ship = true;
-                break;
-            }
-        }
+bool poll_net_message(NetMessage *message) {
+    SDL_LockMutex(net_session.mutex);
+    bool has_message = net_session.num_inbox > 0;
+    if (has_message) {
+        *message = net_session.inbox[net_session.inbox_start];
+        net_session.inbox_start = (net_session.inbox_start + 1) % NET_INBOX_CAPACITY;
+        net_session.num_inbox--;
     }
+    SDL_UnlockMutex(net_session.mutex);
+    return has_message;
+}
 
-    // Update invalid_click only if the user clicked on an invalid position in placement mode (i.e., not on a button or a ship)
-    if (clicked_on_button || clicked_on_available_ship) {
-        *invalid_click = false;
-    } else if (*ship_selected >= 0) {
-        *invalid_click = !(*valid_position);
+bool send_net_message(const NetMessage *message) {
+    if (!is_net_connected()) {
+        return false;
     }
 
-    // Check if the user clicked on the grid
-    if (grid_mouse_x >= 0 && grid_mouse_x < BOARD_SIZE && grid_mouse_y >= 0 && grid_mouse_y < BOARD_SIZE) {
+    // Send the whole message, waiting while the socket buffer is full
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = encode_net_message(message, buffer);
+    size_t sent = 0;
+    while (sent < size) {
+        int result = net_send(net_session.socket, buffer + sent, size - sent);
+        if (result < 0 || (result == 0 && net_wait(net_session.socket, true, NET_SEND_TIMEOUT) <= 0)) {
+            printf("Error sending a message to the opponent.\n");
+            return false;
+        }
+        sent += result;
+    }
 
-        // Check if the user clicked on a placed ship
-        if (*ship_selected == -1) {
-            int clicked_ship_index = find_ship_at_position(current_player, grid_mouse_x, grid_mouse_y);
+    net_session.bytes_sent += size;
+    return true;
+}
 
-            // Check if the user clicked on a placed ship
-            if (clicked_ship_index >= 0 && placed_ships[clicked_ship_index]) {
-                Ship *clicked_ship = &ships[clicked_ship_index];
-                remove_ship_from_board(&current_player->board, clicked_ship, clicked_ship->x, clicked_ship->y,
-                                       clicked_ship->orientation);
-                current_player->remaining_ships--;
-                placed_ships[clicked_ship_index] = false;
-                *ship_selected = clicked_ship_index;
-            }
-        }
+NetShip get_net_ship(const Player *player, int ship_index) {
+    const Ship *ship = &player->ships[ship_index];
+    NetShip net_ship = {(uint8_t) ship_index, (uint8_t) ship->orientation, (uint8_t) ship->x, (uint8_t) ship->y};
+    return net_ship;
+}
 
-        // Check if the user clicked on a valid position and if a ship is selected
-        if (*ship_selected >= 0 && !placed_ships[*ship_selected] && *valid_position) {
-            current_player->ships[*ship_selected].size = ships[*ship_selected].size;
-            place_ship(&current_player->board, &current_player->ships[*ship_selected], grid_mouse_x, grid_mouse_y,
-                       *orientation, *ship_selected);
-            placed_ships[*ship_selected] = true; // Set the ship as placed
+bool commit_net_fleet(const Player *player) {
+    // Draw a new salt, so the commitment does not tell which of the possible fleets was placed
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, SDL_GetPerformanceCounter(), (intptr_t) &net_session);
+    for (int i = 0; i < NET_SALT_SIZE; i++) {
+        net_session.salt[i] = (uint8_t) pcg32_random_r(&rng);
+    }
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        net_session.fleet[i] = get_net_ship(player, i);
+    }
 
-            // Update player's placed ships
-            current_player->placed_ships[*ship_selected] = placed_ships[*ship_selected];
+    NetMessage message = {.type = NET_MSG_FLEET};
+    compute_fleet_commitment(net_session.salt, net_session.fleet, message.commitment);
+    net_session.fleet_sent = send_net_message(&message);
+    return net_session.fleet_sent;
+}
 
-            // Update player's ships
-            current_player->remaining_ships++;
-            current_player->ships[*ship_selected].hit_count = 0;
+void reveal_net_fleet(void) {
+    if (net_session.fleet_revealed || !net_session.fleet_sent) {
+        return;
+    }
 
-            *ship_selected = -1;
+    NetMessage message = {.type = NET_MSG_REVEAL};
+    memcpy(message.salt, net_session.salt, NET_SALT_SIZE);
+    memcpy(message.fleet, net_session.fleet, sizeof(net_session.fleet));
+    send_net_message(&message);
+    net_session.fleet_revealed = true;
+}
+
+bool verify_net_fleet(const Player *remote, const NetMessage *reveal) {
+    // Check the fleet against the commitment sent before the first shot
+    uint8_t commitment[NET_COMMITMENT_SIZE];
+    compute_fleet_commitment(reveal->salt, reveal->fleet, commitment);
+    if (memcmp(commitment, net_session.opponent_commitment, NET_COMMITMENT_SIZE) != 0) {
+        return false;
+    }
+
+    // Place the fleet on an empty board, which checks that the ships fit and do not overlap
+    Player fleet;
+    initialize_game_board(&fleet.board);
+    initialize_ships(&fleet);
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        const NetShip *ship = &reveal->fleet[i];
+        if (ship->index != i || !is_position_valid(&fleet, fleet.ships[i].size, ship->x, ship->y, ship->orientation)) {
+            return false;
+        }
+        place_ship(&fleet.board, &fleet.ships[i], ship->x, ship->y, ship->orientation, i);
+    }
+
+    // Every result the opponent sent must match the fleet
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            const Cell *cell = &remote->board.cells[x][y];
+            if (cell->hit && cell->occupied != fleet.board.cells[x][y].occupied) {
+                return false;
+            }
         }
     }
+    return true;
+}
+
+void send_net_shot(Player *local, int cell_x, int cell_y) {
+    // Only one shot is in flight, the next shot depends on its result
+    if (net_session.shot_pending) {
+        return;
+    }
+
+    NetMessage message = {.type = NET_MSG_SHOT, .x = (uint8_t) cell_x, .y = (uint8_t) cell_y};
+    if (send_net_message(&message)) {
+        net_session.shot_pending = true;
+        net_session.shot_x = cell_x;
+        net_session.shot_y = cell_y;
+        net_session.shot_time = SDL_GetPerformanceCounter();
+        local->has_shot = true;
+    }
 }
 
-void handle_placement_mouse_motion(SDL_Event *event, ButtonData *button_data, bool *placed_ships) {
-    int x = event->motion.x;
-    int y = event->motion.y;
+void handle_net_shot(Timeline *timeline, Player *local, Player *remote, const NetMessage *shot) {
+    // Ignore shots out of turn and repeated shots
+    Cell *cell = &local->board.cells[shot->x][shot->y];
+    if (!remote->is_turn || cell->hit) {
+        printf("Ignoring an invalid shot from the opponent at %d, %d.\n", shot->x, shot->y);
+        return;
+    }
 
-    // Check if the user is hovering over the orientation button
-    if (is_mouse_inside_button(x, y, button_data->orientation_button)) {
-        button_data->hover_orientation = 1;
-    } else {
-        button_data->hover_orientation = 0;
+    // Resolve the shot on the local board
+    cell->hit = true;
+    mark_board_dirty(&local->board);
+    NetMessage result = {.type = NET_MSG_RESULT, .x = shot->x, .y = shot->y, .result = NET_RESULT_MISS};
+    if (cell->occupied) {
+        bool sunk = update_hit_count(local, cell->ship_index);
+        result.result = sunk ? NET_RESULT_SUNK : NET_RESULT_HIT;
+        result.ship = get_net_ship(local, cell->ship_index);
     }
+    send_net_message(&result);
+    add_shot_tweens(timeline, local, shot->x, shot->y, 50, 100);
+
+    // A miss ends the turn of the opponent
+    if (!cell->occupied) {
+        remote->is_turn = false;
+        local->is_turn = true;
+        local->can_shoot = true;
+        local->has_shot = false;
+    }
+}
 
-    // Check if the user is hovering over the reset button
-    if (is_mouse_inside_button(x, y, button_data->reset_button)) {
-        button_data->hover_reset = 1;
-    } else {
-        button_data->hover_reset = 0;
+void handle_net_result(Timeline *timeline, Player *local, Player *remote, const NetMessage *result) {
+    // Only the shot in flight can have a result, at the cell it was fired at
+    if (!net_session.shot_pending) {
+        printf("Ignoring an unexpected result from the opponent.\n");
+        return;
     }
+    if (result->x != net_session.shot_x || result->y != net_session.shot_y) {
+        printf("Ignoring a result from the opponent at %d, %d for the shot at %d, %d.\n", result->x, result->y,
+               net_session.shot_x, net_session.shot_y);
+        return;
+    }
+    net_session.shot_pending = false;
+    if (net_session.num_shot_round_trips < BOARD_SIZE * BOARD_SIZE) {
+        net_session.shot_round_trips[net_session.num_shot_round_trips++] =
+                (float) ((double) (SDL_GetPerformanceCounter() - net_session.shot_time) * 1000.0 /
+                         (double) SDL_GetPerformanceFrequency());
+    }
+
+    // Fill in the opponent's board
+    const Ship *sunk_ship = apply_net_shot_result(remote, result);
+    bool hit = result->result != NET_RESULT_MISS;
+    add_shot_result_tweens(timeline, result->x, result->y, hit, sunk_ship, 2 * 50 + BOARD_SIZE * CELL_SIZE, 100);
 
-    // Check if the user is hovering over the "Random Board" button
-    if (is_mouse_inside_button(x, y, button_data->random_button)) {
-        button_data->hover_random = 1;
+    // A hit lets the local player shoot again, a miss passes the turn to the opponent
+    if (hit) {
+        local->can_shoot = true;
     } else {
-        button_data->hover_random = 0;
+        local->is_turn = false;
+        remote->is_turn = true;
+        local->can_shoot = true;
     }
+}
 
-    // Check if the user is hovering over the "Finish placement phase" button
-    if (is_mouse_inside_button(x, y, button_data->finish_button) && all_ships_placed(placed_ships)) {
-        button_data->hover_finish = 1;
-    } else {
-        button_data->hover_finish = 0;
+const Ship *apply_net_shot_result(Player *target, const NetMessage *result) {
+    // Mark the cell, the whole ship is known once it is sunk
+    Cell *cell = &target->board.cells[result->x][result->y];
+    cell->hit = true;
+    cell->occupied = result->result != NET_RESULT_MISS;
+    const Ship *sunk_ship = NULL;
+    if (result->result == NET_RESULT_SUNK) {
+        const NetShip *ship = &result->ship;
+        Ship *target_ship = &target->ships[ship->index];
+        int end_x = ship->x + (ship->orientation == 0 ? target_ship->size : 1);
+        int end_y = ship->y + (ship->orientation == 1 ? target_ship->size : 1);
+        bool covers_shot = result->x >= ship->x && result->x < end_x && result->y >= ship->y && result->y < end_y;
+        if (covers_shot && end_x <= BOARD_SIZE && end_y <= BOARD_SIZE && target_ship->hit_count < target_ship->size) {
+            place_ship(&target->board, target_ship, ship->x, ship->y, ship->orientation, ship->index);
+            target_ship->hit_count = target_ship->size;
+            target->remaining_ships--;
+            sunk_ship = target_ship;
+        }
     }
+    mark_board_dirty(&target->board);
+    return sunk_ship;
 }
 
-void handle_placement_phase_event(SDL_Event *event, bool *running, int *ship_selected, bool *placed_ships, Ship *ships,
-                                  Player *current_player, int grid_mouse_x, int grid_mouse_y,
-                                  const bool *valid_position, int *orientation, bool *invalid_click,
-                                  ButtonData *button_data) {
-    while (SDL_PollEvent(event)) {
-        switch (event->type) {
-            // Handle SDL_QUIT evenT
-            case SDL_QUIT:
-                *running = false;
+bool handle_net_messages(Timeline *timeline, Player *local, Player *remote) {
+    NetMessage message;
+    while (poll_net_message(&message)) {
+        switch (message.type) {
+            case NET_MSG_SHOT:
+                handle_net_shot(timeline, local, remote, &message);
                 break;
 
-                // Handle mouse button press event
-            case SDL_MOUSEBUTTONDOWN:
-                if (event->button.button == SDL_BUTTON_LEFT) {
-                    handle_placement_mouse_button_down(event, running, current_player, ship_selected, placed_ships,
-                                                       orientation, button_data, invalid_click, grid_mouse_x,
-                                                       grid_mouse_y, valid_position, ships);
-                }
+            case NET_MSG_RESULT:
+                handle_net_result(timeline, local, remote, &message);
                 break;
 
-                // Handle mouse motion event
-            case SDL_MOUSEMOTION:
-                handle_placement_mouse_motion(event, button_data, placed_ships);
+            case NET_MSG_RESIGN:
+                printf("The opponent left the game.\n");
+                net_session.opponent_left = true;
                 break;
 
-                // Handle mouse button up event
-            case SDL_MOUSEBUTTONUP:
-                if (event->button.button == SDL_BUTTON_LEFT) {
-                    *invalid_click = false;
+            case NET_MSG_REVEAL:
+                if (verify_net_fleet(remote, &message)) {
+                    printf("The opponent's fleet matches its commitment.\n");
+                } else {
+                    printf("The opponent's fleet does not match its commitment or its results!\n");
                 }
                 break;
-        }
-    }
-}
-
-void placement_phase_screen(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *current_player) {
-    // Load background texture
-    SDL_Texture *background_texture = IMG_LoadTexture(renderer, "Assets/selecting_screen_background.jpg");
-
-    // Create black surface
-    SDL_Surface *black_surface = SDL_CreateRGBSurface(0, CELL_SIZE, CELL_SIZE, 32, 0, 0, 0, 0);
-    SDL_SetSurfaceAlphaMod(black_surface, 128); // Set the alpha value to 128 (50% opacity)
-    SDL_FillRect(black_surface, NULL, SDL_MapRGB(black_surface->format, 0, 0, 0));
-    SDL_Texture *black_texture = SDL_CreateTextureFromSurface(renderer, black_surface);
-    SDL_SetTextureBlendMode(black_texture, SDL_BLENDMODE_BLEND);
 
-    // Initialize variables
-    int ship_selected = -1;
-    int orientation = 0; // 0 for horizontal, 1 for vertical
-    int hover_orientation = 0;
-    int hover_reset = 0;
-    int hover_random = 0;
-    int hover_finish = 0;
-    bool invalid_click = false;
-    bool placed_ships[NUM_SHIPS] = {false};
-    current_player->remaining_ships = 0;
+            case NET_MSG_FLEET:
+                printf("Ignoring a repeated fleet from the opponent.\n");
+                break;
 
-    initialize_game_board(&current_player->board);
+            default:
+                printf("Ignoring a match server message from the opponent.\n");
+                break;
+        }
+    }
 
-    // Initialize buttons
-    SDL_Rect orientation_button = {50, 300, 275, 50}; // x, y, width, height
-    SDL_Rect exit_button = {0, 0, 100, 50};
-    SDL_Rect reset_button = {50, 400, 275, 50};
-    SDL_Rect random_button = {50, 500, 275, 50};
-    SDL_Rect finish_button = {425, 400, 275, 50};
-
-    // Initialize the button data struct
-    ButtonData button_data = {
-            exit_button,
-            orientation_button,
-            reset_button,
-            random_button,
-            finish_button,
-            hover_orientation,
-            hover_reset,
-            hover_random,
-            hover_finish
-    };
+    // A lost connection counts as the opponent leaving
+    if (!net_session.opponent_left && is_net_disconnected()) {
+        printf("The connection to the opponent was lost.\n");
+        net_session.opponent_left = true;
+    }
+    return net_session.opponent_left;
+}
 
-    // Initialize ships
-    initialize_ships(current_player);
+bool wait_for_opponent_screen(SDL_Renderer *renderer, TTF_Font *font, const Player *local) {
+    SDL_Texture *background_texture = acquire_texture("Assets/game_screen_background.jpeg");
 
-    // Main loop for the placement_phase_screen
-    bool running = 1;
+    bool success = false;
+    bool running = true;
+    bool redraw = true;
+    begin_screen_stats("waiting");
     while (running) {
-        SDL_Event event;
+        // Sleep until an event arrives, the network thread wakes the screen when the state of the connection changes
+        if (!redraw && !wait_for_events(IDLE_WAIT_TIMEOUT)) {
+            continue;
+        }
+        redraw = false;
 
-        // Get the current mouse position on the grid
-        int mouse_x, mouse_y;
-        SDL_GetMouseState(&mouse_x, &mouse_y);
-        int grid_mouse_x = (mouse_x - 400) / CELL_SIZE;
-        int grid_mouse_y = (mouse_y - 50) / CELL_SIZE;
-        bool valid_position = is_position_valid(current_player, current_player->ships[ship_selected].size, grid_mouse_x,
-                                                grid_mouse_y, orientation);
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                running = false;
+            } else if (event.type == SDL_RENDER_TARGETS_RESET) {
+                mark_all_board_layers_dirty();
+            }
+        }
 
-        // Handle events
-        handle_placement_phase_event(&event, &running, &ship_selected, placed_ships, current_player->ships,
-                                     current_player, grid_mouse_x, grid_mouse_y, &valid_position, &orientation,
-                                     &invalid_click, &button_data);
+        // Send the fleet once connected and wait for the fleet of the opponent
+        if (is_net_disconnected()) {
+            printf("The connection to the opponent failed or was lost.\n");
+            running = false;
+        } else if (is_net_connected() && !net_session.fleet_sent && !commit_net_fleet(local)) {
+            running = false;
+        }
+        NetMessage message;
+        while (running && !net_session.has_opponent_fleet && poll_net_message(&message)) {
+            if (message.type == NET_MSG_FLEET) {
+                memcpy(net_session.opponent_commitment, message.commitment, NET_COMMITMENT_SIZE);
+                net_session.has_opponent_fleet = true;
+            } else if (message.type == NET_MSG_RESIGN) {
+                printf("The opponent left the game.\n");
+                running = false;
+            }
+        }
+        if (net_session.has_opponent_fleet && net_session.fleet_sent) {
+            success = true;
+            break;
+        }
+        begin_frame_stats();
 
-        // Clear screen
+        // Render the state of the connection
+        const char *text = !is_net_connected() ? (net_session.is_host ? "Waiting for the opponent to connect..."
+                                                                      : "Connecting...")
+                                               : "Waiting for the opponent to place ships...";
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
         SDL_RenderClear(renderer);
-
-        // Render screen background
         SDL_RenderCopy(renderer, background_texture, NULL, NULL);
+        render_colored_text(renderer, text, font, 200, 280, 255, 255, 255);
+        render_frame_stats_overlay(renderer, font);
+        SDL_RenderPresent(renderer);
+        end_frame_stats();
+    }
+    end_screen_stats();
 
-        // Render the ships on the left side of the screen
-        render_placement_ships_left_side(renderer, textures, current_player->ships, placed_ships, black_texture,
-                                         ship_selected);
-
-        // Render the grid and the ships on the grid (if any).
-        render_placement_grid_ships(renderer, textures, current_player->ships, placed_ships, ship_selected, orientation,
-                                    grid_mouse_x, grid_mouse_y, valid_position);
-
-        // Render exit option
-        render_text(renderer, "Exit", font, exit_button.x + 25, exit_button.y + 10);
+    release_texture(background_texture);
+    return success;
+}
 
-        // Render the buttons
-        render_placement_buttons(renderer, font, &button_data, placed_ships, orientation, black_texture);
+int play_net_game(SDL_Renderer *renderer, SDL_Window *window, GameTextures *textures, TTF_Font *font,
+                  Player *player1, Player *player2) {
+    // The host is player 1, only the local player is controlled by this process
+    Player *local = net_session.is_host ? player1 : player2;
+    Player *remote = net_session.is_host ? player2 : player1;
+    local->is_human = true;
+    remote->is_human = false;
+
+    // Place the local fleet
+    const char *window_title = net_session.is_host ? "Battleship - Player 1" : "Battleship - Player 2";
+    enter_scene(window_title, 800, 600);
+    placement_phase_screen(renderer, textures, font, local);
+    if (local->remaining_ships != NUM_SHIPS) {
+        printf("The ships were not placed.\n");
+        return -1;
+    }
 
-        // Render invalid position border
-        if (invalid_click) {
-            render_invalid_position_border(renderer);
-        }
+    // The opponent's board starts empty, it is filled in from the results of the shots
+    initialize_game_board(&remote->board);
+    initialize_ships(remote);
+    remote->remaining_ships = NUM_SHIPS;
 
-        // Render the screen
-        SDL_RenderPresent(renderer);
-        SDL_Delay(1000 / 60); // Limit frame rate to 60 FPS
+    if (!wait_for_opponent_screen(renderer, font, local)) {
+        return -1;
     }
 
-    // Destroy textures
-    SDL_DestroyTexture(background_texture);
-    SDL_FreeSurface(black_surface);
-    SDL_DestroyTexture(black_texture);
-}
-
-void placement_phase_computer(Player *computer) {
-    // Initialize the computer's game board
-    initialize_game_board(&computer->board);
+    // Play the game, the host shoots first
+    int current_turn = 1;
+    game_screen(renderer, window, textures, font, player1, player2, &current_turn, NULL);
 
-    // Initialize the computer's ships
-    initialize_ships(computer);
+    // Tell the opponent if the game was left before it ended
+    if (local->remaining_ships > 0 && remote->remaining_ships > 0 && !net_session.opponent_left) {
+        NetMessage message = {.type = NET_MSG_RESIGN};
+        send_net_message(&message);
+    }
 
-    // Place the computer's ships randomly
-    int ship_selected = -1;
-    int orientation = 0;
-    bool placed_ships[NUM_SHIPS] = {false};
-    place_random_ships(computer, computer->ships, placed_ships, &ship_selected, &orientation);
+    return 0;
 }
 
-void render_player_board(SDL_Renderer *renderer, GameTextures *textures, Player *player, int board_x, int board_y) {
-    // Render the placed ships on the player's board
-    render_placed_ships(renderer, textures, player->ships, player->placed_ships, board_x, board_y);
+void load_net_snapshot(Player *player1, Player *player2, const NetMessage *snapshot) {
+    Player *players[2] = {player1, player2};
+    for (int seat = 0; seat < 2; seat++) {
+        Player *player = players[seat];
+        initialize_game_board(&player->board);
+        initialize_ships(player);
+        player->remaining_ships = snapshot->remaining_ships[seat];
 
-    // Loop through the cells of the player's board and render the appropriate texture
-    for (int y = 0; y < BOARD_SIZE; y++) {
+        // Only the shot cells are known, a hit cell belongs to a ship without telling which one
         for (int x = 0; x < BOARD_SIZE; x++) {
-            Cell cell = player->board.cells[x][y];
-            SDL_Rect cell_rect = {board_x + x * CELL_SIZE, board_y + y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
-
-            // Render hit or miss textures
-            if (cell.hit) {
-                if (cell.occupied) {
-                    SDL_RenderCopy(renderer, textures->hit_own_ship, NULL, &cell_rect);
-                } else {
-                    SDL_RenderCopy(renderer, textures->hit_ocean, NULL, &cell_rect);
-                }
-            } else {
-                // Render the ocean texture if the cell is not hit or occupied
-                if (!cell.occupied) {
-                    SDL_RenderCopy(renderer, textures->ocean, NULL, &cell_rect);
-                }
+            for (int y = 0; y < BOARD_SIZE; y++) {
+                uint8_t view = snapshot->view[seat][x * BOARD_SIZE + y];
+                Cell *cell = &player->board.cells[x][y];
+                cell->hit = view != NET_CELL_UNKNOWN;
+                cell->occupied = view == NET_CELL_HIT || view == NET_CELL_SUNK;
             }
         }
     }
+
+    // The seat of a snapshot is the player whose turn it is
+    player1->is_turn = snapshot->seat == 1;
+    player2->is_turn = snapshot->seat == 2;
 }
 
-void render_opponent_board(SDL_Renderer *renderer, GameTextures *textures, Player *opponent, int board_x, int board_y) {
-    // Loop through the cells of the opponent's board and render the appropriate texture
-    for (int y = 0; y < BOARD_SIZE; y++) {
-        for (int x = 0; x < BOARD_SIZE; x++) {
-            Cell cell = opponent->board.cells[x][y];
-            SDL_Rect cell_rect = {board_x + x * CELL_SIZE, board_y + y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
+int spectate_net_game(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *player1,
+                      Player *player2) {
+    enter_scene("Battleship - Spectating", 800, 600);
+    SDL_Texture *background_texture = acquire_texture("Assets/game_screen_background.jpeg");
+
+    // The boards stay empty until the first snapshot
+    initialize_game_board(&player1->board);
+    initialize_game_board(&player2->board);
+    initialize_ships(player1);
+    initialize_ships(player2);
+    player1->remaining_ships = NUM_SHIPS;
+    player2->remaining_ships = NUM_SHIPS;
+
+    // Shade both boards by the shots of the AI of the match server
+    set_shot_heatmap_game(player1, player2, NULL, true);
+
+    WidgetTree widgets;
+    init_widget_tree(&widgets);
+    add_widget(&widgets, WIDGET_LINK, (SDL_Rect) {710, 550, 50, 30}, (SDL_Point) {0, 0}, "Exit");
+
+    // Timeline of the shot, turn and victory animations
+    Timeline timeline;
+    clear_timeline(&timeline);
+    SDL_Rect banner_rect = {0, 30, 800, 50};
+    SDL_Rect win_rect = {0, 490, 800, 45};
+    bool requested = false;
+    bool following = false;
+    bool game_over = false;
+    int current_turn = 1;
+    int result = 0;
 
-            // Render hit or miss textures
-            if (cell.hit) {
-                if (cell.occupied) {
-                    SDL_RenderCopy(renderer, textures->hit_enemy_ship, NULL, &cell_rect);
-                } else {
-                    SDL_RenderCopy(renderer, textures->miss, NULL, &cell_rect);
-                }
+    bool running = true;
+    bool redraw = true;
+    begin_screen_stats("spectate");
+    while (running) {
+        Uint64 now = SDL_GetPerformanceCounter();
+
+        // Follow the next match once the winner message has been shown
+        if (game_over && !is_timeline_holding(&timeline, now)) {
+            game_over = false;
+            following = false;
+            requested = false;
+            redraw = true;
+        }
 
-                // Render the ocean texture if the cell is not hit or occupied
-            } else {
-                SDL_RenderCopy(renderer, textures->ocean, NULL, &cell_rect);
+        // Sleep until an event arrives or the timeline needs a frame, the network thread wakes the screen
+        if (!redraw) {
+            Uint64 next_update = get_next_timeline_time(&timeline, now);
+            bool has_events = next_update != 0 ? wait_for_events_until(next_update)
+                                               : wait_for_events(IDLE_WAIT_TIMEOUT);
+            if (!has_events && next_update == 0) {
+                continue;
             }
+            now = SDL_GetPerformanceCounter();
         }
-    }
-}
-
-void render_game_boards(SDL_Renderer *renderer, GameTextures *textures, Player *current_player, Player *opponent) {
-    int board_x_offset = 50; // Adjust the horizontal spacing between the boards
-    int board_y_offset = 100; // Adjust the vertical spacing from the top of the screen
-
-    // Render the current player's board
-    render_player_board(renderer, textures, current_player, board_x_offset, board_y_offset);
-
-    // Render the opponent's board
-    int opponent_board_x = 2 * board_x_offset + BOARD_SIZE * CELL_SIZE;
-    render_opponent_board(renderer, textures, opponent, opponent_board_x, board_y_offset);
-}
+        redraw = false;
 
-void render_game_hover_effect(SDL_Renderer *renderer, SDL_Texture *white_texture, int cell_x, int cell_y, int board_x,
-                              int board_y) {
-    // Render hover effect on the specified cell and its corresponding x and y-axis cells
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if (i != cell_y) {
-            SDL_Rect hover_rect = {board_x + cell_x * CELL_SIZE, board_y + i * CELL_SIZE, CELL_SIZE, CELL_SIZE};
-            SDL_RenderCopy(renderer, white_texture, NULL, &hover_rect);
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            int clicked_widget = handle_widget_event(&widgets, &event);
+            if (event.type == SDL_QUIT) {
+                running = false;
+            } else if (event.type == SDL_MOUSEBUTTONUP && clicked_widget == SPECTATE_WIDGET_EXIT) {
+                running = false;
+            } else if (event.type == SDL_RENDER_TARGETS_RESET) {
+                mark_all_board_layers_dirty();
+                mark_widget_tree_dirty(&widgets);
+            }
         }
 
-        if (i != cell_x) {
-            SDL_Rect hover_rect = {board_x + i * CELL_SIZE, board_y + cell_y * CELL_SIZE, CELL_SIZE, CELL_SIZE};
-            SDL_RenderCopy(renderer, white_texture, NULL, &hover_rect);
+        // Ask for a match to follow once connected, the server sends the next one if none is being played
+        if (is_net_disconnected()) {
+            printf("The connection to the match server failed or was lost.\n");
+            result = -1;
+            running = false;
+        } else if (!requested && !game_over && is_net_connected()) {
+            NetMessage message = {.type = NET_MSG_SPECTATE, .match = NET_ANY_MATCH};
+            requested = send_net_message(&message);
         }
-    }
-}
 
-void
-render_finish_turn_button(SDL_Renderer *renderer, TTF_Font *font, SDL_Rect finish_turn_button, bool hover_finish_turn) {
-    // Set button color based on mouse hover
-    set_button_color(renderer, hover_finish_turn);
+        // Apply the snapshot of the match, then its shots
+        NetMessage message;
+        while (running && poll_net_message(&message)) {
+            if (message.type == NET_MSG_SNAPSHOT) {
+                load_net_snapshot(player1, player2, &message);
+                current_turn = message.seat;
+                following = true;
+                clear_timeline(&timeline);
+                add_tween(&timeline, TWEEN_TURN_BANNER, banner_rect, current_turn, TURN_BANNER_DURATION);
+            } else if (message.type == NET_MSG_DELTA && following && !game_over) {
+                // The seat of a delta is the shooter, the shot lands on the board of the other player
+                Player *target = message.seat == 1 ? player2 : player1;
+                int board_x = message.seat == 1 ? 2 * 50 + BOARD_SIZE * CELL_SIZE : 50;
+                const Ship *sunk_ship = apply_net_shot_result(target, &message);
+                add_shot_result_tweens(&timeline, message.x, message.y, message.result != NET_RESULT_MISS, sunk_ship,
+                                       board_x, 100);
+
+                // A miss passes the turn
+                if (message.result == NET_RESULT_MISS) {
+                    current_turn = message.seat == 1 ? 2 : 1;
+                    add_tween(&timeline, TWEEN_TURN_BANNER, banner_rect, current_turn, TURN_BANNER_DURATION);
+                }
+            } else if (message.type == NET_MSG_GAME_OVER && following && !game_over) {
+                game_over = true;
+                add_tween(&timeline, TWEEN_WIN_MESSAGE, win_rect, message.seat, WIN_MESSAGE_DURATION);
+                hold_timeline(&timeline, WIN_MESSAGE_DURATION);
+            }
+        }
+        update_timeline(&timeline, now);
+        begin_frame_stats();
 
-    // Render the button background
-    SDL_RenderFillRect(renderer, &finish_turn_button);
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, background_texture, NULL, NULL);
 
-    // Render button shadow
-    render_button_shadow(renderer, finish_turn_button);
+        // Render both boards with their fleets hidden, and the state of the stream
+        render_game_boards(renderer, textures, player1, player2, true);
+        render_remaining_ships_text(renderer, font, player1, player2);
+        char text[64];
+        if (!is_net_connected()) {
+            snprintf(text, sizeof(text), "Connecting...");
+        } else if (!following) {
+            snprintf(text, sizeof(text), "Waiting for a match...");
+        } else {
+            snprintf(text, sizeof(text), "Spectating - Player %d's turn", current_turn);
+        }
+        render_colored_text(renderer, text, font, 50, 550, 255, 255, 255);
 
-    // Render finish text
-    render_text(renderer, "Finish turn", font, finish_turn_button.x + 24, finish_turn_button.y + 10);
-}
+        // Render the exit link, hovered at the latest mouse position
+        int mouse_x, mouse_y;
+        get_latest_mouse_state(&mouse_x, &mouse_y);
+        update_widget_hover(&widgets, mouse_x, mouse_y);
+        render_widgets(renderer, font, &widgets);
 
-void render_remaining_ships_text(SDL_Renderer *renderer, TTF_Font *font, Player *current_player, Player *opponent) {
-    char text_buffer[50];
-    int text_y = 100 + BOARD_SIZE * CELL_SIZE + 10;
+        // Render the shot, turn and victory animations
+        render_timeline(renderer, font, &timeline, now);
 
-    // Render remaining ships text for the current player
-    snprintf(text_buffer, sizeof(text_buffer), "Remaining ships: %d", current_player->remaining_ships);
-    render_colored_text(renderer, text_buffer, font, 50, text_y, 255, 255, 255);
+        render_frame_stats_overlay(renderer, font);
+        SDL_RenderPresent(renderer);
+        end_frame_stats();
+    }
+    end_screen_stats();
 
-    // Render remaining ships text for the opponent
-    snprintf(text_buffer, sizeof(text_buffer), "Remaining ships: %d", opponent->remaining_ships);
-    int text_x = 2 * 50 + BOARD_SIZE * CELL_SIZE;
-    render_colored_text(renderer, text_buffer, font, text_x, text_y, 255, 255, 255);
+    destroy_widget_tree(&widgets);
+    release_texture(background_texture);
+    set_shot_heatmap_game(NULL, NULL, NULL, false);
+    return result;
 }
 
-bool update_hit_count(Player *player, int ship_index) {
-    // Update the hit count of the ship
-    player->ships[ship_index].hit_count++;
-
-    // Check if the ship has been sunk
-    if (player->ships[ship_index].hit_count == player->ships[ship_index].size) {
-        player->remaining_ships--;
-        return true;
-    }
-    return false;
-}
+// Engine process playing the computer player, with the time it took for each move
+static EngineProcess computer_engine;
+static bool computer_engine_active;
+static float engine_move_times[BOARD_SIZE * BOARD_SIZE + 1];
+static int num_engine_move_times;
 
-void update_window_title(SDL_Window *window, int current_player_num) {
-    // Update the window title to show the current player
-    char title[50];
-    snprintf(title, sizeof(title), "Battleship - Player %d", current_player_num);
-    SDL_SetWindowTitle(window, title);
-}
+// Thread waiting for the shots of the engine
+static EngineWorker engine_worker;
 
-void show_winner_message(SDL_Renderer *renderer, TTF_Font *font, int winner_player_num) {
-    // Create the winner message
-    char message[50];
-    sprintf(message, "Player %d won!", winner_player_num);
+bool start_computer_engine(void) {
+    const GameOptions *options = get_game_options();
+    if (!start_engine(&computer_engine, options->engine_command, options->engine_movetime, false)) {
+        return false;
+    }
+    if (!start_engine_game(&computer_engine, 2)) {
+        stop_engine(&computer_engine);
+        return false;
+    }
+    computer_engine_active = true;
+    printf("The engine %s plays the computer, %d ms per move.\n", computer_engine.name, options->engine_movetime);
 
-    // Render the winner message
-    SDL_Color color = {255, 255, 255, 255};
-    render_colored_text(renderer, message, font, 300, 500, color.r, color.g, color.b);
+    // Wait for the shots on a thread, the game waits for them itself if it cannot be started
+    if (!start_engine_worker()) {
+        printf("The engine thread could not be started, the game waits for the shots of the engine.\n");
+    }
+    return true;
 }
 
-void handle_game_mouse_button_down(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, bool *running,
-                                   Player *current_player, Player *opponent) {
-    // Get the mouse position
-    int mouse_x, mouse_y;
-    SDL_GetMouseState(&mouse_x, &mouse_y);
+void stop_computer_engine(void) {
+    if (!computer_engine_active) {
+        return;
+    }
 
-    // Get the x and y coordinates of the opponent's board
-    int opponent_board_x = 2 * 50 + BOARD_SIZE * CELL_SIZE;
-    int opponent_board_y = 100;
+    // Let the thread finish the shot it is waiting for before the engine is stopped
+    stop_engine_worker();
 
-    // Check if the mouse click is within the opponent's board and if the player can shoot
-    if (current_player->can_shoot && mouse_x >= opponent_board_x &&
-        mouse_x < opponent_board_x + BOARD_SIZE * CELL_SIZE &&
-        mouse_y >= opponent_board_y && mouse_y < opponent_board_y + BOARD_SIZE * CELL_SIZE) {
+    // Print the time the engine took per move, stopping the engine clears its session
+    float p50, p95, p99;
+    get_percentiles(engine_move_times, num_engine_move_times, &p50, &p95, &p99);
+    printf("Engine %s: %d moves, move time p50 %.2f ms, p99 %.2f ms, %llu bytes sent, %llu bytes received\n",
+           computer_engine.name, num_engine_move_times, p50, p99, (unsigned long long) computer_engine.bytes_sent,
+           (unsigned long long) computer_engine.bytes_received);
 
-        int cell_x = (mouse_x - opponent_board_x) / CELL_SIZE;
-        int cell_y = (mouse_y - opponent_board_y) / CELL_SIZE;
+    stop_engine(&computer_engine);
+    computer_engine_active = false;
+}
 
-        // Check if the cell is already hit
-        if (!opponent->board.cells[cell_x][cell_y].hit) {
-            opponent->board.cells[cell_x][cell_y].hit = true;
+bool is_engine_game(void) {
+    return computer_engine_active;
+}
 
-            // Set has_shot to true
-            current_player->has_shot = true;
+bool place_engine_fleet(Player *computer) {
+    NetShip fleet[NET_FLEET_SIZE];
+    if (!get_engine_fleet(&computer_engine, fleet)) {
+        printf("The engine %s did not send its fleet, the built-in AI takes over.\n", computer_engine.name);
+        stop_computer_engine();
+        return false;
+    }
+    engine_move_times[num_engine_move_times++] = computer_engine.last_move_time;
 
-            // Check if the cell is occupied by an enemy ship
-            if (opponent->board.cells[cell_x][cell_y].occupied) {
-                // Update the hit_count of the respective ship and check if it's destroyed
-                int ship_index = opponent->board.cells[cell_x][cell_y].ship_index;
-                update_hit_count(opponent, ship_index);
+    // Place the ships with the checks of the placement phase
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        if (!is_position_valid(computer, computer->ships[i].size, fleet[i].x, fleet[i].y, fleet[i].orientation)) {
+            printf("The engine %s sent an invalid fleet, the built-in AI takes over.\n", computer_engine.name);
+            stop_computer_engine();
+            initialize_game_board(&computer->board);
+            initialize_ships(computer);
+            return false;
+        }
+        place_ship(&computer->board, &computer->ships[i], fleet[i].x, fleet[i].y, fleet[i].orientation, i);
+        computer->placed_ships[i] = true;
+    }
+    computer->remaining_ships = NUM_SHIPS;
+    return true;
+}
 
-                // Allow the player to continue shooting
-                current_player->can_shoot = true;
-            } else {
-                // Show the "Finish turn" button
-                current_player->can_shoot = false;
+ComputerShot handle_engine_turn(Player *opponent, bool *pending) {
+    ComputerShot shot = {false, false, -1, -1};
+    *pending = false;
+
+    // Ask the thread for the shot and keep the turn pending until the engine has answered
+    uint8_t x = 0, y = 0;
+    bool valid;
+    if (engine_worker.thread != NULL) {
+        SDL_LockMutex(engine_worker.mutex);
+        if (!engine_worker.has_answer) {
+            if (!engine_worker.has_request) {
+                engine_worker.has_request = true;
+                SDL_CondSignal(engine_worker.condition);
             }
+            SDL_UnlockMutex(engine_worker.mutex);
+            *pending = true;
+            return shot;
         }
+        engine_worker.has_answer = false;
+        valid = engine_worker.valid;
+        x = engine_worker.x;
+        y = engine_worker.y;
+        SDL_UnlockMutex(engine_worker.mutex);
+    } else {
+        valid = get_engine_shot(&computer_engine, &x, &y);
     }
 
-    // Check if the game is over (no enemy ships remaining)
-    if (opponent->remaining_ships == 0) {
-        // Show winning message
-        int winner_player_num = current_player->is_turn ? 1 : 2;
-        show_winner_message(renderer, font, winner_player_num);
-        render_game_boards(renderer, textures, current_player, opponent);
-        SDL_RenderPresent(renderer);
-        SDL_Delay(3000); // Wait for 3 seconds before closing the game
-        *running = 0;
+    // A late or invalid shot ends the session, the built-in AI fires instead
+    if (!valid || x >= BOARD_SIZE || y >= BOARD_SIZE || opponent->board.cells[x][y].hit) {
+        printf("The engine %s did not send a valid shot, the built-in AI takes over.\n", computer_engine.name);
+        stop_computer_engine();
+        return shot;
+    }
+    if (num_engine_move_times < BOARD_SIZE * BOARD_SIZE + 1) {
+        engine_move_times[num_engine_move_times++] = computer_engine.last_move_time;
     }
-}
 
-void handle_game_mouse_button_up(Player *current_player, Player *opponent, SDL_Rect finish_turn_button,
-                                 const bool *hover_save, const bool *hover_exit, bool *running, AI_State *ai_state) {
-    // Get the mouse position
-    int mouse_x, mouse_y;
-    SDL_GetMouseState(&mouse_x, &mouse_y);
+    // Apply the shot like the shots of the built-in AI
+    Cell *cell = &opponent->board.cells[x][y];
+    cell->hit = true;
+    mark_board_dirty(&opponent->board);
+    NetShotResult result = NET_RESULT_MISS;
+    NetShip ship = {0};
+    if (cell->occupied) {
+        bool sunk = update_hit_count(opponent, cell->ship_index);
+        result = sunk ? NET_RESULT_SUNK : NET_RESULT_HIT;
+        ship = get_net_ship(opponent, cell->ship_index);
+    }
+    send_engine_result(&computer_engine, x, y, result, &ship);
 
-    // If the "Finish turn" button is visible and the player cannot shoot, check if the mouse click is within the button's area
-    if (!current_player->can_shoot && is_mouse_inside_button(mouse_x, mouse_y, finish_turn_button)) {
-        current_player->is_turn = !current_player->is_turn;
-        opponent->is_turn = !opponent->is_turn;
+    shot.has_shot = true;
+    shot.hit = cell->occupied;
+    shot.x = x;
+    shot.y = y;
+    return shot;
+}
 
-        // Reset can_shoot variable
-        current_player->can_shoot = true;
+bool start_engine_worker(void) {
+    // Register the event waking the game loop once the engine has answered
+    SDL_zero(engine_worker);
+    engine_worker.engine = &computer_engine;
+    engine_worker.answer_event = SDL_RegisterEvents(1);
+    if (engine_worker.answer_event == (Uint32) -1) {
+        return false;
     }
 
-    if (*hover_save) {
-        if (save_game(current_player, opponent, current_player->is_turn ? 1 : 2, ai_state)) {
-            printf("Game saved successfully!\n");
-        } else {
-            printf("Error saving game!");
-        }
+    // Create the synchronization primitives and the thread
+    engine_worker.mutex = SDL_CreateMutex();
+    engine_worker.condition = SDL_CreateCond();
+    if (engine_worker.mutex == NULL || engine_worker.condition == NULL) {
+        stop_engine_worker();
+        return false;
     }
 
-    if (*hover_exit) {
-        *running = false;
+    engine_worker.thread = SDL_CreateThread(engine_worker_thread, "engine_worker", &engine_worker);
+    if (engine_worker.thread == NULL) {
+        stop_engine_worker();
+        return false;
     }
-}
 
-void handle_game_screen_events(SDL_Event *event, SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font,
-                               Player *current_player, Player *opponent, bool *running, SDL_Rect finish_turn_button,
-                               const bool *hover_save, const bool *hover_exit, AI_State *ai_state) {
-    // Handle game screen events
-    while (SDL_PollEvent(event)) {
-        switch (event->type) {
-            // Handle SDL_QUIT event
-            case SDL_QUIT:
-                *running = false;
-                break;
+    return true;
+}
 
-                // Handle mouse button down event
-            case SDL_MOUSEBUTTONDOWN:
-                if (event->button.button == SDL_BUTTON_LEFT && current_player->is_human) {
-                    handle_game_mouse_button_down(renderer, textures, font, running, current_player, opponent);
-                }
-                break;
+void stop_engine_worker(void) {
+    // Ask the thread to quit after the shot it is waiting for, which takes at most the time per move
+    if (engine_worker.thread != NULL) {
+        SDL_LockMutex(engine_worker.mutex);
+        engine_worker.quit = true;
+        SDL_CondSignal(engine_worker.condition);
+        SDL_UnlockMutex(engine_worker.mutex);
 
-                // Handle mouse button up event
-            case SDL_MOUSEBUTTONUP:
-                if (event->button.button == SDL_BUTTON_LEFT) {
-                    handle_game_mouse_button_up(current_player, opponent, finish_turn_button, hover_save, hover_exit,
-                                                running, ai_state);
-                }
-                break;
-        }
+        SDL_WaitThread(engine_worker.thread, NULL);
+        engine_worker.thread = NULL;
     }
-}
 
-void shuffle_directions(int *dir_indices, int size) {
-    // Shuffle the directions
-    for (int i = size - 1; i > 0; i--) {
-        int j = (int) pcg32_boundedrand(i + 1);
-        int temp = dir_indices[i];
-        dir_indices[i] = dir_indices[j];
-        dir_indices[j] = temp;
+    // Free the synchronization primitives
+    if (engine_worker.condition != NULL) {
+        SDL_DestroyCond(engine_worker.condition);
+        engine_worker.condition = NULL;
+    }
+    if (engine_worker.mutex != NULL) {
+        SDL_DestroyMutex(engine_worker.mutex);
+        engine_worker.mutex = NULL;
     }
 }
 
-void remove_cell(int x, int y, int (*remaining_cells)[2], int *remaining_cells_count) {
-    // Find the cell in the array
-    for (int i = 0; i < *remaining_cells_count; i++) {
-        if (remaining_cells[i][0] == x && remaining_cells[i][1] == y) {
-            // Replace the cell with the last cell in the array
-            remaining_cells[i][0] = remaining_cells[*remaining_cells_count - 1][0];
-            remaining_cells[i][1] = remaining_cells[*remaining_cells_count - 1][1];
-
-            // Decrease the count of remaining cells
-            (*remaining_cells_count)--;
-
+int engine_worker_thread(void *data) {
+    EngineWorker *worker = (EngineWorker *) data;
+    SDL_Event answer;
+    SDL_zero(answer);
+    answer.type = worker->answer_event;
+
+    SDL_LockMutex(worker->mutex);
+    while (true) {
+        // Wait until the game asks for a shot or the thread is asked to quit
+        while (!worker->has_request && !worker->quit) {
+            SDL_CondWait(worker->condition, worker->mutex);
+        }
+        if (!worker->has_request) {
             break;
         }
+
+        // Wait for the engine without the lock, the game does not use the engine until the answer is in
+        SDL_UnlockMutex(worker->mutex);
+        uint8_t x = 0, y = 0;
+        bool valid = get_engine_shot(worker->engine, &x, &y);
+        SDL_LockMutex(worker->mutex);
+
+        // Hand the shot to the game and wake its loop
+        worker->has_request = false;
+        worker->has_answer = true;
+        worker->valid = valid;
+        worker->x = x;
+        worker->y = y;
+        SDL_PushEvent(&answer);
     }
+    SDL_UnlockMutex(worker->mutex);
+
+    return 0;
 }
 
-void initialize_ai_context(AI_Context* ctx) {
-    ctx->initialized = true;
-    ctx->min_gap = 1;
-    ctx->direction = 0; // 0 -> left, 1 -> down, 2 -> right, 3 -> up
-    ctx->last_hit_x = -1;
-    ctx->last_hit_y = -1;
-    ctx->initial_hit_x = -1;
-    ctx->initial_hit_y = -1;
-    ctx->is_revisit = false;
-    ctx->first_revisit = true;
-    ctx->hit_segments_count = 0;
-    ctx->direction_fully_explored = false;
-    ctx->dx[0] = -1;
-    ctx->dx[1] = 0;
-    ctx->dx[2] = 1;
-    ctx->dx[3] = 0;
-    ctx->dy[0] = 0;
-    ctx->dy[1] = 1;
-    ctx->dy[2] = 0;
-    ctx->dy[3] = -1;
-    ctx->dir_indices[0] = 0;
-    ctx->dir_indices[1] = 1;
-    ctx->dir_indices[2] = 2;
-    ctx->dir_indices[3] = 3;
-    ctx->remaining_cells_count = BOARD_SIZE * BOARD_SIZE;
+void send_engine_human_shot(int x, int y) {
+    if (computer_engine_active) {
+        send_engine_incoming(&computer_engine, x, y);
+    }
 }
 
-void
-handle_computer_turn(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, Player *computer, Player *opponent,
-                     AI_State *ai_state) {
-    static AI_Context ai_ctx;
+void end_computer_engine_game(int winner) {
+    if (computer_engine_active) {
+        end_engine_game(&computer_engine, winner);
+    }
+}
 
-    // Call initializers if necessary
-    if (!ai_ctx.initialized) {
-        initialize_ai_context(&ai_ctx);
+// Policy network choosing the shots of the computer, with the time it took for each shot
+static PolicyNetwork computer_policy;
+static bool computer_policy_loaded;
+static float policy_shot_times[BOARD_SIZE * BOARD_SIZE];
+static int num_policy_shot_times;
+
+bool load_computer_policy(void) {
+    const char *filename = get_game_options()->policy_file;
+    if (!load_policy_network(&computer_policy, filename)) {
+        return false;
     }
 
-    // Declare variables for the current shot
-    int ship_index;
-    int cell_x, cell_y;
-    bool has_shot = false;
-    bool shot_successful = false;
-    bool valid_cell_found = false;
+    // Time the network with every input set, the most expensive observation since zero inputs are skipped
+    float inputs[POLICY_NUM_INPUTS];
+    float scores[POLICY_NUM_OUTPUTS];
+    for (int i = 0; i < POLICY_NUM_INPUTS; i++) {
+        inputs[i] = 1.0f;
+    }
 
-    // Initialize remaining_cells array if it's the first computer's turn
-    if (ai_ctx.remaining_cells_count == BOARD_SIZE * BOARD_SIZE) {
-        int index = 0;
-        for (int x = 0; x < BOARD_SIZE; x++) {
-            for (int y = 0; y < BOARD_SIZE; y++) {
-                ai_ctx.remaining_cells[index][0] = x;
-                ai_ctx.remaining_cells[index][1] = y;
-                index++;
-            }
+    // Warm the caches up first, then keep the slowest of several shots so one lucky run does not pass the budget
+    evaluate_policy_network(&computer_policy, inputs, scores);
+    float elapsed = 0.0f;
+    for (int run = 0; run < POLICY_BUDGET_RUNS; run++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        evaluate_policy_network(&computer_policy, inputs, scores);
+        float run_time = (float) ((double) (SDL_GetPerformanceCounter() - start) * 1000.0 /
+                                  (double) SDL_GetPerformanceFrequency());
+        if (run_time > elapsed) {
+            elapsed = run_time;
         }
     }
+    if (elapsed > POLICY_MOVE_BUDGET) {
+        printf("The policy network %s takes up to %.2f ms per shot over %d runs, more than %d ms.\n", filename,
+               elapsed, POLICY_BUDGET_RUNS, POLICY_MOVE_BUDGET);
+        free_policy_network(&computer_policy);
+        return false;
+    }
 
-    do {
-        // Handle AI states (SEARCH, TARGET, DESTROY)
-        switch (*ai_state) {
-            SEARCH_CASE:
-            case SEARCH:
-                // Check if there are segments of a ship that haven't been destroyed yet
-                if (ai_ctx.hit_segments_count > 0) {
-                    *ai_state = REVISIT;
-                    goto REVISIT_CASE;
-                }
+    computer_policy_loaded = true;
+    printf("Policy network %s: %d layers, %zu parameters, %.3f ms per shot at most over %d runs.\n", filename,
+           computer_policy.num_layers, computer_policy.num_parameters, elapsed, POLICY_BUDGET_RUNS);
 
-                // Reset variables
-                ai_ctx.attempts = 0;
-                int search_attempts = 0;
-                ai_ctx.is_revisit = false;
+    // Work out the shots of the network while the human is thinking
+    if (!start_computer_ponder()) {
+        printf("Ponder thread could not be started, the shots are computed on the computer's turn. SDL Error: %s\n",
+               SDL_GetError());
+    }
+    return true;
+}
 
-                // Shuffle the direction indices
-                shuffle_directions(ai_ctx.dir_indices, 4);
+void unload_computer_policy(void) {
+    if (!computer_policy_loaded) {
+        return;
+    }
 
-                // Create a temporary array for remaining cells
-                int (*temp_remaining_cells)[2] = malloc(ai_ctx.remaining_cells_count * sizeof(int[2]));
-                memcpy(temp_remaining_cells, ai_ctx.remaining_cells, ai_ctx.remaining_cells_count * sizeof(int[2]));
-                int temp_remaining_cells_count = ai_ctx.remaining_cells_count;
+    // Print the time the network took per shot
+    float p50, p95, p99;
+    get_percentiles(policy_shot_times, num_policy_shot_times, &p50, &p95, &p99);
+    printf("Policy network: %d shots, p50 %.3f ms, p99 %.3f ms\n", num_policy_shot_times, p50, p99);
 
-                // Try to find a valid cell to shoot
-                while (!valid_cell_found && search_attempts < ai_ctx.remaining_cells_count) {
-                    // Choose a random cell to shoot from the temp_remaining_cells array
-                    int random_index = (int) pcg32_boundedrand(temp_remaining_cells_count);
-                    cell_x = temp_remaining_cells[random_index][0];
-                    cell_y = temp_remaining_cells[random_index][1];
+    // The pondering thread reads the network until it stops
+    stop_computer_ponder();
+    free_policy_network(&computer_policy);
+    computer_policy_loaded = false;
+}
 
-                    // Remove the cell from the temp_remaining_cells array and decrease the temp_remaining_cells_count
-                    temp_remaining_cells[random_index][0] = temp_remaining_cells[temp_remaining_cells_count - 1][0];
-                    temp_remaining_cells[random_index][1] = temp_remaining_cells[temp_remaining_cells_count - 1][1];
-                    temp_remaining_cells_count--;
+void get_player_view(const Player *player, uint8_t view[RULES_NUM_CELLS], uint8_t sunk_ships[RULES_NUM_SHIPS]) {
+    for (int i = 0; i < NUM_SHIPS; i++) {
+        sunk_ships[i] = player->ships[i].hit_count >= player->ships[i].size;
+    }
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            const Cell *cell = &player->board.cells[x][y];
+            view[x * BOARD_SIZE + y] = !cell->hit ? NET_CELL_UNKNOWN
+                                       : !cell->occupied ? NET_CELL_MISS
+                                       : sunk_ships[cell->ship_index] ? NET_CELL_SUNK : NET_CELL_HIT;
+        }
+    }
+}
 
-                    // Check if the cell meets the minimum gap requirement.
-                    // The minimum gap requirement means
-                    // that the cell must have a minimum gap of 1 cell from any hit cell
-                    bool meets_gap_requirement = true;
-
-                    for (int i = 0; i < 4; i++) {
-                        int x = cell_x + ai_ctx.dx[i];
-                        int y = cell_y + ai_ctx.dy[i];
-
-                        // Check if the cell is within the board and hasn't been hit before
-                        if (x < 0 || x >= BOARD_SIZE || y < 0 || y >= BOARD_SIZE) continue;
-                        if (!opponent->board.cells[x][y].hit) continue;
-                        // Check if the cell meets the minimum gap requirement
-                        if (opponent->board.cells[x][y].ship_index != -1) {
-                            if (opponent->ships[opponent->board.cells[x][y].ship_index].size >= ai_ctx.min_gap) continue;
-                            meets_gap_requirement = false;
-                        } else {
-                            meets_gap_requirement = false;
-                        }
-                    }
+bool choose_computer_policy_shot(const Player *opponent, int *cell_x, int *cell_y) {
+    if (!computer_policy_loaded) {
+        return false;
+    }
 
-                    if (meets_gap_requirement) {
-                        valid_cell_found = true;
-                    }
-                    search_attempts++;
-                }
+    // The computer knows the shot cells of the opponent's board and which ships are sunk
+    uint8_t view[RULES_NUM_CELLS];
+    uint8_t sunk_ships[RULES_NUM_SHIPS];
+    get_player_view(opponent, view, sunk_ships);
 
-                if (search_attempts == temp_remaining_cells_count && !valid_cell_found) {
-                    // If the AI can't find a valid cell to shoot, it will shoot randomly until it finds a valid cell
-                    do {
-                        // Choose a random cell from the remaining_cells array
-                        int random_index = (int) pcg32_boundedrand(ai_ctx.remaining_cells_count);
-                        cell_x = ai_ctx.remaining_cells[random_index][0];
-                        cell_y = ai_ctx.remaining_cells[random_index][1];
+    // Answer from the shots pondered during the human's turn, or run the network now
+    Uint64 start = SDL_GetPerformanceCounter();
+    uint8_t x, y;
+    if (!find_pondered_shot(view, sunk_ships, &x, &y) &&
+        !choose_policy_shot(&computer_policy, view, sunk_ships, &x, &y)) {
+        return false;
+    }
+    if (num_policy_shot_times < BOARD_SIZE * BOARD_SIZE) {
+        policy_shot_times[num_policy_shot_times++] =
+                (float) ((double) (SDL_GetPerformanceCounter() - start) * 1000.0 /
+                         (double) SDL_GetPerformanceFrequency());
+    }
+    *cell_x = x;
+    *cell_y = y;
+    return true;
+}
 
-                        // Check if the cell hasn't been hit before
-                        if (opponent->board.cells[cell_x][cell_y].hit) continue;
-                        valid_cell_found = true;
-                    } while (!valid_cell_found);
-                    printf("AI can't find a valid cell to shoot, shooting randomly\n");
-                }
-                break;
+void get_computer_shot_probabilities(const Player *opponent, const AI_State *ai_state,
+                                     float probabilities[RULES_NUM_CELLS]) {
+    memset(probabilities, 0, RULES_NUM_CELLS * sizeof(float));
+    if (computer_policy_loaded) {
+        // Softmax of the scores of the network over the cells not shot yet
+        uint8_t view[RULES_NUM_CELLS];
+        uint8_t sunk_ships[RULES_NUM_SHIPS];
+        float inputs[POLICY_NUM_INPUTS];
+        float scores[POLICY_NUM_OUTPUTS];
+        get_player_view(opponent, view, sunk_ships);
+        get_policy_inputs(view, sunk_ships, inputs);
+        evaluate_policy_network(&computer_policy, inputs, scores);
+        int best = -1;
+        for (int i = 0; i < RULES_NUM_CELLS; i++) {
+            if (view[i] == NET_CELL_UNKNOWN && (best < 0 || scores[i] > scores[best])) {
+                best = i;
+            }
+        }
+        float total = 0.0f;
+        for (int i = 0; i < RULES_NUM_CELLS; i++) {
+            probabilities[i] = view[i] == NET_CELL_UNKNOWN ? (float) SDL_exp(scores[i] - scores[best]) : 0.0f;
+            total += probabilities[i];
+        }
+        for (int i = 0; i < RULES_NUM_CELLS && total > 0.0f; i++) {
+            probabilities[i] /= total;
+        }
+        return;
+    }
 
-            TARGET_CASE:
-            case TARGET:
-            case DESTROY:
-                valid_cell_found = false;
-
-                // Try to find a valid cell to shoot in the current direction
-                while (!valid_cell_found && ai_ctx.attempts < 4) {
-                    if (*ai_state == TARGET && !ai_ctx.direction_fully_explored && !ai_ctx.is_revisit) {
-                        // Choose a random direction to shoot
-                        ai_ctx.direction = ai_ctx.dir_indices[ai_ctx.attempts];
-                        cell_x = ai_ctx.initial_hit_x + ai_ctx.dx[ai_ctx.direction];
-                        cell_y = ai_ctx.initial_hit_y + ai_ctx.dy[ai_ctx.direction];
-                    } else { // *ai_state == DESTROY, direction_fully_explored or is_revisit
-
-                        // Check if the direction has been fully explored to start revisiting
-                        if (ai_ctx.direction_fully_explored && *ai_state == TARGET && ai_ctx.attempts > 0) {
-                            *ai_state = REVISIT;
-                            goto REVISIT_CASE;
-                        }
+    // TARGET and DESTROY shoot the first cell they find, follow them on a copy of the context
+    AI_Context ctx = ai_ctx;
+    if (!ctx.initialized) {
+        initialize_ai_context(&ctx);
+    }
+    AI_State state = *ai_state;
+    int cell_x, cell_y;
+    for (int i = 0; i < 8 && (state == TARGET || state == DESTROY); i++) {
+        if (find_target_cell(&ctx, &state, opponent, &cell_x, &cell_y)) {
+            probabilities[cell_x * BOARD_SIZE + cell_y] = 1.0f;
+            return;
+        }
+    }
 
-                        // Check if the AI has not explored the other direction yet
-                        if (ai_ctx.is_revisit && ai_ctx.attempts == 1 && !ai_ctx.direction_fully_explored) {
-                            // try the other direction
-                            ai_ctx.direction = (ai_ctx.direction + 2) % 4;
-                            ai_ctx.direction_fully_explored = true;
-                        }
+    // SEARCH revisits the hit segments left before searching again
+    float search_weight = 1.0f;
+    if ((state == SEARCH || state == REVISIT) && ctx.hit_segments_count > 0) {
+        search_weight -= add_revisit_probabilities(&ctx, opponent, 1.0f, probabilities);
+    }
+    if (search_weight <= 0.0f) {
+        return;
+    }
 
-                        cell_x = ai_ctx.last_hit_x + ai_ctx.dx[ai_ctx.direction];
-                        cell_y = ai_ctx.last_hit_y + ai_ctx.dy[ai_ctx.direction];
-                    }
+    // SEARCH shoots a random cell meeting the minimum gap, or any cell not shot yet if none does
+    int num_candidates = 0;
+    int num_cells = 0;
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            if (!opponent->board.cells[x][y].hit) {
+                num_cells++;
+                num_candidates += meets_min_gap(&ctx, opponent, x, y);
+            }
+        }
+    }
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            if (opponent->board.cells[x][y].hit) {
+                continue;
+            }
+            if (num_candidates == 0) {
+                probabilities[x * BOARD_SIZE + y] += search_weight / (float) num_cells;
+            } else if (meets_min_gap(&ctx, opponent, x, y)) {
+                probabilities[x * BOARD_SIZE + y] += search_weight / (float) num_candidates;
+            }
+        }
+    }
+}
 
-                    // Check if the cell is within the board and hasn't been hit before
-                    if (cell_x >= 0 && cell_x < BOARD_SIZE && cell_y >= 0 && cell_y < BOARD_SIZE &&
-                        !opponent->board.cells[cell_x][cell_y].hit) {
-                        valid_cell_found = true;
-                    } else {
-                        // Increment the attempt counter
-                        ai_ctx.attempts++;
-
-                        if (ai_ctx.direction_fully_explored || *ai_state != DESTROY) continue;
-                        // If the AI has found the orientation and can't explore further in the first direction,
-                        // explore the other direction
-                        ai_ctx.direction = (ai_ctx.direction + 2) % 4;
-                        ai_ctx.last_hit_x = ai_ctx.initial_hit_x;
-                        ai_ctx.last_hit_y = ai_ctx.initial_hit_y;
-                        ai_ctx.direction_fully_explored = true;
-                    }
-                }
+float add_revisit_probabilities(const AI_Context *ctx, const Player *opponent, float weight,
+                                float probabilities[RULES_NUM_CELLS]) {
+    // The first revisit turns across the last direction, or takes the first shuffled direction after a vertical one,
+    // the next revisits take one of the two directions across at random
+    int directions[2] = {ctx->dir_indices_revisit[0], ctx->dir_indices_revisit[1]};
+    int next_directions[2] = {ctx->dir_indices_revisit[0], ctx->dir_indices_revisit[1]};
+    int num_directions = 2;
+    if (ctx->first_revisit && (ctx->direction == 0 || ctx->direction == 2)) {
+        directions[0] = next_directions[0] = 1;
+        directions[1] = next_directions[1] = 3;
+    } else if (ctx->first_revisit) {
+        directions[0] = ctx->dir_indices[0];
+        num_directions = 1;
+        next_directions[0] = 0;
+        next_directions[1] = 2;
+    }
 
-                // If no valid cell is found in TARGET or DESTROY state, switch back to SEARCH state
-                if (!valid_cell_found && (*ai_state == TARGET || *ai_state == DESTROY)) {
-                    if (*ai_state == TARGET) {
-                        ai_ctx.direction = (ai_ctx.direction + 1) % 4; // Try the next direction
-                        ai_ctx.attempts++; // Increment attempts count
+    // Follow each segment and direction on a copy of the context, the segment is taken out of the array
+    float found = 0.0f;
+    float revisit_weight = weight / (float) (ctx->hit_segments_count * num_directions);
+    for (int segment = 0; segment < ctx->hit_segments_count; segment++) {
+        for (int d = 0; d < num_directions; d++) {
+            AI_Context revisit = *ctx;
+            revisit.initial_hit_x = revisit.last_hit_x = ctx->hit_segments[segment][0];
+            revisit.initial_hit_y = revisit.last_hit_y = ctx->hit_segments[segment][1];
+            revisit.hit_segments[segment][0] = revisit.hit_segments[revisit.hit_segments_count - 1][0];
+            revisit.hit_segments[segment][1] = revisit.hit_segments[revisit.hit_segments_count - 1][1];
+            revisit.hit_segments_count--;
+            revisit.dir_indices_revisit[0] = next_directions[0];
+            revisit.dir_indices_revisit[1] = next_directions[1];
+            revisit.direction = directions[d];
+            revisit.is_revisit = true;
+            revisit.first_revisit = false;
+            revisit.attempts = 0;
+            revisit.direction_fully_explored = false;
+            AI_State state = TARGET;
+            int cell_x, cell_y;
+            bool cell_found = false;
+            for (int i = 0; i < 8 && !cell_found && (state == TARGET || state == DESTROY); i++) {
+                cell_found = find_target_cell(&revisit, &state, opponent, &cell_x, &cell_y);
+            }
+            if (cell_found) {
+                probabilities[cell_x * BOARD_SIZE + cell_y] += revisit_weight;
+                found += revisit_weight;
+            } else if (revisit.hit_segments_count > 0) {
+                found += add_revisit_probabilities(&revisit, opponent, revisit_weight, probabilities);
+            }
+        }
+    }
+    return found;
+}
 
-                        // If all directions have been tried, switch back to SEARCH state
-                        if (ai_ctx.attempts < 4) continue;
-                        *ai_state = SEARCH;
-                        ai_ctx.attempts = 0;
-                        ai_ctx.direction = 0;
-                        ai_ctx.last_hit_x = -1;
-                        ai_ctx.last_hit_y = -1;
-                        ai_ctx.initial_hit_x = -1;
-                        ai_ctx.initial_hit_y = -1;
-                        ai_ctx.direction_fully_explored = false;
-                    } else { // *ai_state == DESTROY
-                        *ai_state = SEARCH;
-                        ai_ctx.attempts = 0;
-                        ai_ctx.direction = 0;
-                        ai_ctx.last_hit_x = -1;
-                        ai_ctx.last_hit_y = -1;
-                        ai_ctx.initial_hit_x = -1;
-                        ai_ctx.initial_hit_y = -1;
-                        ai_ctx.direction_fully_explored = false;
-                    }
-                    continue; // Continue with the next iteration of the do-while loop
-                }
-                break;
+void get_server_shot_probabilities(const uint8_t view[RULES_NUM_CELLS], float probabilities[RULES_NUM_CELLS]) {
+    // A cell listed once per hit next to it is that much more likely
+    uint8_t candidates[RULES_NUM_CELLS];
+    int num_candidates = get_compact_shot_candidates(view, candidates);
+    memset(probabilities, 0, RULES_NUM_CELLS * sizeof(float));
+    for (int i = 0; i < num_candidates; i++) {
+        probabilities[candidates[i]] += 1.0f / (float) num_candidates;
+    }
+}
 
-            REVISIT_CASE:
-            case REVISIT:
-                if (ai_ctx.hit_segments_count > 0) {
-                    // Choose a random segment from the hit_segments array
-                    int random_index = (int) pcg32_boundedrand(ai_ctx.hit_segments_count);
-                    cell_x = ai_ctx.hit_segments[random_index][0];
-                    cell_y = ai_ctx.hit_segments[random_index][1];
+// Thread pondering the shots of the policy network
+static PonderWorker ponder_worker;
 
-                    // Remove the cell from the hit_segments array and decrease the hit_segments_count
-                    ai_ctx.hit_segments[random_index][0] = ai_ctx.hit_segments[ai_ctx.hit_segments_count - 1][0];
-                    ai_ctx.hit_segments[random_index][1] = ai_ctx.hit_segments[ai_ctx.hit_segments_count - 1][1];
-                    ai_ctx.hit_segments_count--;
+bool start_computer_ponder(void) {
+    // Create the synchronization primitives and the thread
+    SDL_zero(ponder_worker);
+    ponder_worker.mutex = SDL_CreateMutex();
+    ponder_worker.condition = SDL_CreateCond();
+    if (ponder_worker.mutex == NULL || ponder_worker.condition == NULL) {
+        stop_computer_ponder();
+        return false;
+    }
 
-                    // Set the initially hit coordinates and last hit coordinates to the cell coordinates
-                    ai_ctx.initial_hit_x = ai_ctx.last_hit_x = cell_x;
-                    ai_ctx.initial_hit_y = ai_ctx.last_hit_y = cell_y;
+    ponder_worker.thread = SDL_CreateThread(ponder_worker_thread, "ponder_worker", &ponder_worker);
+    if (ponder_worker.thread == NULL) {
+        stop_computer_ponder();
+        return false;
+    }
 
-                    static int dir_indices_revisit[2] = {0};
+    return true;
+}
 
-                    // Choose a random direction based on the saved direction, but only for the first revisit
-                    if (ai_ctx.first_revisit) {
-                        if (ai_ctx.direction == 0 || ai_ctx.direction == 2) {
+void stop_computer_ponder(void) {
+    // Ask the thread to quit, it stops after the reply it is working out
+    if (ponder_worker.thread != NULL) {
+        SDL_LockMutex(ponder_worker.mutex);
+        ponder_worker.quit = true;
+        ponder_worker.generation++;
+        SDL_CondSignal(ponder_worker.condition);
+        SDL_UnlockMutex(ponder_worker.mutex);
+
+        SDL_WaitThread(ponder_worker.thread, NULL);
+        ponder_worker.thread = NULL;
+        printf("Pondering: %d shots answered from the cache, %d computed on the computer's turn\n",
+               ponder_worker.hits, ponder_worker.misses);
+    }
 
-                            // If the direction is 0 or 2, the other directions are 1 and 3
-                            dir_indices_revisit[0] = 1;
-                            dir_indices_revisit[1] = 3;
-                            shuffle_directions(dir_indices_revisit, 2);
+    // Free the synchronization primitives
+    if (ponder_worker.condition != NULL) {
+        SDL_DestroyCond(ponder_worker.condition);
+        ponder_worker.condition = NULL;
+    }
+    if (ponder_worker.mutex != NULL) {
+        SDL_DestroyMutex(ponder_worker.mutex);
+        ponder_worker.mutex = NULL;
+    }
+}
 
-                            // Choose a random direction from the other two
-                            ai_ctx.direction = dir_indices_revisit[0];
-                        } else {
-                            // If the direction is 1 or 3, the other directions are 0 and 2
-                            dir_indices_revisit[0] = 0;
-                            dir_indices_revisit[1] = 2;
-                            shuffle_directions(dir_indices_revisit, 2);
-                            ai_ctx.direction = ai_ctx.dir_indices[0];
-                        }
-                        ai_ctx.first_revisit = false;
-                    } else {
-                        shuffle_directions(dir_indices_revisit, 2);
-                        ai_ctx.direction = dir_indices_revisit[0];
-                    }
+void ponder_computer_shot(const Player *human) {
+    if (ponder_worker.thread == NULL) {
+        return;
+    }
 
-                    // Update the AI state to TARGET
-                    ai_ctx.is_revisit = true;
-                    *ai_state = TARGET;
-                    ai_ctx.attempts = 0;
-                    ai_ctx.direction_fully_explored = false;
-                    goto TARGET_CASE;
-                } else {
-                    // If there are no hit segments left to revisit, switch back to SEARCH state
-                    ai_ctx.is_revisit = false;
-                    ai_ctx.first_revisit = true;
-                    *ai_state = SEARCH;
-                    goto SEARCH_CASE;
-                }
-        }
+    // Wake the thread only when a shot changed the view
+    uint8_t view[RULES_NUM_CELLS];
+    uint8_t sunk_ships[RULES_NUM_SHIPS];
+    get_player_view(human, view, sunk_ships);
+    SDL_LockMutex(ponder_worker.mutex);
+    if (memcmp(ponder_worker.root_view, view, sizeof(view)) != 0 ||
+        memcmp(ponder_worker.root_sunk_ships, sunk_ships, sizeof(sunk_ships)) != 0 || ponder_worker.generation == 0) {
+        memcpy(ponder_worker.root_view, view, sizeof(view));
+        memcpy(ponder_worker.root_sunk_ships, sunk_ships, sizeof(sunk_ships));
+        ponder_worker.has_root = true;
+        ponder_worker.generation++;
+        SDL_CondSignal(ponder_worker.condition);
+    }
+    SDL_UnlockMutex(ponder_worker.mutex);
+}
 
-        // If the chosen cell hasn't been hit before
-        if (!opponent->board.cells[cell_x][cell_y].hit) {
-            // Mark the cell as hit
-            opponent->board.cells[cell_x][cell_y].hit = true;
-            has_shot = true;
+bool find_pondered_shot(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS], uint8_t *x,
+                        uint8_t *y) {
+    if (ponder_worker.thread == NULL) {
+        return false;
+    }
 
-            // Remove the cell from the remaining_cells array
-            remove_cell(cell_x, cell_y, ai_ctx.remaining_cells, &ai_ctx.remaining_cells_count);
+    SDL_LockMutex(ponder_worker.mutex);
+    PonderEntry *entry = find_ponder_entry(&ponder_worker, view, sunk_ships);
+    if (entry != NULL) {
+        *x = entry->x;
+        *y = entry->y;
+        ponder_worker.hits++;
+    } else {
+        // The replies being worked out are for other observations, stop the thread until the next view
+        ponder_worker.has_root = false;
+        ponder_worker.generation++;
+        ponder_worker.misses++;
+    }
+    SDL_UnlockMutex(ponder_worker.mutex);
+    return entry != NULL;
+}
 
-            // If the cell is occupied by a ship
-            if (opponent->board.cells[cell_x][cell_y].occupied) {
-                // Update hit count of the ship
-                ship_index = opponent->board.cells[cell_x][cell_y].ship_index;
-                update_hit_count(opponent, ship_index);
-                shot_successful = true;
+int ponder_worker_thread(void *data) {
+    PonderWorker *worker = (PonderWorker *) data;
+    uint8_t views[PONDER_MAX_REPLIES][RULES_NUM_CELLS];
+    uint8_t sunk_ships[RULES_NUM_SHIPS];
 
-                // Update AI state based on the current state
-                if (*ai_state == SEARCH) {
-                    *ai_state = TARGET;
-                    ai_ctx.initial_hit_x = ai_ctx.last_hit_x = cell_x;
-                    ai_ctx.initial_hit_y = ai_ctx.last_hit_y = cell_y;
-                } else if (*ai_state == TARGET || *ai_state == DESTROY) {
-                    if (*ai_state == TARGET) {
-                        // Update the state to DESTROY
-                        *ai_state = DESTROY;
-                        ai_ctx.attempts = 0;
-                    }
-                    ai_ctx.last_hit_x = cell_x;
-                    ai_ctx.last_hit_y = cell_y;
+    SDL_LockMutex(worker->mutex);
+    while (true) {
+        // Wait until there is a new view to ponder or the thread is asked to quit
+        while (!worker->has_root && !worker->quit) {
+            SDL_CondWait(worker->condition, worker->mutex);
+        }
+        if (worker->quit) {
+            break;
+        }
+        unsigned generation = worker->generation;
+        memcpy(views[0], worker->root_view, sizeof(views[0]));
+        memcpy(sunk_ships, worker->root_sunk_ships, sizeof(sunk_ships));
+        worker->has_root = false;
+
+        // Work out the replies breadth first, until the view changes or the turn comes
+        int num_views = 1;
+        for (int i = 0; i < num_views && worker->generation == generation; i++) {
+            PonderEntry *entry = find_ponder_entry(worker, views[i], sunk_ships);
+            if (entry == NULL) {
+                // Run the network without the lock, the game loop keeps handing views and looking up shots
+                uint8_t x, y;
+                SDL_UnlockMutex(worker->mutex);
+                bool chosen = choose_policy_shot(&computer_policy, views[i], sunk_ships, &x, &y);
+                SDL_LockMutex(worker->mutex);
+                if (!chosen || worker->generation != generation) {
+                    continue;
                 }
 
-                // If the ship is sunk, reset AI state to SEARCH, update destroyed_ships array and min gap
-                if (opponent->ships[ship_index].hit_count == opponent->ships[ship_index].size) {
-                    ai_ctx.destroyed_ships[ship_index] = true;
-
-                    // Update min_gap when a ship is destroyed
-                    int smallest_ship_remaining = BOARD_SIZE + 1;
-                    for (int i = 0; i < NUM_SHIPS; i++) {
-                        if (ai_ctx.destroyed_ships[i] || opponent->ships[i].size >= smallest_ship_remaining) continue;
-                        smallest_ship_remaining = opponent->ships[i].size;
+                // Replace an entry of a previous view, the replies of this one are kept
+                for (int j = 0; j < PONDER_CACHE_SIZE && entry == NULL; j++) {
+                    if (!worker->cache[j].valid || worker->cache[j].generation != generation) {
+                        entry = &worker->cache[j];
                     }
-                    ai_ctx.min_gap = smallest_ship_remaining - 1;
+                }
+                entry->valid = true;
+                memcpy(entry->view, views[i], sizeof(entry->view));
+                memcpy(entry->sunk_ships, sunk_ships, sizeof(entry->sunk_ships));
+                entry->x = x;
+                entry->y = y;
+            }
+            entry->generation = generation;
+
+            // The likely next observations: the reply misses, or hits without sinking a ship
+            int cell = entry->x * BOARD_SIZE + entry->y;
+            for (int outcome = NET_CELL_MISS; outcome <= NET_CELL_HIT && num_views < PONDER_MAX_REPLIES; outcome++) {
+                memcpy(views[num_views], views[i], sizeof(views[num_views]));
+                views[num_views][cell] = (uint8_t) outcome;
+                num_views++;
+            }
+        }
+    }
+    SDL_UnlockMutex(worker->mutex);
 
-                    if (!ai_ctx.is_revisit) {
-                        // reset hit segments array
-                        for (int i = 0; i < ai_ctx.hit_segments_count; i++) {
-                            ai_ctx.hit_segments[i][0] = -1;
-                            ai_ctx.hit_segments[i][1] = -1;
-                            ai_ctx.hit_segments_count = 0;
-                        }
-                        ai_ctx.direction = 0;
-                    }
+    return 0;
+}
 
-                    // Reset AI state
-                    *ai_state = SEARCH;
-                    ai_ctx.attempts = 0;
-                    ai_ctx.last_hit_x = -1;
-                    ai_ctx.last_hit_y = -1;
-                    ai_ctx.initial_hit_x = -1;
-                    ai_ctx.initial_hit_y = -1;
-                    valid_cell_found = false;
-                    ai_ctx.direction_fully_explored = false;
-                } else if (!ai_ctx.is_revisit) {
-                    // Add ship segments to the hit_segments array
-                    ai_ctx.hit_segments[ai_ctx.hit_segments_count][0] = cell_x;
-                    ai_ctx.hit_segments[ai_ctx.hit_segments_count][1] = cell_y;
-                    ai_ctx.hit_segments_count++;
-                }
+PonderEntry *find_ponder_entry(PonderWorker *worker, const uint8_t view[RULES_NUM_CELLS],
+                               const uint8_t sunk_ships[RULES_NUM_SHIPS]) {
+    for (int i = 0; i < PONDER_CACHE_SIZE; i++) {
+        PonderEntry *entry = &worker->cache[i];
+        if (entry->valid && memcmp(entry->view, view, sizeof(entry->view)) == 0 &&
+            memcmp(entry->sunk_ships, sunk_ships, sizeof(entry->sunk_ships)) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
 
-                // Render the game boards again
-                render_game_boards(renderer, textures, opponent, computer);
-                SDL_RenderPresent(renderer);
-                SDL_Delay(1000); // Delay for 1 second
-            } else {
-                // If the cell was not occupied by a ship, update AI state
-                shot_successful = false;
-                if (*ai_state == TARGET) {
-                    ai_ctx.attempts++;
-                } else if (*ai_state == DESTROY) {
-                    *ai_state = TARGET;
-                    ai_ctx.direction = (ai_ctx.direction + 2) % 4; // Reverse direction
-                    ai_ctx.last_hit_x = ai_ctx.initial_hit_x;
-                    ai_ctx.last_hit_y = ai_ctx.initial_hit_y;
-                    ai_ctx.direction_fully_explored = true;
-                }
+// Options given on the command line
+static GameOptions game_options;
+
+bool parse_game_options(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--vsync") == 0) {
+            game_options.vsync = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            game_options.show_frame_stats = true;
+        } else if (strcmp(argv[i], "--stats-log") == 0 && i + 1 < argc) {
+            game_options.frame_stats_log = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            game_options.render_profile_file = argv[++i];
+        } else if (strcmp(argv[i], "--animation-speed") == 0 && i + 1 < argc) {
+            char *end;
+            game_options.animation_speed = strtof(argv[++i], &end);
+            if (*end != '\0' || game_options.animation_speed < 0.0f) {
+                printf("Invalid animation speed: %s\n", argv[i]);
+                return false;
             }
-        } else {
-            // If the shot was unsuccessful, update AI states
-            if (*ai_state == TARGET) {
-                ai_ctx.direction = ai_ctx.dir_indices[ai_ctx.attempts];
-                ai_ctx.attempts++;
-                ai_ctx.direction_fully_explored = false;
-            } else if (*ai_state == DESTROY) {
-                if (ai_ctx.direction_fully_explored) {
-                    *ai_state = REVISIT;
-                } else {
-                    *ai_state = TARGET;
-                    ai_ctx.direction = (ai_ctx.direction + 2) % 4; // Reverse direction
-                    ai_ctx.last_hit_x = ai_ctx.initial_hit_x;
-                    ai_ctx.last_hit_y = ai_ctx.initial_hit_y;
+            game_options.instant_animations = game_options.animation_speed == 0.0f;
+        } else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            game_options.net_host = true;
+            game_options.net_port = atoi(argv[++i]);
+            if (game_options.net_port <= 0 || game_options.net_port > 65535) {
+                printf("Invalid port: %s\n", argv[i]);
+                return false;
+            }
+        } else if ((strcmp(argv[i], "--connect") == 0 || strcmp(argv[i], "--spectate") == 0) && i + 1 < argc) {
+            // Split the port from the address, the port is optional
+            game_options.net_spectate = strcmp(argv[i], "--spectate") == 0;
+            game_options.net_address = argv[++i];
+            game_options.net_port = NET_DEFAULT_PORT;
+            char *separator = strrchr(argv[i], ':');
+            if (separator != NULL) {
+                *separator = '\0';
+                game_options.net_port = atoi(separator + 1);
+                if (game_options.net_port <= 0 || game_options.net_port > 65535) {
+                    printf("Invalid port: %s\n", separator + 1);
+                    return false;
                 }
             }
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            game_options.engine_command = argv[++i];
+        } else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) {
+            game_options.engine_movetime = atoi(argv[++i]);
+            if (game_options.engine_movetime <= 0) {
+                printf("Invalid move time: %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            game_options.policy_file = argv[++i];
+        } else if (strcmp(argv[i], "--heatmap") == 0) {
+            game_options.show_shot_heatmap = true;
+        } else if (strcmp(argv[i], "--render-test") == 0 && i + 1 < argc) {
+            game_options.render_test_dir = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            game_options.golden_dir = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            game_options.render_test_frames = atoi(argv[++i]);
+            if (game_options.render_test_frames <= 0) {
+                printf("Invalid frame count: %s\n", argv[i]);
+                return false;
+            }
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return false;
         }
-    } while (shot_successful && opponent->remaining_ships > 0);
-
-    if (!has_shot) {
-        printf("This should never happen\n");
     }
 
-    // If all opponent's ships are sunk, show the winner message
-    if (opponent->remaining_ships == 0) {
-        show_winner_message(renderer, font, 2);
+    if (game_options.net_host && game_options.net_address != NULL) {
+        printf("--host cannot be used with --connect or --spectate\n");
+        return false;
+    }
+    if (game_options.render_test_frames == 0) {
+        game_options.render_test_frames = RENDER_TEST_DEFAULT_FRAMES;
+    }
+    if (game_options.engine_movetime == 0) {
+        game_options.engine_movetime = ENGINE_DEFAULT_MOVETIME;
     }
+    if (game_options.animation_speed == 0.0f && !game_options.instant_animations) {
+        game_options.animation_speed = 1.0f;
+    }
+    frame_stats_overlay = game_options.show_frame_stats;
+    shot_heatmap_enabled = game_options.show_shot_heatmap;
+    if (game_options.render_profile_file != NULL) {
+        set_render_profiling(true);
+    }
+    return true;
+}
 
-    // Render the game boards one last time and wait for a second
-    render_game_boards(renderer, textures, opponent, computer);
-    render_remaining_ships_text(renderer, font, opponent, computer);
-    SDL_RenderPresent(renderer);
-    SDL_Delay(1000); // Delay for 1 second
+const GameOptions *get_game_options(void) {
+    return &game_options;
 }
 
-void game_screen(SDL_Renderer *renderer, SDL_Window *window, GameTextures *textures, TTF_Font *font, Player *player1,
-                 Player *player2, int *current_turn, AI_State *ai_state) {
-    // Load background texture
-    SDL_Texture *background_texture = IMG_LoadTexture(renderer, "Assets/game_screen_background.jpeg");
+Uint32 get_renderer_flags(void) {
+    return SDL_RENDERER_ACCELERATED | (game_options.vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
+}
 
-    // Create black surface
-    SDL_Surface *black_surface = SDL_CreateRGBSurface(0, CELL_SIZE, CELL_SIZE, 32, 0, 0, 0, 0);
-    SDL_SetSurfaceAlphaMod(black_surface, 50); // Set the alpha value to 128 (50% opacity)
-    SDL_FillRect(black_surface, NULL, SDL_MapRGB(black_surface->format, 0, 0, 0));
-    SDL_Texture *black_texture = SDL_CreateTextureFromSurface(renderer, black_surface);
-    SDL_SetTextureBlendMode(black_texture, SDL_BLENDMODE_BLEND);
+// Names of the render test scenes, also the names of their images
+static const char *render_test_scene_names[RENDER_TEST_SCENE_COUNT] = {"main_menu", "placement_phase", "game"};
 
-    // Initialize the variables
-    bool running = true;
-    bool hover_exit = false;
-    bool hover_save = false;
-    bool hover_finish_turn = false;
-    SDL_Event event;
+// Ship positions of the render test fleet, as {x, y, orientation}
+static const int render_test_fleet[NUM_SHIPS][3] = {{0, 0, 0}, {0, 2, 0}, {6, 4, 1}, {2, 6, 0}, {8, 8, 0}};
 
-    // Initialize button
-    SDL_Rect finish_turn_button = {800 / 2 - 100, 600 - 70, 200, 40};
-    SDL_Rect save_button = {630, 550, 50, 30};
-    SDL_Rect exit_button = {710, 550, 50, 30};
+// Shots of the render test, hitting every ship, sinking the last one and missing some cells
+static const int render_test_shots[][2] = {
+        {0, 0}, {1, 0}, {2, 0}, {3, 2}, {6, 4}, {6, 5}, {8, 8}, {9, 8}, {5, 5}, {9, 0}, {0, 9}, {4, 4}
+};
 
-    // Main game loop
-    while (running) {
-        // Set the current player and opponent based on the current turn
-        Player *current_player = *current_turn == 1 ? player1 : player2;
-        Player *opponent = *current_turn == 1 ? player2 : player1;
+void setup_render_test_player(Player *player, int num_placed) {
+    memset(player, 0, sizeof(Player));
+    initialize_game_board(&player->board);
+    initialize_ships(player);
 
-        // Set the render draw color to white
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    // Place the first ships of the fleet
+    for (int i = 0; i < num_placed; i++) {
+        const int *position = render_test_fleet[i];
+        place_ship(&player->board, &player->ships[i], position[0], position[1], position[2], i);
+        player->placed_ships[i] = true;
+    }
+    player->remaining_ships = num_placed;
+    player->is_human = true;
+    player->can_shoot = true;
+}
 
-        // Clear the screen
-        SDL_RenderClear(renderer);
+void fire_render_test_shots(Player *target) {
+    int num_shots = (int) (sizeof(render_test_shots) / sizeof(render_test_shots[0]));
+    for (int i = 0; i < num_shots; i++) {
+        Cell *cell = &target->board.cells[render_test_shots[i][0]][render_test_shots[i][1]];
+        if (cell->hit) {
+            continue;
+        }
 
-        // Render the background texture
-        SDL_RenderCopy(renderer, background_texture, NULL, NULL);
+        // Apply the shot the way the game screen does
+        cell->hit = true;
+        if (cell->occupied) {
+            update_hit_count(target, cell->ship_index);
+        }
+    }
+    mark_board_dirty(&target->board);
+}
 
-        // Render game boards for both players
-        render_game_boards(renderer, textures, current_player, opponent);
+bool init_render_test_state(RenderTestState *state, SDL_Renderer *renderer) {
+    memset(state, 0, sizeof(RenderTestState));
 
-        // Check if it is the computer's turn and handle it
-        if (current_player->is_human == false) {
-            handle_computer_turn(renderer, textures, font, current_player, opponent, ai_state);
-            if (opponent->remaining_ships == 0) {
-                break;
-            }
-            current_player->is_turn = !current_player->is_turn;
-            opponent->is_turn = !opponent->is_turn;
-        } else {
-            // Render remaining ships text for both players
-            render_remaining_ships_text(renderer, font, current_player, opponent);
-        }
+    // The main menu shows the first frame of its background
+    init_main_menu(renderer, &state->background, &state->menu_widgets);
 
-        // Get mouse position
-        int mouse_x, mouse_y;
-        SDL_GetMouseState(&mouse_x, &mouse_y);
+    // The second button of the main menu is hovered
+    SDL_Rect hovered_rect = state->menu_widgets.widgets[MAIN_MENU_NEW_GAME_PVC].rect;
+    update_widget_hover(&state->menu_widgets, hovered_rect.x, hovered_rect.y);
+    state->placement_background = acquire_texture("Assets/selecting_screen_background.jpg");
+    state->game_background = acquire_texture("Assets/game_screen_background.jpeg");
 
-        // Calculate the cell coordinates based on the mouse position
-        int opponent_board_x = 2 * 50 + BOARD_SIZE * CELL_SIZE;
-        int opponent_board_y = 100;
+    // The placement phase has three ships placed
+    setup_render_test_player(&state->placement_player, 3);
 
-        // Check if the mouse is hovering over the opponent's board
-        if (mouse_x >= opponent_board_x && mouse_x < opponent_board_x + BOARD_SIZE * CELL_SIZE &&
-            mouse_y >= opponent_board_y && mouse_y < opponent_board_y + BOARD_SIZE * CELL_SIZE) {
+    // The game has both fleets placed and shots fired at both boards
+    setup_render_test_player(&state->player1, NUM_SHIPS);
+    setup_render_test_player(&state->player2, NUM_SHIPS);
+    fire_render_test_shots(&state->player1);
+    fire_render_test_shots(&state->player2);
+    state->player1.is_turn = true;
 
-            int cell_x = (mouse_x - opponent_board_x) / CELL_SIZE;
-            int cell_y = (mouse_y - opponent_board_y) / CELL_SIZE;
+    // Create the texture behind the ship list, as the placement screen does
+    SDL_Surface *black_surface = SDL_CreateRGBSurface(0, CELL_SIZE, CELL_SIZE, 32, 0, 0, 0, 0);
+    if (black_surface == NULL) {
+        printf("Error creating black surface: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_FillRect(black_surface, NULL, SDL_MapRGB(black_surface->format, 0, 0, 0));
+    state->black_texture = SDL_CreateTextureFromSurface(renderer, black_surface);
+    SDL_FreeSurface(black_surface);
+    return state->black_texture != NULL;
+}
 
-            // Render the hover effect
-            if (current_player->can_shoot) {
-                render_game_hover_effect(renderer, black_texture, cell_x, cell_y, opponent_board_x, opponent_board_y);
+void destroy_render_test_state(RenderTestState *state) {
+    destroy_animation_player(&state->background);
+    destroy_widget_tree(&state->menu_widgets);
+    release_texture(state->placement_background);
+    release_texture(state->game_background);
+    SDL_DestroyTexture(state->black_texture);
+    destroy_board_layers();
+}
+
+void render_test_scene(SDL_Renderer *renderer, GameTextures *textures, TTF_Font *font, RenderTestScene scene,
+                       RenderTestState *state) {
+    // Clear screen
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderClear(renderer);
+
+    if (scene == RENDER_TEST_MAIN_MENU) {
+        // The main menu with the second button hovered
+        render_main_menu(renderer, get_animation_texture(&state->background), font, &state->menu_widgets);
+    } else if (scene == RENDER_TEST_PLACEMENT) {
+        // The placement phase with the fourth ship hovering vertically over the grid
+        Player *player = &state->placement_player;
+        SDL_RenderCopy(renderer, state->placement_background, NULL, NULL);
+        render_placement_ships_left_side(renderer, textures, player->ships, player->placed_ships,
+                                         state->black_texture, 3, -1);
+        render_placement_grid_ships(renderer, textures, &player->board, player->ships, player->placed_ships, 3, 1,
+                                    7, 2, is_position_valid(player, player->ships[3].size, 7, 2, 1));
+    } else {
+        // The game with both boards shot at, seen by the first player
+        SDL_RenderCopy(renderer, state->game_background, NULL, NULL);
+        render_game_boards(renderer, textures, &state->player1, &state->player2, false);
+        render_remaining_ships_text(renderer, font, &state->player1, &state->player2);
+    }
+}
+
+int compare_frame_with_golden(SDL_Surface *frame, SDL_Surface *golden, int tolerance) {
+    if (frame->w != golden->w || frame->h != golden->h) {
+        return -1;
+    }
+
+    // Compare in the format of the frame
+    SDL_Surface *expected = SDL_ConvertSurfaceFormat(golden, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (expected == NULL) {
+        return -1;
+    }
+
+    int num_different = 0;
+    for (int y = 0; y < frame->h; y++) {
+        const Uint8 *actual_row = (const Uint8 *) frame->pixels + y * frame->pitch;
+        const Uint8 *expected_row = (const Uint8 *) expected->pixels + y * expected->pitch;
+        for (int x = 0; x < frame->w; x++) {
+            // Compare the color channels, the alpha of the frame is not meaningful
+            Uint32 actual = ((const Uint32 *) actual_row)[x];
+            Uint32 wanted = ((const Uint32 *) expected_row)[x];
+            for (int shift = 0; shift < 24; shift += 8) {
+                int difference = abs((int) ((actual >> shift) & 0xFF) - (int) ((wanted >> shift) & 0xFF));
+                if (difference > tolerance) {
+                    num_different++;
+                    break;
+                }
             }
         }
+    }
 
-        // Check if the mouse is hovering over the save button
-        hover_save = is_mouse_inside_button(mouse_x, mouse_y, save_button);
+    SDL_FreeSurface(expected);
+    return num_different;
+}
 
-        // Check if the mouse is hovering over the exit button
-        hover_exit = is_mouse_inside_button(mouse_x, mouse_y, exit_button);
+int run_render_test(void) {
+    const GameOptions *options = get_game_options();
 
-        // Render the save button
-        SDL_Color save_button_color = hover_save ? (SDL_Color) {255, 255, 0, 255} : (SDL_Color) {255, 255, 255, 255};
-        render_colored_text(renderer, "Save", font, save_button.x, save_button.y, save_button_color.r,
-                            save_button_color.g, save_button_color.b);
+    // Render without a display, unless a video driver is forced with SDL_VIDEODRIVER
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
+        SDL_Quit();
+        return 1;
+    }
+    if (TTF_Init() == -1) {
+        printf("TTF_Init: %s\n", TTF_GetError());
+        IMG_Quit();
+        SDL_Quit();
+        return 1;
+    }
 
-        // Render the exit button
-        SDL_Color exit_button_color = hover_exit ? (SDL_Color) {255, 255, 0, 255} : (SDL_Color) {255, 255, 255, 255};
-        render_colored_text(renderer, "Exit", font, exit_button.x, exit_button.y, exit_button_color.r,
-                            exit_button_color.g, exit_button_color.b);
+    // Create the offscreen renderer with the size of the game window, and the font and scripted state
+    TTF_Font *font = NULL;
+    RenderTestState state;
+    bool initialized = init_headless_scene_manager(800, 600);
+    if (initialized) {
+        font = TTF_OpenFontRW(open_asset("Assets/Fonts/cambria.ttc"), 1, 24);
+        if (font == NULL) {
+            printf("TTF_OpenFont: %s\n", TTF_GetError());
+        }
+        initialized = font != NULL && init_render_test_state(&state, get_scene_renderer());
+    }
 
-        // Check if the mouse is hovering over the exit button
-        hover_exit = is_mouse_inside_button(mouse_x, mouse_y, exit_button);
+    int failures = initialized ? 0 : 1;
+    SDL_Renderer *renderer = get_scene_renderer();
+    GameTextures *textures = get_scene_textures();
+    int num_frames = options->render_test_frames;
+    float *frame_times = initialized ? malloc(num_frames * sizeof(float)) : NULL;
+    if (initialized && frame_times == NULL) {
+        printf("Error allocating frame times.\n");
+        failures = 1;
+    }
 
-        // Render the "Finish turn" button if the current player has shot and can't shoot anymore
-        if (!current_player->can_shoot && current_player->has_shot) {
-            // Check if the mouse is hovering over the "Finish turn" button
-            hover_finish_turn = is_mouse_inside_button(mouse_x, mouse_y, finish_turn_button);
+    for (int scene = 0; scene < RENDER_TEST_SCENE_COUNT && frame_times != NULL; scene++) {
+        const char *name = render_test_scene_names[scene];
+        begin_screen_stats(name);
 
-            // Render the "Finish turn" button
-            render_finish_turn_button(renderer, font, finish_turn_button, hover_finish_turn);
+        // The main menu is drawn in the top-left corner, with the size of its window
+        SDL_Rect viewport = {0, 0, 800, 600};
+        if (scene == RENDER_TEST_MAIN_MENU) {
+            viewport.w = 320;
+            viewport.h = 320;
+        }
+        SDL_RenderSetViewport(renderer, &viewport);
+
+        // Render the frames, the first one also fills the caches
+        clock_t cpu_start = clock();
+        for (int i = 0; i < num_frames; i++) {
+            Uint64 frame_start = SDL_GetPerformanceCounter();
+            render_test_scene(renderer, textures, font, (RenderTestScene) scene, &state);
+            SDL_RenderFlush(renderer);
+            frame_times[i] = (float) ((double) (SDL_GetPerformanceCounter() - frame_start) * 1000.0 /
+                                      (double) SDL_GetPerformanceFrequency());
+        }
+        double cpu_time = (double) (clock() - cpu_start) * 1000.0 / CLOCKS_PER_SEC / num_frames;
+        qsort(frame_times, num_frames, sizeof(float), compare_floats);
+
+        // Read back the last frame
+        SDL_Surface *frame = SDL_CreateRGBSurfaceWithFormat(0, viewport.w, viewport.h, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (frame == NULL || SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, frame->pixels,
+                                                  frame->pitch) != 0) {
+            printf("%s: FAIL, frame could not be read: %s\n", name, SDL_GetError());
+            SDL_FreeSurface(frame);
+            failures++;
+            continue;
         }
 
-        // Update the screen
-        SDL_RenderPresent(renderer);
-        SDL_Delay(1000 / 60); // Limit frame rate to 60 FPS
-
-        // Handle game screen events
-        handle_game_screen_events(&event, renderer, textures, font, current_player, opponent, &running,
-                                  finish_turn_button, &hover_save, &hover_exit, ai_state);
+        // Dump the frame
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.png", options->render_test_dir, name);
+        if (IMG_SavePNG(frame, path) != 0) {
+            printf("%s: could not save %s: %s\n", name, path, IMG_GetError());
+        }
 
-        // Change the current turn
-        if (current_player->is_turn == false) {
-            *current_turn = *current_turn == 1 ? 2 : 1;
-            update_window_title(window, *current_turn);
+        // Compare it with the golden image
+        const char *result = "DUMPED";
+        int num_different = 0;
+        if (options->golden_dir != NULL) {
+            snprintf(path, sizeof(path), "%s/%s.png", options->golden_dir, name);
+            SDL_Surface *golden = IMG_Load(path);
+            if (golden == NULL) {
+                printf("%s: golden image %s could not be loaded: %s\n", name, path, IMG_GetError());
+                num_different = -1;
+            } else {
+                num_different = compare_frame_with_golden(frame, golden, RENDER_TEST_TOLERANCE);
+                SDL_FreeSurface(golden);
+            }
+            result = num_different == 0 ? "PASS" : "FAIL";
+            if (num_different != 0) {
+                failures++;
+            }
         }
+        SDL_FreeSurface(frame);
+
+        printf("%s: %s (%d pixels differ), %d frames, p50 %.3f ms, p99 %.3f ms, cpu %.3f ms/frame\n", name, result,
+               num_different, num_frames, frame_times[(num_frames - 1) * 50 / 100],
+               frame_times[(num_frames - 1) * 99 / 100], cpu_time);
     }
 
     // Free resources
-    SDL_FreeSurface(black_surface);
-    SDL_DestroyTexture(black_texture);
-    SDL_DestroyTexture(background_texture);
-}
-
-void cleanup(GameTextures *textures, SDL_Renderer *renderer, TTF_Font *font, SDL_Window *window) {
-    free(textures);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
+    set_render_profiling(false);
+    free(frame_times);
+    if (initialized) {
+        destroy_render_test_state(&state);
+    }
+    shutdown_scene_manager();
+    if (font != NULL) {
+        TTF_CloseFont(font);
+    }
+    TTF_Quit();
     IMG_Quit();
     SDL_Quit();
+    return failures == 0 ? 0 : 1;
+}
+
+void cleanup(TTF_Font *font) {
+    set_render_profiling(false);
+    stop_save_worker();
+    stop_net_session();
+    stop_computer_engine();
+    unload_computer_policy();
+    stop_decode_pool();
+    shutdown_scene_manager();
     TTF_CloseFont(font);
     TTF_Quit();
+    IMG_Quit();
+    SDL_Quit();
+    close_assets();
 }
@@ -0,0 +1,437 @@
+#include "net.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+/// \brief Packs a ship into two bytes.
+///
+/// \param ship A pointer to the NetShip to pack.
+/// \param buffer The buffer receiving the two bytes.
+/// \return void
+static void pack_ship(const NetShip *ship, uint8_t *buffer);
+
+/// \brief Unpacks a ship from two bytes.
+///
+/// \param buffer The two bytes.
+/// \param ship A pointer to the NetShip receiving the ship.
+/// \return bool Returns true if the ship is valid, false otherwise.
+static bool unpack_ship(const uint8_t *buffer, NetShip *ship);
+
+/// \brief Makes a socket non-blocking and disables Nagle's algorithm, so small messages are sent at once.
+///
+/// \param socket The socket.
+/// \return bool Returns true on success, false otherwise.
+static bool configure_socket(NetSocket socket);
+
+/// \brief Checks whether the last socket call failed only because it would block.
+///
+/// \return bool Returns true if the call would block, false otherwise.
+static bool would_block(void);
+
+size_t encode_net_message(const NetMessage *message, uint8_t *buffer) {
+    size_t size = 0;
+    buffer[size++] = (uint8_t) message->type;
+
+    switch (message->type) {
+        case NET_MSG_FLEET:
+            memcpy(buffer + size, message->commitment, NET_COMMITMENT_SIZE);
+            size += NET_COMMITMENT_SIZE;
+            break;
+
+        case NET_MSG_SHOT:
+            buffer[size++] = (uint8_t) (message->x * NET_BOARD_SIZE + message->y);
+            break;
+
+        case NET_MSG_RESULT:
+            buffer[size++] = (uint8_t) (message->x * NET_BOARD_SIZE + message->y);
+            buffer[size++] = (uint8_t) message->result;
+            if (message->result == NET_RESULT_SUNK) {
+                pack_ship(&message->ship, buffer + size);
+                size += 2;
+            }
+            break;
+
+        case NET_MSG_RESIGN:
+            break;
+
+        case NET_MSG_REVEAL:
+            memcpy(buffer + size, message->salt, NET_SALT_SIZE);
+            size += NET_SALT_SIZE;
+            for (int i = 0; i < NET_FLEET_SIZE; i++) {
+                pack_ship(&message->fleet[i], buffer + size);
+                size += 2;
+            }
+            break;
+
+        case NET_MSG_PLACE:
+            buffer[size++] = (uint8_t) message->mode;
+            for (int i = 0; i < NET_FLEET_SIZE; i++) {
+                pack_ship(&message->fleet[i], buffer + size);
+                size += 2;
+            }
+            break;
+
+        case NET_MSG_START:
+        case NET_MSG_GAME_OVER:
+            buffer[size++] = message->seat;
+            break;
+
+        case NET_MSG_SPECTATE:
+            buffer[size++] = (uint8_t) (message->match & 0xFF);
+            buffer[size++] = (uint8_t) (message->match >> 8);
+            break;
+
+        case NET_MSG_SNAPSHOT:
+            buffer[size++] = message->seat;
+            buffer[size++] = (uint8_t) (message->remaining_ships[0] | (message->remaining_ships[1] << 4));
+            for (int board = 0; board < 2; board++) {
+                // Four cells per byte
+                for (int i = 0; i < NET_NUM_CELLS; i += 4) {
+                    buffer[size++] = (uint8_t) (message->view[board][i] | (message->view[board][i + 1] << 2) |
+                                                (message->view[board][i + 2] << 4) |
+                                                (message->view[board][i + 3] << 6));
+                }
+            }
+            break;
+
+        case NET_MSG_DELTA:
+            buffer[size++] = (uint8_t) (message->seat | (message->result << 2));
+            buffer[size++] = (uint8_t) (message->x * NET_BOARD_SIZE + message->y);
+            if (message->result == NET_RESULT_SUNK) {
+                pack_ship(&message->ship, buffer + size);
+                size += 2;
+            }
+            break;
+    }
+
+    return size;
+}
+
+int decode_net_message(const uint8_t *buffer, size_t size, NetMessage *message) {
+    if (size == 0) {
+        return 0;
+    }
+    memset(message, 0, sizeof(NetMessage));
+    message->type = (NetMessageType) buffer[0];
+
+    // Find the size of the message from its type
+    size_t message_size;
+    switch (message->type) {
+        case NET_MSG_FLEET:
+            message_size = 1 + NET_COMMITMENT_SIZE;
+            break;
+        case NET_MSG_SHOT:
+            message_size = 2;
+            break;
+        case NET_MSG_RESULT:
+            if (size < 3) {
+                return 0;
+            }
+            message_size = buffer[2] == NET_RESULT_SUNK ? 5 : 3;
+            break;
+        case NET_MSG_RESIGN:
+            message_size = 1;
+            break;
+        case NET_MSG_REVEAL:
+            message_size = 1 + NET_SALT_SIZE + 2 * NET_FLEET_SIZE;
+            break;
+        case NET_MSG_PLACE:
+            message_size = 2 + 2 * NET_FLEET_SIZE;
+            break;
+        case NET_MSG_START:
+        case NET_MSG_GAME_OVER:
+            message_size = 2;
+            break;
+        case NET_MSG_SPECTATE:
+            message_size = 3;
+            break;
+        case NET_MSG_SNAPSHOT:
+            message_size = NET_SNAPSHOT_SIZE;
+            break;
+        case NET_MSG_DELTA:
+            if (size < 2) {
+                return 0;
+            }
+            message_size = (buffer[1] >> 2) == NET_RESULT_SUNK ? 5 : 3;
+            break;
+        default:
+            return -1;
+    }
+    if (size < message_size) {
+        return 0;
+    }
+
+    // Decode and check the fields
+    if (message->type == NET_MSG_FLEET) {
+        memcpy(message->commitment, buffer + 1, NET_COMMITMENT_SIZE);
+    } else if (message->type == NET_MSG_SHOT || message->type == NET_MSG_RESULT) {
+        if (buffer[1] >= NET_BOARD_SIZE * NET_BOARD_SIZE) {
+            return -1;
+        }
+        message->x = buffer[1] / NET_BOARD_SIZE;
+        message->y = buffer[1] % NET_BOARD_SIZE;
+
+        if (message->type == NET_MSG_RESULT) {
+            if (buffer[2] > NET_RESULT_SUNK) {
+                return -1;
+            }
+            message->result = (NetShotResult) buffer[2];
+            if (message->result == NET_RESULT_SUNK && !unpack_ship(buffer + 3, &message->ship)) {
+                return -1;
+            }
+        }
+    } else if (message->type == NET_MSG_REVEAL) {
+        memcpy(message->salt, buffer + 1, NET_SALT_SIZE);
+        for (int i = 0; i < NET_FLEET_SIZE; i++) {
+            if (!unpack_ship(buffer + 1 + NET_SALT_SIZE + 2 * i, &message->fleet[i])) {
+                return -1;
+            }
+        }
+    } else if (message->type == NET_MSG_PLACE) {
+        if (buffer[1] > NET_MODE_AI) {
+            return -1;
+        }
+        message->mode = (NetMatchMode) buffer[1];
+        for (int i = 0; i < NET_FLEET_SIZE; i++) {
+            if (!unpack_ship(buffer + 2 + 2 * i, &message->fleet[i])) {
+                return -1;
+            }
+        }
+    } else if (message->type == NET_MSG_START || message->type == NET_MSG_GAME_OVER) {
+        if (buffer[1] < 1 || buffer[1] > 2) {
+            return -1;
+        }
+        message->seat = buffer[1];
+    } else if (message->type == NET_MSG_SPECTATE) {
+        message->match = (uint16_t) (buffer[1] | (buffer[2] << 8));
+    } else if (message->type == NET_MSG_SNAPSHOT) {
+        message->seat = buffer[1];
+        message->remaining_ships[0] = buffer[2] & 0x0F;
+        message->remaining_ships[1] = buffer[2] >> 4;
+        if (message->seat < 1 || message->seat > 2 || message->remaining_ships[0] > NET_FLEET_SIZE ||
+            message->remaining_ships[1] > NET_FLEET_SIZE) {
+            return -1;
+        }
+        for (int board = 0; board < 2; board++) {
+            for (int i = 0; i < NET_NUM_CELLS; i++) {
+                message->view[board][i] = (buffer[3 + board * NET_NUM_CELLS / 4 + i / 4] >> (2 * (i % 4))) & 0x03;
+            }
+        }
+    } else if (message->type == NET_MSG_DELTA) {
+        message->seat = buffer[1] & 0x03;
+        message->result = (NetShotResult) (buffer[1] >> 2);
+        if (message->seat < 1 || message->seat > 2 || message->result > NET_RESULT_SUNK ||
+            buffer[2] >= NET_NUM_CELLS) {
+            return -1;
+        }
+        message->x = buffer[2] / NET_BOARD_SIZE;
+        message->y = buffer[2] % NET_BOARD_SIZE;
+        if (message->result == NET_RESULT_SUNK && !unpack_ship(buffer + 3, &message->ship)) {
+            return -1;
+        }
+    }
+
+    return (int) message_size;
+}
+
+void compute_fleet_commitment(const uint8_t salt[NET_SALT_SIZE], const NetShip fleet[NET_FLEET_SIZE],
+                              uint8_t commitment[NET_COMMITMENT_SIZE]) {
+    // Hash the salt followed by the fleet as it is sent
+    uint8_t data[NET_SALT_SIZE + 2 * NET_FLEET_SIZE];
+    memcpy(data, salt, NET_SALT_SIZE);
+    for (int i = 0; i < NET_FLEET_SIZE; i++) {
+        pack_ship(&fleet[i], data + NET_SALT_SIZE + 2 * i);
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(data); i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    // Store the hash in little-endian order
+    for (int i = 0; i < NET_COMMITMENT_SIZE; i++) {
+        commitment[i] = (uint8_t) (hash >> (8 * i));
+    }
+}
+
+static void pack_ship(const NetShip *ship, uint8_t *buffer) {
+    buffer[0] = (uint8_t) (ship->index | (ship->orientation << 7));
+    buffer[1] = (uint8_t) (ship->x * NET_BOARD_SIZE + ship->y);
+}
+
+static bool unpack_ship(const uint8_t *buffer, NetShip *ship) {
+    ship->index = buffer[0] & 0x7F;
+    ship->orientation = buffer[0] >> 7;
+    ship->x = buffer[1] / NET_BOARD_SIZE;
+    ship->y = buffer[1] % NET_BOARD_SIZE;
+    return ship->index < NET_FLEET_SIZE && buffer[1] < NET_BOARD_SIZE * NET_BOARD_SIZE;
+}
+
+bool net_startup(void) {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+void net_shutdown(void) {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+NetSocket net_listen(uint16_t port) {
+    NetSocket listener = (NetSocket) socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+
+    // Allow the port to be reused right after a previous game
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *) &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0 ||
+        !configure_socket(listener)) {
+        net_close(listener);
+        return NET_INVALID_SOCKET;
+    }
+
+    return listener;
+}
+
+NetSocket net_accept(NetSocket listener) {
+    NetSocket client = (NetSocket) accept(listener, NULL, NULL);
+    if (client == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+
+    if (!configure_socket(client)) {
+        net_close(client);
+        return NET_INVALID_SOCKET;
+    }
+    return client;
+}
+
+NetSocket net_connect(const char *host, uint16_t port) {
+    // Resolve the host
+    char port_text[8];
+    snprintf(port_text, sizeof(port_text), "%u", (unsigned int) port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addresses;
+    if (getaddrinfo(host, port_text, &hints, &addresses) != 0) {
+        return NET_INVALID_SOCKET;
+    }
+
+    // Start connecting to the first address, the connection completes in the background
+    NetSocket connection = (NetSocket) socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+    if (connection != NET_INVALID_SOCKET &&
+        (!configure_socket(connection) ||
+         (connect(connection, addresses->ai_addr, (int) addresses->ai_addrlen) != 0 && !would_block()))) {
+        net_close(connection);
+        connection = NET_INVALID_SOCKET;
+    }
+
+    freeaddrinfo(addresses);
+    return connection;
+}
+
+bool net_finish_connect(NetSocket socket) {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    return getsockopt(socket, SOL_SOCKET, SO_ERROR, (char *) &error, &length) == 0 && error == 0;
+}
+
+int net_wait(NetSocket socket, bool write, int timeout) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(socket, &set);
+    struct timeval time = {timeout / 1000, (timeout % 1000) * 1000};
+
+    // The first argument is ignored on Windows
+    int result = select((int) socket + 1, write ? NULL : &set, write ? &set : NULL, NULL, &time);
+    return result > 0 ? 1 : result;
+}
+
+int net_send(NetSocket socket, const void *data, size_t size) {
+#ifdef _WIN32
+    int sent = send(socket, (const char *) data, (int) size, 0);
+#else
+    int sent = (int) send(socket, data, size, MSG_NOSIGNAL);
+#endif
+    if (sent < 0) {
+        return would_block() ? 0 : -1;
+    }
+    return sent;
+}
+
+int net_receive(NetSocket socket, void *buffer, size_t size) {
+#ifdef _WIN32
+    int received = recv(socket, (char *) buffer, (int) size, 0);
+#else
+    int received = (int) recv(socket, buffer, size, 0);
+#endif
+    if (received < 0) {
+        return would_block() ? 0 : -1;
+    }
+
+    // A connection closed by the other side reads as 0 bytes
+    return received == 0 ? -1 : received;
+}
+
+void net_close(NetSocket socket) {
+    if (socket == NET_INVALID_SOCKET) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static bool configure_socket(NetSocket socket) {
+    int no_delay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *) &no_delay, sizeof(no_delay));
+
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    return ioctlsocket(socket, FIONBIO, &non_blocking) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool would_block(void) {
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+#endif
+}
@@ -0,0 +1,198 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NET_DEFAULT_PORT 27015
+#define NET_BOARD_SIZE 10
+#define NET_FLEET_SIZE 5
+#define NET_COMMITMENT_SIZE 8
+#define NET_SALT_SIZE 8
+#define NET_NUM_CELLS (NET_BOARD_SIZE * NET_BOARD_SIZE)
+#define NET_SNAPSHOT_SIZE (3 + 2 * NET_NUM_CELLS / 4)
+#define NET_MAX_MESSAGE_SIZE NET_SNAPSHOT_SIZE
+#define NET_ANY_MATCH 0xFFFF
+
+#ifdef _WIN32
+typedef uintptr_t NetSocket;
+#else
+typedef int NetSocket;
+#endif
+#define NET_INVALID_SOCKET ((NetSocket) -1)
+
+// Enum for the types of messages, sent as the first byte of each message
+typedef enum {
+    NET_MSG_FLEET = 1,
+    NET_MSG_SHOT,
+    NET_MSG_RESULT,
+    NET_MSG_RESIGN,
+    NET_MSG_REVEAL,
+    NET_MSG_PLACE,
+    NET_MSG_START,
+    NET_MSG_GAME_OVER,
+    NET_MSG_SPECTATE,
+    NET_MSG_SNAPSHOT,
+    NET_MSG_DELTA
+} NetMessageType;
+
+// Enum for the results of a shot
+typedef enum {
+    NET_RESULT_MISS,
+    NET_RESULT_HIT,
+    NET_RESULT_SUNK
+} NetShotResult;
+
+// Enum for what a spectator knows of a cell, the fleets stay hidden until their ships are sunk
+typedef enum {
+    NET_CELL_UNKNOWN,
+    NET_CELL_MISS,
+    NET_CELL_HIT,
+    NET_CELL_SUNK
+} NetCellView;
+
+// Enum for the opponents a match server can pair a player with
+typedef enum {
+    NET_MODE_PVP,
+    NET_MODE_AI
+} NetMatchMode;
+
+// Structure for the position of a ship as it is sent, packed into two bytes
+typedef struct {
+    uint8_t index;
+    uint8_t orientation;
+    uint8_t x;
+    uint8_t y;
+} NetShip;
+
+// Structure for a decoded message, only the fields of its type are meaningful
+//
+// FLEET (9 bytes): commitment to the fleet, sent once the fleet is placed.
+// SHOT (2 bytes): x and y of a shot at the board of the receiver.
+// RESULT (3 bytes, 5 if a ship was sunk): x, y and result of the last shot of the receiver, and the sunk ship.
+// RESIGN (1 byte): the sender leaves the game.
+// REVEAL (19 bytes): salt and fleet behind the commitment, sent when the game ends.
+//
+// Between a player and a match server, which knows both fleets, FLEET and REVEAL are not used:
+// PLACE (12 bytes): mode and fleet in clear, sent to join a match.
+// START (2 bytes): seat of the receiver, seat 1 shoots first. SHOT and RESULT are then used as above.
+// GAME_OVER (2 bytes): seat of the winner.
+//
+// Spectators of a match server:
+// SPECTATE (3 bytes): match to follow, or NET_ANY_MATCH for the latest one. Without a live match the spectator
+// follows the next match to start.
+// SNAPSHOT (53 bytes): seat whose turn it is, remaining ships and the view of both boards, two bits per cell.
+// DELTA (3 bytes, 5 if a ship was sunk): seat shooting, result, cell and the sunk ship. GAME_OVER ends the stream.
+typedef struct {
+    NetMessageType type;
+    uint8_t x;
+    uint8_t y;
+    NetShotResult result;
+    NetMatchMode mode;
+    uint8_t seat;
+    uint16_t match;
+    uint8_t remaining_ships[2];
+    uint8_t view[2][NET_NUM_CELLS];
+    NetShip ship;
+    uint8_t commitment[NET_COMMITMENT_SIZE];
+    uint8_t salt[NET_SALT_SIZE];
+    NetShip fleet[NET_FLEET_SIZE];
+} NetMessage;
+
+/// \brief Encodes a message.
+///
+/// \param message A pointer to the NetMessage to encode.
+/// \param buffer The buffer receiving the message, at least NET_MAX_MESSAGE_SIZE bytes long.
+/// \return size_t The size of the encoded message.
+size_t encode_net_message(const NetMessage *message, uint8_t *buffer);
+
+/// \brief Decodes the first message of a buffer.
+///
+/// \param buffer The received bytes.
+/// \param size The number of received bytes.
+/// \param message A pointer to the NetMessage receiving the decoded message.
+/// \return int The size of the message, 0 if the buffer does not hold a whole message yet, or -1 if it is invalid.
+int decode_net_message(const uint8_t *buffer, size_t size, NetMessage *message);
+
+/// \brief Computes the commitment of a fleet.
+///
+/// The commitment is a 64-bit FNV-1a hash of the salt and the packed fleet. It lets the opponent check at the
+/// end of the game that the results it was sent match the fleet that was placed; it is not a cryptographic
+/// commitment.
+///
+/// \param salt The random salt, kept secret until the fleet is revealed.
+/// \param fleet The positions of the ships.
+/// \param commitment The buffer receiving the commitment.
+/// \return void
+void compute_fleet_commitment(const uint8_t salt[NET_SALT_SIZE], const NetShip fleet[NET_FLEET_SIZE],
+                              uint8_t commitment[NET_COMMITMENT_SIZE]);
+
+/// \brief Initializes the socket library.
+///
+/// \return bool Returns true if sockets can be used, false otherwise.
+bool net_startup(void);
+
+/// \brief Releases the socket library.
+///
+/// \return void
+void net_shutdown(void);
+
+/// \brief Creates a non-blocking socket listening on a port of all addresses, with the largest backlog allowed.
+///
+/// \param port The port to listen on.
+/// \return NetSocket The listening socket, or NET_INVALID_SOCKET on failure.
+NetSocket net_listen(uint16_t port);
+
+/// \brief Accepts a pending connection.
+///
+/// \param listener The listening socket.
+/// \return NetSocket The non-blocking connected socket, or NET_INVALID_SOCKET if no connection is pending.
+NetSocket net_accept(NetSocket listener);
+
+/// \brief Starts connecting a non-blocking socket.
+///
+/// The connection is established once the socket is writable, see net_finish_connect.
+///
+/// \param host The name or address of the host.
+/// \param port The port of the host.
+/// \return NetSocket The connecting socket, or NET_INVALID_SOCKET on failure.
+NetSocket net_connect(const char *host, uint16_t port);
+
+/// \brief Checks whether a connection started with net_connect succeeded, once the socket is writable.
+///
+/// \param socket The connecting socket.
+/// \return bool Returns true if the socket is connected, false if the connection failed.
+bool net_finish_connect(NetSocket socket);
+
+/// \brief Waits until a socket is readable or writable.
+///
+/// \param socket The socket.
+/// \param write Whether to wait until the socket is writable instead of readable.
+/// \param timeout The longest time to wait, in milliseconds.
+/// \return int 1 if the socket is ready, 0 on timeout, or -1 on error.
+int net_wait(NetSocket socket, bool write, int timeout);
+
+/// \brief Sends bytes on a non-blocking socket.
+///
+/// \param socket The connected socket.
+/// \param data The bytes to send.
+/// \param size The number of bytes.
+/// \return int The number of bytes sent, 0 if the socket would block, or -1 on error.
+int net_send(NetSocket socket, const void *data, size_t size);
+
+/// \brief Receives bytes from a non-blocking socket.
+///
+/// \param socket The connected socket.
+/// \param buffer The buffer receiving the bytes.
+/// \param size The size of the buffer.
+/// \return int The number of bytes received, 0 if no bytes are available, or -1 if the connection was closed.
+int net_receive(NetSocket socket, void *buffer, size_t size);
+
+/// \brief Closes a socket.
+///
+/// \param socket The socket to close, NET_INVALID_SOCKET is ignored.
+/// \return void
+void net_close(NetSocket socket);
+
+#endif // NET_H
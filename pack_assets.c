@@ -0,0 +1,222 @@
+#define SDL_MAIN_HANDLED
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "asset_bundle.h"
+
+#define MAX_ASSETS 128
+#define NUM_BACKGROUND_FRAMES 50
+
+// Structure for an asset to pack, with the size it is scaled to (0 to store the file as it is)
+typedef struct {
+    char name[ASSET_NAME_LENGTH];
+    int width;
+    int height;
+} AssetSource;
+
+/// \brief Adds an asset to the list of assets to pack.
+///
+/// \param assets The list of assets.
+/// \param num_assets A pointer to the number of assets in the list.
+/// \param name The path of the asset, also used as its name in the bundle.
+/// \param width The width the image is scaled to, or 0 to store the file as it is.
+/// \param height The height the image is scaled to, or 0 to store the file as it is.
+/// \return void
+void add_asset(AssetSource *assets, int *num_assets, const char *name, int width, int height);
+
+/// \brief Compares two assets by name for qsort.
+///
+/// \param a A pointer to the first AssetSource.
+/// \param b A pointer to the second AssetSource.
+/// \return int The order of the names.
+int compare_assets(const void *a, const void *b);
+
+/// \brief Writes padding until the position of the file is aligned.
+///
+/// \param file The SDL_RWops of the bundle file.
+/// \return bool Returns true if the padding was written, false otherwise.
+bool align_output(SDL_RWops *file);
+
+/// \brief Copies a file into the bundle as it is.
+///
+/// \param file The SDL_RWops of the bundle file.
+/// \param asset The asset to copy.
+/// \return bool Returns true if the file was copied, false otherwise.
+bool write_raw_asset(SDL_RWops *file, const AssetSource *asset);
+
+/// \brief Decodes an image, scales it to the size of the asset and writes it into the bundle.
+///
+/// JPEG images are encoded as JPEG again and other images as PNG, so the bundle stays small.
+///
+/// \param file The SDL_RWops of the bundle file.
+/// \param asset The asset to scale.
+/// \return bool Returns true if the image was written, false otherwise.
+bool write_scaled_asset(SDL_RWops *file, const AssetSource *asset);
+
+/// \brief Packs the game assets into a bundle file.
+///
+/// Usage: pack_assets <output file>. Must be run from the game directory, the asset names are the paths the
+/// game loads them from.
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 on success, 1 on failure.
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        printf("Usage: %s <output file>\n", argv[0]);
+        return 1;
+    }
+
+    if (!(IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) & IMG_INIT_PNG)) {
+        printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
+        return 1;
+    }
+
+    // List the assets, the backgrounds are scaled to the size of the window they are shown in
+    AssetSource assets[MAX_ASSETS];
+    int num_assets = 0;
+    const char *tile_files[] = {
+            "Assets/ocean.png", "Assets/ocean_selection_mode.png", "Assets/ship_top.png", "Assets/ship_left.png",
+            "Assets/ship_middle.png", "Assets/ship_right.png", "Assets/ship_bottom.png", "Assets/hit_enemy_ship.png",
+            "Assets/hit_own_ship.png", "Assets/hit_ocean.png", "Assets/miss.png"
+    };
+    for (int i = 0; i < (int) (sizeof(tile_files) / sizeof(tile_files[0])); i++) {
+        add_asset(assets, &num_assets, tile_files[i], 0, 0);
+    }
+    add_asset(assets, &num_assets, "Assets/Fonts/cambria.ttc", 0, 0);
+    add_asset(assets, &num_assets, "Assets/game_screen_background.jpeg", 800, 600);
+    add_asset(assets, &num_assets, "Assets/selecting_screen_background.jpg", 800, 600);
+    for (int i = 0; i < NUM_BACKGROUND_FRAMES; i++) {
+        char name[ASSET_NAME_LENGTH];
+        snprintf(name, sizeof(name), "Assets/Backgrounds/frame_%d.png", i);
+        add_asset(assets, &num_assets, name, 320, 320);
+    }
+    qsort(assets, num_assets, sizeof(AssetSource), compare_assets);
+
+    // Write to a temporary file, so a failed run does not leave a broken bundle behind
+    char temp_name[256];
+    snprintf(temp_name, sizeof(temp_name), "%s.tmp", argv[1]);
+    SDL_RWops *file = SDL_RWFromFile(temp_name, "wb");
+    if (file == NULL) {
+        printf("Error creating %s: %s\n", temp_name, SDL_GetError());
+        return 1;
+    }
+
+    // Reserve space for the header and the entry table, they are written once the offsets are known
+    AssetBundleHeader header = {{0}, ASSET_BUNDLE_VERSION, (uint32_t) num_assets, 0};
+    memcpy(header.magic, ASSET_BUNDLE_MAGIC, 4);
+    AssetBundleEntry entries[MAX_ASSETS];
+    memset(entries, 0, sizeof(entries));
+    size_t table_size = sizeof(AssetBundleHeader) + num_assets * sizeof(AssetBundleEntry);
+    SDL_RWseek(file, (Sint64) table_size, RW_SEEK_SET);
+
+    // Write the data of each asset
+    bool success = true;
+    for (int i = 0; i < num_assets && success; i++) {
+        success = align_output(file);
+        Sint64 offset = SDL_RWtell(file);
+        if (success) {
+            success = assets[i].width > 0 ? write_scaled_asset(file, &assets[i]) : write_raw_asset(file, &assets[i]);
+        }
+
+        snprintf(entries[i].name, ASSET_NAME_LENGTH, "%s", assets[i].name);
+        entries[i].offset = (uint64_t) offset;
+        entries[i].size = (uint64_t) (SDL_RWtell(file) - offset);
+    }
+
+    // Write the header and the entry table
+    if (success) {
+        SDL_RWseek(file, 0, RW_SEEK_SET);
+        success = SDL_RWwrite(file, &header, sizeof(header), 1) == 1 &&
+                  SDL_RWwrite(file, entries, sizeof(AssetBundleEntry), num_assets) == (size_t) num_assets;
+    }
+    Sint64 bundle_size = SDL_RWsize(file);
+    if (SDL_RWclose(file) != 0) {
+        success = false;
+    }
+
+    if (!success) {
+        printf("Error writing asset bundle.\n");
+        remove(temp_name);
+        return 1;
+    }
+
+    // Replace the previous bundle
+    remove(argv[1]);
+    if (rename(temp_name, argv[1]) != 0) {
+        printf("Error renaming %s to %s\n", temp_name, argv[1]);
+        return 1;
+    }
+
+    printf("Packed %d assets into %s (%lld bytes).\n", num_assets, argv[1], (long long) bundle_size);
+    IMG_Quit();
+    return 0;
+}
+
+void add_asset(AssetSource *assets, int *num_assets, const char *name, int width, int height) {
+    AssetSource *asset = &assets[(*num_assets)++];
+    snprintf(asset->name, ASSET_NAME_LENGTH, "%s", name);
+    asset->width = width;
+    asset->height = height;
+}
+
+int compare_assets(const void *a, const void *b) {
+    return strcmp(((const AssetSource *) a)->name, ((const AssetSource *) b)->name);
+}
+
+bool align_output(SDL_RWops *file) {
+    static const char padding[ASSET_DATA_ALIGNMENT] = {0};
+    Sint64 position = SDL_RWtell(file);
+    size_t padding_size = (size_t) ((ASSET_DATA_ALIGNMENT - position % ASSET_DATA_ALIGNMENT) % ASSET_DATA_ALIGNMENT);
+    return padding_size == 0 || SDL_RWwrite(file, padding, padding_size, 1) == 1;
+}
+
+bool write_raw_asset(SDL_RWops *file, const AssetSource *asset) {
+    // Read the whole file and append it
+    size_t size;
+    void *data = SDL_LoadFile(asset->name, &size);
+    if (data == NULL) {
+        printf("Error reading %s: %s\n", asset->name, SDL_GetError());
+        return false;
+    }
+
+    bool success = SDL_RWwrite(file, data, size, 1) == 1;
+    SDL_free(data);
+    return success;
+}
+
+bool write_scaled_asset(SDL_RWops *file, const AssetSource *asset) {
+    // Decode the image in a 32-bit format, the linear scaler needs the same format on both sides
+    SDL_Surface *image = IMG_Load(asset->name);
+    if (image == NULL) {
+        printf("Error loading %s: %s\n", asset->name, IMG_GetError());
+        return false;
+    }
+    SDL_Surface *source = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(image);
+    SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0, asset->width, asset->height, 32,
+                                                         SDL_PIXELFORMAT_ARGB8888);
+    if (source == NULL || scaled == NULL || SDL_SoftStretchLinear(source, NULL, scaled, NULL) != 0) {
+        printf("Error scaling %s: %s\n", asset->name, SDL_GetError());
+        SDL_FreeSurface(source);
+        SDL_FreeSurface(scaled);
+        return false;
+    }
+    SDL_FreeSurface(source);
+
+    // Encode the scaled image in the format of the source
+    const char *extension = strrchr(asset->name, '.');
+    bool is_jpeg = extension != NULL && (strcmp(extension, ".jpg") == 0 || strcmp(extension, ".jpeg") == 0);
+    int result = is_jpeg ? IMG_SaveJPG_RW(scaled, file, 0, 90) : IMG_SavePNG_RW(scaled, file, 0);
+    SDL_FreeSurface(scaled);
+    if (result != 0) {
+        printf("Error encoding %s: %s\n", asset->name, IMG_GetError());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,212 @@
+#include "policy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+// Eight floats processed at once, compiled to SSE, AVX or NEON instructions depending on the target
+typedef float PolicyVector __attribute__((vector_size(32)));
+#endif
+
+/// \brief Checks the sizes of the layers of a network.
+///
+/// \param num_layers The number of layers.
+/// \param sizes The num_layers + 1 sizes of the layers.
+/// \return bool Returns true if the sizes are valid, false otherwise.
+static bool is_policy_layout_valid(int num_layers, const int *sizes);
+
+/// \brief Adds a row of weights scaled by an input to the outputs of a layer.
+///
+/// \param outputs The outputs of the layer.
+/// \param row The weights from the input to each output.
+/// \param scale The value of the input.
+/// \param size The number of outputs.
+/// \return void
+static void add_scaled_row(float *outputs, const float *row, float scale, int size);
+
+bool allocate_policy_network(PolicyNetwork *network, int num_layers, const int *sizes) {
+    memset(network, 0, sizeof(PolicyNetwork));
+    if (!is_policy_layout_valid(num_layers, sizes)) {
+        return false;
+    }
+
+    // Count the parameters, the weights of each layer are followed by its biases
+    network->num_layers = num_layers;
+    for (int i = 0; i < num_layers; i++) {
+        network->sizes[i] = sizes[i];
+        network->num_parameters += (size_t) (sizes[i] + 1) * (size_t) sizes[i + 1];
+    }
+    network->sizes[num_layers] = sizes[num_layers];
+
+    network->parameters = calloc(network->num_parameters, sizeof(float));
+    if (network->parameters == NULL) {
+        return false;
+    }
+    float *parameter = network->parameters;
+    for (int i = 0; i < num_layers; i++) {
+        network->weights[i] = parameter;
+        parameter += (size_t) sizes[i] * (size_t) sizes[i + 1];
+        network->biases[i] = parameter;
+        parameter += sizes[i + 1];
+    }
+    return true;
+}
+
+bool load_policy_network(PolicyNetwork *network, const char *filename) {
+    memset(network, 0, sizeof(PolicyNetwork));
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        printf("Could not open the weights file %s.\n", filename);
+        return false;
+    }
+
+    // Check the header before allocating the layers it describes
+    PolicyFileHeader header;
+    int sizes[POLICY_MAX_LAYERS + 1] = {0};
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, POLICY_FILE_MAGIC, 4) == 0 &&
+                 header.version == POLICY_FILE_VERSION && header.num_layers >= 1 &&
+                 header.num_layers <= POLICY_MAX_LAYERS;
+    for (uint32_t i = 0; valid && i <= header.num_layers; i++) {
+        sizes[i] = header.sizes[i] <= POLICY_MAX_WIDTH ? (int) header.sizes[i] : 0;
+    }
+    if (!valid || !allocate_policy_network(network, (int) header.num_layers, sizes)) {
+        printf("%s is not a weights file of version %d.\n", filename, POLICY_FILE_VERSION);
+        fclose(file);
+        return false;
+    }
+
+    // The parameters are stored in the order of the array, with nothing after them
+    valid = fread(network->parameters, sizeof(float), network->num_parameters, file) == network->num_parameters &&
+            fgetc(file) == EOF;
+    fclose(file);
+    if (!valid) {
+        printf("The weights file %s is truncated or too long.\n", filename);
+        free_policy_network(network);
+        return false;
+    }
+    return true;
+}
+
+bool save_policy_network(const PolicyNetwork *network, const char *filename) {
+    PolicyFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POLICY_FILE_MAGIC, 4);
+    header.version = POLICY_FILE_VERSION;
+    header.num_layers = (uint32_t) network->num_layers;
+    for (int i = 0; i <= network->num_layers; i++) {
+        header.sizes[i] = (uint32_t) network->sizes[i];
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        printf("Could not create the weights file %s.\n", filename);
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(network->parameters, sizeof(float), network->num_parameters, file) ==
+                   network->num_parameters;
+    if (fclose(file) != 0 || !written) {
+        printf("Could not write the weights file %s.\n", filename);
+        return false;
+    }
+    return true;
+}
+
+void free_policy_network(PolicyNetwork *network) {
+    free(network->parameters);
+    memset(network, 0, sizeof(PolicyNetwork));
+}
+
+void get_policy_inputs(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS],
+                       float inputs[POLICY_NUM_INPUTS]) {
+    // A plane of the hit cells, sunk or not, then a plane of the missed cells
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        inputs[i] = view[i] == NET_CELL_HIT || view[i] == NET_CELL_SUNK ? 1.0f : 0.0f;
+        inputs[RULES_NUM_CELLS + i] = view[i] == NET_CELL_MISS ? 1.0f : 0.0f;
+    }
+    for (int i = 0; i < RULES_NUM_SHIPS; i++) {
+        inputs[2 * RULES_NUM_CELLS + i] = sunk_ships[i] ? 1.0f : 0.0f;
+    }
+}
+
+void evaluate_policy_network(const PolicyNetwork *network, const float *inputs, float *outputs) {
+    float activations[2][POLICY_MAX_WIDTH];
+    const float *layer_inputs = inputs;
+
+    for (int layer = 0; layer < network->num_layers; layer++) {
+        int num_inputs = network->sizes[layer];
+        int num_outputs = network->sizes[layer + 1];
+        bool last = layer == network->num_layers - 1;
+        float *layer_outputs = last ? outputs : activations[layer % 2];
+
+        // Start from the biases and add the rows of the inputs that are not zero
+        memcpy(layer_outputs, network->biases[layer], (size_t) num_outputs * sizeof(float));
+        const float *weights = network->weights[layer];
+        for (int i = 0; i < num_inputs; i++) {
+            if (layer_inputs[i] != 0.0f) {
+                add_scaled_row(layer_outputs, &weights[(size_t) i * num_outputs], layer_inputs[i], num_outputs);
+            }
+        }
+
+        // The hidden layers are followed by a ReLU
+        if (!last) {
+            for (int o = 0; o < num_outputs; o++) {
+                layer_outputs[o] = layer_outputs[o] > 0.0f ? layer_outputs[o] : 0.0f;
+            }
+        }
+        layer_inputs = layer_outputs;
+    }
+}
+
+bool choose_policy_shot(const PolicyNetwork *network, const uint8_t view[RULES_NUM_CELLS],
+                        const uint8_t sunk_ships[RULES_NUM_SHIPS], uint8_t *x, uint8_t *y) {
+    float inputs[POLICY_NUM_INPUTS];
+    float scores[POLICY_NUM_OUTPUTS];
+    get_policy_inputs(view, sunk_ships, inputs);
+    evaluate_policy_network(network, inputs, scores);
+
+    // Take the best cell that was not shot yet
+    int best = -1;
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if (view[i] == NET_CELL_UNKNOWN && (best < 0 || scores[i] > scores[best])) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    *x = (uint8_t) (best / RULES_BOARD_SIZE);
+    *y = (uint8_t) (best % RULES_BOARD_SIZE);
+    return true;
+}
+
+static bool is_policy_layout_valid(int num_layers, const int *sizes) {
+    if (num_layers < 1 || num_layers > POLICY_MAX_LAYERS || sizes[0] != POLICY_NUM_INPUTS ||
+        sizes[num_layers] != POLICY_NUM_OUTPUTS) {
+        return false;
+    }
+    for (int i = 0; i <= num_layers; i++) {
+        if (sizes[i] <= 0 || sizes[i] > POLICY_MAX_WIDTH) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void add_scaled_row(float *outputs, const float *row, float scale, int size) {
+    int o = 0;
+#if defined(__GNUC__)
+    // The rows are not aligned, the vectors are copied in and out
+    for (; o + 8 <= size; o += 8) {
+        PolicyVector output, weights;
+        memcpy(&output, &outputs[o], sizeof(output));
+        memcpy(&weights, &row[o], sizeof(weights));
+        output += weights * scale;
+        memcpy(&outputs[o], &output, sizeof(output));
+    }
+#endif
+    for (; o < size; o++) {
+        outputs[o] += row[o] * scale;
+    }
+}
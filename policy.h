@@ -0,0 +1,100 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "rules.h"
+
+#define POLICY_FILE_MAGIC "BSPW"
+#define POLICY_FILE_VERSION 1
+#define POLICY_NUM_INPUTS (2 * RULES_NUM_CELLS + RULES_NUM_SHIPS)
+#define POLICY_NUM_OUTPUTS RULES_NUM_CELLS
+#define POLICY_MAX_LAYERS 4
+#define POLICY_MAX_WIDTH 512
+
+// Header at the start of a weights file, followed by the parameters of each layer as little-endian float32
+//
+// Layer i has sizes[i] inputs and sizes[i + 1] outputs. Its weights are stored input by input, sizes[i] rows of
+// sizes[i + 1] floats, then its sizes[i + 1] biases. Every layer but the last is followed by a ReLU.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t num_layers;
+    uint32_t sizes[POLICY_MAX_LAYERS + 1];
+} PolicyFileHeader;
+
+// Structure for a shot policy: a small MLP from the observation of the opponent's board to a score per cell
+//
+// The inputs are the observation of env.h: a plane of the hit cells, a plane of the missed cells, then 1 for each
+// sunk ship. All parameters are in one array in the order of the file, the weights and biases point into it.
+typedef struct {
+    int num_layers;
+    int sizes[POLICY_MAX_LAYERS + 1];
+    size_t num_parameters;
+    float *parameters;
+    float *weights[POLICY_MAX_LAYERS];
+    float *biases[POLICY_MAX_LAYERS];
+} PolicyNetwork;
+
+/// \brief Allocates a network with all parameters set to zero.
+///
+/// \param network A pointer to the PolicyNetwork.
+/// \param num_layers The number of layers, at most POLICY_MAX_LAYERS.
+/// \param sizes The num_layers + 1 sizes of the layers, from POLICY_NUM_INPUTS to POLICY_NUM_OUTPUTS, each at most
+/// POLICY_MAX_WIDTH.
+/// \return bool Returns true if the network was allocated, false if the sizes are invalid or out of memory.
+bool allocate_policy_network(PolicyNetwork *network, int num_layers, const int *sizes);
+
+/// \brief Loads a network from a weights file.
+///
+/// \param network A pointer to the PolicyNetwork.
+/// \param filename The path to the weights file.
+/// \return bool Returns true if the file is a valid weights file of this version, false otherwise.
+bool load_policy_network(PolicyNetwork *network, const char *filename);
+
+/// \brief Writes a network to a weights file.
+///
+/// \param network A pointer to the PolicyNetwork.
+/// \param filename The path to the weights file.
+/// \return bool Returns true if the file was written, false otherwise.
+bool save_policy_network(const PolicyNetwork *network, const char *filename);
+
+/// \brief Frees the parameters of a network.
+///
+/// \param network A pointer to the PolicyNetwork.
+/// \return void
+void free_policy_network(PolicyNetwork *network);
+
+/// \brief Fills the inputs of the network from what the shooter knows of the opponent's board.
+///
+/// \param view The NetCellView of each cell of the board.
+/// \param sunk_ships Non-zero for each sunk ship, in the order of their indices.
+/// \param inputs The buffer receiving POLICY_NUM_INPUTS inputs.
+/// \return void
+void get_policy_inputs(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS],
+                       float inputs[POLICY_NUM_INPUTS]);
+
+/// \brief Runs the network on one observation.
+///
+/// Inputs and hidden units that are zero are skipped, most of the board is unknown and half of the units are cut
+/// by the ReLU, so a shot costs a fraction of the size of the network.
+///
+/// \param network A pointer to the PolicyNetwork.
+/// \param inputs The POLICY_NUM_INPUTS inputs.
+/// \param outputs The buffer receiving the POLICY_NUM_OUTPUTS scores, one per cell.
+/// \return void
+void evaluate_policy_network(const PolicyNetwork *network, const float *inputs, float *outputs);
+
+/// \brief Chooses the cell with the best score among the cells not shot yet.
+///
+/// \param network A pointer to the PolicyNetwork.
+/// \param view The NetCellView of each cell of the board.
+/// \param sunk_ships Non-zero for each sunk ship, in the order of their indices.
+/// \param x A pointer to the x-coordinate of the shot.
+/// \param y A pointer to the y-coordinate of the shot.
+/// \return bool Returns true if a cell was chosen, false if every cell was shot.
+bool choose_policy_shot(const PolicyNetwork *network, const uint8_t view[RULES_NUM_CELLS],
+                        const uint8_t sunk_ships[RULES_NUM_SHIPS], uint8_t *x, uint8_t *y);
+
+#endif // POLICY_H
@@ -0,0 +1,589 @@
+#include "rules.h"
+
+#include <string.h>
+
+// Sizes of the ships, the same as initialize_ships in the game
+static const int rules_ship_sizes[RULES_NUM_SHIPS] = {5, 4, 3, 3, 2};
+
+// Directions of the AI of the game: left, down, right and up
+static const int compact_ai_dx[4] = {-1, 0, 1, 0};
+static const int compact_ai_dy[4] = {0, 1, 0, -1};
+
+/// \brief Shuffles directions, like shuffle_directions in the game.
+///
+/// \param dir_indices The directions.
+/// \param size The number of directions.
+/// \param rng A pointer to the random number generator.
+/// \return void
+static void shuffle_compact_directions(int *dir_indices, int size, pcg32_random_t *rng);
+
+/// \brief Checks whether a cell keeps the minimum gap of the SEARCH state, like meets_min_gap in the game.
+///
+/// \param ai A pointer to the CompactAI.
+/// \param board A pointer to the CompactBoard that is shot at.
+/// \param cell_x The x-coordinate of the cell.
+/// \param cell_y The y-coordinate of the cell.
+/// \return bool Returns true if no missed cell and no hit on a ship smaller than the minimum gap is next to the cell.
+static bool meets_compact_min_gap(const CompactAI *ai, const CompactBoard *board, int cell_x, int cell_y);
+
+/// \brief Looks for the next cell of the TARGET and DESTROY states, like find_target_cell in the game.
+///
+/// \param ai A pointer to the CompactAI, its state turns to REVISIT or SEARCH once the directions are exhausted.
+/// \param board A pointer to the CompactBoard that is shot at.
+/// \param cell_x A pointer to the x-coordinate of the cell.
+/// \param cell_y A pointer to the y-coordinate of the cell.
+/// \return bool Returns true if a cell was found, false if the next direction or the new state must be tried.
+static bool find_compact_target_cell(CompactAI *ai, const CompactBoard *board, int *cell_x, int *cell_y);
+
+int get_rules_ship_size(int ship_index) {
+    return rules_ship_sizes[ship_index];
+}
+
+void clear_compact_board(CompactBoard *board) {
+    memset(board, 0, sizeof(CompactBoard));
+    board->remaining_ships = RULES_NUM_SHIPS;
+}
+
+bool is_compact_position_valid(const CompactBoard *board, int ship_size, int x, int y, int orientation) {
+    // Iterate through all cells of the ship
+    for (int k = 0; k < ship_size; k++) {
+        int cell_x = x + (orientation == 0 ? k : 0);
+        int cell_y = y + (orientation == 1 ? k : 0);
+
+        // Check if the cell is inside the grid and not already occupied
+        if (cell_x < 0 || cell_x >= RULES_BOARD_SIZE || cell_y < 0 || cell_y >= RULES_BOARD_SIZE ||
+            (board->cells[cell_x * RULES_BOARD_SIZE + cell_y] & RULES_CELL_SHIP) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool place_compact_fleet(CompactBoard *board, const NetShip fleet[RULES_NUM_SHIPS]) {
+    clear_compact_board(board);
+
+    for (int i = 0; i < RULES_NUM_SHIPS; i++) {
+        const NetShip *ship = &fleet[i];
+        int size = rules_ship_sizes[i];
+        if (ship->index != i || ship->orientation > 1 ||
+            !is_compact_position_valid(board, size, ship->x, ship->y, ship->orientation)) {
+            return false;
+        }
+
+        // Mark the cells of the ship
+        for (int k = 0; k < size; k++) {
+            int cell_x = ship->x + (ship->orientation == 0 ? k : 0);
+            int cell_y = ship->y + (ship->orientation == 1 ? k : 0);
+            board->cells[cell_x * RULES_BOARD_SIZE + cell_y] = (uint8_t) (i + 1);
+        }
+    }
+    return true;
+}
+
+void place_random_compact_fleet(CompactBoard *board, pcg32_random_t *rng, NetShip fleet[RULES_NUM_SHIPS]) {
+    NetShip ships[RULES_NUM_SHIPS];
+
+    // Place the ships one by one at random valid positions, like place_random_ships in the game
+    clear_compact_board(board);
+    for (int i = 0; i < RULES_NUM_SHIPS; i++) {
+        int size = rules_ship_sizes[i];
+        NetShip *ship = &ships[i];
+        ship->index = (uint8_t) i;
+        do {
+            ship->x = (uint8_t) pcg32_boundedrand_r(rng, RULES_BOARD_SIZE);
+            ship->y = (uint8_t) pcg32_boundedrand_r(rng, RULES_BOARD_SIZE);
+            ship->orientation = (uint8_t) pcg32_boundedrand_r(rng, 2);
+        } while (!is_compact_position_valid(board, size, ship->x, ship->y, ship->orientation));
+
+        for (int k = 0; k < size; k++) {
+            int cell_x = ship->x + (ship->orientation == 0 ? k : 0);
+            int cell_y = ship->y + (ship->orientation == 1 ? k : 0);
+            board->cells[cell_x * RULES_BOARD_SIZE + cell_y] = (uint8_t) (i + 1);
+        }
+    }
+
+    if (fleet != NULL) {
+        memcpy(fleet, ships, sizeof(ships));
+    }
+}
+
+int apply_compact_shot(CompactBoard *board, int x, int y, NetShip *sunk_ship) {
+    if (x < 0 || x >= RULES_BOARD_SIZE || y < 0 || y >= RULES_BOARD_SIZE) {
+        return -1;
+    }
+    uint8_t *cell = &board->cells[x * RULES_BOARD_SIZE + y];
+    if (*cell & RULES_CELL_HIT) {
+        return -1;
+    }
+    *cell |= RULES_CELL_HIT;
+
+    int ship = *cell & RULES_CELL_SHIP;
+    if (ship == 0) {
+        return NET_RESULT_MISS;
+    }
+
+    // Update the hit count of the ship and check if it has been sunk
+    int ship_index = ship - 1;
+    board->hit_counts[ship_index]++;
+    if (board->hit_counts[ship_index] < rules_ship_sizes[ship_index]) {
+        return NET_RESULT_HIT;
+    }
+    board->remaining_ships--;
+    if (sunk_ship != NULL) {
+        find_compact_ship(board, ship_index, sunk_ship);
+    }
+    return NET_RESULT_SUNK;
+}
+
+void get_compact_view(const CompactBoard *board, uint8_t view[RULES_NUM_CELLS]) {
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        uint8_t cell = board->cells[i];
+        int ship = cell & RULES_CELL_SHIP;
+        if (!(cell & RULES_CELL_HIT)) {
+            view[i] = NET_CELL_UNKNOWN;
+        } else if (ship == 0) {
+            view[i] = NET_CELL_MISS;
+        } else {
+            view[i] = board->hit_counts[ship - 1] == rules_ship_sizes[ship - 1] ? NET_CELL_SUNK : NET_CELL_HIT;
+        }
+    }
+}
+
+bool find_compact_ship(const CompactBoard *board, int ship_index, NetShip *ship) {
+    // The first cell in storage order is the first cell of the ship, the next one tells its orientation
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if ((board->cells[i] & RULES_CELL_SHIP) == ship_index + 1) {
+            ship->index = (uint8_t) ship_index;
+            ship->x = (uint8_t) (i / RULES_BOARD_SIZE);
+            ship->y = (uint8_t) (i % RULES_BOARD_SIZE);
+            ship->orientation = ship->y + 1 < RULES_BOARD_SIZE &&
+                                (board->cells[i + 1] & RULES_CELL_SHIP) == ship_index + 1 ? 1 : 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void choose_compact_shot(const uint8_t view[RULES_NUM_CELLS], pcg32_random_t *rng, uint8_t *x, uint8_t *y) {
+    uint8_t candidates[RULES_NUM_CELLS];
+    int num_candidates = get_compact_shot_candidates(view, candidates);
+    uint8_t cell = num_candidates > 0 ? candidates[pcg32_boundedrand_r(rng, (uint32_t) num_candidates)] : 0;
+    *x = (uint8_t) (cell / RULES_BOARD_SIZE);
+    *y = (uint8_t) (cell % RULES_BOARD_SIZE);
+}
+
+int get_compact_shot_candidates(const uint8_t view[RULES_NUM_CELLS], uint8_t candidates[RULES_NUM_CELLS]) {
+    static const int directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    int num_candidates = 0;
+    int num_lined_up = 0;
+
+    // Target the cells next to a hit on a ship still afloat, first those in line with a second hit
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if (view[i] != NET_CELL_HIT) {
+            continue;
+        }
+        int cell_x = i / RULES_BOARD_SIZE;
+        int cell_y = i % RULES_BOARD_SIZE;
+        for (int d = 0; d < 4; d++) {
+            int next_x = cell_x + directions[d][0];
+            int next_y = cell_y + directions[d][1];
+            int back_x = cell_x - directions[d][0];
+            int back_y = cell_y - directions[d][1];
+            if (next_x < 0 || next_x >= RULES_BOARD_SIZE || next_y < 0 || next_y >= RULES_BOARD_SIZE ||
+                view[next_x * RULES_BOARD_SIZE + next_y] != NET_CELL_UNKNOWN) {
+                continue;
+            }
+            bool lined_up = back_x >= 0 && back_x < RULES_BOARD_SIZE && back_y >= 0 && back_y < RULES_BOARD_SIZE &&
+                            view[back_x * RULES_BOARD_SIZE + back_y] == NET_CELL_HIT;
+            uint8_t cell = (uint8_t) (next_x * RULES_BOARD_SIZE + next_y);
+            if (lined_up) {
+                // Keep the lined-up cells at the front of the list
+                if (num_candidates > num_lined_up) {
+                    candidates[num_candidates] = candidates[num_lined_up];
+                }
+                num_candidates++;
+                candidates[num_lined_up++] = cell;
+            } else {
+                candidates[num_candidates++] = cell;
+            }
+        }
+    }
+
+    // Otherwise search the checkerboard cells, then any cell left
+    if (num_candidates == 0) {
+        for (int i = 0; i < RULES_NUM_CELLS; i++) {
+            if (view[i] == NET_CELL_UNKNOWN && (i / RULES_BOARD_SIZE + i % RULES_BOARD_SIZE) % 2 == 0) {
+                candidates[num_candidates++] = (uint8_t) i;
+            }
+        }
+    }
+    if (num_candidates == 0) {
+        for (int i = 0; i < RULES_NUM_CELLS; i++) {
+            if (view[i] == NET_CELL_UNKNOWN) {
+                candidates[num_candidates++] = (uint8_t) i;
+            }
+        }
+    }
+
+    return num_lined_up > 0 ? num_lined_up : num_candidates;
+}
+
+void init_compact_ai(CompactAI *ai) {
+    memset(ai, 0, sizeof(CompactAI));
+    ai->state = COMPACT_AI_SEARCH;
+    ai->min_gap = 1;
+    ai->last_hit_x = -1;
+    ai->last_hit_y = -1;
+    ai->initial_hit_x = -1;
+    ai->initial_hit_y = -1;
+    ai->first_revisit = true;
+    for (int i = 0; i < 4; i++) {
+        ai->dir_indices[i] = i;
+    }
+
+    // The cells not shot yet, in the order the game lists them
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        ai->remaining_cells[i] = (uint8_t) i;
+    }
+    ai->remaining_cells_count = RULES_NUM_CELLS;
+}
+
+void choose_compact_ai_shot(CompactAI *ai, const CompactBoard *board, pcg32_random_t *rng, uint8_t *x, uint8_t *y) {
+    int cell_x = 0, cell_y = 0;
+    for (;;) {
+        // The states hand over to each other until one of them finds a cell
+        switch (ai->state) {
+            case COMPACT_AI_SEARCH: {
+                // Go back to the hits of the other ships first
+                if (ai->hit_segments_count > 0) {
+                    ai->state = COMPACT_AI_REVISIT;
+                    continue;
+                }
+                ai->attempts = 0;
+                ai->is_revisit = false;
+                shuffle_compact_directions(ai->dir_indices, 4, rng);
+
+                // Draw cells not shot yet until one keeps the minimum gap, the last one drawn is shot otherwise
+                uint8_t cells[RULES_NUM_CELLS];
+                int num_cells = ai->remaining_cells_count;
+                memcpy(cells, ai->remaining_cells, (size_t) num_cells);
+                bool valid_cell_found = false;
+                while (!valid_cell_found && num_cells > 0) {
+                    int index = (int) pcg32_boundedrand_r(rng, (uint32_t) num_cells);
+                    cell_x = cells[index] / RULES_BOARD_SIZE;
+                    cell_y = cells[index] % RULES_BOARD_SIZE;
+                    cells[index] = cells[--num_cells];
+                    valid_cell_found = meets_compact_min_gap(ai, board, cell_x, cell_y);
+                }
+                break;
+            }
+
+            case COMPACT_AI_TARGET:
+            case COMPACT_AI_DESTROY:
+                // Try the directions around the first hit, revisiting or searching again once they are exhausted
+                if (!find_compact_target_cell(ai, board, &cell_x, &cell_y)) {
+                    continue;
+                }
+                break;
+
+            case COMPACT_AI_REVISIT:
+                // Search again once there is no hit left to revisit
+                if (ai->hit_segments_count == 0) {
+                    ai->is_revisit = false;
+                    ai->first_revisit = true;
+                    ai->state = COMPACT_AI_SEARCH;
+                    continue;
+                }
+
+                // Target a random hit left behind
+                int index = (int) pcg32_boundedrand_r(rng, (uint32_t) ai->hit_segments_count);
+                cell_x = ai->hit_segments[index][0];
+                cell_y = ai->hit_segments[index][1];
+                ai->hit_segments_count--;
+                ai->hit_segments[index][0] = ai->hit_segments[ai->hit_segments_count][0];
+                ai->hit_segments[index][1] = ai->hit_segments[ai->hit_segments_count][1];
+                ai->initial_hit_x = ai->last_hit_x = cell_x;
+                ai->initial_hit_y = ai->last_hit_y = cell_y;
+
+                // The first revisit turns across the direction the ship was followed in, the game then picks the
+                // first of its shuffled directions when that direction was vertical
+                if (ai->first_revisit) {
+                    bool horizontal = ai->direction == 0 || ai->direction == 2;
+                    ai->dir_indices_revisit[0] = horizontal ? 1 : 0;
+                    ai->dir_indices_revisit[1] = horizontal ? 3 : 2;
+                    shuffle_compact_directions(ai->dir_indices_revisit, 2, rng);
+                    ai->direction = horizontal ? ai->dir_indices_revisit[0] : ai->dir_indices[0];
+                    ai->first_revisit = false;
+                } else {
+                    shuffle_compact_directions(ai->dir_indices_revisit, 2, rng);
+                    ai->direction = ai->dir_indices_revisit[0];
+                }
+                ai->is_revisit = true;
+                ai->state = COMPACT_AI_TARGET;
+                ai->attempts = 0;
+                ai->direction_fully_explored = false;
+                continue;
+        }
+
+        // Shoot the cell if it was not shot yet
+        if (!(board->cells[cell_x * RULES_BOARD_SIZE + cell_y] & RULES_CELL_HIT)) {
+            *x = (uint8_t) cell_x;
+            *y = (uint8_t) cell_y;
+            return;
+        }
+
+        // Otherwise try the next direction, or turn around along the ship
+        if (ai->state == COMPACT_AI_TARGET) {
+            ai->direction = ai->dir_indices[ai->attempts];
+            ai->attempts++;
+            ai->direction_fully_explored = false;
+        } else if (ai->state == COMPACT_AI_DESTROY) {
+            if (ai->direction_fully_explored) {
+                ai->state = COMPACT_AI_REVISIT;
+            } else {
+                ai->state = COMPACT_AI_TARGET;
+                ai->direction = (ai->direction + 2) % 4;
+                ai->last_hit_x = ai->initial_hit_x;
+                ai->last_hit_y = ai->initial_hit_y;
+            }
+        }
+    }
+}
+
+void update_compact_ai(CompactAI *ai, const CompactBoard *board, int x, int y) {
+    // Remove the cell from the cells not shot yet, the last cell takes its place
+    for (int i = 0; i < ai->remaining_cells_count; i++) {
+        if (ai->remaining_cells[i] == x * RULES_BOARD_SIZE + y) {
+            ai->remaining_cells[i] = ai->remaining_cells[--ai->remaining_cells_count];
+            break;
+        }
+    }
+
+    // A miss tries the next direction, or turns around along the ship
+    int ship = board->cells[x * RULES_BOARD_SIZE + y] & RULES_CELL_SHIP;
+    if (ship == 0) {
+        if (ai->state == COMPACT_AI_TARGET) {
+            ai->attempts++;
+        } else if (ai->state == COMPACT_AI_DESTROY) {
+            ai->state = COMPACT_AI_TARGET;
+            ai->direction = (ai->direction + 2) % 4;
+            ai->last_hit_x = ai->initial_hit_x;
+            ai->last_hit_y = ai->initial_hit_y;
+            ai->direction_fully_explored = true;
+        }
+        return;
+    }
+
+    // A hit starts targeting the ship, a second hit follows it
+    int ship_index = ship - 1;
+    if (ai->state == COMPACT_AI_SEARCH) {
+        ai->state = COMPACT_AI_TARGET;
+        ai->initial_hit_x = ai->last_hit_x = x;
+        ai->initial_hit_y = ai->last_hit_y = y;
+    } else if (ai->state == COMPACT_AI_TARGET || ai->state == COMPACT_AI_DESTROY) {
+        if (ai->state == COMPACT_AI_TARGET) {
+            ai->state = COMPACT_AI_DESTROY;
+            ai->attempts = 0;
+        }
+        ai->last_hit_x = x;
+        ai->last_hit_y = y;
+    }
+
+    // Hits of other ships found on the way are kept for later, while there is room
+    if (board->hit_counts[ship_index] < rules_ship_sizes[ship_index]) {
+        if (!ai->is_revisit && ai->hit_segments_count < RULES_MAX_HIT_SEGMENTS) {
+            ai->hit_segments[ai->hit_segments_count][0] = x;
+            ai->hit_segments[ai->hit_segments_count][1] = y;
+            ai->hit_segments_count++;
+        }
+        return;
+    }
+
+    // A sunk ship widens the minimum gap to the smallest ship left, and the search starts again
+    ai->destroyed_ships[ship_index] = true;
+    int smallest_ship_remaining = RULES_BOARD_SIZE + 1;
+    for (int i = 0; i < RULES_NUM_SHIPS; i++) {
+        if (!ai->destroyed_ships[i] && rules_ship_sizes[i] < smallest_ship_remaining) {
+            smallest_ship_remaining = rules_ship_sizes[i];
+        }
+    }
+    ai->min_gap = smallest_ship_remaining - 1;
+    if (!ai->is_revisit) {
+        ai->hit_segments_count = 0;
+        ai->direction = 0;
+    }
+    ai->state = COMPACT_AI_SEARCH;
+    ai->attempts = 0;
+    ai->last_hit_x = -1;
+    ai->last_hit_y = -1;
+    ai->initial_hit_x = -1;
+    ai->initial_hit_y = -1;
+    ai->direction_fully_explored = false;
+}
+
+void get_compact_density(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS],
+                         float density[RULES_NUM_CELLS]) {
+    // Ships of the same size have the same positions, count the ships afloat of each size
+    int num_ships_of_size[RULES_BOARD_SIZE + 1] = {0};
+    int max_size = 0;
+    for (int i = 0; i < RULES_NUM_SHIPS; i++) {
+        if (!sunk_ships[i]) {
+            num_ships_of_size[rules_ship_sizes[i]]++;
+            max_size = rules_ship_sizes[i] > max_size ? rules_ship_sizes[i] : max_size;
+        }
+    }
+    double hit_weights[RULES_BOARD_SIZE + 1];
+    hit_weights[0] = 1.0;
+    for (int i = 1; i <= max_size; i++) {
+        hit_weights[i] = hit_weights[i - 1] * RULES_DENSITY_HIT_WEIGHT;
+    }
+    memset(density, 0, RULES_NUM_CELLS * sizeof(float));
+
+    // Slide each ship along each row and column, a ship cannot cover a miss or a sunk ship
+    for (int orientation = 0; orientation < 2; orientation++) {
+        int step = orientation == 0 ? RULES_BOARD_SIZE : 1;
+        int line_step = orientation == 0 ? 1 : RULES_BOARD_SIZE;
+        for (int line = 0; line < RULES_BOARD_SIZE; line++) {
+            int first = line * line_step;
+            uint8_t blocked[RULES_BOARD_SIZE];
+            uint8_t hits[RULES_BOARD_SIZE];
+            for (int t = 0; t < RULES_BOARD_SIZE; t++) {
+                uint8_t cell = view[first + t * step];
+                blocked[t] = cell == NET_CELL_MISS || cell == NET_CELL_SUNK;
+                hits[t] = cell == NET_CELL_HIT;
+            }
+
+            // Each position adds its weight to the cells it covers through the differences between cells
+            double differences[RULES_BOARD_SIZE + 1] = {0};
+            for (int size = 2; size <= max_size; size++) {
+                if (num_ships_of_size[size] == 0) {
+                    continue;
+                }
+                int num_blocked = 0;
+                int num_hits = 0;
+                for (int t = 0; t < RULES_BOARD_SIZE; t++) {
+                    num_blocked += blocked[t];
+                    num_hits += hits[t];
+                    if (t >= size) {
+                        num_blocked -= blocked[t - size];
+                        num_hits -= hits[t - size];
+                    }
+                    if (t >= size - 1 && num_blocked == 0) {
+                        double weight = num_ships_of_size[size] * hit_weights[num_hits];
+                        differences[t - size + 1] += weight;
+                        differences[t + 1] -= weight;
+                    }
+                }
+            }
+            double sum = 0.0;
+            for (int t = 0; t < RULES_BOARD_SIZE; t++) {
+                sum += differences[t];
+                density[first + t * step] += (float) sum;
+            }
+        }
+    }
+
+    // Keep the cells not shot yet and normalize, a board without any possible position gets a uniform density
+    float total = 0.0f;
+    int num_unknown = 0;
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if (view[i] != NET_CELL_UNKNOWN) {
+            density[i] = 0.0f;
+        } else {
+            total += density[i];
+            num_unknown++;
+        }
+    }
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if (view[i] == NET_CELL_UNKNOWN) {
+            density[i] = total > 0.0f ? density[i] / total : 1.0f / (float) num_unknown;
+        }
+    }
+}
+
+static void shuffle_compact_directions(int *dir_indices, int size, pcg32_random_t *rng) {
+    for (int i = size - 1; i > 0; i--) {
+        int j = (int) pcg32_boundedrand_r(rng, (uint32_t) (i + 1));
+        int temp = dir_indices[i];
+        dir_indices[i] = dir_indices[j];
+        dir_indices[j] = temp;
+    }
+}
+
+static bool meets_compact_min_gap(const CompactAI *ai, const CompactBoard *board, int cell_x, int cell_y) {
+    // No neighbor may be a miss or a hit on a ship smaller than the minimum gap
+    for (int i = 0; i < 4; i++) {
+        int x = cell_x + compact_ai_dx[i];
+        int y = cell_y + compact_ai_dy[i];
+        if (x < 0 || x >= RULES_BOARD_SIZE || y < 0 || y >= RULES_BOARD_SIZE) {
+            continue;
+        }
+        uint8_t cell = board->cells[x * RULES_BOARD_SIZE + y];
+        int ship = cell & RULES_CELL_SHIP;
+        if ((cell & RULES_CELL_HIT) && (ship == 0 || rules_ship_sizes[ship - 1] < ai->min_gap)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool find_compact_target_cell(CompactAI *ai, const CompactBoard *board, int *cell_x, int *cell_y) {
+    // Try to find a valid cell to shoot in the current direction
+    while (ai->attempts < 4) {
+        if (ai->state == COMPACT_AI_TARGET && !ai->direction_fully_explored && !ai->is_revisit) {
+            ai->direction = ai->dir_indices[ai->attempts];
+            *cell_x = ai->initial_hit_x + compact_ai_dx[ai->direction];
+            *cell_y = ai->initial_hit_y + compact_ai_dy[ai->direction];
+        } else {
+            // Revisit once a direction has been fully explored
+            if (ai->direction_fully_explored && ai->state == COMPACT_AI_TARGET && ai->attempts > 0) {
+                ai->state = COMPACT_AI_REVISIT;
+                return false;
+            }
+
+            // A revisit tries the other direction after the first
+            if (ai->is_revisit && ai->attempts == 1 && !ai->direction_fully_explored) {
+                ai->direction = (ai->direction + 2) % 4;
+                ai->direction_fully_explored = true;
+            }
+            *cell_x = ai->last_hit_x + compact_ai_dx[ai->direction];
+            *cell_y = ai->last_hit_y + compact_ai_dy[ai->direction];
+        }
+
+        // Check if the cell is within the board and hasn't been hit before
+        if (*cell_x >= 0 && *cell_x < RULES_BOARD_SIZE && *cell_y >= 0 && *cell_y < RULES_BOARD_SIZE &&
+            !(board->cells[*cell_x * RULES_BOARD_SIZE + *cell_y] & RULES_CELL_HIT)) {
+            return true;
+        }
+        ai->attempts++;
+
+        // Once the orientation is known and the ship ends in this direction, follow it the other way
+        if (ai->direction_fully_explored || ai->state != COMPACT_AI_DESTROY) {
+            continue;
+        }
+        ai->direction = (ai->direction + 2) % 4;
+        ai->last_hit_x = ai->initial_hit_x;
+        ai->last_hit_y = ai->initial_hit_y;
+        ai->direction_fully_explored = true;
+    }
+
+    // Try the next direction in the TARGET state
+    if (ai->state == COMPACT_AI_TARGET) {
+        ai->direction = (ai->direction + 1) % 4;
+        ai->attempts++;
+        if (ai->attempts < 4) {
+            return false;
+        }
+    }
+
+    // Search again once every direction has been tried
+    ai->state = COMPACT_AI_SEARCH;
+    ai->attempts = 0;
+    ai->direction = 0;
+    ai->last_hit_x = -1;
+    ai->last_hit_y = -1;
+    ai->initial_hit_x = -1;
+    ai->initial_hit_y = -1;
+    ai->direction_fully_explored = false;
+    return false;
+}
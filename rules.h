@@ -0,0 +1,186 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "net.h"
+#include "pcg_basic.h"
+
+#define RULES_BOARD_SIZE NET_BOARD_SIZE
+#define RULES_NUM_SHIPS NET_FLEET_SIZE
+#define RULES_NUM_CELLS (RULES_BOARD_SIZE * RULES_BOARD_SIZE)
+#define RULES_CELL_HIT 0x80
+#define RULES_CELL_SHIP 0x07
+#define RULES_DENSITY_HIT_WEIGHT 50.0f
+#define RULES_MAX_HIT_SEGMENTS 5
+
+// Structure for a board without any rendering state, one byte per cell
+//
+// The low bits of a cell are the index of its ship plus one (0 for water), RULES_CELL_HIT marks a shot cell.
+// Cells are stored by x * RULES_BOARD_SIZE + y, like the cells of GameBoard and the cells sent by net.h.
+typedef struct {
+    uint8_t cells[RULES_NUM_CELLS];
+    uint8_t hit_counts[RULES_NUM_SHIPS];
+    uint8_t remaining_ships;
+} CompactBoard;
+
+// Enum for the states of CompactAI, the same as AI_State in the game
+typedef enum {
+    COMPACT_AI_SEARCH,
+    COMPACT_AI_TARGET,
+    COMPACT_AI_DESTROY,
+    COMPACT_AI_REVISIT
+} CompactAIState;
+
+// Structure for the AI of the computer in the game, handle_computer_turn, playing on a CompactBoard
+//
+// SEARCH shoots random cells keeping a minimum gap from the cells shot, TARGET tries the directions around a hit,
+// DESTROY follows the ship and turns around at its end, and REVISIT goes back to the hits of other ships found on the
+// way. Given the same random numbers, it shoots the same cells as the game.
+typedef struct {
+    CompactAIState state;
+    int min_gap;
+    int attempts;
+    int direction;
+    int last_hit_x;
+    int last_hit_y;
+    int initial_hit_x;
+    int initial_hit_y;
+    bool is_revisit;
+    bool first_revisit;
+    bool direction_fully_explored;
+    bool destroyed_ships[RULES_NUM_SHIPS];
+    int hit_segments_count;
+    int hit_segments[RULES_MAX_HIT_SEGMENTS][2];
+    int dir_indices[4];
+    int dir_indices_revisit[2];
+    uint8_t remaining_cells[RULES_NUM_CELLS];
+    int remaining_cells_count;
+} CompactAI;
+
+/// \brief Returns the size of a ship of the fleet.
+///
+/// \param ship_index The index of the ship.
+/// \return int The number of cells of the ship.
+int get_rules_ship_size(int ship_index);
+
+/// \brief Empties a board.
+///
+/// \param board A pointer to the CompactBoard.
+/// \return void
+void clear_compact_board(CompactBoard *board);
+
+/// \brief Checks whether a ship fits on the board without overlapping another ship.
+///
+/// Same rule as is_position_valid in the game.
+///
+/// \param board A pointer to the CompactBoard.
+/// \param ship_size The number of cells of the ship.
+/// \param x The x-coordinate of the first cell of the ship.
+/// \param y The y-coordinate of the first cell of the ship.
+/// \param orientation 0 for horizontal, 1 for vertical.
+/// \return bool Returns true if the position is valid, false otherwise.
+bool is_compact_position_valid(const CompactBoard *board, int ship_size, int x, int y, int orientation);
+
+/// \brief Clears a board and places a whole fleet on it.
+///
+/// \param board A pointer to the CompactBoard.
+/// \param fleet The positions of the ships, in the order of their indices.
+/// \return bool Returns true if every ship is at a valid position, false otherwise.
+bool place_compact_fleet(CompactBoard *board, const NetShip fleet[RULES_NUM_SHIPS]);
+
+/// \brief Places a fleet at random valid positions.
+///
+/// \param board A pointer to the CompactBoard receiving the fleet.
+/// \param rng A pointer to the random number generator.
+/// \param fleet The buffer receiving the positions of the ships, or NULL.
+/// \return void
+void place_random_compact_fleet(CompactBoard *board, pcg32_random_t *rng, NetShip fleet[RULES_NUM_SHIPS]);
+
+/// \brief Resolves a shot at a board.
+///
+/// Hits are counted with the same rule as update_hit_count in the game.
+///
+/// \param board A pointer to the CompactBoard that is shot at.
+/// \param x The x-coordinate of the cell.
+/// \param y The y-coordinate of the cell.
+/// \param sunk_ship A pointer to a NetShip receiving the sunk ship, or NULL.
+/// \return int The NetShotResult of the shot, or -1 if the cell is outside the board or was already shot.
+int apply_compact_shot(CompactBoard *board, int x, int y, NetShip *sunk_ship);
+
+/// \brief Returns what an observer of the shots knows of a board, the ships are only known where they were hit.
+///
+/// \param board A pointer to the CompactBoard.
+/// \param view The buffer receiving a NetCellView per cell, in the order of the cells of the board.
+/// \return void
+void get_compact_view(const CompactBoard *board, uint8_t view[RULES_NUM_CELLS]);
+
+/// \brief Finds the position of a ship from the cells it occupies.
+///
+/// \param board A pointer to the CompactBoard.
+/// \param ship_index The index of the ship.
+/// \param ship A pointer to the NetShip receiving the position.
+/// \return bool Returns true if the ship is on the board, false otherwise.
+bool find_compact_ship(const CompactBoard *board, int ship_index, NetShip *ship);
+
+/// \brief Chooses a shot from what the AI can see: next to an unsunk hit if there is one, on a checkerboard
+/// cell otherwise, since the smallest ship covers two cells.
+///
+/// \param view The NetCellView of each cell of the board.
+/// \param rng A pointer to the random number generator.
+/// \param x A pointer to the x-coordinate of the shot.
+/// \param y A pointer to the y-coordinate of the shot.
+/// \return void
+void choose_compact_shot(const uint8_t view[RULES_NUM_CELLS], pcg32_random_t *rng, uint8_t *x, uint8_t *y);
+
+/// \brief Lists the cells choose_compact_shot picks from uniformly: the cells in line with two unsunk hits if there
+/// are any, the cells next to an unsunk hit otherwise, then the checkerboard cells, then any cell not shot yet.
+///
+/// \param view The NetCellView of each cell of the board.
+/// \param candidates The buffer receiving the index of each candidate, a cell next to several hits is listed once
+/// per hit.
+/// \return int The number of candidates, 0 if every cell was shot.
+int get_compact_shot_candidates(const uint8_t view[RULES_NUM_CELLS], uint8_t candidates[RULES_NUM_CELLS]);
+
+/// \brief Starts the AI of the game on a new board.
+///
+/// \param ai A pointer to the CompactAI.
+/// \return void
+void init_compact_ai(CompactAI *ai);
+
+/// \brief Chooses the next shot of the AI of the game.
+///
+/// Like the game, the AI reads which ship a hit cell belongs to when it keeps the minimum gap. The shot must then be
+/// applied with apply_compact_shot and passed to update_compact_ai.
+///
+/// \param ai A pointer to the CompactAI.
+/// \param board A pointer to the CompactBoard that is shot at.
+/// \param rng A pointer to the random number generator.
+/// \param x A pointer to the x-coordinate of the shot.
+/// \param y A pointer to the y-coordinate of the shot.
+/// \return void
+void choose_compact_ai_shot(CompactAI *ai, const CompactBoard *board, pcg32_random_t *rng, uint8_t *x, uint8_t *y);
+
+/// \brief Updates the AI of the game with the result of its shot.
+///
+/// \param ai A pointer to the CompactAI.
+/// \param board A pointer to the CompactBoard, after the shot was applied.
+/// \param x The x-coordinate of the shot.
+/// \param y The y-coordinate of the shot.
+/// \return void
+void update_compact_ai(CompactAI *ai, const CompactBoard *board, int x, int y);
+
+/// \brief Estimates the probability that each cell holds a ship, from what the shooter knows of the board.
+///
+/// Every position of every ship still afloat that avoids the missed cells and the sunk ships is counted on the
+/// cells it covers, and a position covering hit cells counts RULES_DENSITY_HIT_WEIGHT times more per hit. Shot
+/// cells get 0 and the other cells sum to 1.
+///
+/// \param view The NetCellView of each cell of the board.
+/// \param sunk_ships Non-zero for each sunk ship, in the order of their indices.
+/// \param density The buffer receiving the probability of each cell.
+/// \return void
+void get_compact_density(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS],
+                         float density[RULES_NUM_CELLS]);
+
+#endif // RULES_H
@@ -0,0 +1,288 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "rules.h"
+#include "selfplay.h"
+
+#define SELFPLAY_DEFAULT_SAMPLES 1000000
+#define SELFPLAY_MAX_THREADS 256
+#define SELFPLAY_POLL_INTERVAL 100
+#define SELFPLAY_REPORT_INTERVAL 1000
+
+_Static_assert(sizeof(SelfPlayShardHeader) == 64, "the shard header must keep the samples aligned");
+
+// Structure for a thread generating games and writing them to its shard
+typedef struct {
+    int index;
+    const char *directory;
+    uint64_t seed;
+    uint64_t quota;
+    atomic_uint_fast64_t num_samples;
+    atomic_bool finished;
+    uint64_t num_games;
+    bool failed;
+    pthread_t thread;
+} SelfPlayWorker;
+
+/// \brief Parses the options, starts a thread per core and reports the samples per second until they are done.
+///
+/// Usage: battleship_selfplay --output <dir> [--samples <n>] [--threads <n>] [--seed <n>]. Thread i writes
+/// <dir>/shard-<i>.bssp from the pcg32 stream i of the seed, so a run can be reproduced with the same seed and
+/// number of threads.
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 if every shard was written, 1 otherwise.
+int main(int argc, char *argv[]);
+
+/// \brief The function run by each thread, plays games until the quota of the thread is written.
+///
+/// \param data A pointer to the SelfPlayWorker.
+/// \return void* Always NULL.
+void *selfplay_worker_thread(void *data);
+
+/// \brief Plays one game against a random fleet, shooting cells drawn from the target distribution.
+///
+/// \param rng A pointer to the random number generator of the thread.
+/// \param samples The buffer receiving a sample per shot, at least RULES_NUM_CELLS samples.
+/// \return int The number of shots of the game.
+int play_selfplay_game(pcg32_random_t *rng, SelfPlaySample *samples);
+
+/// \brief Rewrites the header of a shard at the start of its file, after the samples written so far.
+///
+/// \param file The shard file.
+/// \param header A pointer to the SelfPlayShardHeader.
+/// \return bool Returns true if the header was written, false otherwise.
+bool write_shard_header(FILE *file, const SelfPlayShardHeader *header);
+
+/// \brief Returns the value of the monotonic clock in seconds.
+///
+/// \return double The time in seconds.
+double get_time_s(void);
+
+int main(int argc, char *argv[]) {
+    const char *directory = NULL;
+    uint64_t num_samples = SELFPLAY_DEFAULT_SAMPLES;
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = (uint64_t) time(NULL);
+
+    // Parse the command-line options
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            num_samples = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || directory == NULL || num_samples == 0 || num_threads <= 0 || num_threads > SELFPLAY_MAX_THREADS) {
+        printf("Usage: %s --output <dir> [--samples <n>] [--threads <n>] [--seed <n>]\n", argv[0]);
+        return 1;
+    }
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("Could not create the directory %s: %s\n", directory, strerror(errno));
+        return 1;
+    }
+
+    // Split the samples between the threads, the first ones write the remainder
+    static SelfPlayWorker workers[SELFPLAY_MAX_THREADS];
+    printf("Writing %llu samples to %s with %ld threads, seed %llu.\n", (unsigned long long) num_samples, directory,
+           num_threads, (unsigned long long) seed);
+    double start_time = get_time_s();
+    int num_started = 0;
+    for (int i = 0; i < num_threads; i++) {
+        SelfPlayWorker *worker = &workers[i];
+        worker->index = i;
+        worker->directory = directory;
+        worker->seed = seed;
+        worker->quota = num_samples / (uint64_t) num_threads + ((uint64_t) i < num_samples % (uint64_t) num_threads);
+        atomic_init(&worker->num_samples, 0);
+        atomic_init(&worker->finished, false);
+        if (pthread_create(&worker->thread, NULL, selfplay_worker_thread, worker) != 0) {
+            printf("Could not start thread %d.\n", i);
+            break;
+        }
+        num_started++;
+    }
+
+    // Report the progress every second until every thread has written its quota
+    uint64_t written = 0;
+    bool running = num_started > 0;
+    for (int tick = 1; running; tick++) {
+        struct timespec interval = {0, SELFPLAY_POLL_INTERVAL * 1000000L};
+        nanosleep(&interval, NULL);
+        running = false;
+        for (int i = 0; i < num_started; i++) {
+            running = running || !atomic_load(&workers[i].finished);
+        }
+        if (!running || tick % (SELFPLAY_REPORT_INTERVAL / SELFPLAY_POLL_INTERVAL) != 0) {
+            continue;
+        }
+        uint64_t previous = written;
+        written = 0;
+        for (int i = 0; i < num_started; i++) {
+            written += atomic_load_explicit(&workers[i].num_samples, memory_order_relaxed);
+        }
+        printf("%llu samples, %.0f samples/s\n", (unsigned long long) written,
+               (double) (written - previous) * 1000.0 / SELFPLAY_REPORT_INTERVAL);
+        fflush(stdout);
+    }
+
+    // Wait for the threads and print the throughput of the whole run
+    uint64_t num_games = 0;
+    bool failed = num_started < num_threads;
+    written = 0;
+    for (int i = 0; i < num_started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        written += atomic_load(&workers[i].num_samples);
+        num_games += workers[i].num_games;
+        failed = failed || workers[i].failed;
+    }
+    double elapsed = get_time_s() - start_time;
+    double megabytes = (double) (written * sizeof(SelfPlaySample) + (uint64_t) num_started *
+                                 sizeof(SelfPlayShardHeader)) / 1e6;
+    printf("%llu samples from %llu games in %.2f s: %.0f samples/s, %.1f MB/s, %.1f MB in %d shards\n",
+           (unsigned long long) written, (unsigned long long) num_games, elapsed, (double) written / elapsed,
+           megabytes / elapsed, megabytes, num_started);
+    return failed ? 1 : 0;
+}
+
+void *selfplay_worker_thread(void *data) {
+    SelfPlayWorker *worker = data;
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, worker->seed, (uint64_t) worker->index);
+
+    // Each thread writes its own shard, so the threads never wait for each other
+    char filename[4096];
+    snprintf(filename, sizeof(filename), SELFPLAY_SHARD_NAME_FORMAT, worker->directory, worker->index);
+    FILE *file = fopen(filename, "wb");
+    SelfPlaySample *chunk = malloc((SELFPLAY_CHUNK_SAMPLES + RULES_NUM_CELLS) * sizeof(SelfPlaySample));
+    SelfPlayShardHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SELFPLAY_MAGIC, 4);
+    header.version = SELFPLAY_VERSION;
+    header.sample_size = sizeof(SelfPlaySample);
+    header.chunk_samples = SELFPLAY_CHUNK_SAMPLES;
+    header.seed = worker->seed;
+    header.shard_index = (uint32_t) worker->index;
+    if (file == NULL || chunk == NULL || fwrite(&header, sizeof(header), 1, file) != 1) {
+        printf("Could not create the shard %s.\n", filename);
+        worker->failed = true;
+        free(chunk);
+        if (file != NULL) {
+            fclose(file);
+        }
+        atomic_store(&worker->finished, true);
+        return NULL;
+    }
+
+    // Fill a chunk with whole games, the samples past the chunk move to the start of the next one
+    size_t num_buffered = 0;
+    while (header.num_samples < worker->quota) {
+        num_buffered += (size_t) play_selfplay_game(&rng, &chunk[num_buffered]);
+        header.num_games++;
+        uint64_t remaining = worker->quota - header.num_samples;
+        if (num_buffered < SELFPLAY_CHUNK_SAMPLES && num_buffered < remaining) {
+            continue;
+        }
+
+        // Write the chunk, then the header so readers see the new samples
+        size_t count = num_buffered < SELFPLAY_CHUNK_SAMPLES ? num_buffered : SELFPLAY_CHUNK_SAMPLES;
+        count = count < remaining ? count : (size_t) remaining;
+        if (fwrite(chunk, sizeof(SelfPlaySample), count, file) != count) {
+            worker->failed = true;
+            break;
+        }
+        header.num_samples += count;
+        if (!write_shard_header(file, &header)) {
+            worker->failed = true;
+            break;
+        }
+        atomic_store_explicit(&worker->num_samples, header.num_samples, memory_order_relaxed);
+        num_buffered -= count;
+        memmove(chunk, &chunk[count], num_buffered * sizeof(SelfPlaySample));
+    }
+
+    if (fclose(file) != 0 || worker->failed) {
+        printf("Could not write the shard %s.\n", filename);
+        worker->failed = true;
+    }
+    worker->num_games = header.num_games;
+    free(chunk);
+    atomic_store(&worker->finished, true);
+    return NULL;
+}
+
+int play_selfplay_game(pcg32_random_t *rng, SelfPlaySample *samples) {
+    CompactBoard board;
+    uint8_t sunk_ships[RULES_NUM_SHIPS] = {0};
+    uint8_t sunk_mask = 0;
+    float density[RULES_NUM_CELLS];
+    int num_shots = 0;
+
+    // A new fleet drawn like place_random_ships draws the fleet of the computer
+    place_random_compact_fleet(&board, rng, NULL);
+    while (board.remaining_ships > 0) {
+        SelfPlaySample *sample = &samples[num_shots];
+        get_compact_view(&board, sample->view);
+        sample->sunk_ships = sunk_mask;
+        sample->reserved = 0;
+        get_compact_density(sample->view, sunk_ships, density);
+        for (int i = 0; i < RULES_NUM_CELLS; i++) {
+            sample->target[i] = (uint16_t) (density[i] * SELFPLAY_TARGET_SCALE + 0.5f);
+        }
+
+        // Draw the shot from the target, so the games cover the states a strong player reaches and a few others
+        float draw = (float) pcg32_random_r(rng) / 4294967296.0f;
+        int cell = -1;
+        for (int i = 0; i < RULES_NUM_CELLS; i++) {
+            if (sample->view[i] == NET_CELL_UNKNOWN) {
+                cell = i;
+                draw -= density[i];
+                if (draw < 0.0f) {
+                    break;
+                }
+            }
+        }
+        sample->action = (uint8_t) cell;
+
+        NetShip sunk_ship;
+        if (apply_compact_shot(&board, cell / RULES_BOARD_SIZE, cell % RULES_BOARD_SIZE, &sunk_ship) ==
+            NET_RESULT_SUNK) {
+            sunk_ships[sunk_ship.index] = 1;
+            sunk_mask |= (uint8_t) (1 << sunk_ship.index);
+        }
+        num_shots++;
+    }
+
+    // The outcome of each sample is known once the game is over
+    for (int i = 0; i < num_shots; i++) {
+        samples[i].remaining_shots = (uint8_t) (num_shots - i);
+    }
+    return num_shots;
+}
+
+bool write_shard_header(FILE *file, const SelfPlayShardHeader *header) {
+    // The header is rewritten in place with pwrite, the samples keep being appended through the stream
+    return fflush(file) == 0 && pwrite(fileno(file), header, sizeof(SelfPlayShardHeader), 0) ==
+                                (ssize_t) sizeof(SelfPlayShardHeader);
+}
+
+double get_time_s(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
@@ -0,0 +1,46 @@
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <stdint.h>
+#include "rules.h"
+
+#define SELFPLAY_MAGIC "BSSP"
+#define SELFPLAY_VERSION 1
+#define SELFPLAY_CHUNK_SAMPLES 4096
+#define SELFPLAY_TARGET_SCALE 65535.0f
+#define SELFPLAY_SHARD_NAME_FORMAT "%s/shard-%03d.bssp"
+
+// Self-play shards written by battleship_selfplay and read by battleship_train
+//
+// Each generating thread writes its own shard: a header, then fixed-size samples in native (little-endian) byte
+// order, so a shard can be mapped and indexed directly. The samples are written in chunks of
+// SELFPLAY_CHUNK_SAMPLES, and the header is rewritten after each chunk: a reader can use the first num_samples
+// samples of a shard while it is still being written.
+
+// Header at the start of a shard file, 64 bytes so the samples that follow stay aligned
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t sample_size;
+    uint32_t chunk_samples;
+    uint64_t num_samples;
+    uint64_t num_games;
+    uint64_t seed;
+    uint32_t shard_index;
+    uint32_t reserved[5];
+} SelfPlayShardHeader;
+
+// Structure for one sample: what the shooter knew before a shot, the target distribution and the outcome
+//
+// The target is the probability of each cell given by get_compact_density, scaled by SELFPLAY_TARGET_SCALE. The
+// outcome is the number of shots the game still took, this one included.
+typedef struct {
+    uint8_t view[RULES_NUM_CELLS];
+    uint8_t sunk_ships;
+    uint8_t action;
+    uint8_t remaining_shots;
+    uint8_t reserved;
+    uint16_t target[RULES_NUM_CELLS];
+} SelfPlaySample;
+
+#endif // SELFPLAY_H
@@ -0,0 +1,1146 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "net.h"
+#include "rules.h"
+
+#define SERVER_DEFAULT_MAX_MATCHES 4096
+#define SERVER_DEFAULT_AI_WORKERS 2
+#define SERVER_DEFAULT_MAX_SPECTATORS 4096
+#define SERVER_MAX_EVENTS 256
+#define SERVER_STATS_INTERVAL 5000
+#define CONNECTION_RECEIVE_SIZE 64
+#define CONNECTION_SEND_SIZE 256
+#define LISTENER_ID UINT32_MAX
+#define AI_EVENT_ID (UINT32_MAX - 1)
+#define NO_INDEX (-1)
+#define SPECTATOR_LOBBY (-2)
+
+// Enum for the states of a match slot of the arena
+typedef enum {
+    MATCH_FREE,
+    MATCH_WAITING,
+    MATCH_PLAYING
+} MatchState;
+
+// Structure for a match, the arena holds a fixed number of them
+//
+// boards[seat] holds the fleet of the seat, seat 0 is player 1 and shoots first. A seat without a connection is
+// played by the AI. The spectators of the match are linked through their connections.
+typedef struct {
+    CompactBoard boards[2];
+    int connections[2];
+    int first_spectator;
+    uint32_t generation;
+    int next_free;
+    uint8_t state;
+    uint8_t turn;
+    bool ai_pending;
+} Match;
+
+// Structure for a client connection, the pool holds two per match and the spectators
+//
+// A spectator has no match, spectating is the match it follows or SPECTATOR_LOBBY while it waits for a match.
+typedef struct {
+    NetSocket socket;
+    int match;
+    int seat;
+    int spectating;
+    int previous_spectator;
+    int next_spectator;
+    int next_free;
+    bool writing;
+    uint16_t receive_size;
+    uint16_t send_size;
+    uint8_t receive_buffer[CONNECTION_RECEIVE_SIZE];
+    uint8_t send_buffer[CONNECTION_SEND_SIZE];
+} Connection;
+
+// Structure for a shot to compute on the AI worker pool, with the NetCellView of the board it shoots at
+typedef struct {
+    int match;
+    uint32_t generation;
+    uint8_t view[RULES_NUM_CELLS];
+    uint8_t x;
+    uint8_t y;
+} AIJob;
+
+// Structure for the job and the result of a match slot waiting in the AI worker pool
+typedef struct {
+    AIJob job;
+    AIJob result;
+    bool has_job;
+    bool has_result;
+} AISlot;
+
+// Structure for the AI worker pool, jobs and results are passed through two rings of match slots guarded by one
+// mutex
+//
+// A slot is in each ring at most once, so the rings never hold more than one entry per match. A job queued for a new
+// generation of a slot replaces the job of the previous one if no worker took it yet, and a result replaces the
+// result of an older generation not applied yet.
+typedef struct {
+    pthread_t *threads;
+    int num_threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    AISlot *slots;
+    int *job_ring;
+    int job_start;
+    int num_jobs;
+    int *result_ring;
+    int result_start;
+    int num_results;
+    int capacity;
+    int event_fd;
+    bool quit;
+} AIPool;
+
+// Structure for the state of the server
+typedef struct {
+    int epoll_fd;
+    NetSocket listener;
+    Match *matches;
+    int max_matches;
+    int free_match;
+    int waiting_match;
+    Connection *connections;
+    int max_connections;
+    int free_connection;
+    int lobby_spectators;
+    int latest_match;
+    AIPool ai_pool;
+    int live_matches;
+    int peak_matches;
+    int live_connections;
+    int live_spectators;
+    uint64_t matches_finished;
+    uint64_t shots;
+    uint64_t broadcasts;
+    uint64_t spectator_messages;
+} Server;
+
+/// \brief Parses the options, starts the server and runs the event loop until SIGINT or SIGTERM.
+///
+/// Usage: battleship_server [--port <port>] [--max-matches <n>] [--ai-workers <n>] [--max-spectators <n>].
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 on success, 1 on failure.
+int main(int argc, char *argv[]);
+
+/// \brief Sets the flag that stops the event loop.
+///
+/// \param signal_number The signal received.
+/// \return void
+void handle_stop_signal(int signal_number);
+
+/// \brief Allocates the match arena, the connection pool and the AI worker pool, and starts listening.
+///
+/// \param server A pointer to the Server.
+/// \param port The port to listen on.
+/// \param max_matches The number of matches of the arena.
+/// \param ai_workers The number of AI worker threads.
+/// \param max_spectators The number of spectator connections of the pool.
+/// \return bool Returns true on success, false otherwise.
+bool start_server(Server *server, int port, int max_matches, int ai_workers, int max_spectators);
+
+/// \brief Closes all connections, stops the AI worker pool and frees the arena.
+///
+/// \param server A pointer to the Server.
+/// \return void
+void stop_server(Server *server);
+
+/// \brief Runs the epoll event loop until the stop flag is set.
+///
+/// \param server A pointer to the Server.
+/// \return void
+void run_server(Server *server);
+
+/// \brief Prints the number of matches and connections, the shots per second and the memory use.
+///
+/// \param server A pointer to the Server.
+/// \param elapsed The time since the last statistics, in seconds.
+/// \param shots The number of shots since the last statistics.
+/// \return void
+void print_server_stats(const Server *server, double elapsed, uint64_t shots);
+
+/// \brief Accepts all pending connections.
+///
+/// \param server A pointer to the Server.
+/// \return void
+void accept_connections(Server *server);
+
+/// \brief Closes a connection, the opponent wins the match it was playing.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \return void
+void close_connection(Server *server, int connection_index);
+
+/// \brief Receives and handles the messages of a connection.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \return void
+void receive_messages(Server *server, int connection_index);
+
+/// \brief Sends a message, buffering what the socket does not take at once.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the message was sent or buffered, false if the connection was closed.
+bool send_message(Server *server, int connection_index, const NetMessage *message);
+
+/// \brief Sends encoded bytes, buffering what the socket does not take at once.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \param data The encoded messages.
+/// \param size The number of bytes.
+/// \return bool Returns true if the bytes were sent or buffered, false if the connection was closed.
+bool send_bytes(Server *server, int connection_index, const uint8_t *data, size_t size);
+
+/// \brief Sends the buffered bytes of a connection.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \return bool Returns true if the connection is still open, false if it was closed.
+bool flush_connection(Server *server, int connection_index);
+
+/// \brief Handles a message of a client.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the connection is still open, false if it was closed.
+bool handle_client_message(Server *server, int connection_index, const NetMessage *message);
+
+/// \brief Validates the fleet of a client and seats it in a match.
+///
+/// Against the AI a new match is started at once, otherwise the client waits for the next client.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \param message A pointer to the NET_MSG_PLACE message.
+/// \return bool Returns true if the connection is still open, false if it was closed.
+bool join_match(Server *server, int connection_index, const NetMessage *message);
+
+/// \brief Makes a connection follow a match, or the next match to start if there is no live match.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \param match_id The index of the match, or NET_ANY_MATCH for the latest match.
+/// \return bool Returns true if the connection is still open, false if it was closed.
+bool add_spectator(Server *server, int connection_index, int match_id);
+
+/// \brief Links a spectator at the head of a list.
+///
+/// \param server A pointer to the Server.
+/// \param head A pointer to the first spectator of the list.
+/// \param connection_index The index of the connection.
+/// \param spectating The match of the list, or SPECTATOR_LOBBY.
+/// \return void
+void link_spectator(Server *server, int *head, int connection_index, int spectating);
+
+/// \brief Unlinks a spectator from the list it is in.
+///
+/// \param server A pointer to the Server.
+/// \param connection_index The index of the connection.
+/// \return void
+void unlink_spectator(Server *server, int connection_index);
+
+/// \brief Builds the snapshot of a match: the turn, the remaining ships and the shots at both boards.
+///
+/// \param match A pointer to the Match.
+/// \param message A pointer to the NetMessage receiving the snapshot.
+/// \return void
+void get_match_snapshot(const Match *match, NetMessage *message);
+
+/// \brief Sends one encoded buffer to every spectator of a match.
+///
+/// \param server A pointer to the Server.
+/// \param match_index The index of the match.
+/// \param message A pointer to the NetMessage, encoded once for all spectators.
+/// \return void
+void broadcast_to_spectators(Server *server, int match_index, const NetMessage *message);
+
+/// \brief Takes a match from the free list of the arena.
+///
+/// \param server A pointer to the Server.
+/// \return int The index of the match, or NO_INDEX if the arena is full.
+int allocate_match(Server *server);
+
+/// \brief Returns a match to the free list, the connections seated in it go back to the lobby.
+///
+/// \param server A pointer to the Server.
+/// \param match_index The index of the match.
+/// \return void
+void free_match(Server *server, int match_index);
+
+/// \brief Sends START to the seats of a match that just began, and lets the AI shoot if it has the first turn.
+///
+/// \param server A pointer to the Server.
+/// \param match_index The index of the match.
+/// \return void
+void start_match(Server *server, int match_index);
+
+/// \brief Resolves a shot of a seat, tells both seats and ends the match when the last ship is sunk.
+///
+/// \param server A pointer to the Server.
+/// \param match_index The index of the match.
+/// \param seat The seat shooting.
+/// \param x The x-coordinate of the cell.
+/// \param y The y-coordinate of the cell.
+/// \return bool Returns true if the shot was valid, false otherwise.
+bool resolve_shot(Server *server, int match_index, int seat, int x, int y);
+
+/// \brief Sends GAME_OVER to the seats still connected and frees the match.
+///
+/// \param server A pointer to the Server.
+/// \param match_index The index of the match.
+/// \param winner The seat of the winner.
+/// \return void
+void finish_match(Server *server, int match_index, int winner);
+
+/// \brief Queues the next shot of the AI seat of a match on the worker pool, if it is its turn.
+///
+/// \param server A pointer to the Server.
+/// \param match_index The index of the match.
+/// \return void
+void request_ai_shot(Server *server, int match_index);
+
+/// \brief Applies the shots computed by the AI worker pool.
+///
+/// A result is dropped unless its match is still the same generation, is waiting for the AI and the AI has the turn.
+///
+/// \param server A pointer to the Server.
+/// \return void
+void apply_ai_shots(Server *server);
+
+/// \brief Starts the AI worker threads.
+///
+/// \param pool A pointer to the AIPool.
+/// \param num_threads The number of threads.
+/// \param capacity The number of match slots, each has at most one job and one result queued.
+/// \return bool Returns true on success, false otherwise.
+bool start_ai_pool(AIPool *pool, int num_threads, int capacity);
+
+/// \brief Stops the AI worker threads and frees the rings.
+///
+/// \param pool A pointer to the AIPool.
+/// \return void
+void stop_ai_pool(AIPool *pool);
+
+/// \brief The function run by each AI worker thread.
+///
+/// \param data A pointer to the AIPool.
+/// \return void* Always NULL.
+void *ai_worker_thread(void *data);
+
+/// \brief Returns the value of the monotonic clock in milliseconds.
+///
+/// \return uint64_t The time in milliseconds.
+uint64_t get_time_ms(void);
+
+/// \brief Returns the resident memory of the process.
+///
+/// \return size_t The resident memory in bytes, or 0 if it is not known.
+size_t get_resident_memory(void);
+
+// Set by SIGINT and SIGTERM
+static volatile sig_atomic_t stop_requested = 0;
+
+int main(int argc, char *argv[]) {
+    int port = NET_DEFAULT_PORT;
+    int max_matches = SERVER_DEFAULT_MAX_MATCHES;
+    int ai_workers = SERVER_DEFAULT_AI_WORKERS;
+    int max_spectators = SERVER_DEFAULT_MAX_SPECTATORS;
+
+    // Parse the command-line options
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-matches") == 0 && i + 1 < argc) {
+            max_matches = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ai-workers") == 0 && i + 1 < argc) {
+            ai_workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-spectators") == 0 && i + 1 < argc) {
+            max_spectators = atoi(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            port = 0;
+            break;
+        }
+    }
+    if (port <= 0 || port > 65535 || max_matches <= 0 || max_matches >= NET_ANY_MATCH || ai_workers <= 0 ||
+        max_spectators < 0) {
+        printf("Usage: %s [--port <port>] [--max-matches <n>] [--ai-workers <n>] [--max-spectators <n>]\n", argv[0]);
+        return 1;
+    }
+
+    // Stop cleanly on Ctrl+C, and report closed sockets as errors instead of signals
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    Server server;
+    if (!start_server(&server, port, max_matches, ai_workers, max_spectators)) {
+        stop_server(&server);
+        return 1;
+    }
+    printf("Serving up to %d matches on port %d with %d AI workers.\n", max_matches, port, ai_workers);
+
+    run_server(&server);
+
+    printf("Finished %llu matches, peak %d concurrent matches.\n", (unsigned long long) server.matches_finished,
+           server.peak_matches);
+    printf("Sent %llu spectator messages from %llu encoded buffers.\n",
+           (unsigned long long) server.spectator_messages, (unsigned long long) server.broadcasts);
+    stop_server(&server);
+    return 0;
+}
+
+void handle_stop_signal(int signal_number) {
+    (void) signal_number;
+    stop_requested = 1;
+}
+
+bool start_server(Server *server, int port, int max_matches, int ai_workers, int max_spectators) {
+    memset(server, 0, sizeof(Server));
+    server->epoll_fd = -1;
+    server->listener = NET_INVALID_SOCKET;
+    server->waiting_match = NO_INDEX;
+    server->lobby_spectators = NO_INDEX;
+    server->latest_match = NO_INDEX;
+    server->ai_pool.event_fd = -1;
+
+    // Allocate the arena and the pool once, slots are linked into free lists
+    server->max_matches = max_matches;
+    server->max_connections = 2 * max_matches + max_spectators;
+    server->matches = calloc(max_matches, sizeof(Match));
+    server->connections = calloc(server->max_connections, sizeof(Connection));
+    if (server->matches == NULL || server->connections == NULL) {
+        printf("Could not allocate %d matches.\n", max_matches);
+        return false;
+    }
+    for (int i = 0; i < max_matches; i++) {
+        server->matches[i].next_free = i + 1 < max_matches ? i + 1 : NO_INDEX;
+    }
+    for (int i = 0; i < server->max_connections; i++) {
+        server->connections[i].socket = NET_INVALID_SOCKET;
+        server->connections[i].next_free = i + 1 < server->max_connections ? i + 1 : NO_INDEX;
+    }
+
+    // Start the AI workers, they wake the event loop through an eventfd
+    if (!start_ai_pool(&server->ai_pool, ai_workers, max_matches)) {
+        printf("Could not start the AI workers.\n");
+        return false;
+    }
+
+    server->epoll_fd = epoll_create1(0);
+    server->listener = net_listen((uint16_t) port);
+    if (server->epoll_fd < 0 || server->listener == NET_INVALID_SOCKET) {
+        printf("Could not listen on port %d: %s\n", port, strerror(errno));
+        return false;
+    }
+
+    struct epoll_event event = {.events = EPOLLIN, .data.u32 = LISTENER_ID};
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listener, &event);
+    event.data.u32 = AI_EVENT_ID;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->ai_pool.event_fd, &event);
+    return true;
+}
+
+void stop_server(Server *server) {
+    if (server->connections != NULL) {
+        for (int i = 0; i < server->max_connections; i++) {
+            net_close(server->connections[i].socket);
+        }
+    }
+    stop_ai_pool(&server->ai_pool);
+    net_close(server->listener);
+    if (server->epoll_fd >= 0) {
+        close(server->epoll_fd);
+    }
+    free(server->matches);
+    free(server->connections);
+    server->matches = NULL;
+    server->connections = NULL;
+}
+
+void run_server(Server *server) {
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    uint64_t last_stats = get_time_ms();
+    uint64_t last_shots = 0;
+
+    while (!stop_requested) {
+        int num_events = epoll_wait(server->epoll_fd, events, SERVER_MAX_EVENTS, SERVER_STATS_INTERVAL);
+        if (num_events < 0 && errno != EINTR) {
+            printf("epoll_wait failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < num_events; i++) {
+            uint32_t id = events[i].data.u32;
+            if (id == LISTENER_ID) {
+                accept_connections(server);
+            } else if (id == AI_EVENT_ID) {
+                apply_ai_shots(server);
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(server, (int) id);
+            } else {
+                // A connection closed while writing is not read
+                if ((events[i].events & EPOLLOUT) && !flush_connection(server, (int) id)) {
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    receive_messages(server, (int) id);
+                }
+            }
+        }
+
+        // Print the statistics regularly while there is traffic
+        uint64_t now = get_time_ms();
+        if (now - last_stats >= SERVER_STATS_INTERVAL) {
+            if (server->shots != last_shots || server->live_connections > 0) {
+                print_server_stats(server, (double) (now - last_stats) / 1000.0, server->shots - last_shots);
+            }
+            last_stats = now;
+            last_shots = server->shots;
+        }
+    }
+}
+
+void print_server_stats(const Server *server, double elapsed, uint64_t shots) {
+    size_t bytes_per_match = sizeof(Match) + 2 * sizeof(Connection);
+    size_t resident = get_resident_memory();
+    printf("%d matches (peak %d), %d connections, %d spectators, %llu finished, %.0f shots/s, "
+           "%zu bytes per match in the arena, %.1f MB resident\n", server->live_matches, server->peak_matches,
+           server->live_connections, server->live_spectators, (unsigned long long) server->matches_finished,
+           (double) shots / elapsed, bytes_per_match, (double) resident / (1024.0 * 1024.0));
+}
+
+void accept_connections(Server *server) {
+    for (;;) {
+        NetSocket socket = net_accept(server->listener);
+        if (socket == NET_INVALID_SOCKET) {
+            return;
+        }
+
+        // Refuse the connection if the pool is full
+        int index = server->free_connection;
+        if (index == NO_INDEX) {
+            net_close(socket);
+            continue;
+        }
+        Connection *connection = &server->connections[index];
+        server->free_connection = connection->next_free;
+        connection->socket = socket;
+        connection->match = NO_INDEX;
+        connection->seat = 0;
+        connection->spectating = NO_INDEX;
+        connection->writing = false;
+        connection->receive_size = 0;
+        connection->send_size = 0;
+        server->live_connections++;
+
+        struct epoll_event event = {.events = EPOLLIN, .data.u32 = (uint32_t) index};
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, socket, &event);
+    }
+}
+
+void close_connection(Server *server, int connection_index) {
+    Connection *connection = &server->connections[connection_index];
+    if (connection->socket == NET_INVALID_SOCKET) {
+        return;
+    }
+
+    // Leaving a match hands the win to the opponent
+    unlink_spectator(server, connection_index);
+    int match_index = connection->match;
+    if (match_index != NO_INDEX) {
+        Match *match = &server->matches[match_index];
+        match->connections[connection->seat] = NO_INDEX;
+        if (match->state == MATCH_PLAYING) {
+            finish_match(server, match_index, 1 - connection->seat);
+        } else {
+            free_match(server, match_index);
+        }
+    }
+
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->socket, NULL);
+    net_close(connection->socket);
+    connection->socket = NET_INVALID_SOCKET;
+    connection->match = NO_INDEX;
+    connection->next_free = server->free_connection;
+    server->free_connection = connection_index;
+    server->live_connections--;
+}
+
+void receive_messages(Server *server, int connection_index) {
+    Connection *connection = &server->connections[connection_index];
+    int received = net_receive(connection->socket, connection->receive_buffer + connection->receive_size,
+                               CONNECTION_RECEIVE_SIZE - connection->receive_size);
+    if (received < 0) {
+        close_connection(server, connection_index);
+        return;
+    }
+    connection->receive_size += received;
+
+    // Handle the whole messages, a partial message stays at the start of the buffer
+    size_t offset = 0;
+    for (;;) {
+        NetMessage message;
+        int size = decode_net_message(connection->receive_buffer + offset, connection->receive_size - offset,
+                                      &message);
+        if (size == 0) {
+            break;
+        }
+        if (size < 0) {
+            close_connection(server, connection_index);
+            return;
+        }
+        offset += size;
+        if (!handle_client_message(server, connection_index, &message)) {
+            return;
+        }
+    }
+    memmove(connection->receive_buffer, connection->receive_buffer + offset, connection->receive_size - offset);
+    connection->receive_size -= offset;
+}
+
+bool send_message(Server *server, int connection_index, const NetMessage *message) {
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = encode_net_message(message, buffer);
+    return send_bytes(server, connection_index, buffer, size);
+}
+
+bool send_bytes(Server *server, int connection_index, const uint8_t *data, size_t size) {
+    // A client that does not read its messages is dropped
+    Connection *connection = &server->connections[connection_index];
+    if (connection->send_size + size > CONNECTION_SEND_SIZE) {
+        close_connection(server, connection_index);
+        return false;
+    }
+    memcpy(connection->send_buffer + connection->send_size, data, size);
+    connection->send_size += size;
+    return flush_connection(server, connection_index);
+}
+
+bool flush_connection(Server *server, int connection_index) {
+    Connection *connection = &server->connections[connection_index];
+    if (connection->send_size > 0) {
+        int sent = net_send(connection->socket, connection->send_buffer, connection->send_size);
+        if (sent < 0) {
+            close_connection(server, connection_index);
+            return false;
+        }
+        memmove(connection->send_buffer, connection->send_buffer + sent, connection->send_size - sent);
+        connection->send_size -= sent;
+    }
+
+    // Only wait for the socket to be writable while bytes are left
+    bool writing = connection->send_size > 0;
+    if (writing != connection->writing) {
+        struct epoll_event event = {.events = EPOLLIN | (writing ? EPOLLOUT : 0),
+                                    .data.u32 = (uint32_t) connection_index};
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->socket, &event);
+        connection->writing = writing;
+    }
+    return true;
+}
+
+bool handle_client_message(Server *server, int connection_index, const NetMessage *message) {
+    Connection *connection = &server->connections[connection_index];
+    int match_index = connection->match;
+
+    switch (message->type) {
+        case NET_MSG_PLACE:
+            if (match_index != NO_INDEX || connection->spectating != NO_INDEX) {
+                break;
+            }
+            return join_match(server, connection_index, message);
+
+        case NET_MSG_SPECTATE:
+            if (match_index != NO_INDEX || connection->spectating != NO_INDEX) {
+                break;
+            }
+            return add_spectator(server, connection_index, message->match);
+
+        case NET_MSG_SHOT:
+            // Shots out of turn or at a cell already shot are ignored, like in the game
+            if (match_index != NO_INDEX && server->matches[match_index].state == MATCH_PLAYING &&
+                server->matches[match_index].turn == connection->seat) {
+                resolve_shot(server, match_index, connection->seat, message->x, message->y);
+            }
+            break;
+
+        case NET_MSG_RESIGN:
+            if (match_index != NO_INDEX && server->matches[match_index].state == MATCH_PLAYING) {
+                finish_match(server, match_index, 1 - connection->seat);
+            } else if (match_index != NO_INDEX) {
+                free_match(server, match_index);
+            }
+            break;
+
+        default:
+            // The other messages are only sent by the server or between two games
+            close_connection(server, connection_index);
+            return false;
+    }
+
+    return server->connections[connection_index].socket != NET_INVALID_SOCKET;
+}
+
+bool join_match(Server *server, int connection_index, const NetMessage *message) {
+    Connection *connection = &server->connections[connection_index];
+
+    // Validate the fleet with the rules of the game
+    CompactBoard board;
+    if (!place_compact_fleet(&board, message->fleet)) {
+        close_connection(server, connection_index);
+        return false;
+    }
+
+    // Join the client waiting for an opponent
+    if (message->mode == NET_MODE_PVP && server->waiting_match != NO_INDEX) {
+        int match_index = server->waiting_match;
+        Match *match = &server->matches[match_index];
+        server->waiting_match = NO_INDEX;
+        match->boards[1] = board;
+        match->connections[1] = connection_index;
+        connection->match = match_index;
+        connection->seat = 1;
+        start_match(server, match_index);
+        return server->connections[connection_index].socket != NET_INVALID_SOCKET;
+    }
+
+    // Otherwise open a new match
+    int match_index = allocate_match(server);
+    if (match_index == NO_INDEX) {
+        close_connection(server, connection_index);
+        return false;
+    }
+    Match *match = &server->matches[match_index];
+    match->boards[0] = board;
+    match->connections[0] = connection_index;
+    connection->match = match_index;
+    connection->seat = 0;
+
+    if (message->mode == NET_MODE_AI) {
+        // The AI places its fleet with the server's generator, seeded per match
+        pcg32_random_t rng;
+        pcg32_srandom_r(&rng, get_time_ms() ^ ((uint64_t) match->generation << 32), (uint64_t) match_index);
+        place_random_compact_fleet(&match->boards[1], &rng, NULL);
+        start_match(server, match_index);
+    } else {
+        match->state = MATCH_WAITING;
+        server->waiting_match = match_index;
+    }
+    return server->connections[connection_index].socket != NET_INVALID_SOCKET;
+}
+
+bool add_spectator(Server *server, int connection_index, int match_id) {
+    // Find the match to follow
+    int match_index = match_id == NET_ANY_MATCH ? server->latest_match : match_id;
+    if (match_index >= server->max_matches) {
+        match_index = NO_INDEX;
+    }
+    if (match_id == NET_ANY_MATCH && (match_index == NO_INDEX || server->matches[match_index].state != MATCH_PLAYING)) {
+        match_index = NO_INDEX;
+        for (int i = 0; i < server->max_matches && match_index == NO_INDEX; i++) {
+            match_index = server->matches[i].state == MATCH_PLAYING ? i : NO_INDEX;
+        }
+    }
+
+    // Wait for the next match if there is nothing to follow yet
+    if (match_index == NO_INDEX || server->matches[match_index].state != MATCH_PLAYING) {
+        link_spectator(server, &server->lobby_spectators, connection_index, SPECTATOR_LOBBY);
+        return true;
+    }
+
+    // Start the stream with a snapshot, the deltas follow
+    Match *match = &server->matches[match_index];
+    link_spectator(server, &match->first_spectator, connection_index, match_index);
+    NetMessage snapshot;
+    get_match_snapshot(match, &snapshot);
+    server->spectator_messages++;
+    return send_message(server, connection_index, &snapshot);
+}
+
+void link_spectator(Server *server, int *head, int connection_index, int spectating) {
+    Connection *connection = &server->connections[connection_index];
+    connection->spectating = spectating;
+    connection->previous_spectator = NO_INDEX;
+    connection->next_spectator = *head;
+    if (*head != NO_INDEX) {
+        server->connections[*head].previous_spectator = connection_index;
+    }
+    *head = connection_index;
+    server->live_spectators++;
+}
+
+void unlink_spectator(Server *server, int connection_index) {
+    Connection *connection = &server->connections[connection_index];
+    if (connection->spectating == NO_INDEX) {
+        return;
+    }
+
+    int *head = connection->spectating == SPECTATOR_LOBBY ? &server->lobby_spectators
+                                                          : &server->matches[connection->spectating].first_spectator;
+    if (connection->previous_spectator != NO_INDEX) {
+        server->connections[connection->previous_spectator].next_spectator = connection->next_spectator;
+    } else {
+        *head = connection->next_spectator;
+    }
+    if (connection->next_spectator != NO_INDEX) {
+        server->connections[connection->next_spectator].previous_spectator = connection->previous_spectator;
+    }
+    connection->spectating = NO_INDEX;
+    server->live_spectators--;
+}
+
+void get_match_snapshot(const Match *match, NetMessage *message) {
+    memset(message, 0, sizeof(NetMessage));
+    message->type = NET_MSG_SNAPSHOT;
+    message->seat = (uint8_t) (match->turn + 1);
+    for (int seat = 0; seat < 2; seat++) {
+        message->remaining_ships[seat] = match->boards[seat].remaining_ships;
+        get_compact_view(&match->boards[seat], message->view[seat]);
+    }
+}
+
+void broadcast_to_spectators(Server *server, int match_index, const NetMessage *message) {
+    int spectator = server->matches[match_index].first_spectator;
+    if (spectator == NO_INDEX) {
+        return;
+    }
+
+    // Encode once, every spectator receives the same bytes
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = encode_net_message(message, buffer);
+    server->broadcasts++;
+    while (spectator != NO_INDEX) {
+        // A spectator too slow to take the message is closed and unlinked, so the next one is read first
+        int next_spectator = server->connections[spectator].next_spectator;
+        send_bytes(server, spectator, buffer, size);
+        server->spectator_messages++;
+        spectator = next_spectator;
+    }
+}
+
+int allocate_match(Server *server) {
+    int match_index = server->free_match;
+    if (match_index == NO_INDEX) {
+        return NO_INDEX;
+    }
+
+    Match *match = &server->matches[match_index];
+    server->free_match = match->next_free;
+    match->connections[0] = NO_INDEX;
+    match->connections[1] = NO_INDEX;
+    match->first_spectator = NO_INDEX;
+    match->state = MATCH_WAITING;
+    match->turn = 0;
+    match->ai_pending = false;
+    server->live_matches++;
+    if (server->live_matches > server->peak_matches) {
+        server->peak_matches = server->live_matches;
+    }
+    return match_index;
+}
+
+void free_match(Server *server, int match_index) {
+    Match *match = &server->matches[match_index];
+    if (match->state == MATCH_FREE) {
+        return;
+    }
+
+    for (int seat = 0; seat < 2; seat++) {
+        if (match->connections[seat] != NO_INDEX) {
+            server->connections[match->connections[seat]].match = NO_INDEX;
+        }
+    }
+    if (server->waiting_match == match_index) {
+        server->waiting_match = NO_INDEX;
+    }
+    while (match->first_spectator != NO_INDEX) {
+        unlink_spectator(server, match->first_spectator);
+    }
+
+    // A new generation makes the AI results computed for this match stale
+    match->state = MATCH_FREE;
+    match->generation++;
+    match->next_free = server->free_match;
+    server->free_match = match_index;
+    server->live_matches--;
+}
+
+void start_match(Server *server, int match_index) {
+    Match *match = &server->matches[match_index];
+    match->state = MATCH_PLAYING;
+    match->turn = 0;
+    server->latest_match = match_index;
+
+    // The spectators waiting for a match follow this one, they all receive the same snapshot
+    while (server->lobby_spectators != NO_INDEX) {
+        int spectator = server->lobby_spectators;
+        unlink_spectator(server, spectator);
+        link_spectator(server, &match->first_spectator, spectator, match_index);
+    }
+    if (match->first_spectator != NO_INDEX) {
+        NetMessage snapshot;
+        get_match_snapshot(match, &snapshot);
+        broadcast_to_spectators(server, match_index, &snapshot);
+    }
+
+    for (int seat = 0; seat < 2 && match->state == MATCH_PLAYING; seat++) {
+        if (match->connections[seat] != NO_INDEX) {
+            NetMessage message = {.type = NET_MSG_START, .seat = (uint8_t) (seat + 1)};
+            send_message(server, match->connections[seat], &message);
+        }
+    }
+    request_ai_shot(server, match_index);
+}
+
+bool resolve_shot(Server *server, int match_index, int seat, int x, int y) {
+    Match *match = &server->matches[match_index];
+    CompactBoard *target = &match->boards[1 - seat];
+    NetShip sunk_ship = {0};
+    int result = apply_compact_shot(target, x, y, &sunk_ship);
+    if (result < 0) {
+        return false;
+    }
+    server->shots++;
+
+    // Tell the shooter the result and the target where it was shot
+    NetMessage message = {.type = NET_MSG_RESULT, .x = (uint8_t) x, .y = (uint8_t) y,
+                          .result = (NetShotResult) result, .ship = sunk_ship};
+    int shooter = match->connections[seat];
+    int shot = match->connections[1 - seat];
+    if (shooter != NO_INDEX) {
+        send_message(server, shooter, &message);
+    }
+    if (shot != NO_INDEX && match->state == MATCH_PLAYING) {
+        message.type = NET_MSG_SHOT;
+        send_message(server, shot, &message);
+    }
+
+    // Sending may have closed a connection and ended the match
+    if (match->state != MATCH_PLAYING) {
+        return true;
+    }
+
+    // The spectators only receive the shot, they already know the rest of the match
+    NetMessage delta = {.type = NET_MSG_DELTA, .seat = (uint8_t) (seat + 1), .x = (uint8_t) x, .y = (uint8_t) y,
+                        .result = (NetShotResult) result, .ship = sunk_ship};
+    broadcast_to_spectators(server, match_index, &delta);
+    if (target->remaining_ships == 0) {
+        finish_match(server, match_index, seat);
+        return true;
+    }
+
+    // A miss passes the turn
+    if (result == NET_RESULT_MISS) {
+        match->turn = (uint8_t) (1 - seat);
+    }
+    request_ai_shot(server, match_index);
+    return true;
+}
+
+void finish_match(Server *server, int match_index, int winner) {
+    Match *match = &server->matches[match_index];
+    NetMessage message = {.type = NET_MSG_GAME_OVER, .seat = (uint8_t) (winner + 1)};
+
+    broadcast_to_spectators(server, match_index, &message);
+
+    // Free the match first, so a connection closed while sending does not finish it again
+    int connections[2] = {match->connections[0], match->connections[1]};
+    free_match(server, match_index);
+    server->matches_finished++;
+    for (int seat = 0; seat < 2; seat++) {
+        if (connections[seat] != NO_INDEX) {
+            send_message(server, connections[seat], &message);
+        }
+    }
+}
+
+void request_ai_shot(Server *server, int match_index) {
+    Match *match = &server->matches[match_index];
+    if (match->state != MATCH_PLAYING || match->connections[match->turn] != NO_INDEX || match->ai_pending) {
+        return;
+    }
+
+    // Copy what the AI may know of the board it shoots at, the worker never reads the arena
+    AIJob job;
+    job.match = match_index;
+    job.generation = match->generation;
+    get_compact_view(&match->boards[1 - match->turn], job.view);
+
+    // A job of a previous generation still queued for the slot is replaced, the slot keeps its place in the ring
+    AIPool *pool = &server->ai_pool;
+    AISlot *slot = &pool->slots[match_index];
+    pthread_mutex_lock(&pool->mutex);
+    slot->job = job;
+    if (!slot->has_job) {
+        slot->has_job = true;
+        pool->job_ring[(pool->job_start + pool->num_jobs) % pool->capacity] = match_index;
+        pool->num_jobs++;
+        pthread_cond_signal(&pool->condition);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    match->ai_pending = true;
+}
+
+void apply_ai_shots(Server *server) {
+    AIPool *pool = &server->ai_pool;
+    uint64_t count;
+    if (read(pool->event_fd, &count, sizeof(count)) != sizeof(count)) {
+        return;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        bool has_result = pool->num_results > 0;
+        AIJob result;
+        if (has_result) {
+            AISlot *slot = &pool->slots[pool->result_ring[pool->result_start]];
+            result = slot->result;
+            slot->has_result = false;
+            pool->result_start = (pool->result_start + 1) % pool->capacity;
+            pool->num_results--;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+        if (!has_result) {
+            break;
+        }
+
+        // Drop the results of matches that ended while the shot was computed, and any result the AI is not waiting
+        // for on its own turn
+        Match *match = &server->matches[result.match];
+        if (match->generation != result.generation || match->state != MATCH_PLAYING || !match->ai_pending ||
+            match->connections[match->turn] != NO_INDEX) {
+            continue;
+        }
+        match->ai_pending = false;
+        resolve_shot(server, result.match, match->turn, result.x, result.y);
+    }
+}
+
+bool start_ai_pool(AIPool *pool, int num_threads, int capacity) {
+    pool->capacity = capacity;
+    pool->slots = calloc(capacity, sizeof(AISlot));
+    pool->job_ring = calloc(capacity, sizeof(int));
+    pool->result_ring = calloc(capacity, sizeof(int));
+    pool->threads = calloc(num_threads, sizeof(pthread_t));
+    pool->event_fd = eventfd(0, EFD_NONBLOCK);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->condition, NULL);
+    if (pool->slots == NULL || pool->job_ring == NULL || pool->result_ring == NULL || pool->threads == NULL ||
+        pool->event_fd < 0) {
+        return false;
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, ai_worker_thread, pool) != 0) {
+            return false;
+        }
+        pool->num_threads++;
+    }
+    return true;
+}
+
+void stop_ai_pool(AIPool *pool) {
+    if (pool->threads == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->condition);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->condition);
+    if (pool->event_fd >= 0) {
+        close(pool->event_fd);
+    }
+    free(pool->threads);
+    free(pool->slots);
+    free(pool->job_ring);
+    free(pool->result_ring);
+    pool->threads = NULL;
+}
+
+void *ai_worker_thread(void *data) {
+    AIPool *pool = (AIPool *) data;
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, get_time_ms(), (uint64_t) (uintptr_t) &rng);
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (pool->num_jobs == 0 && !pool->quit) {
+            pthread_cond_wait(&pool->condition, &pool->mutex);
+        }
+        if (pool->quit) {
+            break;
+        }
+        AISlot *slot = &pool->slots[pool->job_ring[pool->job_start]];
+        AIJob job = slot->job;
+        slot->has_job = false;
+        pool->job_start = (pool->job_start + 1) % pool->capacity;
+        pool->num_jobs--;
+        pthread_mutex_unlock(&pool->mutex);
+
+        choose_compact_shot(job.view, &rng, &job.x, &job.y);
+
+        // Hand the shot back to the event loop, a result of an older generation not applied yet is replaced, and
+        // one computed after a newer one is dropped
+        pthread_mutex_lock(&pool->mutex);
+        if (slot->has_result && (int32_t) (job.generation - slot->result.generation) < 0) {
+            continue;
+        }
+        slot->result = job;
+        if (!slot->has_result) {
+            slot->has_result = true;
+            pool->result_ring[(pool->result_start + pool->num_results) % pool->capacity] = job.match;
+            pool->num_results++;
+        }
+        uint64_t one = 1;
+        if (write(pool->event_fd, &one, sizeof(one)) != sizeof(one)) {
+            printf("Could not wake the event loop: %s\n", strerror(errno));
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+uint64_t get_time_ms(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000 + (uint64_t) time.tv_nsec / 1000000;
+}
+
+size_t get_resident_memory(void) {
+    // The second field of statm is the number of resident pages
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == NULL) {
+        return 0;
+    }
+    unsigned long size, resident;
+    int count = fscanf(file, "%lu %lu", &size, &resident);
+    fclose(file);
+    return count == 2 ? (size_t) resident * (size_t) sysconf(_SC_PAGESIZE) : 0;
+}
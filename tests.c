@@ -0,0 +1,703 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "env.h"
+#include "net.h"
+#include "policy.h"
+#include "rules.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+#define TEST_WEIGHTS_FILE_NAME "test_weights.bspw"
+#define TEST_SERVER_CYCLES 3000
+#define TEST_SERVER_BATCH 20
+#define TEST_SERVER_TIMEOUT 5000
+#define TEST_RECEIVE_SIZE (64 * 1024)
+
+// Structure for the connection of the tests to a match server, with the bytes received but not decoded yet, enough
+// for the messages of every resigned match
+typedef struct {
+    NetSocket socket;
+    size_t receive_size;
+    uint8_t receive_buffer[TEST_RECEIVE_SIZE];
+} TestClient;
+
+// Number of checks that failed, the executable fails if it is not zero
+static int num_failures = 0;
+
+// Records a failed check with its location, without stopping the tests
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+/// \brief Runs every test and prints the number of failed checks.
+///
+/// Usage: battleship_tests [--server <path>]. With --server, only the match server at the path is tested, see
+/// test_server_resign_cycles.
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 if every check passed, 1 otherwise.
+int main(int argc, char *argv[]);
+
+/// \brief Prints a check that failed and counts it.
+///
+/// \param passed Whether the check passed.
+/// \param condition The text of the condition.
+/// \param file The source file of the check.
+/// \param line The line of the check.
+/// \return void
+void check(bool passed, const char *condition, const char *file, int line);
+
+/// \brief Checks that decode_net_message reads back what encode_net_message wrote, byte by byte.
+///
+/// \return void
+void test_net_round_trips(void);
+
+/// \brief Checks that decode_net_message rejects unknown types and out-of-range fields, and waits for whole messages.
+///
+/// \return void
+void test_net_rejections(void);
+
+/// \brief Checks that a network written by save_policy_network is loaded back unchanged.
+///
+/// \return void
+void test_policy_round_trip(void);
+
+/// \brief Checks that load_policy_network rejects headers out of bounds and files of the wrong size.
+///
+/// \return void
+void test_policy_rejections(void);
+
+/// \brief Writes a weights file from a header and a number of floats.
+///
+/// \param header A pointer to the PolicyFileHeader.
+/// \param num_floats The number of zero floats written after the header.
+/// \return bool Returns true if the file was written, false otherwise.
+bool write_test_weights(const PolicyFileHeader *header, size_t num_floats);
+
+/// \brief Checks that an environment starts a new game with cleared observations once the fleet is sunk.
+///
+/// \return void
+void test_env_auto_reset(void);
+
+/// \brief Checks that invalid shots are penalized without changing the observations, and that long games are truncated.
+///
+/// \return void
+void test_env_invalid_and_truncated(void);
+
+/// \brief Checks get_compact_density against a count of every position of every ship, along random games.
+///
+/// \return void
+void test_compact_density(void);
+
+/// \brief Counts the weight of every position of every ship afloat on each cell, one position at a time.
+///
+/// \param view The NetCellView of each cell of the board.
+/// \param sunk_ships Non-zero for each sunk ship, in the order of their indices.
+/// \param density The buffer receiving the probability of each cell.
+/// \return void
+void get_reference_density(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS],
+                           float density[RULES_NUM_CELLS]);
+
+/// \brief Checks that CompactAI only shoots cells it has not shot yet and sinks every fleet, along random games.
+///
+/// \return void
+void test_compact_ai(void);
+
+/// \brief Checks that a match server with one match and one AI worker survives a flood of matches against the AI
+/// that are placed, shot at and resigned at once, then plays a whole match whose every AI shot is answered.
+///
+/// The AI shots of the resigned matches are still queued or computed when the next match takes the slot. The
+/// server is started on its own port and stopped with SIGTERM. Only on Linux, like the server.
+///
+/// \param server_path The path of battleship_server.
+/// \return void
+void test_server_resign_cycles(const char *server_path);
+
+/// \brief Sends a message to the match server, reading what it sends meanwhile so neither side blocks.
+///
+/// \param client A pointer to the TestClient.
+/// \param message A pointer to the NetMessage.
+/// \return bool Returns true if the message was sent, false if the connection was closed.
+bool send_test_message(TestClient *client, const NetMessage *message);
+
+/// \brief Sends bytes to the match server, reading what it sends meanwhile so neither side blocks.
+///
+/// \param client A pointer to the TestClient.
+/// \param data The bytes.
+/// \param size The number of bytes.
+/// \return bool Returns true if the bytes were sent, false if the connection was closed.
+bool send_test_bytes(TestClient *client, const uint8_t *data, size_t size);
+
+/// \brief Receives the next message from the match server.
+///
+/// \param client A pointer to the TestClient.
+/// \param message A pointer to the NetMessage receiving the message.
+/// \param timeout The longest time to wait, in milliseconds.
+/// \return int 1 if a message was received, 0 on timeout, -1 if the connection was closed or sent invalid bytes.
+int receive_test_message(TestClient *client, NetMessage *message, int timeout);
+
+int main(int argc, char *argv[]) {
+    // Test the match server alone when its path is given
+    if (argc == 3 && strcmp(argv[1], "--server") == 0) {
+        test_server_resign_cycles(argv[2]);
+        printf("%d checks failed\n", num_failures);
+        return num_failures == 0 ? 0 : 1;
+    }
+    if (argc != 1) {
+        printf("Usage: %s [--server <path>]\n", argv[0]);
+        return 1;
+    }
+
+    test_net_round_trips();
+    test_net_rejections();
+    test_policy_round_trip();
+    test_policy_rejections();
+    test_env_auto_reset();
+    test_env_invalid_and_truncated();
+    test_compact_density();
+    test_compact_ai();
+
+    remove(TEST_WEIGHTS_FILE_NAME);
+    printf("%d checks failed\n", num_failures);
+    return num_failures == 0 ? 0 : 1;
+}
+
+void check(bool passed, const char *condition, const char *file, int line) {
+    if (!passed) {
+        printf("%s:%d: check failed: %s\n", file, line, condition);
+        num_failures++;
+    }
+}
+
+void test_net_round_trips(void) {
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    NetMessage decoded;
+
+    // A result that sinks a ship carries the ship
+    NetMessage result = {.type = NET_MSG_RESULT, .x = 3, .y = 7, .result = NET_RESULT_SUNK};
+    result.ship = (NetShip) {.index = 4, .orientation = 1, .x = 3, .y = 6};
+    size_t size = encode_net_message(&result, buffer);
+    CHECK(size == 5);
+    CHECK(decode_net_message(buffer, size, &decoded) == 5);
+    CHECK(decoded.type == NET_MSG_RESULT && decoded.x == 3 && decoded.y == 7 && decoded.result == NET_RESULT_SUNK);
+    CHECK(decoded.ship.index == 4 && decoded.ship.orientation == 1 && decoded.ship.x == 3 && decoded.ship.y == 6);
+
+    // A delta with the seat and the result packed into one byte
+    NetMessage delta = {.type = NET_MSG_DELTA, .seat = 2, .x = 9, .y = 0, .result = NET_RESULT_HIT};
+    size = encode_net_message(&delta, buffer);
+    CHECK(size == 3);
+    CHECK(decode_net_message(buffer, size, &decoded) == 3);
+    CHECK(decoded.seat == 2 && decoded.x == 9 && decoded.y == 0 && decoded.result == NET_RESULT_HIT);
+
+    // Every message but the first is left in the buffer
+    NetMessage shot = {.type = NET_MSG_SHOT, .x = 1, .y = 2};
+    size = encode_net_message(&shot, buffer);
+    size += encode_net_message(&shot, buffer + size);
+    CHECK(decode_net_message(buffer, size, &decoded) == 2);
+}
+
+void test_net_rejections(void) {
+    NetMessage message;
+
+    // Unknown types
+    uint8_t unknown[] = {0, 0, 0};
+    CHECK(decode_net_message(unknown, sizeof(unknown), &message) == -1);
+    unknown[0] = NET_MSG_DELTA + 1;
+    CHECK(decode_net_message(unknown, sizeof(unknown), &message) == -1);
+
+    // Cells off the board
+    uint8_t shot[] = {NET_MSG_SHOT, NET_NUM_CELLS};
+    CHECK(decode_net_message(shot, sizeof(shot), &message) == -1);
+    uint8_t delta[] = {NET_MSG_DELTA, 1 | (NET_RESULT_MISS << 2), NET_NUM_CELLS};
+    CHECK(decode_net_message(delta, sizeof(delta), &message) == -1);
+
+    // Results, seats and modes out of range
+    uint8_t result[] = {NET_MSG_RESULT, 0, NET_RESULT_SUNK + 1};
+    CHECK(decode_net_message(result, sizeof(result), &message) == -1);
+    uint8_t start[] = {NET_MSG_START, 3};
+    CHECK(decode_net_message(start, sizeof(start), &message) == -1);
+    start[1] = 0;
+    CHECK(decode_net_message(start, sizeof(start), &message) == -1);
+    uint8_t delta_seat[] = {NET_MSG_DELTA, 3 | (NET_RESULT_MISS << 2), 0};
+    CHECK(decode_net_message(delta_seat, sizeof(delta_seat), &message) == -1);
+    uint8_t place[2 + 2 * NET_FLEET_SIZE] = {NET_MSG_PLACE, NET_MODE_AI + 1};
+    CHECK(decode_net_message(place, sizeof(place), &message) == -1);
+
+    // Ships with an index past the fleet or a cell off the board
+    uint8_t sunk[] = {NET_MSG_RESULT, 0, NET_RESULT_SUNK, NET_FLEET_SIZE, 0};
+    CHECK(decode_net_message(sunk, sizeof(sunk), &message) == -1);
+    sunk[3] = 0;
+    sunk[4] = NET_NUM_CELLS;
+    CHECK(decode_net_message(sunk, sizeof(sunk), &message) == -1);
+
+    // Snapshots with more remaining ships than a fleet
+    uint8_t snapshot[NET_SNAPSHOT_SIZE] = {NET_MSG_SNAPSHOT, 1, NET_FLEET_SIZE + 1};
+    CHECK(decode_net_message(snapshot, sizeof(snapshot), &message) == -1);
+
+    // Partial messages wait for the rest, a sunk result is only whole with its ship
+    CHECK(decode_net_message(shot, 1, &message) == 0);
+    CHECK(decode_net_message(sunk, 4, &message) == 0);
+    CHECK(decode_net_message(snapshot, sizeof(snapshot) - 1, &message) == 0);
+    CHECK(decode_net_message(unknown, 0, &message) == 0);
+}
+
+void test_policy_round_trip(void) {
+    // A network with a distinct value in every parameter
+    PolicyNetwork network;
+    int sizes[] = {POLICY_NUM_INPUTS, 16, POLICY_NUM_OUTPUTS};
+    CHECK(allocate_policy_network(&network, 2, sizes));
+    for (size_t i = 0; i < network.num_parameters; i++) {
+        network.parameters[i] = (float) i * 0.25f;
+    }
+    CHECK(save_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+
+    PolicyNetwork loaded;
+    CHECK(load_policy_network(&loaded, TEST_WEIGHTS_FILE_NAME));
+    CHECK(loaded.num_layers == 2 && loaded.sizes[1] == 16 && loaded.num_parameters == network.num_parameters);
+    CHECK(loaded.parameters != NULL &&
+          memcmp(loaded.parameters, network.parameters, network.num_parameters * sizeof(float)) == 0);
+    free_policy_network(&loaded);
+    free_policy_network(&network);
+}
+
+void test_policy_rejections(void) {
+    PolicyFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POLICY_FILE_MAGIC, 4);
+    header.version = POLICY_FILE_VERSION;
+    header.num_layers = 1;
+    header.sizes[0] = POLICY_NUM_INPUTS;
+    header.sizes[1] = POLICY_NUM_OUTPUTS;
+    size_t num_floats = (POLICY_NUM_INPUTS + 1) * POLICY_NUM_OUTPUTS;
+    PolicyNetwork network;
+
+    // The valid single-layer file the other cases start from
+    CHECK(write_test_weights(&header, num_floats) && load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    free_policy_network(&network);
+
+    // Files of the wrong size
+    CHECK(write_test_weights(&header, num_floats - 1) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    CHECK(write_test_weights(&header, num_floats + 1) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    CHECK(network.parameters == NULL);
+
+    // Headers out of bounds
+    PolicyFileHeader invalid = header;
+    invalid.magic[0] = 'X';
+    CHECK(write_test_weights(&invalid, num_floats) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    invalid = header;
+    invalid.version = POLICY_FILE_VERSION + 1;
+    CHECK(write_test_weights(&invalid, num_floats) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    invalid = header;
+    invalid.num_layers = 0;
+    CHECK(write_test_weights(&invalid, num_floats) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    invalid = header;
+    invalid.num_layers = POLICY_MAX_LAYERS + 1;
+    CHECK(write_test_weights(&invalid, num_floats) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    invalid = header;
+    invalid.sizes[0] = POLICY_NUM_INPUTS + 1;
+    CHECK(write_test_weights(&invalid, num_floats) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+
+    // Hidden layers wider than allowed, including sizes that overflow an int
+    invalid = header;
+    invalid.num_layers = 2;
+    invalid.sizes[1] = POLICY_MAX_WIDTH + 1;
+    invalid.sizes[2] = POLICY_NUM_OUTPUTS;
+    CHECK(write_test_weights(&invalid, num_floats) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+    invalid.sizes[1] = UINT32_MAX;
+    CHECK(write_test_weights(&invalid, num_floats) && !load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+
+    // A file shorter than its header
+    FILE *file = fopen(TEST_WEIGHTS_FILE_NAME, "wb");
+    CHECK(file != NULL && fwrite(&header, sizeof(header) - 1, 1, file) == 1 && fclose(file) == 0);
+    CHECK(!load_policy_network(&network, TEST_WEIGHTS_FILE_NAME));
+}
+
+bool write_test_weights(const PolicyFileHeader *header, size_t num_floats) {
+    FILE *file = fopen(TEST_WEIGHTS_FILE_NAME, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    bool written = fwrite(header, sizeof(PolicyFileHeader), 1, file) == 1;
+    float zero = 0.0f;
+    for (size_t i = 0; i < num_floats && written; i++) {
+        written = fwrite(&zero, sizeof(zero), 1, file) == 1;
+    }
+    return fclose(file) == 0 && written;
+}
+
+void test_env_auto_reset(void) {
+    BattleshipEnvs *envs = create_battleship_envs(1, 7);
+    CHECK(envs != NULL);
+    if (envs == NULL) {
+        return;
+    }
+
+    // Sweep the board cell by cell, the fleet is sunk at the latest on the last cell
+    int32_t action;
+    float reward, hits = 0.0f;
+    uint8_t done = BATTLESHIP_ENV_RUNNING;
+    int32_t episode_shots = 0;
+    for (action = 0; action < BATTLESHIP_ENV_NUM_CELLS && done == BATTLESHIP_ENV_RUNNING; action++) {
+        int num_done = step_battleship_envs(envs, &action, &reward, &done, &episode_shots);
+        CHECK(num_done == (done != BATTLESHIP_ENV_RUNNING));
+        CHECK(reward == BATTLESHIP_ENV_REWARD_HIT || reward == BATTLESHIP_ENV_REWARD_MISS);
+        hits += reward;
+    }
+    CHECK(done == BATTLESHIP_ENV_WON);
+    CHECK(episode_shots == action);
+    CHECK(hits == 17.0f);
+
+    // The next game starts with nothing shot and nothing sunk
+    const float *planes = get_battleship_env_planes(envs);
+    const float *sunk_ships = get_battleship_env_sunk_ships(envs);
+    bool cleared = true;
+    for (int i = 0; i < BATTLESHIP_ENV_PLANES_SIZE; i++) {
+        cleared = cleared && planes[i] == 0.0f;
+    }
+    for (int i = 0; i < BATTLESHIP_ENV_NUM_SHIPS; i++) {
+        cleared = cleared && sunk_ships[i] == 0.0f;
+    }
+    CHECK(cleared);
+
+    // The shot counter restarts with the game
+    action = 0;
+    step_battleship_envs(envs, &action, &reward, &done, &episode_shots);
+    CHECK(done == BATTLESHIP_ENV_RUNNING && episode_shots == 0);
+    destroy_battleship_envs(envs);
+}
+
+void test_env_invalid_and_truncated(void) {
+    BattleshipEnvs *envs = create_battleship_envs(1, 7);
+    CHECK(envs != NULL);
+    if (envs == NULL) {
+        return;
+    }
+    const float *planes = get_battleship_env_planes(envs);
+
+    // Cells outside the board and cells already shot are penalized and leave the observations unchanged
+    int32_t actions[] = {-1, BATTLESHIP_ENV_NUM_CELLS, 42, 42};
+    float rewards[4];
+    uint8_t done;
+    for (int i = 0; i < 4; i++) {
+        step_battleship_envs(envs, &actions[i], &rewards[i], &done, NULL);
+    }
+    CHECK(rewards[0] == BATTLESHIP_ENV_REWARD_INVALID && rewards[1] == BATTLESHIP_ENV_REWARD_INVALID);
+    CHECK(rewards[2] != BATTLESHIP_ENV_REWARD_INVALID && rewards[3] == BATTLESHIP_ENV_REWARD_INVALID);
+    float shot = 0.0f;
+    for (int i = 0; i < BATTLESHIP_ENV_PLANES_SIZE; i++) {
+        shot += planes[i];
+    }
+    CHECK(shot == 1.0f);
+
+    // Invalid shots still count, the game is truncated on the last allowed shot
+    int32_t episode_shots = 0;
+    int32_t invalid = -1;
+    float reward;
+    for (int shots = 4; shots < BATTLESHIP_ENV_MAX_SHOTS; shots++) {
+        CHECK(done == BATTLESHIP_ENV_RUNNING);
+        step_battleship_envs(envs, &invalid, &reward, &done, &episode_shots);
+    }
+    CHECK(done == BATTLESHIP_ENV_TRUNCATED && episode_shots == BATTLESHIP_ENV_MAX_SHOTS);
+    destroy_battleship_envs(envs);
+}
+
+void test_compact_density(void) {
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, 7, 1);
+
+    for (int game = 0; game < 20; game++) {
+        CompactBoard board;
+        place_random_compact_fleet(&board, &rng, NULL);
+        uint8_t sunk_ships[RULES_NUM_SHIPS] = {0};
+
+        // Compare the densities after each shot of the AI until the fleet is sunk
+        while (board.remaining_ships > 0) {
+            uint8_t view[RULES_NUM_CELLS];
+            get_compact_view(&board, view);
+            float density[RULES_NUM_CELLS];
+            float reference[RULES_NUM_CELLS];
+            get_compact_density(view, sunk_ships, density);
+            get_reference_density(view, sunk_ships, reference);
+            float total = 0.0f;
+            bool matches = true;
+            for (int i = 0; i < RULES_NUM_CELLS; i++) {
+                total += density[i];
+                matches = matches && fabsf(density[i] - reference[i]) < 1e-5f;
+                matches = matches && (view[i] == NET_CELL_UNKNOWN || density[i] == 0.0f);
+            }
+            CHECK(matches);
+            CHECK(fabsf(total - 1.0f) < 1e-4f);
+
+            // The AI only shoots cells it has not shot yet, among the candidates the heatmap shows
+            uint8_t x, y;
+            choose_compact_shot(view, &rng, &x, &y);
+            CHECK(x < RULES_BOARD_SIZE && y < RULES_BOARD_SIZE && view[x * RULES_BOARD_SIZE + y] == NET_CELL_UNKNOWN);
+            uint8_t candidates[RULES_NUM_CELLS];
+            int num_candidates = get_compact_shot_candidates(view, candidates);
+            bool is_candidate = false;
+            for (int i = 0; i < num_candidates; i++) {
+                is_candidate = is_candidate || candidates[i] == x * RULES_BOARD_SIZE + y;
+            }
+            CHECK(is_candidate);
+            NetShip sunk_ship;
+            if (apply_compact_shot(&board, x, y, &sunk_ship) == NET_RESULT_SUNK) {
+                sunk_ships[sunk_ship.index] = 1;
+            }
+        }
+    }
+}
+
+void get_reference_density(const uint8_t view[RULES_NUM_CELLS], const uint8_t sunk_ships[RULES_NUM_SHIPS],
+                           float density[RULES_NUM_CELLS]) {
+    double counts[RULES_NUM_CELLS] = {0};
+
+    // Every position that fits on the board and covers neither a miss nor a sunk ship
+    for (int ship = 0; ship < RULES_NUM_SHIPS; ship++) {
+        int size = get_rules_ship_size(ship);
+        for (int orientation = 0; orientation < 2 && !sunk_ships[ship]; orientation++) {
+            for (int x = 0; x < RULES_BOARD_SIZE; x++) {
+                for (int y = 0; y < RULES_BOARD_SIZE; y++) {
+                    bool fits = true;
+                    double weight = 1.0;
+                    for (int t = 0; t < size && fits; t++) {
+                        int cell_x = orientation == 0 ? x + t : x;
+                        int cell_y = orientation == 0 ? y : y + t;
+                        fits = cell_x < RULES_BOARD_SIZE && cell_y < RULES_BOARD_SIZE;
+                        uint8_t cell = fits ? view[cell_x * RULES_BOARD_SIZE + cell_y] : NET_CELL_UNKNOWN;
+                        fits = fits && cell != NET_CELL_MISS && cell != NET_CELL_SUNK;
+                        weight *= cell == NET_CELL_HIT ? RULES_DENSITY_HIT_WEIGHT : 1.0;
+                    }
+                    for (int t = 0; t < size && fits; t++) {
+                        counts[(orientation == 0 ? x + t : x) * RULES_BOARD_SIZE + (orientation == 0 ? y : y + t)] +=
+                                weight;
+                    }
+                }
+            }
+        }
+    }
+
+    // Normalize over the cells not shot yet
+    double total = 0.0;
+    int num_unknown = 0;
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if (view[i] == NET_CELL_UNKNOWN) {
+            total += counts[i];
+            num_unknown++;
+        }
+    }
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        density[i] = view[i] != NET_CELL_UNKNOWN ? 0.0f
+                     : total > 0.0 ? (float) (counts[i] / total) : 1.0f / (float) num_unknown;
+    }
+}
+
+void test_compact_ai(void) {
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, 11, 3);
+
+    for (int game = 0; game < 200; game++) {
+        CompactBoard board;
+        place_random_compact_fleet(&board, &rng, NULL);
+        CompactAI ai;
+        init_compact_ai(&ai);
+
+        // Every shot is a new cell, so the fleet is sunk within the cells of the board
+        int shots = 0;
+        bool new_cells = true;
+        while (board.remaining_ships > 0 && shots < RULES_NUM_CELLS) {
+            uint8_t x, y;
+            choose_compact_ai_shot(&ai, &board, &rng, &x, &y);
+            new_cells = new_cells && x < RULES_BOARD_SIZE && y < RULES_BOARD_SIZE &&
+                        !(board.cells[x * RULES_BOARD_SIZE + y] & RULES_CELL_HIT);
+            NetShip sunk_ship;
+            apply_compact_shot(&board, x, y, &sunk_ship);
+            update_compact_ai(&ai, &board, x, y);
+            shots++;
+        }
+        CHECK(new_cells);
+        CHECK(board.remaining_ships == 0);
+        CHECK(ai.remaining_cells_count == RULES_NUM_CELLS - shots);
+    }
+}
+
+#ifdef __linux__
+void test_server_resign_cycles(const char *server_path) {
+    // Start the server with a single match slot and a single AI worker, its statistics are not shown
+    char port_text[8];
+    int port = NET_DEFAULT_PORT + 1 + (int) (getpid() % 1000);
+    snprintf(port_text, sizeof(port_text), "%d", port);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        execl(server_path, server_path, "--port", port_text, "--max-matches", "1", "--ai-workers", "1", (char *) NULL);
+        _exit(127);
+    }
+    CHECK(pid > 0);
+    if (pid <= 0) {
+        return;
+    }
+
+    // Connect once the server listens
+    static TestClient client;
+    client.socket = NET_INVALID_SOCKET;
+    for (int attempt = 0; attempt < 50 && client.socket == NET_INVALID_SOCKET; attempt++) {
+        client.socket = net_connect("127.0.0.1", (uint16_t) port);
+        if (client.socket != NET_INVALID_SOCKET &&
+            (net_wait(client.socket, true, 100) <= 0 || !net_finish_connect(client.socket))) {
+            net_close(client.socket);
+            client.socket = NET_INVALID_SOCKET;
+            usleep(100 * 1000);
+        }
+    }
+    CHECK(client.socket != NET_INVALID_SOCKET);
+
+    // Place a fleet against the AI, shoot once so a miss hands the AI the turn, and resign at once. The matches are
+    // sent in batches read at once by the server, the last match of a batch resigns after a pause in which the AI
+    // answers it while the jobs of the resigned matches are still queued.
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, 42, 54);
+    CompactBoard board;
+    NetMessage place = {.type = NET_MSG_PLACE, .mode = NET_MODE_AI};
+    place_random_compact_fleet(&board, &rng, place.fleet);
+    NetMessage resign = {.type = NET_MSG_RESIGN};
+    uint8_t batch[TEST_SERVER_BATCH * 3 * NET_MAX_MESSAGE_SIZE];
+    size_t batch_size = 0;
+    bool connected = client.socket != NET_INVALID_SOCKET;
+    for (int cycle = 0; cycle < TEST_SERVER_CYCLES && connected; cycle++) {
+        NetMessage shot = {.type = NET_MSG_SHOT, .x = (uint8_t) (cycle % 10), .y = (uint8_t) (cycle / 10 % 10)};
+        batch_size += encode_net_message(&place, batch + batch_size);
+        batch_size += encode_net_message(&shot, batch + batch_size);
+        if (cycle % TEST_SERVER_BATCH == TEST_SERVER_BATCH - 1) {
+            connected = send_test_bytes(&client, batch, batch_size);
+            batch_size = 0;
+            usleep(2000);
+        }
+        batch_size += encode_net_message(&resign, batch + batch_size);
+    }
+    connected = connected && send_test_bytes(&client, batch, batch_size);
+    CHECK(connected);
+
+    // Every resigned match ends with GAME_OVER, and the client is only told the result of its own shot
+    NetMessage message;
+    int games_over = 0;
+    int results = 0;
+    while (connected && games_over < TEST_SERVER_CYCLES) {
+        connected = receive_test_message(&client, &message, TEST_SERVER_TIMEOUT) == 1;
+        games_over += connected && message.type == NET_MSG_GAME_OVER;
+        results += connected && message.type == NET_MSG_RESULT;
+    }
+    CHECK(games_over == TEST_SERVER_CYCLES);
+    CHECK(results == TEST_SERVER_CYCLES);
+
+    // Play a whole match, the AI must answer every turn it is given and nothing may shoot for the client
+    place_compact_fleet(&board, place.fleet);
+    connected = connected && send_test_message(&client, &place) &&
+                receive_test_message(&client, &message, TEST_SERVER_TIMEOUT) == 1;
+    CHECK(connected && message.type == NET_MSG_START && message.seat == 1);
+    int next_shot = 0;
+    bool my_turn = true;
+    bool shot_pending = false;
+    bool game_over = false;
+    while (connected && !game_over) {
+        if (my_turn && !shot_pending) {
+            NetMessage shot = {.type = NET_MSG_SHOT, .x = (uint8_t) (next_shot / 10), .y = (uint8_t) (next_shot % 10)};
+            next_shot++;
+            connected = send_test_message(&client, &shot);
+            shot_pending = true;
+            continue;
+        }
+        connected = receive_test_message(&client, &message, TEST_SERVER_TIMEOUT) == 1;
+        if (!connected) {
+            break;
+        }
+        if (message.type == NET_MSG_RESULT) {
+            CHECK(shot_pending);
+            shot_pending = false;
+            my_turn = message.result != NET_RESULT_MISS;
+        } else if (message.type == NET_MSG_SHOT) {
+            // The AI shoots a cell of the fleet placed by the client once, a miss gives the turn back
+            NetShip sunk_ship;
+            int result = apply_compact_shot(&board, message.x, message.y, &sunk_ship);
+            CHECK(!my_turn && result >= 0);
+            my_turn = result == NET_RESULT_MISS;
+        } else {
+            game_over = message.type == NET_MSG_GAME_OVER;
+            CHECK(game_over);
+        }
+    }
+    CHECK(game_over);
+
+    // The server stops cleanly
+    net_close(client.socket);
+    kill(pid, SIGTERM);
+    int status = 0;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+bool send_test_message(TestClient *client, const NetMessage *message) {
+    uint8_t buffer[NET_MAX_MESSAGE_SIZE];
+    size_t size = encode_net_message(message, buffer);
+    return send_test_bytes(client, buffer, size);
+}
+
+bool send_test_bytes(TestClient *client, const uint8_t *data, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        int sent = net_send(client->socket, data + offset, size - offset);
+        if (sent < 0) {
+            return false;
+        }
+        offset += (size_t) sent;
+
+        // Read while the socket is full, the server drops clients that do not read
+        if (sent == 0) {
+            int received = net_receive(client->socket, client->receive_buffer + client->receive_size,
+                                       TEST_RECEIVE_SIZE - client->receive_size);
+            if (received < 0 || client->receive_size + (size_t) received == TEST_RECEIVE_SIZE) {
+                return false;
+            }
+            client->receive_size += (size_t) received;
+            net_wait(client->socket, true, 10);
+        }
+    }
+    return true;
+}
+
+int receive_test_message(TestClient *client, NetMessage *message, int timeout) {
+    for (;;) {
+        // Decode the next whole message
+        int size = decode_net_message(client->receive_buffer, client->receive_size, message);
+        if (size < 0) {
+            return -1;
+        }
+        if (size > 0) {
+            memmove(client->receive_buffer, client->receive_buffer + size, client->receive_size - (size_t) size);
+            client->receive_size -= (size_t) size;
+            return 1;
+        }
+
+        // Wait for more bytes
+        if (net_wait(client->socket, false, timeout) <= 0) {
+            return 0;
+        }
+        int received = net_receive(client->socket, client->receive_buffer + client->receive_size,
+                                   TEST_RECEIVE_SIZE - client->receive_size);
+        if (received < 0) {
+            return -1;
+        }
+        client->receive_size += (size_t) received;
+    }
+}
+#else
+void test_server_resign_cycles(const char *server_path) {
+    (void) server_path;
+    printf("The match server is only tested on Linux.\n");
+}
+#endif
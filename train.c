@@ -0,0 +1,588 @@
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include "policy.h"
+#include "rules.h"
+#include "selfplay.h"
+
+#define TRAIN_DEFAULT_EPOCHS 4
+#define TRAIN_DEFAULT_BATCH_SIZE 256
+#define TRAIN_DEFAULT_LEARNING_RATE 0.2f
+#define TRAIN_MOMENTUM 0.9f
+#define TRAIN_MAX_THREADS 64
+#define TRAIN_MAX_SHARDS 256
+#define TRAIN_EVAL_GAMES 1000
+#define TRAIN_EVAL_SEED 20261018
+#define TRAIN_REPORT_INTERVAL 1.0
+
+// Structure for a shard mapped into memory
+typedef struct {
+    void *map;
+    size_t size;
+    const SelfPlaySample *samples;
+    uint64_t num_samples;
+} TrainShard;
+
+// Structure for a sense-reversing barrier the threads meet at between the phases of a step, without a lock
+typedef struct {
+    int num_threads;
+    atomic_int num_waiting;
+    atomic_bool sense;
+} TrainBarrier;
+
+// Enum for the strategies compared on the evaluation fleets
+typedef enum {
+    EVAL_POLICY,
+    EVAL_GAME_AI,
+    EVAL_DENSITY
+} EvalStrategy;
+
+// Structure for the state shared by the training threads
+typedef struct {
+    PolicyNetwork network;
+    float *velocity;
+    float *gradients[TRAIN_MAX_THREADS];
+    TrainShard shards[TRAIN_MAX_SHARDS];
+    uint64_t shard_starts[TRAIN_MAX_SHARDS + 1];
+    int num_shards;
+    uint64_t num_samples;
+    TrainBarrier barrier;
+    int num_threads;
+    int batch_size;
+    float learning_rate;
+    uint64_t num_steps;
+    uint64_t steps_per_epoch;
+    const char *output;
+    CompactBoard eval_boards[TRAIN_EVAL_GAMES];
+    double game_ai_shots;
+    double losses[TRAIN_MAX_THREADS];
+    double start_time;
+    double report_time;
+    bool failed;
+} Trainer;
+
+// Structure for one training thread
+typedef struct {
+    Trainer *trainer;
+    int index;
+    pcg32_random_t rng;
+    bool barrier_sense;
+    pthread_t thread;
+} TrainWorker;
+
+/// \brief Parses the options, maps the shards, trains the network on a thread per core and writes the weights.
+///
+/// Usage: battleship_train --data <dir> --output <weights file> [--epochs <n>] [--batch <n>] [--rate <r>]
+/// [--layers <n>,<n>...] [--threads <n>] [--seed <n>]. After every epoch the weights are written and the network
+/// plays the evaluation fleets, its shots to win are compared with those of the AI of the game, played by
+/// CompactAI.
+///
+/// \param argc The number of command-line arguments.
+/// \param argv The command-line arguments.
+/// \return int Returns 0 if the weights were written, 1 otherwise.
+int main(int argc, char *argv[]);
+
+/// \brief Maps the shards of a directory written by battleship_selfplay.
+///
+/// \param trainer A pointer to the Trainer.
+/// \param directory The directory of the shards.
+/// \return bool Returns true if at least one valid shard was mapped, false otherwise.
+bool map_train_shards(Trainer *trainer, const char *directory);
+
+/// \brief Unmaps the shards.
+///
+/// \param trainer A pointer to the Trainer.
+/// \return void
+void unmap_train_shards(Trainer *trainer);
+
+/// \brief Sets random weights scaled to the number of inputs of each layer, and zero biases.
+///
+/// \param network A pointer to the allocated PolicyNetwork.
+/// \param rng A pointer to the random number generator.
+/// \return void
+void init_policy_weights(PolicyNetwork *network, pcg32_random_t *rng);
+
+/// \brief The function run by each thread: computes the gradients of its part of each batch, then updates its
+/// part of the parameters from the gradients of all threads.
+///
+/// \param data A pointer to the TrainWorker.
+/// \return void* Always NULL.
+void *train_worker_thread(void *data);
+
+/// \brief Adds the gradients of the cross-entropy between the policy and the target of one sample.
+///
+/// \param network A pointer to the PolicyNetwork.
+/// \param sample A pointer to the SelfPlaySample.
+/// \param gradients The gradients, in the order of the parameters of the network.
+/// \return double The cross-entropy of the sample.
+double add_sample_gradients(const PolicyNetwork *network, const SelfPlaySample *sample, float *gradients);
+
+/// \brief Plays the evaluation fleets with a strategy.
+///
+/// \param trainer A pointer to the Trainer.
+/// \param strategy The EvalStrategy.
+/// \return double The average number of shots to sink a fleet.
+double evaluate_shots_to_win(Trainer *trainer, EvalStrategy strategy);
+
+/// \brief Prints the loss, samples per second of the training steps and shots to win after an epoch, and writes the
+/// weights.
+///
+/// \param trainer A pointer to the Trainer.
+/// \param epoch The number of the epoch.
+/// \param loss The average loss of the epoch.
+/// \return void
+void end_train_epoch(Trainer *trainer, int epoch, double loss);
+
+/// \brief Initializes a barrier.
+///
+/// \param barrier A pointer to the TrainBarrier.
+/// \param num_threads The number of threads meeting at the barrier.
+/// \return void
+void init_train_barrier(TrainBarrier *barrier, int num_threads);
+
+/// \brief Waits until every thread has reached the barrier, spinning on its sense.
+///
+/// \param barrier A pointer to the TrainBarrier.
+/// \param sense A pointer to the sense of the thread, flipped at every barrier.
+/// \return void
+void wait_train_barrier(TrainBarrier *barrier, bool *sense);
+
+/// \brief Returns the value of the monotonic clock in seconds.
+///
+/// \return double The time in seconds.
+double get_time_s(void);
+
+int main(int argc, char *argv[]) {
+    static Trainer trainer;
+    const char *directory = NULL;
+    int epochs = TRAIN_DEFAULT_EPOCHS;
+    int num_layers = 3;
+    int sizes[POLICY_MAX_LAYERS + 1] = {POLICY_NUM_INPUTS, 256, 128, POLICY_NUM_OUTPUTS};
+    uint64_t seed = 1;
+    trainer.batch_size = TRAIN_DEFAULT_BATCH_SIZE;
+    trainer.learning_rate = TRAIN_DEFAULT_LEARNING_RATE;
+    trainer.num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    // Parse the command-line options
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            trainer.output = argv[++i];
+        } else if (strcmp(argv[i], "--epochs") == 0 && i + 1 < argc) {
+            epochs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            trainer.batch_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            trainer.learning_rate = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            trainer.num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--layers") == 0 && i + 1 < argc) {
+            // The hidden layers, the input and output layers are fixed
+            num_layers = 1;
+            for (char *size = strtok(argv[++i], ","); size != NULL && num_layers < POLICY_MAX_LAYERS;
+                 size = strtok(NULL, ",")) {
+                sizes[num_layers++] = atoi(size);
+            }
+            sizes[num_layers] = POLICY_NUM_OUTPUTS;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || directory == NULL || trainer.output == NULL || epochs <= 0 || trainer.batch_size <= 0 ||
+        trainer.learning_rate <= 0.0f || trainer.num_threads <= 0 || trainer.num_threads > TRAIN_MAX_THREADS) {
+        printf("Usage: %s --data <dir> --output <weights file> [--epochs <n>] [--batch <n>] [--rate <r>]\n"
+               "          [--layers <n>,<n>...] [--threads <n>] [--seed <n>]\n", argv[0]);
+        return 1;
+    }
+
+    // Map the samples and create the network
+    if (!map_train_shards(&trainer, directory)) {
+        return 1;
+    }
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, seed, 0);
+    if (!allocate_policy_network(&trainer.network, num_layers, sizes)) {
+        printf("Invalid layers, each hidden layer takes 1 to %d units.\n", POLICY_MAX_WIDTH);
+        unmap_train_shards(&trainer);
+        return 1;
+    }
+    init_policy_weights(&trainer.network, &rng);
+    trainer.velocity = calloc(trainer.network.num_parameters, sizeof(float));
+    for (int i = 0; i < trainer.num_threads; i++) {
+        trainer.gradients[i] = calloc(trainer.network.num_parameters, sizeof(float));
+        trainer.failed = trainer.failed || trainer.gradients[i] == NULL;
+    }
+    if (trainer.velocity == NULL || trainer.failed) {
+        printf("Out of memory.\n");
+        return 1;
+    }
+    trainer.steps_per_epoch = (trainer.num_samples + (uint64_t) trainer.batch_size - 1) / (uint64_t) trainer.batch_size;
+    trainer.num_steps = trainer.steps_per_epoch * (uint64_t) epochs;
+
+    // Draw the evaluation fleets once, every evaluation plays the same fleets
+    pcg32_random_t eval_rng;
+    pcg32_srandom_r(&eval_rng, TRAIN_EVAL_SEED, 0);
+    for (int i = 0; i < TRAIN_EVAL_GAMES; i++) {
+        place_random_compact_fleet(&trainer.eval_boards[i], &eval_rng, NULL);
+    }
+    trainer.game_ai_shots = evaluate_shots_to_win(&trainer, EVAL_GAME_AI);
+    printf("%llu samples in %d shards, %zu parameters, %d threads, batch %d, %d epochs\n",
+           (unsigned long long) trainer.num_samples, trainer.num_shards, trainer.network.num_parameters,
+           trainer.num_threads, trainer.batch_size, epochs);
+    printf("Shots to win on %d fleets: game AI %.2f, target density %.2f, untrained network %.2f\n",
+           TRAIN_EVAL_GAMES, trainer.game_ai_shots, evaluate_shots_to_win(&trainer, EVAL_DENSITY),
+           evaluate_shots_to_win(&trainer, EVAL_POLICY));
+    fflush(stdout);
+
+    // Train on a thread per core, each with its own stream of the seed to draw its samples
+    static TrainWorker workers[TRAIN_MAX_THREADS];
+    init_train_barrier(&trainer.barrier, trainer.num_threads);
+    trainer.start_time = get_time_s();
+    for (int i = 0; i < trainer.num_threads; i++) {
+        workers[i].trainer = &trainer;
+        workers[i].index = i;
+        workers[i].barrier_sense = false;
+        pcg32_srandom_r(&workers[i].rng, seed, (uint64_t) i + 1);
+    }
+    for (int i = 1; i < trainer.num_threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, train_worker_thread, &workers[i]) != 0) {
+            printf("Could not start thread %d.\n", i);
+            return 1;
+        }
+    }
+    train_worker_thread(&workers[0]);
+    for (int i = 1; i < trainer.num_threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    for (int i = 0; i < trainer.num_threads; i++) {
+        free(trainer.gradients[i]);
+    }
+    free(trainer.velocity);
+    free_policy_network(&trainer.network);
+    unmap_train_shards(&trainer);
+    return trainer.failed ? 1 : 0;
+}
+
+bool map_train_shards(Trainer *trainer, const char *directory) {
+    // The shards are numbered from 0, the first missing number ends the list
+    for (int i = 0; i < TRAIN_MAX_SHARDS; i++) {
+        char filename[4096];
+        snprintf(filename, sizeof(filename), SELFPLAY_SHARD_NAME_FORMAT, directory, i);
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            break;
+        }
+        struct stat status;
+        void *map = MAP_FAILED;
+        if (fstat(fd, &status) == 0 && (size_t) status.st_size >= sizeof(SelfPlayShardHeader)) {
+            map = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (map == MAP_FAILED) {
+            printf("Could not map the shard %s.\n", filename);
+            continue;
+        }
+
+        // Use the samples the header counts, the rest of a shard still being written is ignored
+        const SelfPlayShardHeader *header = map;
+        size_t size = (size_t) status.st_size;
+        if (memcmp(header->magic, SELFPLAY_MAGIC, 4) != 0 || header->version != SELFPLAY_VERSION ||
+            header->sample_size != sizeof(SelfPlaySample) ||
+            header->num_samples > (size - sizeof(SelfPlayShardHeader)) / sizeof(SelfPlaySample)) {
+            printf("%s is not a shard of version %d.\n", filename, SELFPLAY_VERSION);
+            munmap(map, size);
+            continue;
+        }
+        TrainShard *shard = &trainer->shards[trainer->num_shards++];
+        shard->map = map;
+        shard->size = size;
+        shard->samples = (const SelfPlaySample *) ((const char *) map + sizeof(SelfPlayShardHeader));
+        shard->num_samples = header->num_samples;
+        trainer->shard_starts[trainer->num_shards] = trainer->shard_starts[trainer->num_shards - 1] +
+                                                     shard->num_samples;
+    }
+    trainer->num_samples = trainer->shard_starts[trainer->num_shards];
+    if (trainer->num_samples == 0) {
+        printf("No samples found in %s.\n", directory);
+        unmap_train_shards(trainer);
+        return false;
+    }
+    return true;
+}
+
+void unmap_train_shards(Trainer *trainer) {
+    for (int i = 0; i < trainer->num_shards; i++) {
+        munmap(trainer->shards[i].map, trainer->shards[i].size);
+    }
+    trainer->num_shards = 0;
+}
+
+void init_policy_weights(PolicyNetwork *network, pcg32_random_t *rng) {
+    for (int layer = 0; layer < network->num_layers; layer++) {
+        // Uniform weights with the variance that keeps the scale of the activations through a ReLU
+        float limit = sqrtf(6.0f / (float) network->sizes[layer]);
+        size_t num_weights = (size_t) network->sizes[layer] * (size_t) network->sizes[layer + 1];
+        for (size_t i = 0; i < num_weights; i++) {
+            network->weights[layer][i] = ((float) pcg32_random_r(rng) / 4294967296.0f * 2.0f - 1.0f) * limit;
+        }
+        memset(network->biases[layer], 0, (size_t) network->sizes[layer + 1] * sizeof(float));
+    }
+}
+
+void *train_worker_thread(void *data) {
+    TrainWorker *worker = data;
+    Trainer *trainer = worker->trainer;
+    PolicyNetwork *network = &trainer->network;
+    float *gradients = trainer->gradients[worker->index];
+
+    // Each thread computes a share of every batch and updates a slice of the parameters
+    int share = trainer->batch_size / trainer->num_threads + (worker->index < trainer->batch_size %
+                                                              trainer->num_threads);
+    size_t slice = (network->num_parameters + (size_t) trainer->num_threads - 1) / (size_t) trainer->num_threads;
+    size_t first = slice * (size_t) worker->index;
+    size_t last = first + slice < network->num_parameters ? first + slice : network->num_parameters;
+    first = first < last ? first : last;
+    float scale = 1.0f / (float) trainer->batch_size;
+    double epoch_loss = 0.0;
+
+    for (uint64_t step = 0; step < trainer->num_steps; step++) {
+        // Gradients of the share of the thread, the threads only read the parameters
+        memset(gradients, 0, network->num_parameters * sizeof(float));
+        for (int i = 0; i < share; i++) {
+            uint64_t index = ((uint64_t) pcg32_random_r(&worker->rng) << 32 | pcg32_random_r(&worker->rng)) %
+                             trainer->num_samples;
+            int shard = 0;
+            while (trainer->shard_starts[shard + 1] <= index) {
+                shard++;
+            }
+            const SelfPlaySample *sample = &trainer->shards[shard].samples[index - trainer->shard_starts[shard]];
+            epoch_loss += add_sample_gradients(network, sample, gradients);
+        }
+        wait_train_barrier(&trainer->barrier, &worker->barrier_sense);
+
+        // Average the gradients of all threads over the slice of the thread, no two threads write the same slice
+        for (size_t j = first; j < last; j++) {
+            float gradient = 0.0f;
+            for (int t = 0; t < trainer->num_threads; t++) {
+                gradient += trainer->gradients[t][j];
+            }
+            trainer->velocity[j] = TRAIN_MOMENTUM * trainer->velocity[j] + gradient * scale;
+            network->parameters[j] -= trainer->learning_rate * trainer->velocity[j];
+        }
+        wait_train_barrier(&trainer->barrier, &worker->barrier_sense);
+
+        // The first thread reports the epoch while the others wait at the next barrier
+        if ((step + 1) % trainer->steps_per_epoch == 0) {
+            trainer->losses[worker->index] = epoch_loss;
+            epoch_loss = 0.0;
+            wait_train_barrier(&trainer->barrier, &worker->barrier_sense);
+            if (worker->index == 0) {
+                double loss = 0.0;
+                for (int t = 0; t < trainer->num_threads; t++) {
+                    loss += trainer->losses[t];
+                }
+                end_train_epoch(trainer, (int) ((step + 1) / trainer->steps_per_epoch),
+                                loss / (double) (trainer->steps_per_epoch * (uint64_t) trainer->batch_size));
+            }
+            wait_train_barrier(&trainer->barrier, &worker->barrier_sense);
+        }
+    }
+    return NULL;
+}
+
+double add_sample_gradients(const PolicyNetwork *network, const SelfPlaySample *sample, float *gradients) {
+    float activations[POLICY_MAX_LAYERS + 1][POLICY_MAX_WIDTH];
+    float deltas[2][POLICY_MAX_WIDTH];
+    int num_layers = network->num_layers;
+
+    // Forward pass, keeping the activations of every layer
+    uint8_t sunk_ships[RULES_NUM_SHIPS];
+    for (int i = 0; i < RULES_NUM_SHIPS; i++) {
+        sunk_ships[i] = (sample->sunk_ships >> i) & 1;
+    }
+    get_policy_inputs(sample->view, sunk_ships, activations[0]);
+    for (int layer = 0; layer < num_layers; layer++) {
+        int num_inputs = network->sizes[layer];
+        int num_outputs = network->sizes[layer + 1];
+        const float *inputs = activations[layer];
+        float *outputs = activations[layer + 1];
+        memcpy(outputs, network->biases[layer], (size_t) num_outputs * sizeof(float));
+        for (int i = 0; i < num_inputs; i++) {
+            if (inputs[i] != 0.0f) {
+                const float *row = &network->weights[layer][(size_t) i * num_outputs];
+                for (int o = 0; o < num_outputs; o++) {
+                    outputs[o] += inputs[i] * row[o];
+                }
+            }
+        }
+        if (layer < num_layers - 1) {
+            for (int o = 0; o < num_outputs; o++) {
+                outputs[o] = outputs[o] > 0.0f ? outputs[o] : 0.0f;
+            }
+        }
+    }
+
+    // Softmax over the cells not shot yet, its gradient is the difference with the target
+    const float *logits = activations[num_layers];
+    float *delta = deltas[0];
+    float max_logit = -INFINITY;
+    float target_total = 0.0f;
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if (sample->view[i] == NET_CELL_UNKNOWN) {
+            max_logit = logits[i] > max_logit ? logits[i] : max_logit;
+            target_total += sample->target[i];
+        }
+    }
+    float exp_total = 0.0f;
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        delta[i] = sample->view[i] == NET_CELL_UNKNOWN ? expf(logits[i] - max_logit) : 0.0f;
+        exp_total += delta[i];
+    }
+    double loss = 0.0;
+    float log_total = logf(exp_total);
+    for (int i = 0; i < RULES_NUM_CELLS; i++) {
+        if (sample->view[i] != NET_CELL_UNKNOWN) {
+            continue;
+        }
+        float target = target_total > 0.0f ? sample->target[i] / target_total : 0.0f;
+        if (target > 0.0f) {
+            loss -= target * (logits[i] - max_logit - log_total);
+        }
+        delta[i] = delta[i] / exp_total - target;
+    }
+
+    // Backward pass, the ReLU passes the deltas of the units that were not cut
+    for (int layer = num_layers - 1; layer >= 0; layer--) {
+        int num_inputs = network->sizes[layer];
+        int num_outputs = network->sizes[layer + 1];
+        const float *inputs = activations[layer];
+        const float *weights = network->weights[layer];
+        float *weight_gradients = gradients + (network->weights[layer] - network->parameters);
+        float *bias_gradients = gradients + (network->biases[layer] - network->parameters);
+        float *previous_delta = deltas[(num_layers - layer) % 2];
+
+        for (int o = 0; o < num_outputs; o++) {
+            bias_gradients[o] += delta[o];
+        }
+        for (int i = 0; i < num_inputs; i++) {
+            if (inputs[i] == 0.0f) {
+                if (layer > 0) {
+                    previous_delta[i] = 0.0f;
+                }
+                continue;
+            }
+            const float *row = &weights[(size_t) i * num_outputs];
+            float *gradient_row = &weight_gradients[(size_t) i * num_outputs];
+            float sum = 0.0f;
+            for (int o = 0; o < num_outputs; o++) {
+                gradient_row[o] += inputs[i] * delta[o];
+                sum += row[o] * delta[o];
+            }
+            if (layer > 0) {
+                previous_delta[i] = sum;
+            }
+        }
+        delta = previous_delta;
+    }
+    return loss;
+}
+
+double evaluate_shots_to_win(Trainer *trainer, EvalStrategy strategy) {
+    pcg32_random_t rng;
+    pcg32_srandom_r(&rng, TRAIN_EVAL_SEED, 1);
+    uint64_t total_shots = 0;
+
+    for (int game = 0; game < TRAIN_EVAL_GAMES; game++) {
+        CompactBoard board = trainer->eval_boards[game];
+        uint8_t view[RULES_NUM_CELLS];
+        uint8_t sunk_ships[RULES_NUM_SHIPS] = {0};
+        float density[RULES_NUM_CELLS];
+        CompactAI ai;
+        init_compact_ai(&ai);
+
+        // Shoot until the fleet is sunk, every strategy only sees the shots so far
+        while (board.remaining_ships > 0) {
+            get_compact_view(&board, view);
+            uint8_t x = 0, y = 0;
+            if (strategy == EVAL_POLICY) {
+                choose_policy_shot(&trainer->network, view, sunk_ships, &x, &y);
+            } else if (strategy == EVAL_GAME_AI) {
+                choose_compact_ai_shot(&ai, &board, &rng, &x, &y);
+            } else {
+                get_compact_density(view, sunk_ships, density);
+                int best = 0;
+                for (int i = 1; i < RULES_NUM_CELLS; i++) {
+                    best = density[i] > density[best] ? i : best;
+                }
+                x = (uint8_t) (best / RULES_BOARD_SIZE);
+                y = (uint8_t) (best % RULES_BOARD_SIZE);
+            }
+            NetShip sunk_ship;
+            if (apply_compact_shot(&board, x, y, &sunk_ship) == NET_RESULT_SUNK) {
+                sunk_ships[sunk_ship.index] = 1;
+            }
+            if (strategy == EVAL_GAME_AI) {
+                update_compact_ai(&ai, &board, x, y);
+            }
+            total_shots++;
+        }
+    }
+    return (double) total_shots / TRAIN_EVAL_GAMES;
+}
+
+void end_train_epoch(Trainer *trainer, int epoch, double loss) {
+    // Only the training steps count in the samples per second, not the evaluations and writes of the past epochs
+    double report_start = get_time_s();
+    double elapsed = report_start - trainer->start_time - trainer->report_time;
+    double samples = (double) epoch * (double) trainer->steps_per_epoch * (double) trainer->batch_size;
+    double policy_shots = evaluate_shots_to_win(trainer, EVAL_POLICY);
+    printf("Epoch %d: loss %.4f, %.0f samples/s, %.2f shots to win, %+.2f against the game AI\n", epoch, loss,
+           samples / elapsed, policy_shots, trainer->game_ai_shots - policy_shots);
+    if (!save_policy_network(&trainer->network, trainer->output)) {
+        trainer->failed = true;
+    }
+    fflush(stdout);
+    trainer->report_time += get_time_s() - report_start;
+}
+
+void init_train_barrier(TrainBarrier *barrier, int num_threads) {
+    barrier->num_threads = num_threads;
+    atomic_init(&barrier->num_waiting, 0);
+    atomic_init(&barrier->sense, false);
+}
+
+void wait_train_barrier(TrainBarrier *barrier, bool *sense) {
+    // Every barrier waits for the sense to turn to the opposite of the previous one
+    *sense = !*sense;
+    if (atomic_fetch_add(&barrier->num_waiting, 1) == barrier->num_threads - 1) {
+        // The last thread resets the count before releasing the others, none of them can arrive again before
+        atomic_store(&barrier->num_waiting, 0);
+        atomic_store(&barrier->sense, *sense);
+    } else {
+        // Give the core up while waiting, the first thread may be evaluating the network for a while
+        while (atomic_load(&barrier->sense) != *sense) {
+            sched_yield();
+        }
+    }
+}
+
+double get_time_s(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}